@@ -224,6 +224,14 @@ static relopt_int intRelOpts[] =
 		},
 		-1, 64, MAX_KILOBYTES
 	},
+	{
+		{
+			"max_pred_locks_per_relation",
+			"Maximum number of predicate-locked pages or tuples before the lock is promoted to cover the whole relation",
+			RELOPT_KIND_HEAP | RELOPT_KIND_BTREE
+		},
+		-1, 0, INT_MAX
+	},
 
 	/* list terminator */
 	{{NULL}}
@@ -1215,7 +1223,9 @@ default_reloptions(Datum reloptions, bool validate, relopt_kind kind)
 		{"autovacuum_analyze_scale_factor", RELOPT_TYPE_REAL,
 		offsetof(StdRdOptions, autovacuum) +offsetof(AutoVacOpts, analyze_scale_factor)},
 		{"user_catalog_table", RELOPT_TYPE_BOOL,
-		offsetof(StdRdOptions, user_catalog_table)}
+		offsetof(StdRdOptions, user_catalog_table)},
+		{"max_pred_locks_per_relation", RELOPT_TYPE_INT,
+		offsetof(StdRdOptions, max_pred_locks_per_relation)}
 	};
 
 	options = parseRelOptions(reloptions, validate, kind, &numoptions);
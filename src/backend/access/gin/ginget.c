@@ -17,6 +17,7 @@
 #include "access/gin_private.h"
 #include "access/relscan.h"
 #include "miscadmin.h"
+#include "utils/builtins.h"
 #include "utils/datum.h"
 #include "utils/memutils.h"
 
@@ -32,6 +33,8 @@ typedef struct pendingPosition
 	bool	   *hasMatchKey;
 } pendingPosition;
 
+static void startScanEntry(GinState *ginstate, GinScanEntry entry);
+
 
 /*
  * Goes to the next page if current offset is outside of bounds
@@ -287,6 +290,112 @@ collectMatchBitmap(GinBtreeData *btree, GinBtreeStack *stack,
 	}
 }
 
+/*
+ * Start a partial-match entry of an ORDER BY key.
+ *
+ * The ordering function needs to know which of the matching index keys an
+ * item was found under, which a bitmap of the matching items can't tell.
+ * Instead, an exact-match sub-entry is set up for each matching key, and
+ * entryGetItem merges their streams.  The entry tree is only read here; the
+ * posting lists are read one item at a time, like those of other entries.
+ */
+static void
+startScanOrderByPartialEntry(GinState *ginstate, GinScanEntry entry)
+{
+	GinBtreeData btreeEntry;
+	GinBtreeStack *stackEntry;
+	Form_pg_attribute attr;
+	int			allocSubEntries = 8;
+	int			i;
+
+	entry->subEntries = (GinScanEntry *)
+		palloc(allocSubEntries * sizeof(GinScanEntry));
+	entry->nsubEntries = 0;
+	entry->matchKey = (Datum) 0;
+	entry->isFinished = TRUE;
+
+	/* Null query cannot partial-match anything */
+	if (entry->queryCategory != GIN_CAT_NORM_KEY)
+		return;
+
+	attr = ginstate->origTupdesc->attrs[entry->attnum - 1];
+
+	ginPrepareEntryScan(&btreeEntry, entry->attnum,
+						entry->queryKey, entry->queryCategory,
+						ginstate);
+	stackEntry = ginFindLeafPage(&btreeEntry, true);
+	btreeEntry.findItem(&btreeEntry, stackEntry);
+
+	for (;;)
+	{
+		Page		page;
+		IndexTuple	itup;
+		Datum		idatum;
+		GinNullCategory icategory;
+		GinScanEntry subEntry;
+		int32		cmp;
+
+		if (moveRightIfItNeeded(&btreeEntry, stackEntry) == false)
+			break;
+
+		page = BufferGetPage(stackEntry->buffer);
+		itup = (IndexTuple) PageGetItem(page,
+									PageGetItemId(page, stackEntry->off));
+
+		if (gintuple_get_attrnum(ginstate, itup) != entry->attnum)
+			break;
+
+		/* partial matches never match nulls; see collectMatchBitmap */
+		idatum = gintuple_get_key(ginstate, itup, &icategory);
+		if (icategory != GIN_CAT_NORM_KEY)
+			break;
+
+		cmp = DatumGetInt32(FunctionCall4Coll(&ginstate->comparePartialFn[entry->attnum - 1],
+							   ginstate->supportCollation[entry->attnum - 1],
+											  entry->queryKey,
+											  idatum,
+											  UInt16GetDatum(entry->strategy),
+										PointerGetDatum(entry->extra_data)));
+		if (cmp > 0)
+			break;
+
+		if (cmp == 0)
+		{
+			if (entry->nsubEntries >= allocSubEntries)
+			{
+				allocSubEntries *= 2;
+				entry->subEntries = (GinScanEntry *)
+					repalloc(entry->subEntries,
+							 allocSubEntries * sizeof(GinScanEntry));
+			}
+
+			subEntry = (GinScanEntry) palloc(sizeof(GinScanEntryData));
+			memcpy(subEntry, entry, sizeof(GinScanEntryData));
+			subEntry->queryKey = datumCopy(idatum, attr->attbyval,
+										   attr->attlen);
+			subEntry->isPartialMatch = false;
+			subEntry->subEntries = NULL;
+			subEntry->nsubEntries = 0;
+			entry->subEntries[entry->nsubEntries++] = subEntry;
+		}
+
+		stackEntry->off++;
+	}
+
+	LockBuffer(stackEntry->buffer, GIN_UNLOCK);
+	freeGinBtreeStack(stackEntry);
+
+	for (i = 0; i < entry->nsubEntries; i++)
+	{
+		GinScanEntry subEntry = entry->subEntries[i];
+
+		startScanEntry(ginstate, subEntry);
+		if (!subEntry->isFinished)
+			entry->isFinished = FALSE;
+		entry->predictNumberResult += subEntry->predictNumberResult;
+	}
+}
+
 /*
  * Start* functions setup beginning state of searches: finds correct buffer and pins it.
  */
@@ -309,6 +418,12 @@ restartScanEntry:
 	entry->reduceResult = FALSE;
 	entry->predictNumberResult = 0;
 
+	if (entry->isPartialMatch && entry->isOrderBy)
+	{
+		startScanOrderByPartialEntry(ginstate, entry);
+		return;
+	}
+
 	/*
 	 * we should find entry, and begin scan of posting tree or just store
 	 * posting list in memory
@@ -547,6 +662,9 @@ startScan(IndexScanDesc scan)
 
 		for (i = 0; i < so->totalentries; i++)
 		{
+			/* entries of ORDER BY keys must report every item */
+			if (so->entries[i]->isOrderBy)
+				continue;
 			if (so->entries[i]->predictNumberResult <= so->totalentries * GinFuzzySearchLimit)
 			{
 				reduce = false;
@@ -557,6 +675,8 @@ startScan(IndexScanDesc scan)
 		{
 			for (i = 0; i < so->totalentries; i++)
 			{
+				if (so->entries[i]->isOrderBy)
+					continue;
 				so->entries[i]->predictNumberResult /= so->totalentries;
 				so->entries[i]->reduceResult = TRUE;
 			}
@@ -739,7 +859,45 @@ entryGetItem(GinState *ginstate, GinScanEntry entry,
 	Assert(!ItemPointerIsValid(&entry->curItem) ||
 		   ginCompareItemPointers(&entry->curItem, &advancePast) <= 0);
 
-	if (entry->matchBitmap)
+	if (entry->subEntries)
+	{
+		/*
+		 * A partial-match entry of an ORDER BY key: advance the sub-entries,
+		 * and return the smallest of their items, remembering the key of the
+		 * sub-entry it came from.
+		 */
+		GinScanEntry minEntry = NULL;
+		int			i;
+
+		for (i = 0; i < entry->nsubEntries; i++)
+		{
+			GinScanEntry subEntry = entry->subEntries[i];
+
+			if (!subEntry->isFinished &&
+				ginCompareItemPointers(&subEntry->curItem, &advancePast) <= 0)
+				entryGetItem(ginstate, subEntry, advancePast);
+
+			if (subEntry->isFinished)
+				continue;
+
+			if (minEntry == NULL ||
+				ginCompareItemPointers(&subEntry->curItem,
+									   &minEntry->curItem) < 0)
+				minEntry = subEntry;
+		}
+
+		if (minEntry == NULL)
+		{
+			ItemPointerSetInvalid(&entry->curItem);
+			entry->isFinished = TRUE;
+		}
+		else
+		{
+			entry->curItem = minEntry->curItem;
+			entry->matchKey = minEntry->queryKey;
+		}
+	}
+	else if (entry->matchBitmap)
 	{
 		/* A bitmap result */
 		BlockNumber advancePastBlk = GinItemPointerGetBlockNumber(&advancePast);
@@ -1304,6 +1462,322 @@ scanGetItem(IndexScanDesc scan, ItemPointerData advancePast,
 }
 
 
+/*
+ * Functions for ordered scans
+ */
+
+static void scanPendingInsert(IndexScanDesc scan, TIDBitmap *tbm,
+				  int64 *ntids);
+
+#define GinOrderedItemAt(so, i) \
+	((GinOrderedItem *) ((so)->orderedItems + \
+						 (i) * SizeOfGinOrderedItem((so)->norderkeys)))
+
+/*
+ * Set up the entryRes arrays of the ORDER BY keys for the given item.
+ *
+ * The entries of ORDER BY keys aren't advanced by scanGetItem; they are
+ * brought forward here, as the items that passed the scan keys are found in
+ * ascending order.  Their partial-match entries merge exact-match streams
+ * rather than reading a bitmap, so they never return lossy page pointers.
+ */
+static void
+orderKeysGetItem(GinScanOpaque so, ItemPointerData item)
+{
+	ItemPointerData advancePast;
+	int			i;
+	uint32		j;
+
+	Assert(item.ip_posid > 0);
+	advancePast = item;
+	advancePast.ip_posid--;
+
+	for (i = 0; i < so->norderkeys; i++)
+	{
+		GinScanKey	key = so->orderKeys[i];
+
+		if (key == NULL)
+			continue;
+
+		for (j = 0; j < key->nentries; j++)
+		{
+			GinScanEntry entry = key->scanEntry[j];
+
+			if (!entry->isFinished &&
+				ginCompareItemPointers(&entry->curItem, &item) < 0)
+				entryGetItem(&so->ginstate, entry, advancePast);
+
+			key->entryRes[j] = (!entry->isFinished &&
+						ginCompareItemPointers(&entry->curItem, &item) == 0);
+		}
+	}
+}
+
+static int
+orderedItemCmp(const GinOrderedItem *ia, const GinOrderedItem *ib,
+			   int norderkeys)
+{
+	int			i;
+
+	for (i = 0; i < norderkeys; i++)
+	{
+		if (ia->distances[i] != ib->distances[i])
+			return (ia->distances[i] < ib->distances[i]) ? -1 : 1;
+	}
+
+	return ginCompareItemPointers((ItemPointer) &ia->iptr,
+								  (ItemPointer) &ib->iptr);
+}
+
+/*
+ * Add an item to the current batch of the ordered-scan result, computing its
+ * distances from the current entryRes arrays of the ORDER BY keys.
+ *
+ * The batch is a max-heap, ordered by distance and then by item pointer, of
+ * at most orderedItemsLimit items.  Items that sort before or equal to the
+ * last one returned from an earlier batch are skipped.  Once the batch is
+ * full, a new item replaces the worst one if it sorts before it, and is
+ * dropped otherwise; either way, the batch no longer holds all the
+ * remaining items.
+ */
+static void
+addOrderedItem(IndexScanDesc scan, ItemPointerData iptr, bool recheck)
+{
+	GinScanOpaque so = (GinScanOpaque) scan->opaque;
+	Size		itemsz = SizeOfGinOrderedItem(so->norderkeys);
+	GinOrderedItem *item = so->newOrderedItem;
+	MemoryContext oldCtx;
+	int64		hole;
+	int			i;
+
+	item->iptr = iptr;
+	item->recheck = recheck;
+
+	oldCtx = MemoryContextSwitchTo(so->tempCtx);
+
+	for (i = 0; i < so->norderkeys; i++)
+	{
+		GinScanKey	key = so->orderKeys[i];
+		Datum	   *queryValues;
+		uint32		j;
+
+		/*
+		 * A null argument, or a NULL item (found by the key's hidden entry),
+		 * sorts last.
+		 */
+		if (key == NULL || key->entryRes[key->nentries - 1])
+		{
+			item->distances[i] = get_float8_infinity();
+			continue;
+		}
+
+		/*
+		 * For a partial-match entry present in the item, the ordering
+		 * function gets the index key it matched in place of the query key.
+		 */
+		queryValues = (Datum *) palloc(sizeof(Datum) * key->nuserentries);
+		for (j = 0; j < key->nuserentries; j++)
+		{
+			GinScanEntry entry = key->scanEntry[j];
+
+			if (entry->isPartialMatch && key->entryRes[j])
+				queryValues[j] = entry->matchKey;
+			else
+				queryValues[j] = key->queryValues[j];
+		}
+
+		item->distances[i] = DatumGetFloat8(FunctionCall7Coll(
+								&so->ginstate.orderingFn[key->attnum - 1],
+							   so->ginstate.supportCollation[key->attnum - 1],
+											  PointerGetDatum(key->entryRes),
+											   UInt16GetDatum(key->strategy),
+															  key->query,
+										   UInt32GetDatum(key->nuserentries),
+										   PointerGetDatum(key->extra_data),
+											  PointerGetDatum(queryValues),
+									PointerGetDatum(key->queryCategories)));
+	}
+
+	MemoryContextSwitchTo(oldCtx);
+	MemoryContextReset(so->tempCtx);
+
+	if (so->haveLastOrderedItem &&
+		orderedItemCmp(item, so->lastOrderedItem, so->norderkeys) <= 0)
+		return;
+
+	if (so->nOrderedItems < so->orderedItemsLimit)
+	{
+		if (so->nOrderedItems >= so->maxOrderedItems)
+		{
+			if (so->maxOrderedItems == 0)
+			{
+				so->maxOrderedItems = Min(256, so->orderedItemsLimit);
+				so->orderedItems = MemoryContextAllocHuge(so->keyCtx,
+											so->maxOrderedItems * itemsz);
+			}
+			else
+			{
+				so->maxOrderedItems = Min(so->maxOrderedItems * 2,
+										  so->orderedItemsLimit);
+				so->orderedItems = repalloc_huge(so->orderedItems,
+												 so->maxOrderedItems * itemsz);
+			}
+		}
+
+		/* Sift the new item up from the end of the heap */
+		hole = so->nOrderedItems++;
+		while (hole > 0)
+		{
+			int64		parent = (hole - 1) / 2;
+
+			if (orderedItemCmp(GinOrderedItemAt(so, parent), item,
+							   so->norderkeys) >= 0)
+				break;
+			memcpy(GinOrderedItemAt(so, hole), GinOrderedItemAt(so, parent),
+				   itemsz);
+			hole = parent;
+		}
+		memcpy(GinOrderedItemAt(so, hole), item, itemsz);
+		return;
+	}
+
+	so->orderedItemsTruncated = true;
+
+	if (orderedItemCmp(item, GinOrderedItemAt(so, 0), so->norderkeys) >= 0)
+		return;
+
+	/* Replace the worst item with the new one, and sift it down */
+	hole = 0;
+	for (;;)
+	{
+		int64		child = 2 * hole + 1;
+
+		if (child >= so->nOrderedItems)
+			break;
+		if (child + 1 < so->nOrderedItems &&
+			orderedItemCmp(GinOrderedItemAt(so, child + 1),
+						   GinOrderedItemAt(so, child), so->norderkeys) > 0)
+			child++;
+		if (orderedItemCmp(GinOrderedItemAt(so, child), item,
+						   so->norderkeys) <= 0)
+			break;
+		memcpy(GinOrderedItemAt(so, hole), GinOrderedItemAt(so, child),
+			   itemsz);
+		hole = child;
+	}
+	memcpy(GinOrderedItemAt(so, hole), item, itemsz);
+}
+
+static int
+orderedItemDistanceCmp(const void *a, const void *b, void *arg)
+{
+	return orderedItemCmp((const GinOrderedItem *) a,
+						  (const GinOrderedItem *) b,
+						  *(int *) arg);
+}
+
+/*
+ * Collect the next batch of items matching the scan keys, with their
+ * distances, and sort them by distance.
+ *
+ * The batch holds the items that sort first among those after the last item
+ * returned, as many as fit in work_mem.  If more items than that match, the
+ * batch is marked truncated, and another scan collects the next batch once
+ * this one has been returned.  This keeps the memory used bounded, and for
+ * ORDER BY ... LIMIT a single batch normally suffices.
+ *
+ * Like gingetbitmap, this scans the pending list first and then the main
+ * index, so an item moved from one to the other concurrently can be seen
+ * twice.  Both copies have the same distance, so they end up next to each
+ * other in the batch, and one is removed after sorting; or the second one
+ * comes after the end of the batch, and is skipped by the next one.
+ *
+ * A lossy page pointer from the scan keys can't be returned as such, so
+ * every possible item on the page is returned instead, to be rechecked.
+ * Their distances are still exact, since the entries of the ORDER BY keys
+ * never are lossy.
+ */
+static void
+collectOrderedItems(IndexScanDesc scan)
+{
+	GinScanOpaque so = (GinScanOpaque) scan->opaque;
+	Size		itemsz;
+	ItemPointerData iptr;
+	bool		recheck;
+	int64		ntids = 0;
+	int64		i,
+				j;
+
+	ginFreeScanKeys(so);
+	ginNewScanKey(scan);
+	so->orderedItemsReady = true;
+
+	if (so->isVoidRes)
+		return;
+
+	itemsz = SizeOfGinOrderedItem(so->norderkeys);
+	so->orderedItemsLimit = Max((work_mem * 1024L) / itemsz, 2);
+	so->newOrderedItem = (GinOrderedItem *) MemoryContextAlloc(so->keyCtx,
+															   itemsz);
+
+	scanPendingInsert(scan, NULL, &ntids);
+
+	startScan(scan);
+
+	ItemPointerSetMin(&iptr);
+
+	for (;;)
+	{
+		CHECK_FOR_INTERRUPTS();
+
+		if (!scanGetItem(scan, iptr, &iptr, &recheck))
+			break;
+
+		if (ItemPointerIsLossyPage(&iptr))
+		{
+			ItemPointerData item;
+			OffsetNumber off;
+
+			for (off = FirstOffsetNumber; off <= MaxHeapTuplesPerPage; off++)
+			{
+				ItemPointerSet(&item, GinItemPointerGetBlockNumber(&iptr), off);
+				orderKeysGetItem(so, item);
+				addOrderedItem(scan, item, true);
+			}
+		}
+		else
+		{
+			orderKeysGetItem(so, iptr);
+			addOrderedItem(scan, iptr, recheck);
+		}
+	}
+
+	if (so->nOrderedItems < 2)
+		return;
+
+	qsort_arg(so->orderedItems, so->nOrderedItems, itemsz,
+			  orderedItemDistanceCmp, &so->norderkeys);
+
+	/* Remove duplicates, keeping the recheck flag if either copy needs it */
+	j = 0;
+	for (i = 1; i < so->nOrderedItems; i++)
+	{
+		GinOrderedItem *prev = GinOrderedItemAt(so, j);
+		GinOrderedItem *cur = GinOrderedItemAt(so, i);
+
+		if (ItemPointerEquals(&prev->iptr, &cur->iptr))
+			prev->recheck |= cur->recheck;
+		else
+		{
+			j++;
+			if (j != i)
+				memcpy(GinOrderedItemAt(so, j), cur, itemsz);
+		}
+	}
+	so->nOrderedItems = j + 1;
+}
+
+
 /*
  * Functions for scanning the pending list
  */
@@ -1452,7 +1926,24 @@ matchPartialInPendingList(GinState *ginstate, Page page,
 											  UInt16GetDatum(entry->strategy),
 										PointerGetDatum(entry->extra_data)));
 		if (cmp == 0)
+		{
+			/*
+			 * The ordering function is told which key an ORDER BY key's
+			 * entry matched.  Copy it, since the page may be released before
+			 * that, if the heap row continues on the next page.
+			 */
+			if (entry->isOrderBy)
+			{
+				Form_pg_attribute attr;
+
+				attr = ginstate->origTupdesc->attrs[entry->attnum - 1];
+				if (!attr->attbyval && DatumGetPointer(entry->matchKey) != NULL)
+					pfree(DatumGetPointer(entry->matchKey));
+				entry->matchKey = datumCopy(datum[off - 1], attr->attbyval,
+											attr->attlen);
+			}
 			return true;
+		}
 		else if (cmp > 0)
 			return false;
 
@@ -1462,6 +1953,158 @@ matchPartialInPendingList(GinState *ginstate, Page page,
 	return false;
 }
 
+/*
+ * Set up the entryRes array of one scan key by looking at the pending-list
+ * tuples of the current heap row on the current page (pos->firstOffset up to
+ * pos->lastOffset).  Entries already matched on an earlier page are kept.
+ *
+ * datum[]/category[]/datumExtracted[] cache the results of
+ * gintuple_get_key() on the page, across calls for different keys.
+ *
+ * Returns true if any entry of the key matched on this page.
+ */
+static bool
+collectKeyMatchesForHeapRow(GinScanOpaque so, GinScanKey key, Page page,
+							pendingPosition *pos, Datum *datum,
+							GinNullCategory *category, bool *datumExtracted)
+{
+	OffsetNumber attrnum;
+	IndexTuple	itup;
+	bool		matched = false;
+	int			j;
+
+	for (j = 0; j < key->nentries; j++)
+	{
+		GinScanEntry entry = key->scanEntry[j];
+		OffsetNumber StopLow = pos->firstOffset,
+					StopHigh = pos->lastOffset,
+					StopMiddle;
+
+		/* If already matched on earlier page, do no extra work */
+		if (key->entryRes[j])
+			continue;
+
+		/*
+		 * Interesting tuples are from pos->firstOffset to pos->lastOffset
+		 * and they are ordered by (attnum, Datum) as it's done in entry
+		 * tree.  So we can use binary search to avoid linear scanning.
+		 */
+		while (StopLow < StopHigh)
+		{
+			int			res;
+
+			StopMiddle = StopLow + ((StopHigh - StopLow) >> 1);
+
+			itup = (IndexTuple) PageGetItem(page, PageGetItemId(page, StopMiddle));
+
+			attrnum = gintuple_get_attrnum(&so->ginstate, itup);
+
+			if (key->attnum < attrnum)
+			{
+				StopHigh = StopMiddle;
+				continue;
+			}
+			if (key->attnum > attrnum)
+			{
+				StopLow = StopMiddle + 1;
+				continue;
+			}
+
+			if (datumExtracted[StopMiddle - 1] == false)
+			{
+				datum[StopMiddle - 1] =
+					gintuple_get_key(&so->ginstate, itup,
+									 &category[StopMiddle - 1]);
+				datumExtracted[StopMiddle - 1] = true;
+			}
+
+			if (entry->queryCategory == GIN_CAT_EMPTY_QUERY)
+			{
+				/* special behavior depending on searchMode */
+				if (entry->searchMode == GIN_SEARCH_MODE_ALL)
+				{
+					/* match anything except NULL_ITEM */
+					if (category[StopMiddle - 1] == GIN_CAT_NULL_ITEM)
+						res = -1;
+					else
+						res = 0;
+				}
+				else
+				{
+					/* match everything */
+					res = 0;
+				}
+			}
+			else
+			{
+				res = ginCompareEntries(&so->ginstate,
+										entry->attnum,
+										entry->queryKey,
+										entry->queryCategory,
+										datum[StopMiddle - 1],
+										category[StopMiddle - 1]);
+			}
+
+			if (res == 0)
+			{
+				/*
+				 * Found exact match (there can be only one, except in
+				 * EMPTY_QUERY mode).
+				 *
+				 * If doing partial match, scan forward from here to end of
+				 * page to check for matches.
+				 *
+				 * See comment above about tuple's ordering.
+				 */
+				if (entry->isPartialMatch)
+					key->entryRes[j] =
+						matchPartialInPendingList(&so->ginstate,
+												  page,
+												  StopMiddle,
+												  pos->lastOffset,
+												  entry,
+												  datum,
+												  category,
+												  datumExtracted);
+				else
+					key->entryRes[j] = true;
+
+				/* done with binary search */
+				break;
+			}
+			else if (res < 0)
+				StopHigh = StopMiddle;
+			else
+				StopLow = StopMiddle + 1;
+		}
+
+		if (StopLow >= StopHigh && entry->isPartialMatch)
+		{
+			/*
+			 * No exact match on this page.  If doing partial match, scan
+			 * from the first tuple greater than target value to end of page.
+			 * Note that since we don't remember whether the comparePartialFn
+			 * told us to stop early on a previous page, we will uselessly
+			 * apply comparePartialFn to the first tuple on each subsequent
+			 * page.
+			 */
+			key->entryRes[j] =
+				matchPartialInPendingList(&so->ginstate,
+										  page,
+										  StopHigh,
+										  pos->lastOffset,
+										  entry,
+										  datum,
+										  category,
+										  datumExtracted);
+		}
+
+		matched |= key->entryRes[j];
+	}
+
+	return matched;
+}
+
 /*
  * Set up the entryRes array for each key by looking at
  * every entry for current heap row in pending list.
@@ -1478,11 +2121,8 @@ static bool
 collectMatchesForHeapRow(IndexScanDesc scan, pendingPosition *pos)
 {
 	GinScanOpaque so = (GinScanOpaque) scan->opaque;
-	OffsetNumber attrnum;
 	Page		page;
-	IndexTuple	itup;
-	int			i,
-				j;
+	int			i;
 
 	/*
 	 * Reset all entryRes and hasMatchKey flags
@@ -1493,6 +2133,12 @@ collectMatchesForHeapRow(IndexScanDesc scan, pendingPosition *pos)
 
 		memset(key->entryRes, GIN_FALSE, key->nentries);
 	}
+	for (i = 0; i < so->norderkeys; i++)
+	{
+		if (so->orderKeys[i])
+			memset(so->orderKeys[i]->entryRes, GIN_FALSE,
+				   so->orderKeys[i]->nentries);
+	}
 	memset(pos->hasMatchKey, FALSE, so->nkeys);
 
 	/*
@@ -1515,135 +2161,18 @@ collectMatchesForHeapRow(IndexScanDesc scan, pendingPosition *pos)
 		{
 			GinScanKey	key = so->keys + i;
 
-			for (j = 0; j < key->nentries; j++)
-			{
-				GinScanEntry entry = key->scanEntry[j];
-				OffsetNumber StopLow = pos->firstOffset,
-							StopHigh = pos->lastOffset,
-							StopMiddle;
-
-				/* If already matched on earlier page, do no extra work */
-				if (key->entryRes[j])
-					continue;
-
-				/*
-				 * Interesting tuples are from pos->firstOffset to
-				 * pos->lastOffset and they are ordered by (attnum, Datum) as
-				 * it's done in entry tree.  So we can use binary search to
-				 * avoid linear scanning.
-				 */
-				while (StopLow < StopHigh)
-				{
-					int			res;
-
-					StopMiddle = StopLow + ((StopHigh - StopLow) >> 1);
-
-					itup = (IndexTuple) PageGetItem(page, PageGetItemId(page, StopMiddle));
-
-					attrnum = gintuple_get_attrnum(&so->ginstate, itup);
-
-					if (key->attnum < attrnum)
-					{
-						StopHigh = StopMiddle;
-						continue;
-					}
-					if (key->attnum > attrnum)
-					{
-						StopLow = StopMiddle + 1;
-						continue;
-					}
-
-					if (datumExtracted[StopMiddle - 1] == false)
-					{
-						datum[StopMiddle - 1] =
-							gintuple_get_key(&so->ginstate, itup,
-											 &category[StopMiddle - 1]);
-						datumExtracted[StopMiddle - 1] = true;
-					}
-
-					if (entry->queryCategory == GIN_CAT_EMPTY_QUERY)
-					{
-						/* special behavior depending on searchMode */
-						if (entry->searchMode == GIN_SEARCH_MODE_ALL)
-						{
-							/* match anything except NULL_ITEM */
-							if (category[StopMiddle - 1] == GIN_CAT_NULL_ITEM)
-								res = -1;
-							else
-								res = 0;
-						}
-						else
-						{
-							/* match everything */
-							res = 0;
-						}
-					}
-					else
-					{
-						res = ginCompareEntries(&so->ginstate,
-												entry->attnum,
-												entry->queryKey,
-												entry->queryCategory,
-												datum[StopMiddle - 1],
-												category[StopMiddle - 1]);
-					}
-
-					if (res == 0)
-					{
-						/*
-						 * Found exact match (there can be only one, except in
-						 * EMPTY_QUERY mode).
-						 *
-						 * If doing partial match, scan forward from here to
-						 * end of page to check for matches.
-						 *
-						 * See comment above about tuple's ordering.
-						 */
-						if (entry->isPartialMatch)
-							key->entryRes[j] =
-								matchPartialInPendingList(&so->ginstate,
-														  page,
-														  StopMiddle,
-														  pos->lastOffset,
-														  entry,
-														  datum,
-														  category,
-														  datumExtracted);
-						else
-							key->entryRes[j] = true;
-
-						/* done with binary search */
-						break;
-					}
-					else if (res < 0)
-						StopHigh = StopMiddle;
-					else
-						StopLow = StopMiddle + 1;
-				}
-
-				if (StopLow >= StopHigh && entry->isPartialMatch)
-				{
-					/*
-					 * No exact match on this page.  If doing partial match,
-					 * scan from the first tuple greater than target value to
-					 * end of page.  Note that since we don't remember whether
-					 * the comparePartialFn told us to stop early on a
-					 * previous page, we will uselessly apply comparePartialFn
-					 * to the first tuple on each subsequent page.
-					 */
-					key->entryRes[j] =
-						matchPartialInPendingList(&so->ginstate,
-												  page,
-												  StopHigh,
-												  pos->lastOffset,
-												  entry,
-												  datum,
-												  category,
-												  datumExtracted);
-				}
+			pos->hasMatchKey[i] |=
+				collectKeyMatchesForHeapRow(so, key, page, pos,
+											datum, category, datumExtracted);
+		}
 
-				pos->hasMatchKey[i] |= key->entryRes[j];
-			}
+		/* ORDER BY keys only need their entryRes set up */
+		for (i = 0; i < so->norderkeys; i++)
+		{
+			if (so->orderKeys[i])
+				(void) collectKeyMatchesForHeapRow(so, so->orderKeys[i], page,
+												   pos, datum, category,
+												   datumExtracted);
 		}
 
 		/* Advance firstOffset over the scanned tuples */
@@ -1684,7 +2213,8 @@ collectMatchesForHeapRow(IndexScanDesc scan, pendingPosition *pos)
 }
 
 /*
- * Collect all matched rows from pending list into bitmap
+ * Collect all matched rows from pending list into bitmap, or into the
+ * ordered-scan item array if tbm is NULL
  */
 static void
 scanPendingInsert(IndexScanDesc scan, TIDBitmap *tbm, int64 *ntids)
@@ -1761,7 +2291,10 @@ scanPendingInsert(IndexScanDesc scan, TIDBitmap *tbm, int64 *ntids)
 
 		if (match)
 		{
-			tbm_add_tuples(tbm, &pos.item, 1, recheck);
+			if (tbm)
+				tbm_add_tuples(tbm, &pos.item, 1, recheck);
+			else
+				addOrderedItem(scan, pos.item, recheck);
 			(*ntids)++;
 		}
 	}
@@ -1828,3 +2361,50 @@ gingetbitmap(PG_FUNCTION_ARGS)
 
 	PG_RETURN_INT64(ntids);
 }
+
+/*
+ * Ordered scans.
+ *
+ * GIN can't return items one at a time in index order (see gingetbitmap),
+ * but it can collect them in batches and return them sorted by the
+ * distances computed by the opclass's ordering function.  The planner only
+ * uses this for scans with ORDER BY operators.
+ */
+Datum
+gingettuple(PG_FUNCTION_ARGS)
+{
+	IndexScanDesc scan = (IndexScanDesc) PG_GETARG_POINTER(0);
+	ScanDirection dir = (ScanDirection) PG_GETARG_INT32(1);
+	GinScanOpaque so = (GinScanOpaque) scan->opaque;
+	GinOrderedItem *item;
+
+	if (dir != ForwardScanDirection)
+		elog(ERROR, "GIN only supports forward scan direction");
+
+	if (!so->orderedItemsReady)
+		collectOrderedItems(scan);
+
+	/* Collect the next batch if this one didn't hold all the items */
+	while (so->curOrderedItem >= so->nOrderedItems)
+	{
+		if (!so->orderedItemsTruncated)
+			PG_RETURN_BOOL(false);
+
+		if (so->nOrderedItems > 0)
+		{
+			memcpy(so->lastOrderedItem,
+				   GinOrderedItemAt(so, so->nOrderedItems - 1),
+				   SizeOfGinOrderedItem(so->norderkeys));
+			so->haveLastOrderedItem = true;
+		}
+		collectOrderedItems(scan);
+	}
+
+	item = GinOrderedItemAt(so, so->curOrderedItem);
+	so->curOrderedItem++;
+
+	scan->xs_ctup.t_self = item->iptr;
+	scan->xs_recheck = item->recheck;
+
+	PG_RETURN_BOOL(true);
+}
@@ -30,15 +30,26 @@ ginbeginscan(PG_FUNCTION_ARGS)
 	IndexScanDesc scan;
 	GinScanOpaque so;
 
-	/* no order by operators allowed */
-	Assert(norderbys == 0);
-
 	scan = RelationGetIndexScan(rel, nkeys, norderbys);
 
 	/* allocate private workspace */
 	so = (GinScanOpaque) palloc(sizeof(GinScanOpaqueData));
 	so->keys = NULL;
 	so->nkeys = 0;
+	so->orderKeys = NULL;
+	so->norderkeys = 0;
+	so->orderedItems = NULL;
+	so->nOrderedItems = 0;
+	so->maxOrderedItems = 0;
+	so->orderedItemsLimit = 0;
+	so->curOrderedItem = 0;
+	so->orderedItemsReady = false;
+	so->orderedItemsTruncated = false;
+	so->newOrderedItem = NULL;
+	so->lastOrderedItem = NULL;
+	if (norderbys > 0)
+		so->lastOrderedItem = palloc(SizeOfGinOrderedItem(norderbys));
+	so->haveLastOrderedItem = false;
 	so->tempCtx = AllocSetContextCreate(CurrentMemoryContext,
 										"Gin scan temporary context",
 										ALLOCSET_DEFAULT_MINSIZE,
@@ -64,7 +75,8 @@ static GinScanEntry
 ginFillScanEntry(GinScanOpaque so, OffsetNumber attnum,
 				 StrategyNumber strategy, int32 searchMode,
 				 Datum queryKey, GinNullCategory queryCategory,
-				 bool isPartialMatch, Pointer extra_data)
+				 bool isPartialMatch, Pointer extra_data,
+				 bool isOrderBy)
 {
 	GinState   *ginstate = &so->ginstate;
 	GinScanEntry scanEntry;
@@ -75,14 +87,17 @@ ginFillScanEntry(GinScanOpaque so, OffsetNumber attnum,
 	 *
 	 * Entries with non-null extra_data are never considered identical, since
 	 * we can't know exactly what the opclass might be doing with that.
+	 * Entries of ORDER BY keys are advanced independently of the others (see
+	 * ginget.c), so they are never shared either.
 	 */
-	if (extra_data == NULL)
+	if (extra_data == NULL && !isOrderBy)
 	{
 		for (i = 0; i < so->totalentries; i++)
 		{
 			GinScanEntry prevEntry = so->entries[i];
 
 			if (prevEntry->extra_data == NULL &&
+				!prevEntry->isOrderBy &&
 				prevEntry->isPartialMatch == isPartialMatch &&
 				prevEntry->strategy == strategy &&
 				prevEntry->searchMode == searchMode &&
@@ -119,6 +134,10 @@ ginFillScanEntry(GinScanOpaque so, OffsetNumber attnum,
 	scanEntry->offset = InvalidOffsetNumber;
 	scanEntry->isFinished = false;
 	scanEntry->reduceResult = false;
+	scanEntry->isOrderBy = isOrderBy;
+	scanEntry->subEntries = NULL;
+	scanEntry->nsubEntries = 0;
+	scanEntry->matchKey = (Datum) 0;
 
 	/* Add it to so's array */
 	if (so->totalentries >= so->allocentries)
@@ -133,22 +152,25 @@ ginFillScanEntry(GinScanOpaque so, OffsetNumber attnum,
 }
 
 /*
- * Initialize the next GinScanKey using the output from the extractQueryFn
+ * Initialize a GinScanKey using the output from the extractQueryFn
  */
 static void
-ginFillScanKey(GinScanOpaque so, OffsetNumber attnum,
+ginFillScanKey(GinScanOpaque so, GinScanKey key, OffsetNumber attnum,
 			   StrategyNumber strategy, int32 searchMode,
 			   Datum query, uint32 nQueryValues,
 			   Datum *queryValues, GinNullCategory *queryCategories,
-			   bool *partial_matches, Pointer *extra_data)
+			   bool *partial_matches, Pointer *extra_data,
+			   bool isOrderBy)
 {
-	GinScanKey	key = &(so->keys[so->nkeys++]);
 	GinState   *ginstate = &so->ginstate;
 	uint32		nUserQueryValues = nQueryValues;
 	uint32		i;
 
-	/* Non-default search modes add one "hidden" entry to each key */
-	if (searchMode != GIN_SEARCH_MODE_DEFAULT)
+	/*
+	 * Non-default search modes add one "hidden" entry to each key, and so do
+	 * ORDER BY keys
+	 */
+	if (searchMode != GIN_SEARCH_MODE_DEFAULT || isOrderBy)
 		nQueryValues++;
 	key->nentries = nQueryValues;
 	key->nuserentries = nUserQueryValues;
@@ -198,6 +220,11 @@ ginFillScanKey(GinScanOpaque so, OffsetNumber attnum,
 			queryKey = (Datum) 0;
 			switch (searchMode)
 			{
+				case GIN_SEARCH_MODE_DEFAULT:
+					/* ORDER BY key: find the NULL items */
+					Assert(isOrderBy);
+					queryCategory = GIN_CAT_NULL_ITEM;
+					break;
 				case GIN_SEARCH_MODE_INCLUDE_EMPTY:
 					queryCategory = GIN_CAT_EMPTY_ITEM;
 					break;
@@ -228,7 +255,8 @@ ginFillScanKey(GinScanOpaque so, OffsetNumber attnum,
 		key->scanEntry[i] = ginFillScanEntry(so, attnum,
 											 strategy, searchMode,
 											 queryKey, queryCategory,
-											 isPartialMatch, this_extra);
+											 isPartialMatch, this_extra,
+											 isOrderBy);
 	}
 }
 
@@ -239,6 +267,7 @@ void
 ginFreeScanKeys(GinScanOpaque so)
 {
 	uint32		i;
+	int			j;
 
 	if (so->keys == NULL)
 		return;
@@ -247,6 +276,11 @@ ginFreeScanKeys(GinScanOpaque so)
 	{
 		GinScanEntry entry = so->entries[i];
 
+		for (j = 0; j < entry->nsubEntries; j++)
+		{
+			if (entry->subEntries[j]->buffer != InvalidBuffer)
+				ReleaseBuffer(entry->subEntries[j]->buffer);
+		}
 		if (entry->buffer != InvalidBuffer)
 			ReleaseBuffer(entry->buffer);
 		if (entry->matchIterator)
@@ -261,6 +295,16 @@ ginFreeScanKeys(GinScanOpaque so)
 	so->nkeys = 0;
 	so->entries = NULL;
 	so->totalentries = 0;
+	so->orderKeys = NULL;
+	so->norderkeys = 0;
+	so->orderedItems = NULL;
+	so->nOrderedItems = 0;
+	so->maxOrderedItems = 0;
+	so->orderedItemsLimit = 0;
+	so->curOrderedItem = 0;
+	so->orderedItemsReady = false;
+	so->orderedItemsTruncated = false;
+	so->newOrderedItem = NULL;
 }
 
 void
@@ -374,11 +418,81 @@ ginNewScanKey(IndexScanDesc scan)
 		}
 		/* now we can use the nullFlags as category codes */
 
-		ginFillScanKey(so, skey->sk_attno,
+		ginFillScanKey(so, &(so->keys[so->nkeys++]), skey->sk_attno,
 					   skey->sk_strategy, searchMode,
 					   skey->sk_argument, nQueryValues,
 					   queryValues, (GinNullCategory *) nullFlags,
-					   partial_matches, extra_data);
+					   partial_matches, extra_data, false);
+	}
+
+	/*
+	 * Set up a key for each ORDER BY operator.  Their entries don't restrict
+	 * the scan; which of them are present in an item is only reported to the
+	 * opclass's ordering function, to compute the item's distance.
+	 */
+	if (scan->numberOfOrderBys > 0 && !so->isVoidRes)
+	{
+		so->norderkeys = scan->numberOfOrderBys;
+		so->orderKeys = (GinScanKey *)
+			palloc0(so->norderkeys * sizeof(GinScanKey));
+
+		for (i = 0; i < so->norderkeys; i++)
+		{
+			ScanKey		skey = &scan->orderByData[i];
+			OffsetNumber attnum = skey->sk_attno;
+			Datum	   *queryValues;
+			int32		nQueryValues = 0;
+			bool	   *partial_matches = NULL;
+			Pointer    *extra_data = NULL;
+			bool	   *nullFlags = NULL;
+			int32		searchMode = GIN_SEARCH_MODE_DEFAULT;
+			int32		j;
+
+			/* A null argument gives an infinite distance to every item */
+			if (skey->sk_flags & SK_ISNULL)
+				continue;
+
+			if (!so->ginstate.canOrdering[attnum - 1])
+				elog(ERROR, "missing GIN support function %d for attribute %d of index \"%s\"",
+					 GIN_ORDERING_PROC, attnum,
+					 RelationGetRelationName(scan->indexRelation));
+
+			queryValues = (Datum *)
+				DatumGetPointer(FunctionCall7Coll(&so->ginstate.extractQueryFn[attnum - 1],
+								 so->ginstate.supportCollation[attnum - 1],
+												  skey->sk_argument,
+											  PointerGetDatum(&nQueryValues),
+										   UInt16GetDatum(skey->sk_strategy),
+										   PointerGetDatum(&partial_matches),
+												PointerGetDatum(&extra_data),
+												  PointerGetDatum(&nullFlags),
+											   PointerGetDatum(&searchMode)));
+
+			if (queryValues == NULL || nQueryValues < 0)
+				nQueryValues = 0;
+
+			/*
+			 * The search mode doesn't matter, since these entries never
+			 * restrict the scan.
+			 */
+			if (nullFlags == NULL)
+				nullFlags = (bool *) palloc0(Max(nQueryValues, 1) * sizeof(bool));
+			else
+			{
+				for (j = 0; j < nQueryValues; j++)
+				{
+					if (nullFlags[j])
+						nullFlags[j] = true;	/* not any other nonzero value */
+				}
+			}
+
+			so->orderKeys[i] = (GinScanKey) palloc(sizeof(GinScanKeyData));
+			ginFillScanKey(so, so->orderKeys[i], attnum,
+						   skey->sk_strategy, GIN_SEARCH_MODE_DEFAULT,
+						   skey->sk_argument, nQueryValues,
+						   queryValues, (GinNullCategory *) nullFlags,
+						   partial_matches, extra_data, true);
+		}
 	}
 
 	/*
@@ -388,10 +502,10 @@ ginNewScanKey(IndexScanDesc scan)
 	if (so->nkeys == 0 && !so->isVoidRes)
 	{
 		hasNullQuery = true;
-		ginFillScanKey(so, FirstOffsetNumber,
+		ginFillScanKey(so, &(so->keys[so->nkeys++]), FirstOffsetNumber,
 					   InvalidStrategy, GIN_SEARCH_MODE_EVERYTHING,
 					   (Datum) 0, 0,
-					   NULL, NULL, NULL, NULL);
+					   NULL, NULL, NULL, NULL, false);
 	}
 
 	/*
@@ -423,10 +537,12 @@ ginrescan(PG_FUNCTION_ARGS)
 	IndexScanDesc scan = (IndexScanDesc) PG_GETARG_POINTER(0);
 	ScanKey		scankey = (ScanKey) PG_GETARG_POINTER(1);
 
-	/* remaining arguments are ignored */
+	/* nscankeys and norderbys arguments are ignored */
+	ScanKey		orderbys = (ScanKey) PG_GETARG_POINTER(3);
 	GinScanOpaque so = (GinScanOpaque) scan->opaque;
 
 	ginFreeScanKeys(so);
+	so->haveLastOrderedItem = false;
 
 	if (scankey && scan->numberOfKeys > 0)
 	{
@@ -434,6 +550,12 @@ ginrescan(PG_FUNCTION_ARGS)
 				scan->numberOfKeys * sizeof(ScanKeyData));
 	}
 
+	if (orderbys && scan->numberOfOrderBys > 0)
+	{
+		memmove(scan->orderByData, orderbys,
+				scan->numberOfOrderBys * sizeof(ScanKeyData));
+	}
+
 	PG_RETURN_VOID();
 }
 
@@ -449,6 +571,8 @@ ginendscan(PG_FUNCTION_ARGS)
 	MemoryContextDelete(so->tempCtx);
 	MemoryContextDelete(so->keyCtx);
 
+	if (so->lastOrderedItem)
+		pfree(so->lastOrderedItem);
 	pfree(so);
 
 	PG_RETURN_VOID();
@@ -110,6 +110,21 @@ initGinState(GinState *state, Relation index)
 			state->canPartialMatch[i] = false;
 		}
 
+		/*
+		 * Check opclass capability to compute ORDER BY distances.
+		 */
+		if (index_getprocid(index, i + 1, GIN_ORDERING_PROC) != InvalidOid)
+		{
+			fmgr_info_copy(&(state->orderingFn[i]),
+						   index_getprocinfo(index, i + 1, GIN_ORDERING_PROC),
+						   CurrentMemoryContext);
+			state->canOrdering[i] = true;
+		}
+		else
+		{
+			state->canOrdering[i] = false;
+		}
+
 		/*
 		 * If the index column has a specified collation, we should honor that
 		 * while doing comparisons.  However, we may have a collatable storage
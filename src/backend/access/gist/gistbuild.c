@@ -26,6 +26,7 @@
 #include "storage/smgr.h"
 #include "utils/memutils.h"
 #include "utils/rel.h"
+#include "utils/tuplesort.h"
 
 /* Step of index tuples for check whether to switch to buffering build mode */
 #define BUFFERING_MODE_SWITCH_CHECK_STEP 256
@@ -48,9 +49,22 @@ typedef enum
 	GIST_BUFFERING_STATS,		/* gathering statistics of index tuple size
 								 * before switching to the buffering build
 								 * mode */
-	GIST_BUFFERING_ACTIVE		/* in buffering build mode */
+	GIST_BUFFERING_ACTIVE,		/* in buffering build mode */
+	GIST_SORTED_BUILD			/* sorting the tuples, and packing the index
+								 * bottom-up */
 } GistBufferingMode;
 
+/*
+ * In the sorted build, we keep one in-memory page per level of the tree: the
+ * rightmost page of the level, which is being filled.  When it fills up, it
+ * is written out, and a downlink to it is added to the parent level.
+ */
+typedef struct GistSortedBuildPageState
+{
+	Page		page;
+	struct GistSortedBuildPageState *parent;	/* upper level, if any */
+} GistSortedBuildPageState;
+
 /* Working state for gistbuild and its callback */
 typedef struct
 {
@@ -71,6 +85,14 @@ typedef struct
 	HTAB	   *parentMap;
 
 	GistBufferingMode bufferingMode;
+
+	/*
+	 * Extra data structures used during a sorted build.  'sortstate' holds
+	 * the index tuples, and 'pages_allocated' is the number of index pages
+	 * assigned so far.
+	 */
+	Tuplesortstate *sortstate;
+	BlockNumber pages_allocated;
 } GISTBuildState;
 
 /* prototypes for private functions */
@@ -104,10 +126,29 @@ static void gistMemorizeParent(GISTBuildState *buildstate, BlockNumber child,
 static void gistMemorizeAllDownlinks(GISTBuildState *buildstate, Buffer parent);
 static BlockNumber gistGetParent(GISTBuildState *buildstate, BlockNumber child);
 
+static void gistSortedBuildCallback(Relation index,
+						HeapTuple htup,
+						Datum *values,
+						bool *isnull,
+						bool tupleIsAlive,
+						void *state);
+static void gist_indexsortbuild(GISTBuildState *state);
+static void gist_indexsortbuild_pagestate_add(GISTBuildState *state,
+								  GistSortedBuildPageState *pagestate,
+								  IndexTuple itup);
+static void gist_indexsortbuild_pagestate_flush(GISTBuildState *state,
+									GistSortedBuildPageState *pagestate);
+static void gist_indexsortbuild_writepage(GISTBuildState *state, Page page,
+							  BlockNumber blkno);
+
 /*
- * Main entry point to GiST index build. Initially calls insert over and over,
- * but switches to more efficient buffering build algorithm after a certain
- * number of tuples (unless buffering mode is disabled).
+ * Main entry point to GiST index build.
+ *
+ * If all the opclasses provide a SortSupport function, and buffering was not
+ * explicitly requested, the index tuples are sorted and the index is packed
+ * bottom-up, see gist_indexsortbuild.  Otherwise, we initially call insert
+ * over and over, but switch to more efficient buffering build algorithm after
+ * a certain number of tuples (unless buffering mode is disabled).
  */
 Datum
 gistbuild(PG_FUNCTION_ARGS)
@@ -151,6 +192,28 @@ gistbuild(PG_FUNCTION_ARGS)
 	/* Calculate target amount of free space to leave on pages */
 	buildstate.freespace = BLCKSZ * (100 - fillfactor) / 100;
 
+	/*
+	 * Unless buffering mode was forced, see if we can use sorting instead.
+	 * That requires a SortSupport function for every index column.
+	 */
+	if (buildstate.bufferingMode != GIST_BUFFERING_STATS)
+	{
+		bool		hasallsortsupports = true;
+		int			i;
+
+		for (i = 0; i < RelationGetNumberOfAttributes(index); i++)
+		{
+			if (!OidIsValid(index_getprocid(index, i + 1,
+											GIST_SORTSUPPORT_PROC)))
+			{
+				hasallsortsupports = false;
+				break;
+			}
+		}
+		if (hasallsortsupports)
+			buildstate.bufferingMode = GIST_SORTED_BUILD;
+	}
+
 	/*
 	 * We expect to be called exactly once for any index relation. If that's
 	 * not the case, big trouble's what we have.
@@ -169,53 +232,80 @@ gistbuild(PG_FUNCTION_ARGS)
 	 */
 	buildstate.giststate->tempCxt = createTempGistContext();
 
-	/* initialize the root page */
-	buffer = gistNewBuffer(index);
-	Assert(BufferGetBlockNumber(buffer) == GIST_ROOT_BLKNO);
-	page = BufferGetPage(buffer);
-
-	START_CRIT_SECTION();
+	/* build the index */
+	buildstate.indtuples = 0;
+	buildstate.indtuplesSize = 0;
 
-	GISTInitBuffer(buffer, F_LEAF);
+	if (buildstate.bufferingMode == GIST_SORTED_BUILD)
+	{
+		/*
+		 * Sort all data, build the index from bottom up.
+		 */
+		buildstate.sortstate = tuplesort_begin_index_gist(heap,
+														  index,
+														  maintenance_work_mem,
+														  false);
 
-	MarkBufferDirty(buffer);
+		/* Scan the table, adding all tuples to the tuplesort */
+		reltuples = IndexBuildHeapScan(heap, index, indexInfo, true,
+									   gistSortedBuildCallback,
+									   (void *) &buildstate);
 
-	if (RelationNeedsWAL(index))
-	{
-		XLogRecPtr	recptr;
+		/*
+		 * Perform the sort and build index pages.
+		 */
+		tuplesort_performsort(buildstate.sortstate);
 
-		XLogBeginInsert();
-		XLogRegisterBuffer(0, buffer, REGBUF_WILL_INIT);
+		gist_indexsortbuild(&buildstate);
 
-		recptr = XLogInsert(RM_GIST_ID, XLOG_GIST_CREATE_INDEX);
-		PageSetLSN(page, recptr);
+		tuplesort_end(buildstate.sortstate);
 	}
 	else
-		PageSetLSN(page, gistGetFakeLSN(heap));
+	{
+		/* initialize the root page */
+		buffer = gistNewBuffer(index);
+		Assert(BufferGetBlockNumber(buffer) == GIST_ROOT_BLKNO);
+		page = BufferGetPage(buffer);
 
-	UnlockReleaseBuffer(buffer);
+		START_CRIT_SECTION();
 
-	END_CRIT_SECTION();
+		GISTInitBuffer(buffer, F_LEAF);
 
-	/* build the index */
-	buildstate.indtuples = 0;
-	buildstate.indtuplesSize = 0;
+		MarkBufferDirty(buffer);
 
-	/*
-	 * Do the heap scan.
-	 */
-	reltuples = IndexBuildHeapScan(heap, index, indexInfo, true,
-								   gistBuildCallback, (void *) &buildstate);
+		if (RelationNeedsWAL(index))
+		{
+			XLogRecPtr	recptr;
 
-	/*
-	 * If buffering was used, flush out all the tuples that are still in the
-	 * buffers.
-	 */
-	if (buildstate.bufferingMode == GIST_BUFFERING_ACTIVE)
-	{
-		elog(DEBUG1, "all tuples processed, emptying buffers");
-		gistEmptyAllBuffers(&buildstate);
-		gistFreeBuildBuffers(buildstate.gfbb);
+			XLogBeginInsert();
+			XLogRegisterBuffer(0, buffer, REGBUF_WILL_INIT);
+
+			recptr = XLogInsert(RM_GIST_ID, XLOG_GIST_CREATE_INDEX);
+			PageSetLSN(page, recptr);
+		}
+		else
+			PageSetLSN(page, gistGetFakeLSN(heap));
+
+		UnlockReleaseBuffer(buffer);
+
+		END_CRIT_SECTION();
+
+		/*
+		 * Do the heap scan.
+		 */
+		reltuples = IndexBuildHeapScan(heap, index, indexInfo, true,
+									   gistBuildCallback, (void *) &buildstate);
+
+		/*
+		 * If buffering was used, flush out all the tuples that are still in
+		 * the buffers.
+		 */
+		if (buildstate.bufferingMode == GIST_BUFFERING_ACTIVE)
+		{
+			elog(DEBUG1, "all tuples processed, emptying buffers");
+			gistEmptyAllBuffers(&buildstate);
+			gistFreeBuildBuffers(buildstate.gfbb);
+		}
 	}
 
 	/* okay, all heap tuples are indexed */
@@ -1201,3 +1291,246 @@ gistGetParent(GISTBuildState *buildstate, BlockNumber child)
 
 	return entry->parentblkno;
 }
+
+/*-------------------------------------------------------------------------
+ * Routines for the sorted build
+ *-------------------------------------------------------------------------
+ */
+
+/*
+ * Per-tuple callback from IndexBuildHeapScan, in sorted build mode.
+ */
+static void
+gistSortedBuildCallback(Relation index,
+						HeapTuple htup,
+						Datum *values,
+						bool *isnull,
+						bool tupleIsAlive,
+						void *state)
+{
+	GISTBuildState *buildstate = (GISTBuildState *) state;
+	MemoryContext oldCtx;
+	Datum		compressed_values[INDEX_MAX_KEYS];
+
+	oldCtx = MemoryContextSwitchTo(buildstate->giststate->tempCxt);
+
+	/* Form an index tuple and point it at the heap tuple */
+	gistCompressValues(buildstate->giststate, index,
+					   values, isnull,
+					   true, compressed_values);
+
+	tuplesort_putindextuplevalues(buildstate->sortstate,
+								  buildstate->indexrel,
+								  &htup->t_self,
+								  compressed_values, isnull);
+
+	MemoryContextSwitchTo(oldCtx);
+	MemoryContextReset(buildstate->giststate->tempCxt);
+
+	/* Update tuple count. */
+	buildstate->indtuples += 1;
+}
+
+/*
+ * Build GiST index from bottom up from pre-sorted tuples.
+ *
+ * Leaf pages are filled with the sorted tuples in order, up to the fillfactor.
+ * Whenever a page fills up, it is written out, and a downlink holding the
+ * union of its keys is added to the page on the next level up, which is
+ * handled the same way.  Finally, the single page left on the topmost level
+ * becomes the root.
+ *
+ * The pages are written directly with smgr, bypassing shared buffers, like
+ * the btree build does.  Block 0 is reserved for the root, which is written
+ * last.
+ */
+static void
+gist_indexsortbuild(GISTBuildState *state)
+{
+	IndexTuple	itup;
+	GistSortedBuildPageState *leafstate;
+	GistSortedBuildPageState *pagestate;
+	Page		page;
+	bool		should_free;
+
+	/* Ensure rd_smgr is open (could have been closed by relcache flush!) */
+	RelationOpenSmgr(state->indexrel);
+
+	/*
+	 * Write an empty page as a placeholder for the root page.  It will be
+	 * replaced with the real root page at the end.  Don't bother to
+	 * WAL-log or checksum it.
+	 */
+	page = (Page) palloc0(BLCKSZ);
+	smgrextend(state->indexrel->rd_smgr, MAIN_FORKNUM, GIST_ROOT_BLKNO,
+			   (char *) page, true);
+	pfree(page);
+	state->pages_allocated = 1;
+
+	/* Allocate a temporary buffer for the first leaf page. */
+	leafstate = palloc(sizeof(GistSortedBuildPageState));
+	leafstate->page = (Page) palloc(BLCKSZ);
+	leafstate->parent = NULL;
+	gistinitpage(leafstate->page, F_LEAF);
+
+	/*
+	 * Fill index pages with tuples in the sorted order.
+	 */
+	while ((itup = tuplesort_getindextuple(state->sortstate, true,
+										   &should_free)) != NULL)
+	{
+		gist_indexsortbuild_pagestate_add(state, leafstate, itup);
+		MemoryContextReset(state->giststate->tempCxt);
+
+		if (should_free)
+			pfree(itup);
+	}
+
+	/*
+	 * Write out the partially full non-root pages.  Each flush adds a
+	 * downlink to the level above, which may overflow and create yet another
+	 * level, so the loop keeps going until we reach the topmost level.
+	 */
+	pagestate = leafstate;
+	while (pagestate->parent != NULL)
+	{
+		GistSortedBuildPageState *parent;
+
+		gist_indexsortbuild_pagestate_flush(state, pagestate);
+		parent = pagestate->parent;
+		pfree(pagestate->page);
+		pfree(pagestate);
+		pagestate = parent;
+	}
+
+	/* The topmost level has a single page; write it out as the root */
+	gist_indexsortbuild_writepage(state, pagestate->page, GIST_ROOT_BLKNO);
+	pfree(pagestate->page);
+	pfree(pagestate);
+
+	/*
+	 * When we WAL-logged index pages, we must nonetheless fsync index files.
+	 * Since we're building outside shared buffers, a CHECKPOINT occurring
+	 * during the build has no way to flush the previously written data to
+	 * disk (indeed it won't know the index even exists).  A crash later on
+	 * would replay WAL from the checkpoint, therefore it wouldn't replay our
+	 * earlier WAL entries. If we do not fsync those pages here, they might
+	 * still not be on disk when the crash occurs.
+	 */
+	if (RelationNeedsWAL(state->indexrel))
+	{
+		RelationOpenSmgr(state->indexrel);
+		smgrimmedsync(state->indexrel->rd_smgr, MAIN_FORKNUM);
+	}
+}
+
+/*
+ * Add tuple to a page.  If the page doesn't have room for it, the page is
+ * flushed first, and the tuple goes to a fresh page.
+ */
+static void
+gist_indexsortbuild_pagestate_add(GISTBuildState *state,
+								  GistSortedBuildPageState *pagestate,
+								  IndexTuple itup)
+{
+	/* Does the tuple fit? If not, flush (an empty page always takes it) */
+	if (!PageIsEmpty(pagestate->page) &&
+		gistnospace(pagestate->page, &itup, 1, InvalidOffsetNumber,
+					state->freespace))
+		gist_indexsortbuild_pagestate_flush(state, pagestate);
+
+	gistfillbuffer(pagestate->page, &itup, 1, InvalidOffsetNumber);
+}
+
+/*
+ * Write out the page of the given level, and insert a downlink for it to the
+ * parent level, creating the parent level if necessary.  The in-memory page
+ * is reinitialized to receive more tuples.
+ */
+static void
+gist_indexsortbuild_pagestate_flush(GISTBuildState *state,
+									GistSortedBuildPageState *pagestate)
+{
+	GistSortedBuildPageState *parent;
+	IndexTuple *itvec;
+	IndexTuple	union_tuple;
+	int			vect_len;
+	bool		isleaf;
+	BlockNumber blkno;
+	MemoryContext oldCtx;
+
+	/* check once per page */
+	CHECK_FOR_INTERRUPTS();
+
+	/*
+	 * Compute the downlink, in the temporary context.  It's reset by our
+	 * caller once per leaf tuple, so the downlinks of a whole cascade of
+	 * flushes stay valid until they have been copied to the parent pages.
+	 */
+	oldCtx = MemoryContextSwitchTo(state->giststate->tempCxt);
+
+	itvec = gistextractpage(pagestate->page, &vect_len);
+	union_tuple = gistunion(state->indexrel, itvec, vect_len,
+							state->giststate);
+
+	MemoryContextSwitchTo(oldCtx);
+
+	/* Assign the next block number, and point the downlink to it */
+	blkno = state->pages_allocated++;
+	ItemPointerSetBlockNumber(&(union_tuple->t_tid), blkno);
+
+	isleaf = GistPageIsLeaf(pagestate->page);
+	gist_indexsortbuild_writepage(state, pagestate->page, blkno);
+
+	/* Start a new page on this level */
+	gistinitpage(pagestate->page, isleaf ? F_LEAF : 0);
+
+	/* Insert the downlink to the parent page, creating the level if needed */
+	parent = pagestate->parent;
+	if (parent == NULL)
+	{
+		parent = palloc(sizeof(GistSortedBuildPageState));
+		parent->page = (Page) palloc(BLCKSZ);
+		parent->parent = NULL;
+		gistinitpage(parent->page, 0);
+
+		pagestate->parent = parent;
+	}
+	gist_indexsortbuild_pagestate_add(state, parent, union_tuple);
+}
+
+/*
+ * Write out one page of the sorted build.
+ *
+ * Each page must carry a valid LSN, because scans and inserts compare the
+ * LSN of a parent page with the NSN of its children to detect concurrent
+ * splits.  WAL-logging the page sets it; for unlogged and temporary indexes
+ * we use a fake LSN, as elsewhere in GiST.
+ */
+static void
+gist_indexsortbuild_writepage(GISTBuildState *state, Page page,
+							  BlockNumber blkno)
+{
+	Relation	index = state->indexrel;
+
+	/* Ensure rd_smgr is open (could have been closed by relcache flush!) */
+	RelationOpenSmgr(index);
+
+	if (RelationNeedsWAL(index))
+		log_newpage(&index->rd_node, MAIN_FORKNUM, blkno, page, true);
+	else
+		PageSetLSN(page, gistGetFakeLSN(index));
+
+	PageSetChecksumInplace(page, blkno);
+
+	/*
+	 * Pages are written in order of increasing block number, except for the
+	 * root, whose placeholder we overwrite at the very end.  There's no need
+	 * for smgr to schedule an fsync for these writes; we'll do it ourselves
+	 * before ending the build.
+	 */
+	if (blkno == GIST_ROOT_BLKNO)
+		smgrwrite(index->rd_smgr, MAIN_FORKNUM, blkno, (char *) page, true);
+	else
+		smgrextend(index->rd_smgr, MAIN_FORKNUM, blkno, (char *) page, true);
+}
@@ -17,9 +17,12 @@
  */
 #include "postgres.h"
 
+#include <math.h>
+
 #include "access/gist.h"
 #include "access/skey.h"
 #include "utils/geo_decls.h"
+#include "utils/sortsupport.h"
 
 
 static bool gist_box_leaf_consistent(BOX *key, BOX *query,
@@ -1186,6 +1189,182 @@ gist_point_compress(PG_FUNCTION_ARGS)
 	PG_RETURN_POINTER(entry);
 }
 
+/*
+ * GiST Fetch method for point
+ *
+ * Get point coordinates from its bounding box coordinates and form new
+ * gistentry.
+ */
+Datum
+gist_point_fetch(PG_FUNCTION_ARGS)
+{
+	GISTENTRY  *entry = (GISTENTRY *) PG_GETARG_POINTER(0);
+	BOX		   *in = DatumGetBoxP(entry->key);
+	Point	   *r;
+	GISTENTRY  *retval;
+
+	retval = palloc(sizeof(GISTENTRY));
+
+	r = (Point *) palloc(sizeof(Point));
+	r->x = in->high.x;
+	r->y = in->high.y;
+	gistentryinit(*retval, PointerGetDatum(r),
+				  entry->rel, entry->page,
+				  entry->offset, FALSE);
+
+	PG_RETURN_POINTER(retval);
+}
+
+/*
+ * Z-order routines for the sorted GiST build of points
+ *
+ * A Z-order (Morton) curve interleaves the bits of the X and Y coordinates,
+ * so that points which are close to each other in the plane are mostly also
+ * close to each other in the sort order.  Packing leaf pages in that order
+ * gives pages with small, mostly non-overlapping bounding boxes.
+ *
+ * The coordinates are converted to float4 first: we only need a good
+ * clustering, not an exact ordering, and that lets us interleave the two
+ * coordinates into a single 64-bit integer.
+ */
+
+/* Spread the bits of a 32-bit integer into the even bits of a 64-bit one */
+static uint64
+part_bits32_by2(uint32 x)
+{
+	uint64		n = x;
+
+	n = (n | (n << 16)) & UINT64CONST(0x0000FFFF0000FFFF);
+	n = (n | (n << 8)) & UINT64CONST(0x00FF00FF00FF00FF);
+	n = (n | (n << 4)) & UINT64CONST(0x0F0F0F0F0F0F0F0F);
+	n = (n | (n << 2)) & UINT64CONST(0x3333333333333333);
+	n = (n | (n << 1)) & UINT64CONST(0x5555555555555555);
+
+	return n;
+}
+
+/*
+ * Map a float4 to a uint32, so that the integers sort in the same order as
+ * the floats.  NaNs sort after everything else.
+ */
+static uint32
+ieee_float32_to_uint32(float f)
+{
+	union
+	{
+		float		f;
+		uint32		i;
+	}			u;
+
+	if (isnan(f))
+		return 0xFFFFFFFF;
+
+	u.f = f;
+	if ((u.i & 0x80000000) != 0)
+	{
+		/* map negative values (and -0) to range 0 - 7FFFFFFF */
+		u.i ^= 0xFFFFFFFF;
+	}
+	else
+	{
+		/* map positive values (and +0) to range 80000000 - FFFFFFFF */
+		u.i |= 0x80000000;
+	}
+
+	return u.i;
+}
+
+static uint64
+point_zorder_internal(float4 x, float4 y)
+{
+	uint32		ix = ieee_float32_to_uint32(x);
+	uint32		iy = ieee_float32_to_uint32(y);
+
+	/* Interleave the bits */
+	return part_bits32_by2(ix) | (part_bits32_by2(iy) << 1);
+}
+
+/*
+ * Compare two stored point keys (degenerate boxes) in Z-order
+ */
+static int
+gist_bbox_zorder_cmp(Datum a, Datum b, SortSupport ssup)
+{
+	Point	   *p1 = &(DatumGetBoxP(a)->low);
+	Point	   *p2 = &(DatumGetBoxP(b)->low);
+	uint64		z1;
+	uint64		z2;
+
+	/* Do a quick check for equality first */
+	if (p1->x == p2->x && p1->y == p2->y)
+		return 0;
+
+	z1 = point_zorder_internal(p1->x, p1->y);
+	z2 = point_zorder_internal(p2->x, p2->y);
+	if (z1 > z2)
+		return 1;
+	else if (z1 < z2)
+		return -1;
+	else
+		return 0;
+}
+
+#if SIZEOF_DATUM >= 8
+
+/*
+ * Abbreviated key support: the Z-order value itself is the abbreviated key.
+ * It's not a lossy representation of our comparison order, so the abbreviated
+ * comparisons are authoritative, and there's never a reason to abort.
+ */
+static Datum
+gist_bbox_zorder_abbrev_convert(Datum original, SortSupport ssup)
+{
+	Point	   *p = &(DatumGetBoxP(original)->low);
+
+	return (Datum) point_zorder_internal(p->x, p->y);
+}
+
+static int
+gist_bbox_zorder_cmp_abbrev(Datum z1, Datum z2, SortSupport ssup)
+{
+	if (z1 > z2)
+		return 1;
+	else if (z1 < z2)
+		return -1;
+	else
+		return 0;
+}
+
+static bool
+gist_bbox_zorder_abbrev_abort(int memtupcount, SortSupport ssup)
+{
+	return false;
+}
+#endif
+
+/*
+ * GiST SortSupport method for points, used by the sorted index build
+ */
+Datum
+gist_point_sortsupport(PG_FUNCTION_ARGS)
+{
+	SortSupport ssup = (SortSupport) PG_GETARG_POINTER(0);
+
+#if SIZEOF_DATUM >= 8
+	if (ssup->abbreviate)
+	{
+		ssup->comparator = gist_bbox_zorder_cmp_abbrev;
+		ssup->abbrev_converter = gist_bbox_zorder_abbrev_convert;
+		ssup->abbrev_abort = gist_bbox_zorder_abbrev_abort;
+		ssup->abbrev_full_comparator = gist_bbox_zorder_cmp;
+	}
+	else
+#endif
+		ssup->comparator = gist_bbox_zorder_cmp;
+
+	PG_RETURN_VOID();
+}
+
 #define point_point_distance(p1,p2) \
 	DatumGetFloat8(DirectFunctionCall2(point_distance, \
 									   PointPGetDatum(p1), PointPGetDatum(p2)))
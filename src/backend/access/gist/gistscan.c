@@ -17,6 +17,7 @@
 #include "access/gist_private.h"
 #include "access/gistscan.h"
 #include "access/relscan.h"
+#include "catalog/pg_type.h"
 #include "utils/memutils.h"
 #include "utils/rel.h"
 
@@ -48,6 +49,34 @@ pairingheap_GISTSearchItem_cmp(const pairingheap_node *a, const pairingheap_node
 	return 0;
 }
 
+/*
+ * Build the tuple descriptor for tuples returned by an index-only scan.
+ *
+ * The index's own tuple descriptor describes the stored keys, whose type is
+ * the opclass's storage type (for example, point_ops stores boxes).  The
+ * Fetch methods reconstruct the original values, so the descriptor we hand
+ * back to the executor must carry the opclass input type instead.  If that
+ * is polymorphic, the storage type is the same as the column type anyway.
+ */
+static TupleDesc
+gistBuildFetchTupdesc(Relation index)
+{
+	TupleDesc	fetchTupdesc = CreateTupleDescCopy(RelationGetDescr(index));
+	int			i;
+
+	for (i = 0; i < fetchTupdesc->natts; i++)
+	{
+		Oid			opcintype = index->rd_opcintype[i];
+
+		if (fetchTupdesc->attrs[i]->atttypid != opcintype &&
+			!IsPolymorphicType(opcintype))
+			TupleDescInitEntry(fetchTupdesc, (AttrNumber) (i + 1), NULL,
+							   opcintype, -1, 0);
+	}
+
+	return fetchTupdesc;
+}
+
 
 /*
  * Index AM API functions for scanning GiST indexes
@@ -85,6 +114,7 @@ gistbeginscan(PG_FUNCTION_ARGS)
 	/* workspaces with size dependent on numberOfOrderBys: */
 	so->distances = palloc(sizeof(double) * scan->numberOfOrderBys);
 	so->qual_ok = true;			/* in case there are zero keys */
+	so->pageDataCxt = NULL;		/* see gistrescan */
 
 	scan->opaque = so;
 
@@ -108,6 +138,19 @@ gistrescan(PG_FUNCTION_ARGS)
 
 	/* rescan an existing indexscan --- reset state */
 
+	/*
+	 * Release the last tuple returned by an index-only scan.  In an ordered
+	 * scan it was palloc'd separately, and getNextNearest would have freed it
+	 * on the next call; this must be done before the queue memory is reset
+	 * below.  Otherwise it lives in pageDataCxt, which is reset as a whole.
+	 */
+	if (scan->xs_itup)
+	{
+		if (scan->numberOfOrderBys > 0)
+			pfree(scan->xs_itup);
+		scan->xs_itup = NULL;
+	}
+
 	/*
 	 * The first time through, we create the search queue in the scanCxt.
 	 * Subsequent times through, we create the queue in a separate queueCxt,
@@ -141,6 +184,26 @@ gistrescan(PG_FUNCTION_ARGS)
 		first_time = false;
 	}
 
+	/*
+	 * In an index-only scan, also set up a context for the tuples fetched
+	 * back from leaf pages, and the descriptor they are formed with.  We
+	 * can't do this in gistbeginscan, because xs_want_itup isn't set yet at
+	 * that point.
+	 */
+	if (scan->xs_want_itup && so->pageDataCxt == NULL)
+	{
+		oldCxt = MemoryContextSwitchTo(so->giststate->scanCxt);
+		so->giststate->fetchTupdesc = gistBuildFetchTupdesc(scan->indexRelation);
+		MemoryContextSwitchTo(oldCxt);
+
+		so->pageDataCxt = AllocSetContextCreate(so->giststate->scanCxt,
+												"GiST page data context",
+												ALLOCSET_DEFAULT_MINSIZE,
+												ALLOCSET_DEFAULT_INITSIZE,
+												ALLOCSET_DEFAULT_MAXSIZE);
+		scan->xs_itupdesc = so->giststate->fetchTupdesc;
+	}
+
 	/* create new, empty RBTree for search queue */
 	oldCxt = MemoryContextSwitchTo(so->queueCxt);
 	so->queue = pairingheap_allocate(pairingheap_GISTSearchItem_cmp, scan);
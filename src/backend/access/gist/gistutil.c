@@ -589,33 +589,99 @@ IndexTuple
 gistFormTuple(GISTSTATE *giststate, Relation r,
 			  Datum attdata[], bool isnull[], bool newValues)
 {
-	GISTENTRY	centry[INDEX_MAX_KEYS];
 	Datum		compatt[INDEX_MAX_KEYS];
-	int			i;
 	IndexTuple	res;
 
+	gistCompressValues(giststate, r, attdata, isnull, newValues, compatt);
+
+	res = index_form_tuple(giststate->tupdesc, compatt, isnull);
+
+	/*
+	 * The offset number on tuples on internal pages is unused. For historical
+	 * reasons, it is set 0xffff.
+	 */
+	ItemPointerSetOffsetNumber(&(res->t_tid), 0xffff);
+	return res;
+}
+
+/*
+ * Call the compress method on each non-null attribute, storing the
+ * compressed keys into compatt[].  This is the first half of gistFormTuple,
+ * split out for the benefit of the sorted index build, which needs the
+ * compressed values rather than a finished tuple.
+ */
+void
+gistCompressValues(GISTSTATE *giststate, Relation r,
+				   Datum attdata[], bool isnull[], bool newValues,
+				   Datum compatt[])
+{
+	int			i;
+
 	for (i = 0; i < r->rd_att->natts; i++)
 	{
 		if (isnull[i])
 			compatt[i] = (Datum) 0;
 		else
 		{
-			gistcentryinit(giststate, i, &centry[i], attdata[i],
+			GISTENTRY	centry;
+
+			gistcentryinit(giststate, i, &centry, attdata[i],
 						   r, NULL, (OffsetNumber) 0,
 						   newValues,
 						   FALSE);
-			compatt[i] = centry[i].key;
+			compatt[i] = centry.key;
 		}
 	}
+}
 
-	res = index_form_tuple(giststate->tupdesc, compatt, isnull);
+/*
+ * Reconstruct the originally-indexed value of one key using the opclass's
+ * Fetch method
+ */
+static Datum
+gistFetchAtt(GISTSTATE *giststate, int nkey, Datum k, Relation r)
+{
+	GISTENTRY	fentry;
+	GISTENTRY  *fep;
 
-	/*
-	 * The offset number on tuples on internal pages is unused. For historical
-	 * reasons, it is set 0xffff.
-	 */
-	ItemPointerSetOffsetNumber(&(res->t_tid), 0xffff);
-	return res;
+	gistentryinit(fentry, k, r, NULL, (OffsetNumber) 0, false);
+
+	fep = (GISTENTRY *)
+		DatumGetPointer(FunctionCall1Coll(&giststate->fetchFn[nkey],
+										  giststate->supportCollation[nkey],
+										  PointerGetDatum(&fentry)));
+
+	/* fetchFn set 'key', return it to the caller */
+	return fep->key;
+}
+
+/*
+ * Fetch all keys in tuple, for an index-only scan.
+ * Returns a new IndexTuple, formed with giststate->fetchTupdesc, containing
+ * the originally-indexed data.
+ */
+IndexTuple
+gistFetchTuple(GISTSTATE *giststate, Relation r, IndexTuple tuple)
+{
+	MemoryContext oldcxt = MemoryContextSwitchTo(giststate->tempCxt);
+	Datum		fetchatt[INDEX_MAX_KEYS];
+	bool		isnull[INDEX_MAX_KEYS];
+	int			i;
+
+	for (i = 0; i < r->rd_att->natts; i++)
+	{
+		Datum		datum;
+
+		datum = index_getattr(tuple, i + 1, giststate->tupdesc, &isnull[i]);
+
+		if (isnull[i])
+			fetchatt[i] = (Datum) 0;
+		else
+			fetchatt[i] = gistFetchAtt(giststate, i, datum, r);
+	}
+	MemoryContextSwitchTo(oldcxt);
+
+	return index_form_tuple(giststate->fetchTupdesc, fetchatt, isnull);
 }
 
 float
@@ -653,14 +719,20 @@ gistpenalty(GISTSTATE *giststate, int attno,
  */
 void
 GISTInitBuffer(Buffer b, uint32 f)
+{
+	gistinitpage(BufferGetPage(b), f);
+}
+
+/*
+ * Initialize a new index page that is not (yet) in a shared buffer, as
+ * used by the sorted index build
+ */
+void
+gistinitpage(Page page, uint32 f)
 {
 	GISTPageOpaque opaque;
-	Page		page;
-	Size		pageSize;
 
-	pageSize = BufferGetPageSize(b);
-	page = BufferGetPage(b);
-	PageInit(page, pageSize, sizeof(GISTPageOpaqueData));
+	PageInit(page, BLCKSZ, sizeof(GISTPageOpaqueData));
 
 	opaque = GistPageGetOpaque(page);
 	/* page was already zeroed by PageInit, so this is not needed: */
@@ -807,11 +879,12 @@ gistGetFakeLSN(Relation rel)
 {
 	static XLogRecPtr counter = 1;
 
-	if (rel->rd_rel->relpersistence == RELPERSISTENCE_TEMP)
+	if (RelationUsesLocalBuffers(rel))
 	{
 		/*
 		 * Temporary relations are only accessible in our session, so a simple
-		 * backend-local counter will do.
+		 * backend-local counter will do.  The same goes for our own storage
+		 * of a global temporary relation.
 		 */
 		return counter++;
 	}
@@ -56,7 +56,9 @@
 #include "catalog/namespace.h"
 #include "miscadmin.h"
 #include "pgstat.h"
+#include "storage/aio.h"
 #include "storage/bufmgr.h"
+#include "storage/fd.h"
 #include "storage/freespace.h"
 #include "storage/lmgr.h"
 #include "storage/predicate.h"
@@ -75,12 +77,20 @@
 /* GUC variable */
 bool		synchronize_seqscans = true;
 
+/*
+ * Number of pages a sequential scan reads ahead when direct I/O is used for
+ * data files, in which case the kernel's readahead doesn't happen.  This is
+ * 128kB with the default block size, the same as Linux's default readahead.
+ */
+#define HEAP_READAHEAD_PAGES	16
+
 
 static HeapScanDesc heap_beginscan_internal(Relation relation,
 						Snapshot snapshot,
 						int nkeys, ScanKey key,
 						bool allow_strat, bool allow_sync,
 						bool is_bitmapscan, bool temp_snap);
+static void heapreadahead(HeapScanDesc scan, BlockNumber page);
 static HeapTuple heap_prepare_insert(Relation relation, HeapTuple tup,
 					TransactionId xid, CommandId cid, int options);
 static XLogRecPtr log_heap_update(Relation reln, Buffer oldbuf,
@@ -282,6 +292,7 @@ initscan(HeapScanDesc scan, ScanKey key, bool is_rescan)
 	ItemPointerSetInvalid(&scan->rs_ctup.t_self);
 	scan->rs_cbuf = InvalidBuffer;
 	scan->rs_cblock = InvalidBlockNumber;
+	scan->rs_readahead = 0;
 
 	/* page-at-a-time fields are always invalid when not rs_inited */
 
@@ -307,6 +318,42 @@ heap_setscanlimits(HeapScanDesc scan, BlockNumber startBlk, BlockNumber numBlks)
 	scan->rs_numblocks = numBlks;
 }
 
+/*
+ * heapreadahead - prefetch the pages a forward scan will visit next
+ *
+ * rs_readahead is the position, counted in scan order from rs_startblock,
+ * up to which pages have already been prefetched.  We keep it up to
+ * HEAP_READAHEAD_PAGES ahead of the page about to be read.  Backward scans
+ * only ever see pages behind that point, so they get no readahead.
+ */
+static void
+heapreadahead(HeapScanDesc scan, BlockNumber page)
+{
+	BlockNumber pos;
+	BlockNumber limit;
+
+	/* position of this page in scan order */
+	if (page >= scan->rs_startblock)
+		pos = page - scan->rs_startblock;
+	else
+		pos = page + scan->rs_nblocks - scan->rs_startblock;
+
+	if (scan->rs_readahead <= pos)
+		scan->rs_readahead = pos + 1;
+
+	/* don't go past the end of the scan */
+	limit = Min(pos + 1 + HEAP_READAHEAD_PAGES, scan->rs_nblocks);
+	if (scan->rs_numblocks != InvalidBlockNumber)
+		limit = Min(limit, pos + scan->rs_numblocks);
+
+	/* the I/O workers read the pages with the same kind of ring we use */
+	for (; scan->rs_readahead < limit; scan->rs_readahead++)
+		PrefetchBufferExtended(scan->rs_rd, MAIN_FORKNUM,
+							   (scan->rs_startblock + scan->rs_readahead) %
+							   scan->rs_nblocks,
+							   scan->rs_strategy ? BAS_BULKREAD : BAS_NORMAL);
+}
+
 /*
  * heapgetpage - subroutine for heapgettup()
  *
@@ -342,6 +389,13 @@ heapgetpage(HeapScanDesc scan, BlockNumber page)
 	 */
 	CHECK_FOR_INTERRUPTS();
 
+	/*
+	 * With direct I/O, nobody else will read ahead for us; have the I/O
+	 * workers do it.
+	 */
+	if ((direct_io & DIRECT_IO_DATA) && io_workers > 0 && !scan->rs_bitmapscan)
+		heapreadahead(scan, page);
+
 	/* read page using selected strategy */
 	scan->rs_cbuf = ReadBufferExtended(scan->rs_rd, MAIN_FORKNUM, page,
 									   RBM_NORMAL, scan->rs_strategy);
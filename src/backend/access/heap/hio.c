@@ -97,6 +97,86 @@ ReadBufferBI(Relation relation, BlockNumber targetBlock,
 	return buffer;
 }
 
+/*
+ * Extend a relation by multiple blocks to avoid future contention on the
+ * relation extension lock.  Our caller holds that lock and has seen others
+ * waiting for it; we add a number of blocks proportional to the number of
+ * waiters, initialize them and enter them into the FSM, so that the waiters
+ * find a page there rather than each extending the relation in turn.
+ *
+ * The blocks are added to the file in one smgrzeroextend() call, which
+ * is much cheaper than extending it one page at a time.
+ */
+static void
+RelationAddExtraBlocks(Relation relation, BulkInsertState bistate)
+{
+	BlockNumber firstBlock,
+				blockNum;
+	int			extraBlocks;
+	int			lockWaiters;
+
+	/* Use the length of the lock wait queue to judge how much to extend. */
+	lockWaiters = RelationExtensionLockWaiterCount(relation);
+	if (lockWaiters <= 0)
+		return;
+
+	/*
+	 * Give each waiter enough pages to go on inserting for a while, rather
+	 * than just the one page it is waiting for; otherwise the waiters queue
+	 * up for the lock again as soon as each of them has filled a page.  The
+	 * cap of 512 blocks bounds the time we hold the lock initializing pages,
+	 * and the space added beyond what is needed right away.
+	 */
+	extraBlocks = Min(512, lockWaiters * 20);
+
+	RelationOpenSmgr(relation);
+	firstBlock = smgrnblocks(relation->rd_smgr, MAIN_FORKNUM);
+	smgrzeroextend(relation->rd_smgr, MAIN_FORKNUM, firstBlock, extraBlocks,
+				   false);
+
+	for (blockNum = firstBlock; blockNum < firstBlock + extraBlocks; blockNum++)
+	{
+		Buffer		buffer;
+		Page		page;
+		Size		freespace;
+
+		/*
+		 * The block is known to be all zeroes on disk, so there is no need to
+		 * read it in.
+		 */
+		buffer = ReadBufferExtended(relation, MAIN_FORKNUM, blockNum,
+									RBM_ZERO_AND_LOCK,
+									bistate ? bistate->strategy : NULL);
+		page = BufferGetPage(buffer);
+
+		if (!PageIsNew(page))
+			elog(ERROR, "page %u of relation \"%s\" should be empty but is not",
+				 blockNum, RelationGetRelationName(relation));
+
+		PageInit(page, BufferGetPageSize(buffer), 0);
+
+		/*
+		 * We mark all the new buffers dirty, but do nothing to write them
+		 * out; they'll probably get used soon, and even if they are not, a
+		 * crash will leave an okay all-zeroes page on disk.
+		 */
+		MarkBufferDirty(buffer);
+
+		freespace = PageGetHeapFreeSpace(page);
+		UnlockReleaseBuffer(buffer);
+
+		RecordPageWithFreeSpace(relation, blockNum, freespace);
+	}
+
+	/*
+	 * Updating the upper levels of the free space map is too expensive to do
+	 * for every block, but it's worth doing once at the end to make sure that
+	 * subsequent insertion activity sees all of those nifty free pages we
+	 * just inserted.
+	 */
+	FreeSpaceMapVacuum(relation);
+}
+
 /*
  * For each heap page which is all-visible, acquire a pin on the appropriate
  * visibility map page, if we haven't already got one.
@@ -295,6 +375,7 @@ RelationGetBufferForTuple(Relation relation, Size len,
 		}
 	}
 
+loop:
 	while (targetBlock != InvalidBlockNumber)
 	{
 		/*
@@ -427,14 +508,45 @@ RelationGetBufferForTuple(Relation relation, Size len,
 	 */
 	needLock = !RELATION_IS_LOCAL(relation);
 
+	/*
+	 * If we need the lock but are not able to acquire it immediately, we'll
+	 * consider extending the relation by multiple blocks at a time to manage
+	 * contention on the relation extension lock.  However, this only makes
+	 * sense if we're using the FSM; otherwise, there's no point.
+	 */
 	if (needLock)
-		LockRelationForExtension(relation, ExclusiveLock);
+	{
+		if (!use_fsm)
+			LockRelationForExtension(relation, ExclusiveLock);
+		else if (!ConditionalLockRelationForExtension(relation, ExclusiveLock))
+		{
+			/* Couldn't get the lock immediately; wait for it. */
+			LockRelationForExtension(relation, ExclusiveLock);
+
+			/*
+			 * Check if some other backend has extended a block for us while
+			 * we were waiting on the lock.
+			 */
+			targetBlock = GetPageWithFreeSpace(relation, len + saveFreeSpace);
+
+			/*
+			 * If some other waiter has already extended the relation, we
+			 * don't need to do so; just use the existing freespace.
+			 */
+			if (targetBlock != InvalidBlockNumber)
+			{
+				UnlockRelationForExtension(relation, ExclusiveLock);
+				goto loop;
+			}
+
+			/* Time to bulk-extend. */
+			RelationAddExtraBlocks(relation, bistate);
+		}
+	}
 
 	/*
-	 * XXX This does an lseek - rather expensive - but at the moment it is the
-	 * only way to accurately determine how many blocks are in a relation.  Is
-	 * it worth keeping an accurate file length in shared memory someplace,
-	 * rather than relying on the kernel to do it for us?
+	 * This needs the length of the relation, which usually comes from the
+	 * shared relation size cache maintained by smgr.c rather than an lseek.
 	 */
 	buffer = ReadBufferBI(relation, P_NEW, bistate);
 
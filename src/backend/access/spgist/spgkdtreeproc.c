@@ -16,7 +16,7 @@
 #include "postgres.h"
 
 #include "access/gist.h"		/* for RTree strategy numbers */
-#include "access/spgist.h"
+#include "access/spgist_private.h"
 #include "catalog/pg_type.h"
 #include "utils/builtins.h"
 #include "utils/geo_decls.h"
@@ -48,6 +48,34 @@ getSide(double coord, bool isX, Point *tst)
 		return -1;
 }
 
+/*
+ * Get the half-plane covered by one child of a k-d tree inner tuple, as a
+ * box for distance estimation.  Child 0 holds points whose coordinate is
+ * at most coord, child 1 those whose coordinate is at least coord.
+ */
+static void
+getSideBox(double coord, bool isX, int nodeN, BOX *box)
+{
+	double		inf = get_float8_infinity();
+	double		low = (nodeN == 0) ? -inf : coord;
+	double		high = (nodeN == 0) ? coord : inf;
+
+	if (isX)
+	{
+		box->low.x = low;
+		box->high.x = high;
+		box->low.y = -inf;
+		box->high.y = inf;
+	}
+	else
+	{
+		box->low.x = -inf;
+		box->high.x = inf;
+		box->low.y = low;
+		box->high.y = high;
+	}
+}
+
 Datum
 spg_kd_choose(PG_FUNCTION_ARGS)
 {
@@ -250,10 +278,24 @@ spg_kd_inner_consistent(PG_FUNCTION_ARGS)
 	/* We must descend into the children identified by which */
 	out->nodeNumbers = (int *) palloc(sizeof(int) * 2);
 	out->nNodes = 0;
+	if (in->norderbys > 0)
+		out->distances = (double **) palloc(sizeof(double *) * 2);
 	for (i = 1; i <= 2; i++)
 	{
 		if (which & (1 << i))
+		{
+			if (in->norderbys > 0)
+			{
+				BOX			sideBox;
+
+				getSideBox(coord, (in->level % 2) != 0, i - 1, &sideBox);
+				out->distances[out->nNodes] =
+					spg_key_orderbys_distances(BoxPGetDatum(&sideBox),
+											   false,
+											   in->orderbys, in->norderbys);
+			}
 			out->nodeNumbers[out->nNodes++] = i - 1;
+		}
 	}
 
 	/* Set up level increments, too */
@@ -0,0 +1,98 @@
+/*-------------------------------------------------------------------------
+ *
+ * spgproc.c
+ *	  Common supporting procedures for SP-GiST opclasses.
+ *
+ *
+ * Portions Copyright (c) 1996-2015, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * IDENTIFICATION
+ *			src/backend/access/spgist/spgproc.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "access/gist.h"		/* for RTree strategy numbers */
+#include "access/spgist_private.h"
+#include "utils/builtins.h"
+#include "utils/geo_decls.h"
+
+/*
+ * Distance from a point to an axis-aligned box.
+ *
+ * The box may be unbounded on any side (its coordinates may be infinite),
+ * which lets opclasses describe a half-plane or quadrant directly.
+ */
+static double
+point_box_distance(Point *point, BOX *box)
+{
+	double		dx,
+				dy;
+
+	if (point->x < box->low.x)
+		dx = box->low.x - point->x;
+	else if (point->x > box->high.x)
+		dx = point->x - box->high.x;
+	else
+		dx = 0.0;
+
+	if (point->y < box->low.y)
+		dy = box->low.y - point->y;
+	else if (point->y > box->high.y)
+		dy = point->y - box->high.y;
+	else
+		dy = 0.0;
+
+	return HYPOT(dx, dy);
+}
+
+/*
+ * Compute the distances from a point-ops index key to each of the ordering
+ * operators' arguments, for use in an ordered (k-NN) scan.
+ *
+ * For a leaf entry, key is the indexed point and the result is the exact
+ * distance.  For an inner entry, key is a box bounding every point below
+ * that node, and the result is a lower bound on their distances.  A NULL
+ * ordering argument yields an infinite distance.
+ *
+ * The result array is palloc'd in the current memory context.
+ */
+double *
+spg_key_orderbys_distances(Datum key, bool isLeaf,
+						   ScanKey orderbys, int norderbys)
+{
+	double	   *distances = (double *) palloc(sizeof(double) * norderbys);
+	int			i;
+
+	for (i = 0; i < norderbys; i++)
+	{
+		ScanKey		sk = &orderbys[i];
+		Point	   *query;
+
+		if (sk->sk_strategy != RTKNNSearchStrategyNumber)
+			elog(ERROR, "unrecognized order-by strategy number: %d",
+				 sk->sk_strategy);
+
+		if (sk->sk_flags & SK_ISNULL)
+		{
+			distances[i] = get_float8_infinity();
+			continue;
+		}
+
+		query = DatumGetPointP(sk->sk_argument);
+
+		if (isLeaf)
+		{
+			Point	   *point = DatumGetPointP(key);
+
+			distances[i] = HYPOT(point->x - query->x, point->y - query->y);
+		}
+		else
+			distances[i] = point_box_distance(query, DatumGetBoxP(key));
+	}
+
+	return distances;
+}
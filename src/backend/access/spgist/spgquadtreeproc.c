@@ -16,7 +16,7 @@
 #include "postgres.h"
 
 #include "access/gist.h"		/* for RTree strategy numbers */
-#include "access/spgist.h"
+#include "access/spgist_private.h"
 #include "catalog/pg_type.h"
 #include "utils/builtins.h"
 #include "utils/geo_decls.h"
@@ -77,6 +77,50 @@ getQuadrant(Point *centroid, Point *tst)
 	return 0;
 }
 
+/*
+ * Get the box covering a quadrant of the centroid, for distance estimation.
+ *
+ * The box is unbounded on its outer sides.  Its inner sides are pushed
+ * outwards by EPSILON, since getQuadrant's fuzzy comparisons can place a
+ * point lying just across an axis into this quadrant.
+ */
+static void
+getQuadrantBox(Point *centroid, int quadrant, BOX *box)
+{
+	double		inf = get_float8_infinity();
+
+	switch (quadrant)
+	{
+		case 1:
+			box->low.x = centroid->x - EPSILON;
+			box->high.x = inf;
+			box->low.y = centroid->y - EPSILON;
+			box->high.y = inf;
+			break;
+		case 2:
+			box->low.x = centroid->x - EPSILON;
+			box->high.x = inf;
+			box->low.y = -inf;
+			box->high.y = centroid->y + EPSILON;
+			break;
+		case 3:
+			box->low.x = -inf;
+			box->high.x = centroid->x + EPSILON;
+			box->low.y = -inf;
+			box->high.y = centroid->y + EPSILON;
+			break;
+		case 4:
+			box->low.x = -inf;
+			box->high.x = centroid->x + EPSILON;
+			box->low.y = centroid->y - EPSILON;
+			box->high.y = inf;
+			break;
+		default:
+			elog(ERROR, "getQuadrantBox: impossible case");
+			break;
+	}
+}
+
 
 Datum
 spg_quad_choose(PG_FUNCTION_ARGS)
@@ -209,6 +253,17 @@ spg_quad_inner_consistent(PG_FUNCTION_ARGS)
 		out->nodeNumbers = (int *) palloc(sizeof(int) * in->nNodes);
 		for (i = 0; i < in->nNodes; i++)
 			out->nodeNumbers[i] = i;
+
+		/*
+		 * The nodes' points can lie anywhere in the parent's region, so we
+		 * have no better distance bound than the parent's; report zero.
+		 */
+		if (in->norderbys > 0)
+		{
+			out->distances = (double **) palloc(sizeof(double *) * in->nNodes);
+			for (i = 0; i < in->nNodes; i++)
+				out->distances[i] = (double *) palloc0(sizeof(double) * in->norderbys);
+		}
 		PG_RETURN_VOID();
 	}
 
@@ -289,10 +344,24 @@ spg_quad_inner_consistent(PG_FUNCTION_ARGS)
 	/* We must descend into the quadrant(s) identified by which */
 	out->nodeNumbers = (int *) palloc(sizeof(int) * 4);
 	out->nNodes = 0;
+	if (in->norderbys > 0)
+		out->distances = (double **) palloc(sizeof(double *) * 4);
 	for (i = 1; i <= 4; i++)
 	{
 		if (which & (1 << i))
+		{
+			if (in->norderbys > 0)
+			{
+				BOX			quadrantBox;
+
+				getQuadrantBox(centroid, i, &quadrantBox);
+				out->distances[out->nNodes] =
+					spg_key_orderbys_distances(BoxPGetDatum(&quadrantBox),
+											   false,
+											   in->orderbys, in->norderbys);
+			}
 			out->nodeNumbers[out->nNodes++] = i - 1;
+		}
 	}
 
 	PG_RETURN_VOID();
@@ -356,5 +425,11 @@ spg_quad_leaf_consistent(PG_FUNCTION_ARGS)
 			break;
 	}
 
+	/* Distances to a leaf point are exact */
+	if (res && in->norderbys > 0)
+		out->distances = spg_key_orderbys_distances(in->leafDatum, true,
+													in->orderbys,
+													in->norderbys);
+
 	PG_RETURN_BOOL(res);
 }
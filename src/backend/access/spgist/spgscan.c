@@ -19,6 +19,7 @@
 #include "access/spgist_private.h"
 #include "miscadmin.h"
 #include "storage/bufmgr.h"
+#include "utils/builtins.h"
 #include "utils/datum.h"
 #include "utils/memutils.h"
 #include "utils/rel.h"
@@ -27,13 +28,108 @@
 typedef void (*storeRes_func) (SpGistScanOpaque so, ItemPointer heapPtr,
 								 Datum leafValue, bool isnull, bool recheck);
 
+/*
+ * A to-do item for the scan.  Normally this is an index page (and tuple
+ * offset) still to be visited.  In an ordered scan, it can also be a leaf
+ * tuple that has passed the quals but can't be returned until nothing
+ * closer remains in the queue; then isLeaf is set, ptr is the heap TID,
+ * and reconstructedValue holds the leaf value if one is wanted.
+ */
 typedef struct ScanStackEntry
 {
+	pairingheap_node phNode;	/* pairing heap node, for ordered scans */
 	Datum		reconstructedValue;		/* value reconstructed from parent */
 	int			level;			/* level of items on this page */
 	ItemPointerData ptr;		/* block and offset to scan from */
+	bool		isLeaf;			/* is this a leaf tuple? (ordered scans) */
+	bool		isNull;			/* leaf tuple's value is null */
+	bool		recheck;		/* leaf tuple's quals must be rechecked */
+	double		distances[FLEXIBLE_ARRAY_MEMBER];	/* one per order-by key */
 } ScanStackEntry;
 
+#define SizeOfScanStackEntry(n_distances) \
+	(offsetof(ScanStackEntry, distances) + sizeof(double) * (n_distances))
+
+
+/*
+ * Pairing heap comparison function for the queue of an ordered scan
+ */
+static int
+pairingheap_ScanStackEntry_cmp(const pairingheap_node *a,
+							   const pairingheap_node *b, void *arg)
+{
+	const ScanStackEntry *sa = (const ScanStackEntry *) a;
+	const ScanStackEntry *sb = (const ScanStackEntry *) b;
+	SpGistScanOpaque so = (SpGistScanOpaque) arg;
+	int			i;
+
+	/* Order according to distance comparison */
+	for (i = 0; i < so->numberOfOrderBys; i++)
+	{
+		if (sa->distances[i] != sb->distances[i])
+			return (sa->distances[i] < sb->distances[i]) ? 1 : -1;
+	}
+
+	/* Leaf tuples go before index pages, to ensure a depth-first search */
+	if (sa->isLeaf && !sb->isLeaf)
+		return 1;
+	if (!sa->isLeaf && sb->isLeaf)
+		return -1;
+
+	return 0;
+}
+
+/* Create a ScanStackEntry for the given page, with the given distances */
+static ScanStackEntry *
+newScanStackEntry(SpGistScanOpaque so, BlockNumber blkno, double *distances)
+{
+	ScanStackEntry *stackEntry;
+
+	stackEntry = (ScanStackEntry *)
+		palloc0(SizeOfScanStackEntry(so->numberOfOrderBys));
+	ItemPointerSet(&stackEntry->ptr, blkno, FirstOffsetNumber);
+	if (so->numberOfOrderBys > 0)
+		memcpy(stackEntry->distances, distances,
+			   sizeof(double) * so->numberOfOrderBys);
+	return stackEntry;
+}
+
+/*
+ * Add a ScanStackEntry to the to-do list.  Ordered scans keep it in the
+ * pairing heap; otherwise it goes at the front of the stack, or at the end
+ * if atEnd is true.
+ */
+static void
+pushScanStackEntry(SpGistScanOpaque so, ScanStackEntry *stackEntry,
+				   bool atEnd)
+{
+	if (so->numberOfOrderBys > 0)
+		pairingheap_add(so->scanQueue, &stackEntry->phNode);
+	else if (atEnd)
+		so->scanStack = lappend(so->scanStack, stackEntry);
+	else
+		so->scanStack = lcons(stackEntry, so->scanStack);
+}
+
+/* Remove and return the next ScanStackEntry to process, or NULL if none */
+static ScanStackEntry *
+popScanStackEntry(SpGistScanOpaque so)
+{
+	ScanStackEntry *stackEntry;
+
+	if (so->numberOfOrderBys > 0)
+	{
+		if (pairingheap_is_empty(so->scanQueue))
+			return NULL;
+		return (ScanStackEntry *) pairingheap_remove_first(so->scanQueue);
+	}
+
+	if (so->scanStack == NIL)
+		return NULL;
+	stackEntry = (ScanStackEntry *) linitial(so->scanStack);
+	so->scanStack = list_delete_first(so->scanStack);
+	return stackEntry;
+}
 
 /* Free a ScanStackEntry */
 static void
@@ -49,14 +145,10 @@ freeScanStackEntry(SpGistScanOpaque so, ScanStackEntry *stackEntry)
 static void
 freeScanStack(SpGistScanOpaque so)
 {
-	ListCell   *lc;
+	ScanStackEntry *stackEntry;
 
-	foreach(lc, so->scanStack)
-	{
-		freeScanStackEntry(so, (ScanStackEntry *) lfirst(lc));
-	}
-	list_free(so->scanStack);
-	so->scanStack = NIL;
+	while ((stackEntry = popScanStackEntry(so)) != NULL)
+		freeScanStackEntry(so, stackEntry);
 }
 
 /*
@@ -67,23 +159,27 @@ static void
 resetSpGistScanOpaque(SpGistScanOpaque so)
 {
 	ScanStackEntry *startEntry;
+	int			i;
 
 	freeScanStack(so);
 
 	if (so->searchNulls)
 	{
 		/* Stack a work item to scan the null index entries */
-		startEntry = (ScanStackEntry *) palloc0(sizeof(ScanStackEntry));
-		ItemPointerSet(&startEntry->ptr, SPGIST_NULL_BLKNO, FirstOffsetNumber);
-		so->scanStack = lappend(so->scanStack, startEntry);
+		/* (in an ordered scan, nulls sort after everything else) */
+		for (i = 0; i < so->numberOfOrderBys; i++)
+			so->distances[i] = get_float8_infinity();
+		startEntry = newScanStackEntry(so, SPGIST_NULL_BLKNO, so->distances);
+		pushScanStackEntry(so, startEntry, true);
 	}
 
 	if (so->searchNonNulls)
 	{
 		/* Stack a work item to scan the non-null index entries */
-		startEntry = (ScanStackEntry *) palloc0(sizeof(ScanStackEntry));
-		ItemPointerSet(&startEntry->ptr, SPGIST_ROOT_BLKNO, FirstOffsetNumber);
-		so->scanStack = lappend(so->scanStack, startEntry);
+		for (i = 0; i < so->numberOfOrderBys; i++)
+			so->distances[i] = 0.0;
+		startEntry = newScanStackEntry(so, SPGIST_ROOT_BLKNO, so->distances);
+		pushScanStackEntry(so, startEntry, true);
 	}
 
 	if (so->want_itup)
@@ -178,12 +274,11 @@ spgbeginscan(PG_FUNCTION_ARGS)
 {
 	Relation	rel = (Relation) PG_GETARG_POINTER(0);
 	int			keysz = PG_GETARG_INT32(1);
-
-	/* ScanKey			scankey = (ScanKey) PG_GETARG_POINTER(2); */
+	int			orderbysz = PG_GETARG_INT32(2);
 	IndexScanDesc scan;
 	SpGistScanOpaque so;
 
-	scan = RelationGetIndexScan(rel, keysz, 0);
+	scan = RelationGetIndexScan(rel, keysz, orderbysz);
 
 	so = (SpGistScanOpaque) palloc0(sizeof(SpGistScanOpaqueData));
 	if (keysz > 0)
@@ -200,6 +295,17 @@ spgbeginscan(PG_FUNCTION_ARGS)
 	/* Set up indexTupDesc and xs_itupdesc in case it's an index-only scan */
 	so->indexTupDesc = scan->xs_itupdesc = RelationGetDescr(rel);
 
+	/* Set up the queue and workspace for an ordered scan */
+	so->numberOfOrderBys = scan->numberOfOrderBys;
+	if (so->numberOfOrderBys > 0)
+	{
+		so->orderByData = scan->orderByData;
+		so->distances = (double *)
+			palloc(sizeof(double) * so->numberOfOrderBys);
+		so->scanQueue = pairingheap_allocate(pairingheap_ScanStackEntry_cmp,
+											 so);
+	}
+
 	scan->opaque = so;
 
 	PG_RETURN_POINTER(scan);
@@ -211,6 +317,7 @@ spgrescan(PG_FUNCTION_ARGS)
 	IndexScanDesc scan = (IndexScanDesc) PG_GETARG_POINTER(0);
 	SpGistScanOpaque so = (SpGistScanOpaque) scan->opaque;
 	ScanKey		scankey = (ScanKey) PG_GETARG_POINTER(1);
+	ScanKey		orderbys = (ScanKey) PG_GETARG_POINTER(3);
 
 	/* copy scankeys into local storage */
 	if (scankey && scan->numberOfKeys > 0)
@@ -219,6 +326,13 @@ spgrescan(PG_FUNCTION_ARGS)
 				scan->numberOfKeys * sizeof(ScanKeyData));
 	}
 
+	/* likewise for the order-by keys */
+	if (orderbys && scan->numberOfOrderBys > 0)
+	{
+		memmove(scan->orderByData, orderbys,
+				scan->numberOfOrderBys * sizeof(ScanKeyData));
+	}
+
 	/* preprocess scankeys, set up the representation in *so */
 	spgPrepareScanKeys(scan);
 
@@ -258,6 +372,9 @@ spgrestrpos(PG_FUNCTION_ARGS)
  *
  * *leafValue is set to the reconstructed datum, if provided
  * *recheck is set true if any of the operators are lossy
+ *
+ * In an ordered scan, so->distances[] is filled with the leaf's distances
+ * to the order-by arguments on success.
  */
 static bool
 spgLeafTest(Relation index, SpGistScanOpaque so,
@@ -274,10 +391,14 @@ spgLeafTest(Relation index, SpGistScanOpaque so,
 
 	if (isnull)
 	{
+		int			i;
+
 		/* Should not have arrived on a nulls page unless nulls are wanted */
 		Assert(so->searchNulls);
 		*leafValue = (Datum) 0;
 		*recheck = false;
+		for (i = 0; i < so->numberOfOrderBys; i++)
+			so->distances[i] = get_float8_infinity();
 		return true;
 	}
 
@@ -287,7 +408,9 @@ spgLeafTest(Relation index, SpGistScanOpaque so,
 	oldCtx = MemoryContextSwitchTo(so->tempCxt);
 
 	in.scankeys = so->keyData;
+	in.orderbys = so->orderByData;
 	in.nkeys = so->numberOfKeys;
+	in.norderbys = so->numberOfOrderBys;
 	in.reconstructedValue = reconstructedValue;
 	in.level = level;
 	in.returnData = so->want_itup;
@@ -295,6 +418,7 @@ spgLeafTest(Relation index, SpGistScanOpaque so,
 
 	out.leafValue = (Datum) 0;
 	out.recheck = false;
+	out.distances = NULL;
 
 	procinfo = index_getprocinfo(index, 1, SPGIST_LEAF_CONSISTENT_PROC);
 	result = DatumGetBool(FunctionCall2Coll(procinfo,
@@ -305,17 +429,70 @@ spgLeafTest(Relation index, SpGistScanOpaque so,
 	*leafValue = out.leafValue;
 	*recheck = out.recheck;
 
+	if (result && so->numberOfOrderBys > 0)
+	{
+		if (out.distances == NULL)
+			elog(ERROR, "SP-GiST leaf_consistent function did not return distances");
+		memcpy(so->distances, out.distances,
+			   sizeof(double) * so->numberOfOrderBys);
+	}
+
 	MemoryContextSwitchTo(oldCtx);
 
 	return result;
 }
 
+/*
+ * Handle a leaf tuple that passed the scan quals.
+ *
+ * In an ordinary scan it is reported to storeRes at once.  In an ordered
+ * scan it is queued with the distances left in so->distances by
+ * spgLeafTest, and reported only when it reaches the head of the queue.
+ * Returns true if the tuple was reported.
+ */
+static bool
+spgReportLeaf(SpGistScanOpaque so, ItemPointer heapPtr,
+			  Datum leafValue, bool isnull, bool recheck,
+			  storeRes_func storeRes)
+{
+	ScanStackEntry *leafEntry;
+
+	if (so->numberOfOrderBys == 0)
+	{
+		storeRes(so, heapPtr, leafValue, isnull, recheck);
+		return true;
+	}
+
+	leafEntry = (ScanStackEntry *)
+		palloc(SizeOfScanStackEntry(so->numberOfOrderBys));
+	leafEntry->ptr = *heapPtr;
+	leafEntry->level = 0;
+	leafEntry->isLeaf = true;
+	leafEntry->isNull = isnull;
+	leafEntry->recheck = recheck;
+	/* Must copy value out of temp context */
+	if (so->want_itup && !isnull)
+		leafEntry->reconstructedValue = datumCopy(leafValue,
+												  so->state.attType.attbyval,
+												  so->state.attType.attlen);
+	else
+		leafEntry->reconstructedValue = (Datum) 0;
+	memcpy(leafEntry->distances, so->distances,
+		   sizeof(double) * so->numberOfOrderBys);
+
+	pairingheap_add(so->scanQueue, &leafEntry->phNode);
+	return false;
+}
+
 /*
  * Walk the tree and report all tuples passing the scan quals to the storeRes
  * subroutine.
  *
  * If scanWholeIndex is true, we'll do just that.  If not, we'll stop at the
  * next page boundary once we have reported at least one tuple.
+ *
+ * In an ordered scan, pages and tuples are visited in order of distance
+ * from the order-by arguments, and tuples are reported one at a time.
  */
 static void
 spgWalk(Relation index, SpGistScanOpaque so, bool scanWholeIndex,
@@ -333,11 +510,19 @@ spgWalk(Relation index, SpGistScanOpaque so, bool scanWholeIndex,
 		bool		isnull;
 
 		/* Pull next to-do item from the list */
-		if (so->scanStack == NIL)
+		stackEntry = popScanStackEntry(so);
+		if (stackEntry == NULL)
 			break;				/* there are no more pages to scan */
 
-		stackEntry = (ScanStackEntry *) linitial(so->scanStack);
-		so->scanStack = list_delete_first(so->scanStack);
+		if (stackEntry->isLeaf)
+		{
+			/* A queued leaf tuple is now the nearest one; report it */
+			storeRes(so, &stackEntry->ptr, stackEntry->reconstructedValue,
+					 stackEntry->isNull, stackEntry->recheck);
+			reportedSome = true;
+			freeScanStackEntry(so, stackEntry);
+			continue;
+		}
 
 redirect:
 		/* Check for interrupts, just in case of infinite loop */
@@ -392,9 +577,10 @@ redirect:
 									&leafValue,
 									&recheck))
 					{
-						storeRes(so, &leafTuple->heapPtr,
-								 leafValue, isnull, recheck);
-						reportedSome = true;
+						if (spgReportLeaf(so, &leafTuple->heapPtr,
+										  leafValue, isnull, recheck,
+										  storeRes))
+							reportedSome = true;
 					}
 				}
 			}
@@ -438,9 +624,10 @@ redirect:
 									&leafValue,
 									&recheck))
 					{
-						storeRes(so, &leafTuple->heapPtr,
-								 leafValue, isnull, recheck);
-						reportedSome = true;
+						if (spgReportLeaf(so, &leafTuple->heapPtr,
+										  leafValue, isnull, recheck,
+										  storeRes))
+							reportedSome = true;
 					}
 
 					offset = leafTuple->nextOffset;
@@ -455,7 +642,8 @@ redirect:
 			FmgrInfo   *procinfo;
 			SpGistNodeTuple *nodes;
 			SpGistNodeTuple node;
-			int			i;
+			int			i,
+						j;
 			MemoryContext oldCtx;
 
 			innerTuple = (SpGistInnerTuple) PageGetItem(page,
@@ -478,7 +666,9 @@ redirect:
 			oldCtx = MemoryContextSwitchTo(so->tempCxt);
 
 			in.scankeys = so->keyData;
+			in.orderbys = so->orderByData;
 			in.nkeys = so->numberOfKeys;
+			in.norderbys = so->numberOfOrderBys;
 			in.reconstructedValue = stackEntry->reconstructedValue;
 			in.level = stackEntry->level;
 			in.returnData = so->want_itup;
@@ -532,8 +722,11 @@ redirect:
 					ScanStackEntry *newEntry;
 
 					/* Create new work item for this node */
-					newEntry = palloc(sizeof(ScanStackEntry));
+					newEntry = palloc(SizeOfScanStackEntry(so->numberOfOrderBys));
 					newEntry->ptr = nodes[nodeN]->t_tid;
+					newEntry->isLeaf = false;
+					newEntry->isNull = false;
+					newEntry->recheck = false;
 					if (out.levelAdds)
 						newEntry->level = stackEntry->level + out.levelAdds[i];
 					else
@@ -547,7 +740,21 @@ redirect:
 					else
 						newEntry->reconstructedValue = (Datum) 0;
 
-					so->scanStack = lcons(newEntry, so->scanStack);
+					/*
+					 * The child's entries lie within the parent's, so the
+					 * parent's distances are lower bounds for them too; use
+					 * whichever bound is tighter.
+					 */
+					for (j = 0; j < so->numberOfOrderBys; j++)
+					{
+						double		distance = stackEntry->distances[j];
+
+						if (out.distances && out.distances[i][j] > distance)
+							distance = out.distances[i][j];
+						newEntry->distances[j] = distance;
+					}
+
+					pushScanStackEntry(so, newEntry, false);
 				}
 			}
 		}
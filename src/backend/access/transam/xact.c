@@ -30,6 +30,7 @@
 #include "access/xloginsert.h"
 #include "access/xlogutils.h"
 #include "catalog/catalog.h"
+#include "catalog/globaltemp.h"
 #include "catalog/namespace.h"
 #include "catalog/storage.h"
 #include "commands/async.h"
@@ -1885,6 +1886,9 @@ CommitTransaction(void)
 	 */
 	PreCommit_on_commit_actions();
 
+	/* Remove our storage of global temporary tables dropped meanwhile */
+	PreCommit_GlobalTemp();
+
 	/* close large objects before lower-level cleanup */
 	AtEOXact_LargeObject(true);
 
@@ -4750,6 +4754,8 @@ xact_redo_commit_internal(TransactionId xid, XLogRecPtr lsn,
 	/* Make sure files supposed to be dropped are dropped */
 	if (nrels > 0)
 	{
+		SMgrRelation *srels;
+
 		/*
 		 * First update minimum recovery point to cover this WAL record. Once
 		 * a relation is deleted, there's no going back. The buffer manager
@@ -4767,16 +4773,20 @@ xact_redo_commit_internal(TransactionId xid, XLogRecPtr lsn,
 		 */
 		XLogFlush(lsn);
 
+		/* Drop them all at once, so that their buffers are found in one pass */
+		srels = (SMgrRelation *) palloc(nrels * sizeof(SMgrRelation));
 		for (i = 0; i < nrels; i++)
 		{
-			SMgrRelation srel = smgropen(xnodes[i], InvalidBackendId);
 			ForkNumber	fork;
 
+			srels[i] = smgropen(xnodes[i], InvalidBackendId);
 			for (fork = 0; fork <= MAX_FORKNUM; fork++)
 				XLogDropRelation(xnodes[i], fork);
-			smgrdounlink(srel, true);
-			smgrclose(srel);
 		}
+		smgrdounlinkall(srels, nrels, true);
+		for (i = 0; i < nrels; i++)
+			smgrclose(srels[i]);
+		pfree(srels);
 	}
 
 	/*
@@ -4909,15 +4919,23 @@ xact_redo_abort(xl_xact_abort *xlrec, TransactionId xid)
 	}
 
 	/* Make sure files supposed to be dropped are dropped */
-	for (i = 0; i < xlrec->nrels; i++)
+	if (xlrec->nrels > 0)
 	{
-		SMgrRelation srel = smgropen(xlrec->xnodes[i], InvalidBackendId);
-		ForkNumber	fork;
+		SMgrRelation *srels;
+
+		srels = (SMgrRelation *) palloc(xlrec->nrels * sizeof(SMgrRelation));
+		for (i = 0; i < xlrec->nrels; i++)
+		{
+			ForkNumber	fork;
 
-		for (fork = 0; fork <= MAX_FORKNUM; fork++)
-			XLogDropRelation(xlrec->xnodes[i], fork);
-		smgrdounlink(srel, true);
-		smgrclose(srel);
+			srels[i] = smgropen(xlrec->xnodes[i], InvalidBackendId);
+			for (fork = 0; fork <= MAX_FORKNUM; fork++)
+				XLogDropRelation(xlrec->xnodes[i], fork);
+		}
+		smgrdounlinkall(srels, xlrec->nrels, true);
+		for (i = 0; i < xlrec->nrels; i++)
+			smgrclose(srels[i]);
+		pfree(srels);
 	}
 }
 
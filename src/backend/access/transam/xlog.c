@@ -293,7 +293,7 @@ static TimeLineID curFileTLI;
  * or start a new one; so it can be used to tell if the current transaction has
  * created any XLOG records.
  */
-static XLogRecPtr ProcLastRecPtr = InvalidXLogRecPtr;
+XLogRecPtr	ProcLastRecPtr = InvalidXLogRecPtr;
 
 XLogRecPtr	XactLastRecEnd = InvalidXLogRecPtr;
 
@@ -9080,16 +9080,25 @@ xlog_outdesc(StringInfo buf, XLogReaderState *record)
 
 /*
  * Return the (possible) sync flag used for opening a file, depending on the
- * value of the GUC wal_sync_method.
+ * values of the GUCs wal_sync_method and direct_io.
  */
 static int
 get_sync_bit(int method)
 {
 	int			o_direct_flag = 0;
+	int			direct_flag = 0;
+
+	/*
+	 * If direct_io covers WAL, use O_DIRECT regardless of the sync method and
+	 * of the considerations below; the user has told us the WAL is not worth
+	 * caching.  The walreceiver is still excluded, for correctness.
+	 */
+	if ((direct_io & DIRECT_IO_WAL) && !AmWalReceiverProcess())
+		direct_flag = PG_O_DIRECT;
 
 	/* If fsync is disabled, never open in sync mode */
 	if (!enableFsync)
-		return 0;
+		return direct_flag;
 
 	/*
 	 * Optimize writes by bypassing kernel cache with O_DIRECT when using
@@ -9119,14 +9128,14 @@ get_sync_bit(int method)
 		case SYNC_METHOD_FSYNC:
 		case SYNC_METHOD_FSYNC_WRITETHROUGH:
 		case SYNC_METHOD_FDATASYNC:
-			return 0;
+			return direct_flag;
 #ifdef OPEN_SYNC_FLAG
 		case SYNC_METHOD_OPEN:
-			return OPEN_SYNC_FLAG | o_direct_flag;
+			return OPEN_SYNC_FLAG | o_direct_flag | direct_flag;
 #endif
 #ifdef OPEN_DATASYNC_FLAG
 		case SYNC_METHOD_OPEN_DSYNC:
-			return OPEN_DATASYNC_FLAG | o_direct_flag;
+			return OPEN_DATASYNC_FLAG | o_direct_flag | direct_flag;
 #endif
 		default:
 			/* can't happen (unless we are out of sync with option array) */
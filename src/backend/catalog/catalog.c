@@ -368,6 +368,11 @@ GetNewOidWithIndex(Relation relation, Oid indexId, AttrNumber oidcolumn)
  * As with GetNewOid, there is some theoretical risk of a race condition,
  * but it doesn't seem worth worrying about.
  *
+ * The storage of a global temporary relation is created by every session
+ * that uses it, and a session only removes its copy of a dropped relation
+ * at the end of its next transaction.  So for such relations we avoid the
+ * files of all backends, not just ours.
+ *
  * Note: we don't support using this in bootstrap mode.  All relations
  * created by bootstrap have preassigned OIDs, so there's no need.
  */
@@ -379,10 +384,12 @@ GetNewRelFileNode(Oid reltablespace, Relation pg_class, char relpersistence)
 	int			fd;
 	bool		collides;
 	BackendId	backend;
+	BackendId	lastBackend;
 
 	switch (relpersistence)
 	{
 		case RELPERSISTENCE_TEMP:
+		case RELPERSISTENCE_GLOBAL_TEMP:
 			backend = MyBackendId;
 			break;
 		case RELPERSISTENCE_UNLOGGED:
@@ -398,13 +405,6 @@ GetNewRelFileNode(Oid reltablespace, Relation pg_class, char relpersistence)
 	rnode.node.spcNode = reltablespace ? reltablespace : MyDatabaseTableSpace;
 	rnode.node.dbNode = (rnode.node.spcNode == GLOBALTABLESPACE_OID) ? InvalidOid : MyDatabaseId;
 
-	/*
-	 * The relpath will vary based on the backend ID, so we must initialize
-	 * that properly here to make sure that any collisions based on filename
-	 * are properly detected.
-	 */
-	rnode.backend = backend;
-
 	do
 	{
 		CHECK_FOR_INTERRUPTS();
@@ -415,18 +415,34 @@ GetNewRelFileNode(Oid reltablespace, Relation pg_class, char relpersistence)
 		else
 			rnode.node.relNode = GetNewObjectId();
 
-		/* Check for existing file of same name */
-		rpath = relpath(rnode, MAIN_FORKNUM);
-		fd = BasicOpenFile(rpath, O_RDONLY | PG_BINARY, 0);
-
-		if (fd >= 0)
+		/*
+		 * Check for existing file of same name.  The relpath will vary based
+		 * on the backend ID, so we must initialize that properly here to
+		 * make sure that any collisions based on filename are properly
+		 * detected.
+		 */
+		rnode.backend = backend;
+		lastBackend = backend;
+		if (relpersistence == RELPERSISTENCE_GLOBAL_TEMP)
 		{
-			/* definite collision */
-			close(fd);
-			collides = true;
+			rnode.backend = 1;
+			lastBackend = MaxBackends;
 		}
-		else
+
+		collides = false;
+		for (; !collides && rnode.backend <= lastBackend; rnode.backend++)
 		{
+			rpath = relpath(rnode, MAIN_FORKNUM);
+			fd = BasicOpenFile(rpath, O_RDONLY | PG_BINARY, 0);
+			pfree(rpath);
+
+			if (fd >= 0)
+			{
+				/* definite collision */
+				close(fd);
+				collides = true;
+			}
+
 			/*
 			 * Here we have a little bit of a dilemma: if errno is something
 			 * other than ENOENT, should we declare a collision and loop? In
@@ -438,10 +454,7 @@ GetNewRelFileNode(Oid reltablespace, Relation pg_class, char relpersistence)
 			 * errno.  If there is a colliding file we will get an smgr
 			 * failure when we attempt to create the new relation file.
 			 */
-			collides = false;
 		}
-
-		pfree(rpath);
 	} while (collides);
 
 	return rnode.node.relNode;
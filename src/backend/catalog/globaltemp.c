@@ -0,0 +1,561 @@
+/*-------------------------------------------------------------------------
+ *
+ * globaltemp.c
+ *	  code to manage the per-session storage of global temporary relations
+ *
+ * A global temporary relation has a single, permanent catalog definition
+ * that is shared by all sessions, but its contents are private to each
+ * session.  Every session addresses its own copy of the storage using the
+ * shared relfilenode together with its own backend ID, exactly like the
+ * storage of an ordinary temporary relation, and accesses it through local
+ * buffers.  Using the relation therefore never writes to the catalogs.
+ *
+ * The storage is created lazily, by GlobalTempRelationInitStorage, which the
+ * planner and executor call for the relations a query scans or modifies, and
+ * utility commands for the relations they work on.  Indexes are built lazily
+ * as well: an index is built over the session's copy of the heap the first
+ * time the session is about to use the index.  Merely opening a relation
+ * doesn't create anything.
+ *
+ * The storage is removed when the session exits.  When the relation is
+ * dropped, the dropping session removes its own copy at commit like any
+ * other storage.  Every other session notices the relcache invalidation of
+ * the relation and removes its copy at the end of its next transaction.
+ *
+ * Nothing in the catalogs tracks the XIDs in the sessions' storage, and
+ * autovacuum can't process it.  Instead, each backend advertises the oldest
+ * XID and multixact that its storage may contain in its PGPROC, and
+ * vac_update_datfrozenxid doesn't advance datfrozenxid past them.  VACUUM
+ * in the session advances them again.
+ *
+ * Portions Copyright (c) 1996-2015, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/catalog/globaltemp.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "access/heapam.h"
+#include "access/htup_details.h"
+#include "access/multixact.h"
+#include "access/transam.h"
+#include "access/xact.h"
+#include "catalog/globaltemp.h"
+#include "catalog/index.h"
+#include "catalog/pg_class.h"
+#include "catalog/storage.h"
+#include "nodes/pg_list.h"
+#include "storage/backendid.h"
+#include "storage/ipc.h"
+#include "storage/lmgr.h"
+#include "storage/proc.h"
+#include "storage/smgr.h"
+#include "utils/hsearch.h"
+#include "utils/inval.h"
+#include "utils/rel.h"
+#include "utils/relcache.h"
+#include "utils/syscache.h"
+
+/*
+ * Hash table entry for a relation whose storage exists in this session.
+ *
+ * "valid" is false for an index whose contents don't reflect the heap yet,
+ * for example because building it failed.  "recheck" is set when we get a
+ * relcache invalidation for the relation, which might mean it has been
+ * dropped.  frozenXid and minMulti are the oldest XID and multixact that
+ * may appear in the storage of a heap or toast table; they're invalid for
+ * indexes.
+ */
+typedef struct GlobalTempStorage
+{
+	Oid			relid;			/* hash key: OID of the relation */
+	RelFileNode relnode;		/* relfilenode of its storage */
+	bool		valid;			/* contents are usable? */
+	bool		recheck;		/* might have been dropped? */
+	TransactionId frozenXid;	/* oldest XID in the storage */
+	MultiXactId minMulti;		/* oldest multixact in the storage */
+} GlobalTempStorage;
+
+static HTAB *globalTempStorage = NULL;
+
+/* Have any entries been marked for recheck? */
+static bool globalTempRecheck = false;
+
+static GlobalTempStorage *GlobalTempStorageEnter(Relation rel);
+static void GlobalTempStorageRemove(GlobalTempStorage *entry);
+static void GlobalTempPublishHorizon(void);
+static void GlobalTempRelcacheCallback(Datum arg, Oid relid);
+static void GlobalTempStorageAtExit(int code, Datum arg);
+
+
+/*
+ * GlobalTempStorageLookup
+ *		Find the entry for a relation's storage in this session, if any.
+ *
+ * An entry left behind by a dropped relation whose OID has been reused is
+ * removed, along with its storage, rather than returned.
+ */
+static GlobalTempStorage *
+GlobalTempStorageLookup(Relation rel)
+{
+	GlobalTempStorage *entry;
+	Oid			relid = RelationGetRelid(rel);
+
+	if (globalTempStorage == NULL)
+		return NULL;
+
+	entry = (GlobalTempStorage *) hash_search(globalTempStorage, &relid,
+											  HASH_FIND, NULL);
+	if (entry != NULL && !RelFileNodeEquals(entry->relnode, rel->rd_node))
+	{
+		GlobalTempStorageRemove(entry);
+		entry = NULL;
+	}
+
+	return entry;
+}
+
+/*
+ * GlobalTempStorageEnter
+ *		Remember that a relation's storage exists in this session.
+ */
+static GlobalTempStorage *
+GlobalTempStorageEnter(Relation rel)
+{
+	GlobalTempStorage *entry;
+	Oid			relid = RelationGetRelid(rel);
+	bool		found;
+
+	if (globalTempStorage == NULL)
+	{
+		HASHCTL		ctl;
+
+		MemSet(&ctl, 0, sizeof(ctl));
+		ctl.keysize = sizeof(Oid);
+		ctl.entrysize = sizeof(GlobalTempStorage);
+
+		globalTempStorage = hash_create("Global temporary storage", 64,
+										&ctl, HASH_ELEM | HASH_BLOBS);
+
+		CacheRegisterRelcacheCallback(GlobalTempRelcacheCallback, (Datum) 0);
+		on_shmem_exit(GlobalTempStorageAtExit, 0);
+	}
+
+	entry = (GlobalTempStorage *) hash_search(globalTempStorage, &relid,
+											  HASH_ENTER, &found);
+	if (found)
+		return entry;
+
+	entry->relnode = rel->rd_node;
+	entry->valid = true;
+	entry->recheck = false;
+
+	if (rel->rd_rel->relkind == RELKIND_INDEX)
+	{
+		entry->frozenXid = InvalidTransactionId;
+		entry->minMulti = InvalidMultiXactId;
+	}
+	else
+	{
+		/*
+		 * Anything we store from now on carries an XID of the current
+		 * transaction or of a later one.  Only a multixact that the current
+		 * transaction is already a member of could be older than the next
+		 * one to be assigned, and GetOldestMultiXactId accounts for those.
+		 */
+		entry->frozenXid = GetTopTransactionIdIfAny();
+		if (!TransactionIdIsValid(entry->frozenXid))
+			entry->frozenXid = ReadNewTransactionId();
+		entry->minMulti = GetOldestMultiXactId();
+		GlobalTempPublishHorizon();
+	}
+
+	return entry;
+}
+
+/*
+ * GlobalTempStorageRemove
+ *		Remove a relation's storage in this session, and forget about it.
+ */
+static void
+GlobalTempStorageRemove(GlobalTempStorage *entry)
+{
+	bool		hasXids = TransactionIdIsValid(entry->frozenXid);
+
+	/* this also drops the relation's local buffers */
+	smgrdounlink(smgropen(entry->relnode, MyBackendId), false);
+
+	hash_search(globalTempStorage, &entry->relid, HASH_REMOVE, NULL);
+
+	if (hasXids)
+		GlobalTempPublishHorizon();
+}
+
+/*
+ * GlobalTempPublishHorizon
+ *		Advertise the oldest XID and multixact in this session's storage.
+ */
+static void
+GlobalTempPublishHorizon(void)
+{
+	HASH_SEQ_STATUS status;
+	GlobalTempStorage *entry;
+	TransactionId frozenXid = InvalidTransactionId;
+	MultiXactId minMulti = InvalidMultiXactId;
+
+	hash_seq_init(&status, globalTempStorage);
+	while ((entry = (GlobalTempStorage *) hash_seq_search(&status)) != NULL)
+	{
+		if (!TransactionIdIsValid(entry->frozenXid))
+			continue;
+
+		if (!TransactionIdIsValid(frozenXid) ||
+			TransactionIdPrecedes(entry->frozenXid, frozenXid))
+			frozenXid = entry->frozenXid;
+		if (!MultiXactIdIsValid(minMulti) ||
+			MultiXactIdPrecedes(entry->minMulti, minMulti))
+			minMulti = entry->minMulti;
+	}
+
+	LWLockAcquire(ProcArrayLock, LW_EXCLUSIVE);
+	MyProc->gttFrozenXid = frozenXid;
+	MyProc->gttMinMulti = minMulti;
+	LWLockRelease(ProcArrayLock);
+}
+
+/*
+ * GlobalTempRelationInitStorage
+ *		Make sure this session's storage for a global temporary relation
+ *		exists and is usable, creating it if necessary.
+ *
+ * This must be called before the session's storage of the relation is
+ * accessed in any way.  For a table, the storage of its TOAST table and the
+ * TOAST table's index is set up too, since the toaster accesses those
+ * directly.  An index is built over the session's copy of the heap.  The
+ * caller must hold a lock on the relation.
+ */
+void
+GlobalTempRelationInitStorage(Relation rel)
+{
+	GlobalTempStorage *entry;
+	Relation	heapRel;
+
+	Assert(RELATION_IS_GLOBAL_TEMP(rel));
+
+	/* nothing to do for relations without storage */
+	if (rel->rd_rel->relkind != RELKIND_RELATION &&
+		rel->rd_rel->relkind != RELKIND_TOASTVALUE &&
+		rel->rd_rel->relkind != RELKIND_INDEX)
+		return;
+
+	entry = GlobalTempStorageLookup(rel);
+
+	/* quick exit if the storage is there and usable */
+	if (entry != NULL && entry->valid)
+		return;
+
+	if (entry == NULL)
+	{
+		/*
+		 * First use in this session.  Note that, unlike RelationCreateStorage,
+		 * we don't arrange for the file to be removed if the transaction
+		 * aborts: it belongs to the session, not to the transaction.
+		 */
+		RelationOpenSmgr(rel);
+		smgrcreate(rel->rd_smgr, MAIN_FORKNUM, false);
+		entry = GlobalTempStorageEnter(rel);
+
+		if (rel->rd_rel->relkind == RELKIND_RELATION)
+		{
+			Oid			toastrelid = rel->rd_rel->reltoastrelid;
+
+			if (OidIsValid(toastrelid))
+			{
+				Relation	toastrel = heap_open(toastrelid, AccessShareLock);
+
+				GlobalTempRelationInitStorage(toastrel);
+				heap_close(toastrel, AccessShareLock);
+			}
+			return;
+		}
+		if (rel->rd_rel->relkind == RELKIND_TOASTVALUE)
+		{
+			GlobalTempRelationInitIndexes(rel, AccessShareLock);
+			return;
+		}
+
+		/* the empty index isn't usable until it has been built */
+		entry->valid = false;
+	}
+	else
+	{
+		/* Throw away whatever a failed build left behind */
+		Assert(rel->rd_rel->relkind == RELKIND_INDEX);
+		RelationTruncate(rel, 0);
+	}
+
+	/*
+	 * Build the index over the session's contents of the heap.  index_build
+	 * keeps the entry marked invalid until it succeeds.
+	 */
+	heapRel = heap_open(IndexGetRelation(RelationGetRelid(rel), false),
+						AccessShareLock);
+	index_build(heapRel, rel, BuildIndexInfo(rel), false, true);
+	heap_close(heapRel, NoLock);
+}
+
+/*
+ * GlobalTempRelationInitIndexes
+ *		Make sure this session's storage of all the indexes of a global
+ *		temporary table exists and is usable.
+ *
+ * This is for commands that process all the indexes of a table, such as
+ * VACUUM and TRUNCATE.  The indexes are locked in the given mode.
+ */
+void
+GlobalTempRelationInitIndexes(Relation rel, LOCKMODE lockmode)
+{
+	List	   *indexoidlist = RelationGetIndexList(rel);
+	ListCell   *lc;
+
+	Assert(RELATION_IS_GLOBAL_TEMP(rel));
+
+	foreach(lc, indexoidlist)
+	{
+		Relation	index = index_open(lfirst_oid(lc), lockmode);
+
+		GlobalTempRelationInitStorage(index);
+		index_close(index, NoLock);
+	}
+	list_free(indexoidlist);
+}
+
+/*
+ * GlobalTempRelationHasStorage
+ *		Does this session have storage for a global temporary relation?
+ */
+bool
+GlobalTempRelationHasStorage(Relation rel)
+{
+	Assert(RELATION_IS_GLOBAL_TEMP(rel));
+
+	return GlobalTempStorageLookup(rel) != NULL;
+}
+
+/*
+ * GlobalTempStorageCreated
+ *		Remember storage created by heap_create in this session.
+ */
+void
+GlobalTempStorageCreated(Relation rel)
+{
+	Assert(RELATION_IS_GLOBAL_TEMP(rel));
+
+	(void) GlobalTempStorageEnter(rel);
+}
+
+/*
+ * GlobalTempStorageDropped
+ *		Forget about storage that has been removed at the end of a
+ *		transaction that dropped the relation.
+ *
+ * It's harmless to call this for relations that aren't global temporary.
+ */
+void
+GlobalTempStorageDropped(RelFileNode rnode)
+{
+	HASH_SEQ_STATUS status;
+	GlobalTempStorage *entry;
+
+	if (globalTempStorage == NULL)
+		return;
+
+	hash_seq_init(&status, globalTempStorage);
+	while ((entry = (GlobalTempStorage *) hash_seq_search(&status)) != NULL)
+	{
+		if (RelFileNodeEquals(entry->relnode, rnode))
+		{
+			bool		hasXids = TransactionIdIsValid(entry->frozenXid);
+
+			hash_search(globalTempStorage, &entry->relid, HASH_REMOVE, NULL);
+			hash_seq_term(&status);
+			if (hasXids)
+				GlobalTempPublishHorizon();
+			break;
+		}
+	}
+}
+
+/*
+ * GlobalTempIndexSetValid
+ *		Mark whether an index's contents in this session are usable.
+ *
+ * index_build clears this before it starts and sets it when done, so that
+ * an index whose build failed is rebuilt the next time it is used.
+ */
+void
+GlobalTempIndexSetValid(Relation index, bool valid)
+{
+	GlobalTempStorage *entry;
+
+	Assert(RELATION_IS_GLOBAL_TEMP(index));
+
+	entry = GlobalTempStorageLookup(index);
+	if (entry == NULL)
+		entry = GlobalTempStorageEnter(index);
+	entry->valid = valid;
+}
+
+/*
+ * GlobalTempSetFrozenXid
+ *		Advance the oldest XID and multixact that this session's storage of
+ *		a table may contain, after VACUUM has frozen everything older.
+ */
+void
+GlobalTempSetFrozenXid(Relation rel, TransactionId frozenXid,
+					   MultiXactId minMulti)
+{
+	GlobalTempStorage *entry;
+	bool		changed = false;
+
+	Assert(RELATION_IS_GLOBAL_TEMP(rel));
+
+	entry = GlobalTempStorageLookup(rel);
+	if (entry == NULL || !TransactionIdIsValid(entry->frozenXid))
+		return;
+
+	if (TransactionIdIsNormal(frozenXid) &&
+		TransactionIdPrecedes(entry->frozenXid, frozenXid))
+	{
+		entry->frozenXid = frozenXid;
+		changed = true;
+	}
+	if (MultiXactIdIsValid(minMulti) &&
+		MultiXactIdPrecedes(entry->minMulti, minMulti))
+	{
+		entry->minMulti = minMulti;
+		changed = true;
+	}
+
+	if (changed)
+		GlobalTempPublishHorizon();
+}
+
+/*
+ * PreCommit_GlobalTemp
+ *		Remove this session's storage of relations dropped by other sessions.
+ *
+ * Called at commit of every transaction, while we can still look at the
+ * catalogs.  A relation whose relcache entry has been invalidated is looked
+ * up again; if it's gone, or now has a different relfilenode, its storage
+ * is removed.  A relation dropped by the current transaction is left alone,
+ * because its storage is removed at commit in the usual way, and kept if the
+ * commit fails after all.
+ */
+void
+PreCommit_GlobalTemp(void)
+{
+	HASH_SEQ_STATUS status;
+	GlobalTempStorage *entry;
+	bool		deferred = false;
+
+	if (!globalTempRecheck)
+		return;
+
+	hash_seq_init(&status, globalTempStorage);
+	while ((entry = (GlobalTempStorage *) hash_seq_search(&status)) != NULL)
+	{
+		HeapTuple	tuple;
+		bool		dropped;
+
+		if (!entry->recheck)
+			continue;
+
+		if (smgrIsPendingDelete(entry->relnode, MyBackendId))
+		{
+			deferred = true;
+			continue;
+		}
+
+		tuple = SearchSysCache1(RELOID, ObjectIdGetDatum(entry->relid));
+		if (HeapTupleIsValid(tuple))
+		{
+			Form_pg_class classForm = (Form_pg_class) GETSTRUCT(tuple);
+
+			dropped = (classForm->relpersistence != RELPERSISTENCE_GLOBAL_TEMP ||
+					   classForm->relfilenode != entry->relnode.relNode);
+			ReleaseSysCache(tuple);
+		}
+		else
+			dropped = true;
+
+		/* removing the entry just returned is allowed during a seqscan */
+		if (dropped)
+			GlobalTempStorageRemove(entry);
+		else
+			entry->recheck = false;
+	}
+
+	globalTempRecheck = deferred;
+}
+
+/*
+ * GlobalTempRelcacheCallback
+ *		Relcache invalidation callback.
+ *
+ * We can't look at the catalogs here, so just remember to check whether the
+ * relation still exists at commit.
+ */
+static void
+GlobalTempRelcacheCallback(Datum arg, Oid relid)
+{
+	HASH_SEQ_STATUS status;
+	GlobalTempStorage *entry;
+
+	if (OidIsValid(relid))
+	{
+		entry = (GlobalTempStorage *) hash_search(globalTempStorage, &relid,
+												  HASH_FIND, NULL);
+		if (entry != NULL)
+		{
+			entry->recheck = true;
+			globalTempRecheck = true;
+		}
+		return;
+	}
+
+	hash_seq_init(&status, globalTempStorage);
+	while ((entry = (GlobalTempStorage *) hash_seq_search(&status)) != NULL)
+	{
+		entry->recheck = true;
+		globalTempRecheck = true;
+	}
+}
+
+/*
+ * GlobalTempStorageAtExit
+ *		Remove all of this session's storage at backend exit.
+ */
+static void
+GlobalTempStorageAtExit(int code, Datum arg)
+{
+	HASH_SEQ_STATUS status;
+	GlobalTempStorage *entry;
+
+	hash_seq_init(&status, globalTempStorage);
+	while ((entry = (GlobalTempStorage *) hash_seq_search(&status)) != NULL)
+		smgrdounlink(smgropen(entry->relnode, MyBackendId), false);
+
+	if (MyProc != NULL)
+	{
+		LWLockAcquire(ProcArrayLock, LW_EXCLUSIVE);
+		MyProc->gttFrozenXid = InvalidTransactionId;
+		MyProc->gttMinMulti = InvalidMultiXactId;
+		LWLockRelease(ProcArrayLock);
+	}
+}
@@ -38,6 +38,7 @@
 #include "catalog/binary_upgrade.h"
 #include "catalog/catalog.h"
 #include "catalog/dependency.h"
+#include "catalog/globaltemp.h"
 #include "catalog/heap.h"
 #include "catalog/index.h"
 #include "catalog/objectaccess.h"
@@ -354,6 +355,10 @@ heap_create(const char *relname,
 	{
 		RelationOpenSmgr(rel);
 		RelationCreateStorage(rel->rd_node, relpersistence);
+
+		/* the creating session's storage of a global temp relation exists */
+		if (relpersistence == RELPERSISTENCE_GLOBAL_TEMP)
+			GlobalTempStorageCreated(rel);
 	}
 
 	return rel;
@@ -884,9 +889,19 @@ AddNewRelationTuple(Relation pg_class_desc,
 	}
 
 	/* Initialize relfrozenxid and relminmxid */
-	if (relkind == RELKIND_RELATION ||
-		relkind == RELKIND_MATVIEW ||
-		relkind == RELKIND_TOASTVALUE)
+	if (new_rel_desc->rd_rel->relpersistence == RELPERSISTENCE_GLOBAL_TEMP)
+	{
+		/*
+		 * Every session has its own contents, with different XIDs, so there
+		 * is nothing meaningful to track here.  Each backend advertises the
+		 * oldest XID in its storage in its PGPROC instead; see globaltemp.c.
+		 */
+		new_rel_reltup->relfrozenxid = InvalidTransactionId;
+		new_rel_reltup->relminmxid = InvalidMultiXactId;
+	}
+	else if (relkind == RELKIND_RELATION ||
+			 relkind == RELKIND_MATVIEW ||
+			 relkind == RELKIND_TOASTVALUE)
 	{
 		/*
 		 * Initialize to the minimum XID that could put tuples in the table.
@@ -33,6 +33,7 @@
 #include "catalog/binary_upgrade.h"
 #include "catalog/catalog.h"
 #include "catalog/dependency.h"
+#include "catalog/globaltemp.h"
 #include "catalog/heap.h"
 #include "catalog/index.h"
 #include "catalog/objectaccess.h"
@@ -1860,7 +1861,11 @@ index_update_stats(Relation rel,
 		}
 	}
 
-	if (reltuples >= 0)
+	/*
+	 * The size of a global temporary relation depends on which session is
+	 * looking, so there's no point in recording it.
+	 */
+	if (reltuples >= 0 && !RELATION_IS_GLOBAL_TEMP(rel))
 	{
 		BlockNumber relpages = RelationGetNumberOfBlocks(rel);
 		BlockNumber relallvisible;
@@ -1963,6 +1968,17 @@ index_build(Relation heapRelation,
 						   save_sec_context | SECURITY_RESTRICTED_OPERATION);
 	save_nestlevel = NewGUCNestLevel();
 
+	/*
+	 * The index is built over this session's contents of a global temporary
+	 * table, which may not have been set up yet.  An index that fails to
+	 * build must be rebuilt the next time this session is about to use it.
+	 */
+	if (RELATION_IS_GLOBAL_TEMP(indexRelation))
+	{
+		GlobalTempRelationInitStorage(heapRelation);
+		GlobalTempIndexSetValid(indexRelation, false);
+	}
+
 	/*
 	 * Call the access method's build procedure
 	 */
@@ -2065,6 +2081,9 @@ index_build(Relation heapRelation,
 	if (indexInfo->ii_ExclusionOps != NULL)
 		IndexCheckExclusion(heapRelation, indexRelation, indexInfo);
 
+	if (RELATION_IS_GLOBAL_TEMP(indexRelation))
+		GlobalTempIndexSetValid(indexRelation, true);
+
 	/* Roll back any GUC changes executed by index functions */
 	AtEOXact_GUC(false, save_nestlevel);
 
@@ -3191,13 +3210,30 @@ reindex_index(Oid indexId, bool skip_constraint_checks, char persistence)
 			indexInfo->ii_ExclusionStrats = NULL;
 		}
 
-		/* We'll build a new physical relation for the index */
-		RelationSetNewRelfilenode(iRel, persistence, InvalidTransactionId,
-								  InvalidMultiXactId);
+		/*
+		 * We'll build a new physical relation for the index.  A global
+		 * temporary index has to keep its relfilenode, so rebuild this
+		 * session's copy in place instead.  That's safe even if we roll back
+		 * later, since the index is derived from the session's heap: we mark
+		 * it invalid before throwing away its contents, and only a complete
+		 * build marks it valid again.  An invalid index is rebuilt the next
+		 * time the session is about to use it.
+		 */
+		if (RELATION_IS_GLOBAL_TEMP(iRel))
+		{
+			if (GlobalTempRelationHasStorage(iRel))
+				GlobalTempIndexSetValid(iRel, false);
+			GlobalTempRelationInitStorage(iRel);
+		}
+		else
+		{
+			RelationSetNewRelfilenode(iRel, persistence, InvalidTransactionId,
+									  InvalidMultiXactId);
 
-		/* Initialize the index and rebuild */
-		/* Note: we do not need to re-establish pkey setting */
-		index_build(heapRelation, iRel, indexInfo, false, true);
+			/* Initialize the index and rebuild */
+			/* Note: we do not need to re-establish pkey setting */
+			index_build(heapRelation, iRel, indexInfo, false, true);
+		}
 	}
 	PG_CATCH();
 	{
@@ -25,6 +25,7 @@
 #include "access/xloginsert.h"
 #include "access/xlogutils.h"
 #include "catalog/catalog.h"
+#include "catalog/globaltemp.h"
 #include "catalog/storage.h"
 #include "catalog/storage_xlog.h"
 #include "storage/freespace.h"
@@ -85,6 +86,7 @@ RelationCreateStorage(RelFileNode rnode, char relpersistence)
 	switch (relpersistence)
 	{
 		case RELPERSISTENCE_TEMP:
+		case RELPERSISTENCE_GLOBAL_TEMP:
 			backend = MyBackendId;
 			needs_wal = false;
 			break;
@@ -336,6 +338,10 @@ smgrDoPendingDeletes(bool isCommit)
 
 				srel = smgropen(pending->relnode, pending->backend);
 
+				/* a global temporary relation's storage may go away, too */
+				if (pending->backend == MyBackendId)
+					GlobalTempStorageDropped(pending->relnode);
+
 				/* allocate the initial array, or extend it, if needed */
 				if (maxrels == 0)
 				{
@@ -418,6 +424,25 @@ smgrGetPendingDeletes(bool forCommit, RelFileNode **ptr)
 	return nrels;
 }
 
+/*
+ * smgrIsPendingDelete() -- Is a relation's storage to be deleted at commit?
+ *
+ * This includes deletions scheduled by upper-level transactions.
+ */
+bool
+smgrIsPendingDelete(RelFileNode rnode, BackendId backend)
+{
+	PendingRelDelete *pending;
+
+	for (pending = pendingDeletes; pending != NULL; pending = pending->next)
+	{
+		if (pending->atCommit && pending->backend == backend &&
+			RelFileNodeEquals(rnode, pending->relnode))
+			return true;
+	}
+	return false;
+}
+
 /*
  *	PostPrepare_smgr -- Clean up after a successful PREPARE
  *
@@ -224,6 +224,9 @@ CREATE VIEW pg_locks AS
 CREATE VIEW pg_cursors AS
     SELECT * FROM pg_cursor() AS C;
 
+CREATE VIEW pg_backend_memory_contexts AS
+    SELECT * FROM pg_get_backend_memory_contexts();
+
 CREATE VIEW pg_available_extensions AS
     SELECT E.name, E.default_version, X.extversion AS installed_version,
            E.comment
@@ -733,6 +736,39 @@ CREATE VIEW pg_stat_archiver AS
         s.stats_reset
     FROM pg_stat_get_archiver() s;
 
+CREATE VIEW pg_stat_serializable AS
+    SELECT
+        s.pivot_conflict_out,
+        s.pivot_conflict_in,
+        s.pivot_write,
+        s.pivot_commit,
+        s.pivot_old_committed,
+        s.old_pivot,
+        s.pivot_read,
+        s.prepared_pivot,
+        s.page_promotions,
+        s.relation_promotions
+    FROM pg_stat_get_serializable() s;
+
+CREATE VIEW pg_stat_sinval AS
+    SELECT
+        s.queue_size,
+        s.resets,
+        s.summaries,
+        s.catchup_signals
+    FROM pg_stat_get_sinval() s;
+
+CREATE VIEW pg_stat_aio AS
+    SELECT
+        s.pid,
+        s.reads_submitted,
+        s.writes_submitted,
+        s.completed,
+        s.in_flight,
+        s.queue_full,
+        s.waits
+    FROM pg_stat_get_aio() s;
+
 CREATE VIEW pg_stat_bgwriter AS
     SELECT
         pg_stat_get_bgwriter_timed_checkpoints() AS checkpoints_timed,
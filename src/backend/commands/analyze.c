@@ -23,6 +23,7 @@
 #include "access/visibilitymap.h"
 #include "access/xact.h"
 #include "catalog/catalog.h"
+#include "catalog/globaltemp.h"
 #include "catalog/index.h"
 #include "catalog/indexing.h"
 #include "catalog/pg_collation.h"
@@ -198,6 +199,21 @@ analyze_rel(Oid relid, VacuumStmt *vacstmt,
 		return;
 	}
 
+	/*
+	 * Likewise for global temporary tables that have no storage in this
+	 * session.  Otherwise, any indexes this session hasn't used yet have to
+	 * be built now.
+	 */
+	if (RELATION_IS_GLOBAL_TEMP(onerel))
+	{
+		if (!GlobalTempRelationHasStorage(onerel))
+		{
+			relation_close(onerel, ShareUpdateExclusiveLock);
+			return;
+		}
+		GlobalTempRelationInitIndexes(onerel, AccessShareLock);
+	}
+
 	/*
 	 * We can ANALYZE any table except pg_statistic. See update_attstats
 	 */
@@ -1506,8 +1522,13 @@ acquire_inherited_sample_rows(Relation onerel, int elevel,
 		/* We already got the needed lock */
 		childrel = heap_open(childOID, NoLock);
 
-		/* Ignore if temp table of another backend */
-		if (RELATION_IS_OTHER_TEMP(childrel))
+		/*
+		 * Ignore if temp table of another backend, or global temp table
+		 * without storage in this session
+		 */
+		if (RELATION_IS_OTHER_TEMP(childrel) ||
+			(RELATION_IS_GLOBAL_TEMP(childrel) &&
+			 !GlobalTempRelationHasStorage(childrel)))
 		{
 			/* ... but release the lock on it */
 			Assert(childrel != onerel);
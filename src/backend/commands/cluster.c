@@ -302,9 +302,11 @@ cluster_rel(Oid tableOid, Oid indexOid, bool recheck, bool verbose)
 		 * somebody is executing a database-wide CLUSTER), because there is
 		 * another check in cluster() which will stop any attempt to cluster
 		 * remote temp tables by name.  There is another check in cluster_rel
-		 * which is redundant, but we leave it for extra safety.
+		 * which is redundant, but we leave it for extra safety.  Global
+		 * temporary tables can't be clustered at all, so skip those too.
 		 */
-		if (RELATION_IS_OTHER_TEMP(OldHeap))
+		if (RELATION_IS_OTHER_TEMP(OldHeap) ||
+			RELATION_IS_GLOBAL_TEMP(OldHeap))
 		{
 			relation_close(OldHeap, AccessExclusiveLock);
 			return;
@@ -368,6 +370,17 @@ cluster_rel(Oid tableOid, Oid indexOid, bool recheck, bool verbose)
 				errmsg("cannot vacuum temporary tables of other sessions")));
 	}
 
+	/*
+	 * Rebuilding the table would assign it a new relfilenode, which the
+	 * storage of every session using a global temporary table depends on.
+	 * (VACUUM FULL never gets here for such tables; see vacuum_rel.)
+	 */
+	if (RELATION_IS_GLOBAL_TEMP(OldHeap))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("cannot cluster global temporary table \"%s\"",
+						RelationGetRelationName(OldHeap))));
+
 	/*
 	 * Also check for active uses of the relation in the current transaction,
 	 * including open scans and pending AFTER trigger events.
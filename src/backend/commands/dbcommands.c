@@ -894,6 +894,9 @@ dropdb(const char *dbname, bool missing_ok)
 	 */
 	DropDatabaseBuffers(db_id);
 
+	/* Likewise, forget the cached sizes of its relations */
+	smgrforgetdatabase(db_id);
+
 	/*
 	 * Tell the stats collector to forget it immediately, too.
 	 */
@@ -1169,6 +1172,9 @@ movedb(const char *dbname, const char *tblspcname)
 	 */
 	DropDatabaseBuffers(db_id);
 
+	/* The same goes for cached relation sizes */
+	smgrforgetdatabase(db_id);
+
 	/*
 	 * Check for existence of files in the target directory, i.e., objects of
 	 * this database that are already in the target tablespace.  We can't
@@ -2078,6 +2084,9 @@ dbase_redo(XLogReaderState *record)
 		 * We don't need to copy subdirectories
 		 */
 		copydir(src_path, dst_path, false);
+
+		/* Make sure no stale relation sizes are cached for the new files */
+		smgrforgetdatabase(xlrec->db_id);
 	}
 	else if (info == XLOG_DBASE_DROP)
 	{
@@ -2101,6 +2110,9 @@ dbase_redo(XLogReaderState *record)
 		/* Drop pages for this database that are in the shared buffer cache */
 		DropDatabaseBuffers(xlrec->db_id);
 
+		/* Forget the cached sizes of its relations */
+		smgrforgetdatabase(xlrec->db_id);
+
 		/* Also, clean out any fsync requests that might be pending in md.c */
 		ForgetDatabaseFsyncRequests(xlrec->db_id);
 
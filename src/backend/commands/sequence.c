@@ -123,6 +123,10 @@ DefineSequence(CreateSeqStmt *seq)
 		ereport(ERROR,
 				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
 				 errmsg("unlogged sequences are not supported")));
+	if (seq->sequence->relpersistence == RELPERSISTENCE_GLOBAL_TEMP)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("global temporary sequences are not supported")));
 
 	/*
 	 * If if_not_exists was given and a relation with the same name already
@@ -24,6 +24,7 @@
 #include "access/xlog.h"
 #include "catalog/catalog.h"
 #include "catalog/dependency.h"
+#include "catalog/globaltemp.h"
 #include "catalog/heap.h"
 #include "catalog/index.h"
 #include "catalog/indexing.h"
@@ -476,10 +477,17 @@ DefineRelation(CreateStmt *stmt, char relkind, Oid ownerId)
 	 * Check consistency of arguments
 	 */
 	if (stmt->oncommit != ONCOMMIT_NOOP
-		&& stmt->relation->relpersistence != RELPERSISTENCE_TEMP)
+		&& stmt->relation->relpersistence != RELPERSISTENCE_TEMP
+		&& stmt->relation->relpersistence != RELPERSISTENCE_GLOBAL_TEMP)
 		ereport(ERROR,
 				(errcode(ERRCODE_INVALID_TABLE_DEFINITION),
 				 errmsg("ON COMMIT can only be used on temporary tables")));
+	if (stmt->relation->relpersistence == RELPERSISTENCE_GLOBAL_TEMP &&
+		stmt->oncommit != ONCOMMIT_NOOP &&
+		stmt->oncommit != ONCOMMIT_PRESERVE_ROWS)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("only ON COMMIT PRESERVE ROWS is supported for global temporary tables")));
 
 	/*
 	 * Look up the namespace in which we are supposed to create the relation,
@@ -975,9 +983,12 @@ RangeVarCallbackForDropRelation(const RangeVar *rel, Oid relOid, Oid oldRelOid,
  * added to the group; in RESTRICT mode, we check that all FK references are
  * internal to the group that's being truncated.  Finally all the relations
  * are truncated and reindexed.
+ *
+ * isTopLevel is needed because a global temporary table can only be
+ * truncated outside a transaction block.
  */
 void
-ExecuteTruncate(TruncateStmt *stmt)
+ExecuteTruncate(TruncateStmt *stmt, bool isTopLevel)
 {
 	List	   *rels = NIL;
 	List	   *relids = NIL;
@@ -1112,6 +1123,19 @@ ExecuteTruncate(TruncateStmt *stmt)
 		}
 	}
 
+	/*
+	 * A global temporary table is truncated in place, which can't be rolled
+	 * back, so don't allow that inside a transaction block.
+	 */
+	foreach(cell, rels)
+	{
+		Relation	rel = (Relation) lfirst(cell);
+
+		if (RELATION_IS_GLOBAL_TEMP(rel))
+			PreventTransactionChain(isTopLevel,
+									"TRUNCATE of a global temporary table");
+	}
+
 	/* Prepare to catch AFTER triggers. */
 	AfterTriggerBeginQuery();
 
@@ -1165,9 +1189,22 @@ ExecuteTruncate(TruncateStmt *stmt)
 		 * a new relfilenode in the current (sub)transaction, then we can just
 		 * truncate it in-place, because a rollback would cause the whole
 		 * table or the current physical file to be thrown away anyway.
+		 *
+		 * A global temporary table is always truncated in-place, since its
+		 * relfilenode is shared with the storage of every other session.
+		 * That's why we refused to do it inside a transaction block above.
+		 * If this session never used the table, there's nothing to truncate.
 		 */
-		if (rel->rd_createSubid == mySubid ||
-			rel->rd_newRelfilenodeSubid == mySubid)
+		if (RELATION_IS_GLOBAL_TEMP(rel))
+		{
+			if (GlobalTempRelationHasStorage(rel))
+			{
+				GlobalTempRelationInitIndexes(rel, AccessExclusiveLock);
+				heap_truncate_one_rel(rel);
+			}
+		}
+		else if (rel->rd_createSubid == mySubid ||
+				 rel->rd_newRelfilenodeSubid == mySubid)
 		{
 			/* Immediate, non-rollbackable truncation is OK */
 			heap_truncate_one_rel(rel);
@@ -1518,6 +1555,13 @@ MergeAttributes(List *schema, List *supers, char relpersistence,
 					(errcode(ERRCODE_WRONG_OBJECT_TYPE),
 					 errmsg("cannot inherit from temporary relation of another session")));
 
+		/* Global temporary tables can only inherit from each other */
+		if ((relpersistence == RELPERSISTENCE_GLOBAL_TEMP) !=
+			(relation->rd_rel->relpersistence == RELPERSISTENCE_GLOBAL_TEMP))
+			ereport(ERROR,
+					(errcode(ERRCODE_WRONG_OBJECT_TYPE),
+					 errmsg("cannot mix global temporary and other relations in an inheritance hierarchy")));
+
 		/*
 		 * We should have an UNDER permission flag for this, but for now,
 		 * demand that creator of a child table own the parent.
@@ -3630,6 +3674,24 @@ ATRewriteTables(AlterTableStmt *parsetree, List **wqueue, LOCKMODE lockmode)
 		if (tab->relkind == RELKIND_FOREIGN_TABLE)
 			continue;
 
+		/*
+		 * Every session has its own contents of a global temporary table, and
+		 * we could only rewrite, move or check our own here.
+		 */
+		if (tab->rewrite > 0 || tab->constraints != NIL || tab->new_notnull ||
+			OidIsValid(tab->newTableSpace))
+		{
+			Relation	rel;
+
+			rel = relation_open(tab->relid, NoLock);
+			if (RELATION_IS_GLOBAL_TEMP(rel))
+				ereport(ERROR,
+						(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+						 errmsg("cannot rewrite, move or verify existing rows of global temporary table \"%s\"",
+								RelationGetRelationName(rel))));
+			relation_close(rel, NoLock);
+		}
+
 		/*
 		 * If we change column data types or add/remove OIDs, the operation
 		 * has to be propagated to tables that use this table's rowtype as a
@@ -6067,6 +6129,8 @@ ATAddForeignKeyConstraint(AlteredTableInfo *tab, Relation rel,
 	 * tables to any other table type are also disallowed, because other
 	 * backends might need to run the RI triggers on the perm table, but they
 	 * can't reliably see tuples in the local buffers of other backends.
+	 * Global temporary tables are session-private in the same way, so they
+	 * can only reference each other.
 	 */
 	switch (rel->rd_rel->relpersistence)
 	{
@@ -6093,6 +6157,12 @@ ATAddForeignKeyConstraint(AlteredTableInfo *tab, Relation rel,
 						(errcode(ERRCODE_INVALID_TABLE_DEFINITION),
 						 errmsg("constraints on temporary tables must involve temporary tables of this session")));
 			break;
+		case RELPERSISTENCE_GLOBAL_TEMP:
+			if (pkrel->rd_rel->relpersistence != RELPERSISTENCE_GLOBAL_TEMP)
+				ereport(ERROR,
+						(errcode(ERRCODE_INVALID_TABLE_DEFINITION),
+						 errmsg("constraints on global temporary tables may reference only global temporary tables")));
+			break;
 	}
 
 	/*
@@ -9681,6 +9751,12 @@ ATExecAddInherit(Relation child_rel, RangeVar *parent, LOCKMODE lockmode)
 				(errcode(ERRCODE_WRONG_OBJECT_TYPE),
 		 errmsg("cannot inherit to temporary relation of another session")));
 
+	/* Global temporary tables can only inherit from each other */
+	if (RELATION_IS_GLOBAL_TEMP(parent_rel) != RELATION_IS_GLOBAL_TEMP(child_rel))
+		ereport(ERROR,
+				(errcode(ERRCODE_WRONG_OBJECT_TYPE),
+				 errmsg("cannot mix global temporary and other relations in an inheritance hierarchy")));
+
 	/*
 	 * Check for duplicates in the list of parents, and determine the highest
 	 * inhseqno already present; we'll use the next one for the new parent.
@@ -10827,6 +10903,15 @@ ATPrepChangePersistence(Relation rel, bool toLogged)
 							   RelationGetRelationName(rel)),
 					 errtable(rel)));
 			break;
+		case RELPERSISTENCE_GLOBAL_TEMP:
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_TABLE_DEFINITION),
+					 errmsg("cannot change logged status of table %s",
+							RelationGetRelationName(rel)),
+					 errdetail("Table %s is global temporary.",
+							   RelationGetRelationName(rel)),
+					 errtable(rel)));
+			break;
 		case RELPERSISTENCE_PERMANENT:
 			if (toLogged)
 				/* nothing to do */
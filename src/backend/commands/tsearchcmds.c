@@ -38,10 +38,12 @@
 #include "nodes/makefuncs.h"
 #include "parser/parse_func.h"
 #include "tsearch/ts_cache.h"
+#include "tsearch/ts_shared.h"
 #include "tsearch/ts_utils.h"
 #include "utils/builtins.h"
 #include "utils/fmgroids.h"
 #include "utils/lsyscache.h"
+#include "utils/memutils.h"
 #include "utils/rel.h"
 #include "utils/syscache.h"
 #include "utils/tqual.h"
@@ -348,6 +350,8 @@ verify_dictoptions(Oid tmplId, List *dictoptions)
 	HeapTuple	tup;
 	Form_pg_ts_template tform;
 	Oid			initmethod;
+	MemoryContext initcxt;
+	MemoryContext oldcxt;
 
 	/*
 	 * Suppress this test when running in a standalone backend.  This is a
@@ -385,10 +389,22 @@ verify_dictoptions(Oid tmplId, List *dictoptions)
 		dictoptions = copyObject(dictoptions);
 
 		/*
-		 * Call the init method and see if it complains.  We don't worry about
-		 * it leaking memory, since our command will soon be over anyway.
+		 * Call the init method and see if it complains.  It runs in a
+		 * context of its own, so that any shared dictionary data it attaches
+		 * to can be released again along with the dictionary.
 		 */
+		initcxt = AllocSetContextCreate(CurrentMemoryContext,
+										"text search dictionary check",
+										ALLOCSET_DEFAULT_MINSIZE,
+										ALLOCSET_DEFAULT_INITSIZE,
+										ALLOCSET_DEFAULT_MAXSIZE);
+		oldcxt = MemoryContextSwitchTo(initcxt);
+
 		(void) OidFunctionCall1(initmethod, PointerGetDatum(dictoptions));
+
+		MemoryContextSwitchTo(oldcxt);
+		ts_shared_release(initcxt);
+		MemoryContextDelete(initcxt);
 	}
 
 	ReleaseSysCache(tup);
@@ -30,6 +30,7 @@
 #include "access/multixact.h"
 #include "access/transam.h"
 #include "access/xact.h"
+#include "catalog/globaltemp.h"
 #include "catalog/namespace.h"
 #include "catalog/pg_database.h"
 #include "catalog/pg_namespace.h"
@@ -702,6 +703,17 @@ vac_update_relstats(Relation relation,
 	Form_pg_class pgcform;
 	bool		dirty;
 
+	/*
+	 * What we found describes only this session's contents of a global
+	 * temporary relation, which doesn't belong in the shared catalog.  The
+	 * session keeps track of how far its contents have been frozen itself.
+	 */
+	if (RELATION_IS_GLOBAL_TEMP(relation))
+	{
+		GlobalTempSetFrozenXid(relation, frozenxid, minmulti);
+		return;
+	}
+
 	rd = heap_open(RelationRelationId, RowExclusiveLock);
 
 	/* Fetch a copy of the tuple to scribble on */
@@ -854,6 +866,15 @@ vac_update_datfrozenxid(void)
 	 */
 	newMinMulti = GetOldestMultiXactId();
 
+	/*
+	 * Sessions' storage of global temporary tables isn't covered by pg_class;
+	 * the sessions advertise what it may contain instead.  This must be
+	 * looked at after the values above have been computed, so that a session
+	 * that starts using such storage concurrently can't be missed; see
+	 * globaltemp.c.
+	 */
+	GetOldestGlobalTempXids(MyDatabaseId, &newFrozenXid, &newMinMulti);
+
 	/*
 	 * Identify the latest relfrozenxid and relminmxid values that we could
 	 * validly see during the scan.  These are conservative values, but it's
@@ -884,6 +905,10 @@ vac_update_datfrozenxid(void)
 			classForm->relkind != RELKIND_TOASTVALUE)
 			continue;
 
+		/* Global temporary tables were dealt with above; see heap.c */
+		if (classForm->relpersistence == RELPERSISTENCE_GLOBAL_TEMP)
+			continue;
+
 		Assert(TransactionIdIsNormal(classForm->relfrozenxid));
 		Assert(MultiXactIdIsValid(classForm->relminmxid));
 
@@ -1119,6 +1144,7 @@ vacuum_rel(Oid relid, VacuumStmt *vacstmt, bool do_toast, bool for_wraparound)
 	Relation	onerel;
 	LockRelId	onerelid;
 	Oid			toast_relid;
+	bool		full;
 	Oid			save_userid;
 	int			save_sec_context;
 	int			save_nestlevel;
@@ -1268,6 +1294,23 @@ vacuum_rel(Oid relid, VacuumStmt *vacstmt, bool do_toast, bool for_wraparound)
 		return false;
 	}
 
+	/*
+	 * Likewise for global temporary tables that have no storage in this
+	 * session.  We can only ever see our own session's contents.
+	 */
+	if (RELATION_IS_GLOBAL_TEMP(onerel) &&
+		!GlobalTempRelationHasStorage(onerel))
+	{
+		relation_close(onerel, lmode);
+		PopActiveSnapshot();
+		CommitTransactionCommand();
+		return false;
+	}
+
+	/* Any indexes this session hasn't used yet have to be built now */
+	if (RELATION_IS_GLOBAL_TEMP(onerel))
+		GlobalTempRelationInitIndexes(onerel, RowExclusiveLock);
+
 	/*
 	 * Get a session-level lock too. This will protect our access to the
 	 * relation across multiple transactions, so that we can vacuum the
@@ -1286,7 +1329,14 @@ vacuum_rel(Oid relid, VacuumStmt *vacstmt, bool do_toast, bool for_wraparound)
 	 * us to process it.  In VACUUM FULL, though, the toast table is
 	 * automatically rebuilt by cluster_rel so we shouldn't recurse to it.
 	 */
-	if (do_toast && !(vacstmt->options & VACOPT_FULL))
+	/*
+	 * VACUUM FULL would assign a new relfilenode, which a global temporary
+	 * table must never get.  Vacuum this session's contents lazily instead.
+	 */
+	full = (vacstmt->options & VACOPT_FULL) != 0 &&
+		!RELATION_IS_GLOBAL_TEMP(onerel);
+
+	if (do_toast && !full)
 		toast_relid = onerel->rd_rel->reltoastrelid;
 	else
 		toast_relid = InvalidOid;
@@ -1305,7 +1355,7 @@ vacuum_rel(Oid relid, VacuumStmt *vacstmt, bool do_toast, bool for_wraparound)
 	/*
 	 * Do the actual work --- either FULL or "lazy" vacuum
 	 */
-	if (vacstmt->options & VACOPT_FULL)
+	if (full)
 	{
 		/* close relation before vacuuming, but hold lock until commit */
 		relation_close(onerel, NoLock);
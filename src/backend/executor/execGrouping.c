@@ -18,17 +18,50 @@
  */
 #include "postgres.h"
 
+#include "access/htup_details.h"
+#include "commands/tablespace.h"
 #include "executor/executor.h"
 #include "miscadmin.h"
+#include "storage/buffile.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
 
 
+/*
+ * Working state of a TupleHashSpill.
+ *
+ * The spill made while reading the original input has depth 0; a spill made
+ * while reading back a batch has a depth one greater than the batch's.  Each
+ * depth partitions on the next TUPLE_HASH_SPILL_BITS bits of the hash value,
+ * taken from the most significant end, since dynahash uses the low-order bits
+ * to choose buckets and we don't want all the tuples of a batch to land in
+ * the same few buckets when they're read back.
+ */
+typedef struct TupleHashSpillData
+{
+	int			depth;			/* see above */
+	bool		started;		/* have we refused any new groups yet? */
+	MemoryContext filecxt;		/* context holding the BufFiles */
+	BufFile    *files[TUPLE_HASH_SPILL_PARTITIONS];		/* NULL if empty */
+} TupleHashSpillData;
+
+/* A partition of a TupleHashSpill that is waiting to be read back */
+typedef struct TupleHashBatchData
+{
+	int			depth;			/* depth of the spill that wrote the file */
+	BufFile    *file;			/* the spilled tuples */
+} TupleHashBatchData;
+
+/* Spilling is impossible once all the bits of the hash value are used up */
+#define TUPLE_HASH_SPILL_MAX_DEPTH	(32 / TUPLE_HASH_SPILL_BITS - 1)
+
 static TupleHashTable CurTupleHashTable = NULL;
 
 static uint32 TupleHashTableHash(const void *key, Size keysize);
 static int TupleHashTableMatch(const void *key1, const void *key2,
 					Size keysize);
+static uint32 TupleHashTableHashSlot(TupleHashTable hashtable,
+					   TupleTableSlot *slot);
 
 
 /*****************************************************************************
@@ -296,6 +329,7 @@ BuildTupleHashTable(int numCols, AttrNumber *keyColIdx,
 	hashtable->tab_eq_funcs = eqfunctions;
 	hashtable->tablecxt = tablecxt;
 	hashtable->tempcxt = tempcxt;
+	hashtable->budgetcxt = MemoryContextGetBudgetContext(tablecxt);
 	hashtable->entrysize = entrysize;
 	hashtable->tableslot = NULL;	/* will be made on first lookup */
 	hashtable->inputslot = NULL;
@@ -458,6 +492,234 @@ FindTupleHashEntry(TupleHashTable hashtable, TupleTableSlot *slot,
 	return entry;
 }
 
+/*
+ * TupleHashSpillCreate
+ *		Set up to spill the tuples of a pass over the input of a hash table.
+ *
+ * "batch" is the spilled batch that the pass reads, or NULL if it reads the
+ * original input.  No files are created until a tuple is actually spilled,
+ * so it's cheap to do this for every pass.
+ */
+TupleHashSpill
+TupleHashSpillCreate(TupleHashBatch batch)
+{
+	TupleHashSpill spill;
+
+	spill = (TupleHashSpill) palloc0(sizeof(TupleHashSpillData));
+	spill->depth = batch ? batch->depth + 1 : 0;
+	spill->started = false;
+	spill->filecxt = CurrentMemoryContext;
+
+	return spill;
+}
+
+/*
+ * TupleHashSpillNeeded
+ *		Must a tuple that belongs to no existing group be spilled, rather than
+ *		starting a new group in the hash table?
+ *
+ * That's the case once the memory used by the hash table (including whatever
+ * else the caller keeps in its context, such as transition values) exceeds
+ * work_mem, or the query as a whole exceeds its memory budget.  The answer
+ * doesn't change back for the rest of the pass: a group whose first tuples
+ * were spilled must not be started later on, or it would be output twice.
+ *
+ * We never refuse a table's first group, so that every pass makes progress;
+ * and we can't spill once the hash value has no more bits to partition on,
+ * in which case the table is simply allowed to grow.
+ */
+bool
+TupleHashSpillNeeded(TupleHashSpill spill, TupleHashTable hashtable)
+{
+	if (spill->started)
+		return true;
+	if (spill->depth > TUPLE_HASH_SPILL_MAX_DEPTH)
+		return false;
+	if (hash_get_num_entries(hashtable->hashtab) == 0)
+		return false;
+
+	if (hashtable->tablecxt->mem_total > (Size) work_mem * 1024 ||
+		MemoryContextOverBudget(hashtable->budgetcxt))
+		spill->started = true;
+
+	return spill->started;
+}
+
+/*
+ * TupleHashSpillStarted
+ *		Has the spill refused any new groups yet?
+ *
+ * Callers use this for tuples that can't start a group anyway, but must
+ * follow the tuples of their group to disk if it was spilled.
+ */
+bool
+TupleHashSpillStarted(TupleHashSpill spill)
+{
+	return spill->started;
+}
+
+/*
+ * TupleHashSpillTuple
+ *		Write a tuple to the partition its group belongs to.
+ *
+ * The hash value is computed on "hashslot", which must be of the hash
+ * table's type, while the tuple stored is the one in "slot".  (They can be
+ * the same slot.)
+ */
+void
+TupleHashSpillTuple(TupleHashSpill spill, TupleHashTable hashtable,
+					TupleTableSlot *hashslot, TupleTableSlot *slot)
+{
+	uint32		hashvalue;
+	int			partno;
+	BufFile    *file;
+	MinimalTuple tuple;
+	size_t		written;
+
+	Assert(spill->started);
+
+	hashvalue = TupleHashTableHashSlot(hashtable, hashslot);
+	partno = (hashvalue << (spill->depth * TUPLE_HASH_SPILL_BITS)) >>
+		(32 - TUPLE_HASH_SPILL_BITS);
+
+	file = spill->files[partno];
+	if (file == NULL)
+	{
+		MemoryContext oldcontext;
+
+		/* First write to this partition, so open it. */
+		oldcontext = MemoryContextSwitchTo(spill->filecxt);
+		PrepareTempTablespaces();
+		file = BufFileCreateTemp(false);
+		spill->files[partno] = file;
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	tuple = ExecFetchSlotMinimalTuple(slot);
+	written = BufFileWrite(file, (void *) tuple, tuple->t_len);
+	if (written != tuple->t_len)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+			   errmsg("could not write to hash table temporary file: %m")));
+}
+
+/*
+ * TupleHashSpillFinish
+ *		Finish a pass, turning each partition written into a batch.
+ *
+ * The new batches are added to the front of the caller's list of batches
+ * still to be processed, which is returned.  The spill itself is freed.
+ * Processing the list from the front finishes the partitions of a batch
+ * before moving on to its siblings, which keeps the number of temporary
+ * files down.
+ */
+List *
+TupleHashSpillFinish(TupleHashSpill spill, List *batches)
+{
+	int			partno;
+
+	for (partno = 0; partno < TUPLE_HASH_SPILL_PARTITIONS; partno++)
+	{
+		TupleHashBatch batch;
+		BufFile    *file = spill->files[partno];
+
+		if (file == NULL)
+			continue;
+
+		if (BufFileSeek(file, 0, 0L, SEEK_SET))
+			ereport(ERROR,
+					(errcode_for_file_access(),
+				 errmsg("could not rewind hash table temporary file: %m")));
+
+		batch = (TupleHashBatch) MemoryContextAlloc(spill->filecxt,
+												sizeof(TupleHashBatchData));
+		batch->depth = spill->depth;
+		batch->file = file;
+		batches = lcons(batch, batches);
+	}
+
+	pfree(spill);
+
+	return batches;
+}
+
+/*
+ * TupleHashBatchRead
+ *		Read the next tuple of a batch into the given slot.
+ *
+ * Returns NULL (with the slot cleared) at the end of the batch.
+ */
+TupleTableSlot *
+TupleHashBatchRead(TupleHashBatch batch, TupleTableSlot *slot)
+{
+	uint32		t_len;
+	size_t		nread;
+	MinimalTuple tuple;
+
+	nread = BufFileRead(batch->file, (void *) &t_len, sizeof(t_len));
+	if (nread == 0)				/* end of file */
+	{
+		ExecClearTuple(slot);
+		return NULL;
+	}
+	if (nread != sizeof(t_len))
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not read from hash table temporary file: %m")));
+	tuple = (MinimalTuple) palloc(t_len);
+	tuple->t_len = t_len;
+	nread = BufFileRead(batch->file,
+						(void *) ((char *) tuple + sizeof(uint32)),
+						t_len - sizeof(uint32));
+	if (nread != t_len - sizeof(uint32))
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not read from hash table temporary file: %m")));
+	return ExecStoreMinimalTuple(tuple, slot, true);
+}
+
+/*
+ * TupleHashBatchEnd
+ *		Release a batch, whether or not it has been read to the end.
+ */
+void
+TupleHashBatchEnd(TupleHashBatch batch)
+{
+	BufFileClose(batch->file);
+	pfree(batch);
+}
+
+/*
+ * Compute the hash value that the hash table would use for the tuple in
+ * "slot", which must be of the table's type.
+ */
+static uint32
+TupleHashTableHashSlot(TupleHashTable hashtable, TupleTableSlot *slot)
+{
+	MemoryContext oldContext;
+	TupleHashTable saveCurHT;
+	TupleHashEntryData dummy;
+	uint32		hashvalue;
+
+	/* Need to run the hash functions in short-lived context */
+	oldContext = MemoryContextSwitchTo(hashtable->tempcxt);
+
+	hashtable->inputslot = slot;
+	hashtable->in_hash_funcs = hashtable->tab_hash_funcs;
+
+	saveCurHT = CurTupleHashTable;
+	CurTupleHashTable = hashtable;
+
+	dummy.firstTuple = NULL;	/* flag to reference inputslot */
+	hashvalue = TupleHashTableHash(&dummy, sizeof(TupleHashEntryData));
+
+	CurTupleHashTable = saveCurHT;
+
+	MemoryContextSwitchTo(oldContext);
+
+	return hashvalue;
+}
+
 /*
  * Compute the hash value for a tuple
  *
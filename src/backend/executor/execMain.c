@@ -41,6 +41,7 @@
 #include "access/sysattr.h"
 #include "access/transam.h"
 #include "access/xact.h"
+#include "catalog/globaltemp.h"
 #include "catalog/namespace.h"
 #include "commands/matview.h"
 #include "commands/trigger.h"
@@ -702,7 +703,10 @@ ExecCheckXactReadOnly(PlannedStmt *plannedstmt)
 {
 	ListCell   *l;
 
-	/* Fail if write permissions are requested on any non-temp table */
+	/*
+	 * Fail if write permissions are requested on any non-temp table.  The
+	 * contents of a global temporary table are private to the session, too.
+	 */
 	foreach(l, plannedstmt->rtable)
 	{
 		RangeTblEntry *rte = (RangeTblEntry *) lfirst(l);
@@ -716,6 +720,9 @@ ExecCheckXactReadOnly(PlannedStmt *plannedstmt)
 		if (isTempNamespace(get_rel_namespace(rte->relid)))
 			continue;
 
+		if (get_rel_persistence(rte->relid) == RELPERSISTENCE_GLOBAL_TEMP)
+			continue;
+
 		PreventCommandIfReadOnly(CreateCommandTag((Node *) plannedstmt));
 	}
 }
@@ -1155,6 +1162,10 @@ InitResultRelInfo(ResultRelInfo *resultRelInfo,
 				  Index resultRelationIndex,
 				  int instrument_options)
 {
+	/* Set up this session's storage of a global temporary table */
+	if (RELATION_IS_GLOBAL_TEMP(resultRelationDesc))
+		GlobalTempRelationInitStorage(resultRelationDesc);
+
 	MemSet(resultRelInfo, 0, sizeof(ResultRelInfo));
 	resultRelInfo->type = T_ResultRelInfo;
 	resultRelInfo->ri_RangeTableIndex = resultRelationIndex;
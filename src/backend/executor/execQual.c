@@ -121,6 +121,12 @@ static Datum ExecEvalDistinct(FuncExprState *fcache, ExprContext *econtext,
 static Datum ExecEvalScalarArrayOp(ScalarArrayOpExprState *sstate,
 					  ExprContext *econtext,
 					  bool *isNull, ExprDoneCond *isDone);
+static ScalarArrayOpHashTable *ExecBuildScalarArrayOpHash(
+						   ScalarArrayOpExprState *sstate,
+						   ExprContext *econtext,
+						   Datum arraydatum, ArrayType *arr, int nitems);
+static Datum ExecEvalHashedScalarArrayOp(ScalarArrayOpExprState *sstate,
+							Datum scalar, bool *isNull);
 static Datum ExecEvalNot(BoolExprState *notclause, ExprContext *econtext,
 			bool *isNull, ExprDoneCond *isDone);
 static Datum ExecEvalOr(BoolExprState *orExpr, ExprContext *econtext,
@@ -2571,6 +2577,11 @@ ExecEvalDistinct(FuncExprState *fcache,
  * and we combine the results across all array elements using OR and AND
  * (for ANY and ALL respectively).  Of course we short-circuit as soon as
  * the result is known.
+ *
+ * If the array can't change during the life of the expression state and is
+ * large, and the operator is a hashable equality (for ANY) or the negator of
+ * one (for ALL), we instead load the array into a hash table on first use
+ * and probe that for each scalar.
  */
 static Datum
 ExecEvalScalarArrayOp(ScalarArrayOpExprState *sstate,
@@ -2628,6 +2639,22 @@ ExecEvalScalarArrayOp(ScalarArrayOpExprState *sstate,
 		*isNull = true;
 		return (Datum) 0;
 	}
+
+	/*
+	 * If we've loaded this array into a hash table, use that.  The array is
+	 * known to be nonempty and the operator strict in that case.
+	 */
+	if (sstate->hashtable != NULL &&
+		sstate->hashtable->array == fcinfo->arg[1])
+	{
+		if (fcinfo->argnull[0])
+		{
+			*isNull = true;
+			return (Datum) 0;
+		}
+		return ExecEvalHashedScalarArrayOp(sstate, fcinfo->arg[0], isNull);
+	}
+
 	/* Else okay to fetch and detoast the array */
 	arr = DatumGetArrayTypeP(fcinfo->arg[1]);
 
@@ -2667,6 +2694,21 @@ ExecEvalScalarArrayOp(ScalarArrayOpExprState *sstate,
 	typbyval = sstate->typbyval;
 	typalign = sstate->typalign;
 
+	/*
+	 * The first time through, consider building a hash table of the array
+	 * elements.  If we succeed, the loop below is never used again.
+	 */
+	if (!sstate->hash_checked)
+	{
+		sstate->hash_checked = true;
+		sstate->hashtable = ExecBuildScalarArrayOpHash(sstate, econtext,
+													   fcinfo->arg[1],
+													   arr, nitems);
+		if (sstate->hashtable != NULL)
+			return ExecEvalHashedScalarArrayOp(sstate, fcinfo->arg[0],
+											   isNull);
+	}
+
 	result = BoolGetDatum(!useOr);
 	resultnull = false;
 
@@ -2745,6 +2787,198 @@ ExecEvalScalarArrayOp(ScalarArrayOpExprState *sstate,
 	return result;
 }
 
+/*
+ * ExecScalarArrayOpCanHash
+ *
+ * Check whether a ScalarArrayOpExpr could be evaluated by hashing its array,
+ * as far as the operator is concerned.  If so, return the equality operator
+ * to probe with (the operator itself for ANY, its negator for ALL) and the
+ * hash functions for the scalar and array element types.
+ *
+ * This is also used by the planner to cost such expressions.
+ */
+bool
+ExecScalarArrayOpCanHash(ScalarArrayOpExpr *opexpr,
+						 Oid *eqop, Oid *lhs_hashfn, Oid *rhs_hashfn)
+{
+	if (opexpr->useOr)
+		*eqop = opexpr->opno;
+	else
+	{
+		/* x <> ALL (array) is the same as NOT (x = ANY (array)) */
+		*eqop = get_negator(opexpr->opno);
+		if (!OidIsValid(*eqop))
+			return false;
+	}
+
+	return get_op_hash_functions(*eqop, lhs_hashfn, rhs_hashfn);
+}
+
+/*
+ * ExecBuildScalarArrayOpHash
+ *
+ * Try to build a hash table of the elements of the given (detoasted) array,
+ * in the per-query memory context.  Returns NULL if the expression isn't
+ * suitable for hashing.
+ */
+static ScalarArrayOpHashTable *
+ExecBuildScalarArrayOpHash(ScalarArrayOpExprState *sstate,
+						   ExprContext *econtext,
+						   Datum arraydatum, ArrayType *arr, int nitems)
+{
+	ScalarArrayOpExpr *opexpr = (ScalarArrayOpExpr *) sstate->fxprstate.xprstate.expr;
+	Expr	   *arrayarg = (Expr *) lsecond(opexpr->args);
+	ParamListInfo paramInfo = econtext->ecxt_param_list_info;
+	ScalarArrayOpHashTable *htab;
+	MemoryContext oldcontext;
+	FmgrInfo	rhs_hash_finfo;
+	Oid			eqop;
+	Oid			eqfunc;
+	Oid			lhs_hashfn;
+	Oid			rhs_hashfn;
+	ArrayType  *arrcopy;
+	Datum	   *elems;
+	bool	   *nulls;
+	int			nelems;
+	int			nbuckets;
+	int			i;
+
+	if (nitems < MIN_ARRAY_SIZE_FOR_HASHED_SAOP)
+		return NULL;
+
+	/*
+	 * The array must be the same every time we're called.  That's true of a
+	 * Const, and of an external Param as long as there's no paramFetch hook
+	 * (PL/pgSQL, which has one, changes parameter values between calls of a
+	 * saved expression state).  As a further safeguard, the caller checks
+	 * that the array datum is the one we loaded.
+	 */
+	if (IsA(arrayarg, Const))
+		 /* ok */ ;
+	else if (IsA(arrayarg, Param) &&
+			 ((Param *) arrayarg)->paramkind == PARAM_EXTERN &&
+			 paramInfo != NULL && paramInfo->paramFetch == NULL)
+		 /* ok */ ;
+	else
+		return NULL;
+
+	if (!ExecScalarArrayOpCanHash(opexpr, &eqop, &lhs_hashfn, &rhs_hashfn))
+		return NULL;
+
+	/*
+	 * We rely on strictness to deal with NULL scalars and elements without
+	 * calling the operator.
+	 */
+	eqfunc = get_opcode(eqop);
+	if (!sstate->fxprstate.func.fn_strict || !func_strict(eqfunc))
+		return NULL;
+
+	oldcontext = MemoryContextSwitchTo(econtext->ecxt_per_query_memory);
+
+	/* Copy the array so the element Datums stay valid */
+	arrcopy = (ArrayType *) palloc(VARSIZE(arr));
+	memcpy(arrcopy, arr, VARSIZE(arr));
+	deconstruct_array(arrcopy, ARR_ELEMTYPE(arrcopy),
+					  sstate->typlen, sstate->typbyval, sstate->typalign,
+					  &elems, &nulls, &nelems);
+
+	htab = (ScalarArrayOpHashTable *) palloc(sizeof(ScalarArrayOpHashTable));
+	htab->array = arraydatum;
+	htab->has_nulls = false;
+	fmgr_info(lhs_hashfn, &htab->hash_finfo);
+	fmgr_info(eqfunc, &htab->eq_finfo);
+	fmgr_info(rhs_hashfn, &rhs_hash_finfo);
+
+	/* Size the bucket array for a load factor of at most 0.5 */
+	nbuckets = 1;
+	while (nbuckets < nelems * 2)
+		nbuckets <<= 1;
+	htab->mask = nbuckets - 1;
+	htab->buckets = (int *) palloc(nbuckets * sizeof(int));
+	for (i = 0; i < nbuckets; i++)
+		htab->buckets[i] = -1;
+	htab->next = (int *) palloc(nelems * sizeof(int));
+	htab->hashes = (uint32 *) palloc(nelems * sizeof(uint32));
+	htab->values = elems;
+
+	/* Enter the non-null elements, compacting them to the front of elems */
+	htab->nvalues = 0;
+	for (i = 0; i < nelems; i++)
+	{
+		uint32		hashvalue;
+		int			bucketno;
+		int			n = htab->nvalues;
+
+		if (nulls[i])
+		{
+			htab->has_nulls = true;
+			continue;
+		}
+
+		hashvalue = DatumGetUInt32(FunctionCall1Coll(&rhs_hash_finfo,
+													 opexpr->inputcollid,
+													 elems[i]));
+		bucketno = hashvalue & htab->mask;
+
+		htab->values[n] = elems[i];
+		htab->hashes[n] = hashvalue;
+		htab->next[n] = htab->buckets[bucketno];
+		htab->buckets[bucketno] = n;
+		htab->nvalues++;
+	}
+
+	pfree(nulls);
+
+	MemoryContextSwitchTo(oldcontext);
+
+	return htab;
+}
+
+/*
+ * ExecEvalHashedScalarArrayOp
+ *
+ * Evaluate a ScalarArrayOpExpr for a non-null scalar using the hash table
+ * built by ExecBuildScalarArrayOpHash.
+ */
+static Datum
+ExecEvalHashedScalarArrayOp(ScalarArrayOpExprState *sstate,
+							Datum scalar, bool *isNull)
+{
+	ScalarArrayOpExpr *opexpr = (ScalarArrayOpExpr *) sstate->fxprstate.xprstate.expr;
+	ScalarArrayOpHashTable *htab = sstate->hashtable;
+	uint32		hashvalue;
+	int			i;
+
+	hashvalue = DatumGetUInt32(FunctionCall1Coll(&htab->hash_finfo,
+												 opexpr->inputcollid,
+												 scalar));
+
+	for (i = htab->buckets[hashvalue & htab->mask]; i >= 0; i = htab->next[i])
+	{
+		if (htab->hashes[i] == hashvalue &&
+			DatumGetBool(FunctionCall2Coll(&htab->eq_finfo,
+										   opexpr->inputcollid,
+										   scalar, htab->values[i])))
+		{
+			/* Found a match: ANY is satisfied, ALL (of <>) is violated */
+			*isNull = false;
+			return BoolGetDatum(opexpr->useOr);
+		}
+	}
+
+	/*
+	 * No match.  If the array contains NULLs, the result is NULL, exactly as
+	 * if we'd compared against each element.
+	 */
+	if (htab->has_nulls)
+	{
+		*isNull = true;
+		return (Datum) 0;
+	}
+	*isNull = false;
+	return BoolGetDatum(!opexpr->useOr);
+}
+
 /* ----------------------------------------------------------------
  *		ExecEvalNot
  *		ExecEvalOr
@@ -4666,6 +4900,8 @@ ExecInitExpr(Expr *node, PlanState *parent)
 					ExecInitExpr((Expr *) opexpr->args, parent);
 				sstate->fxprstate.func.fn_oid = InvalidOid;		/* not initialized */
 				sstate->element_type = InvalidOid;		/* ditto */
+				sstate->hash_checked = false;
+				sstate->hashtable = NULL;
 				state = (ExprState *) sstate;
 			}
 			break;
@@ -44,8 +44,10 @@
 
 #include "access/relscan.h"
 #include "access/transam.h"
+#include "catalog/globaltemp.h"
 #include "catalog/index.h"
 #include "executor/execdebug.h"
+#include "miscadmin.h"
 #include "nodes/nodeFuncs.h"
 #include "parser/parsetree.h"
 #include "storage/lmgr.h"
@@ -93,6 +95,13 @@ CreateExecutorState(void)
 									 ALLOCSET_DEFAULT_INITSIZE,
 									 ALLOCSET_DEFAULT_MAXSIZE);
 
+	/*
+	 * Sorts, hash tables and tuplestores created by the query look for this
+	 * budget to decide when to spill to disk rather than grow further.
+	 */
+	if (query_work_mem > 0)
+		MemoryContextSetBudget(qcontext, query_work_mem * 1024L);
+
 	/*
 	 * Make the EState node within the per-query context.  This way, we don't
 	 * need a separate pfree() operation for it at shutdown.
@@ -935,6 +944,10 @@ ExecOpenIndices(ResultRelInfo *resultRelInfo)
 
 		indexDesc = index_open(indexOid, RowExclusiveLock);
 
+		/* build this session's copy of a global temporary index */
+		if (RELATION_IS_GLOBAL_TEMP(indexDesc))
+			GlobalTempRelationInitStorage(indexDesc);
+
 		/* extract index key information from the index's pg_index info */
 		ii = BuildIndexInfo(indexDesc);
 
@@ -55,6 +55,15 @@
  *	  is used to run finalize functions and compute the output tuple;
  *	  this context can be reset once per output tuple.
  *
+ *	  In AGG_HASHED mode, once the hash table outgrows work_mem we stop
+ *	  creating new groups.  Input tuples belonging to groups that are not in
+ *	  the table are instead written out to temporary files, partitioned by
+ *	  hash value (see TupleHashSpill in execGrouping.c).  After the groups in
+ *	  memory have been returned, the table is emptied and refilled from each
+ *	  partition in turn, partitioning further if need be.  Since all the input
+ *	  tuples of a group either go into the table in the same pass or into the
+ *	  same partition, each group is still aggregated and output just once.
+ *
  *	  The executor's AggState node is passed as the fmgr "context" value in
  *	  all transfunc and finalfunc calls.  It is not recommended that the
  *	  transition functions look at the AggState node directly, but they can
@@ -323,9 +332,11 @@ static Bitmapset *find_unaggregated_cols(AggState *aggstate);
 static bool find_unaggregated_cols_walker(Node *node, Bitmapset **colnos);
 static void build_hash_table(AggState *aggstate);
 static AggHashEntry lookup_hash_entry(AggState *aggstate,
-				  TupleTableSlot *inputslot);
+				  TupleTableSlot *inputslot, TupleHashSpill spill);
 static TupleTableSlot *agg_retrieve_direct(AggState *aggstate);
-static void agg_fill_hash_table(AggState *aggstate);
+static void agg_fill_hash_table(AggState *aggstate, TupleHashBatch batch);
+static bool agg_refill_hash_table(AggState *aggstate);
+static void agg_discard_hash_batches(AggState *aggstate);
 static TupleTableSlot *agg_retrieve_hash_table(AggState *aggstate);
 static Datum GetAggInitVal(Datum textInitVal, Oid transtype);
 
@@ -1025,10 +1036,14 @@ hash_agg_entry_size(int numAggs)
  * Find or create a hashtable entry for the tuple group containing the
  * given tuple.
  *
+ * If the group is not in the hashtable and the hashtable has no room for
+ * more groups, the tuple is spilled instead, and NULL is returned.
+ *
  * When called, CurrentMemoryContext should be the per-query context.
  */
 static AggHashEntry
-lookup_hash_entry(AggState *aggstate, TupleTableSlot *inputslot)
+lookup_hash_entry(AggState *aggstate, TupleTableSlot *inputslot,
+				  TupleHashSpill spill)
 {
 	TupleTableSlot *hashslot = aggstate->hashslot;
 	ListCell   *l;
@@ -1053,6 +1068,18 @@ lookup_hash_entry(AggState *aggstate, TupleTableSlot *inputslot)
 		hashslot->tts_isnull[varNumber] = inputslot->tts_isnull[varNumber];
 	}
 
+	/* don't create a new entry if we're out of memory for them */
+	if (TupleHashSpillNeeded(spill, aggstate->hashtable))
+	{
+		entry = (AggHashEntry) LookupTupleHashEntry(aggstate->hashtable,
+													hashslot,
+													NULL);
+		if (entry == NULL)
+			TupleHashSpillTuple(spill, aggstate->hashtable,
+								hashslot, inputslot);
+		return entry;
+	}
+
 	/* find or create the hashtable entry using the filtered tuple */
 	entry = (AggHashEntry) LookupTupleHashEntry(aggstate->hashtable,
 												hashslot,
@@ -1112,7 +1139,7 @@ ExecAgg(AggState *node)
 	if (((Agg *) node->ss.ps.plan)->aggstrategy == AGG_HASHED)
 	{
 		if (!node->table_filled)
-			agg_fill_hash_table(node);
+			agg_fill_hash_table(node, NULL);
 		return agg_retrieve_hash_table(node);
 	}
 	else
@@ -1328,14 +1355,19 @@ agg_retrieve_direct(AggState *aggstate)
 
 /*
  * ExecAgg for hashed case: phase 1, read input and build hash table
+ *
+ * The input is the outer plan, or the given batch of tuples spilled by an
+ * earlier pass.  Either way, tuples of groups that don't fit are spilled
+ * into new batches.
  */
 static void
-agg_fill_hash_table(AggState *aggstate)
+agg_fill_hash_table(AggState *aggstate, TupleHashBatch batch)
 {
 	PlanState  *outerPlan;
 	ExprContext *tmpcontext;
 	AggHashEntry entry;
 	TupleTableSlot *outerslot;
+	TupleHashSpill spill;
 
 	/*
 	 * get state info from node
@@ -1344,33 +1376,93 @@ agg_fill_hash_table(AggState *aggstate)
 	/* tmpcontext is the per-input-tuple expression context */
 	tmpcontext = aggstate->tmpcontext;
 
+	spill = TupleHashSpillCreate(batch);
+
 	/*
-	 * Process each outer-plan tuple, and then fetch the next one, until we
-	 * exhaust the outer plan.
+	 * Process each input tuple, and then fetch the next one, until we
+	 * exhaust the input.
 	 */
 	for (;;)
 	{
-		outerslot = ExecProcNode(outerPlan);
+		if (batch)
+			outerslot = TupleHashBatchRead(batch, aggstate->hash_batchslot);
+		else
+			outerslot = ExecProcNode(outerPlan);
 		if (TupIsNull(outerslot))
 			break;
 		/* set up for advance_aggregates call */
 		tmpcontext->ecxt_outertuple = outerslot;
 
 		/* Find or build hashtable entry for this tuple's group */
-		entry = lookup_hash_entry(aggstate, outerslot);
+		entry = lookup_hash_entry(aggstate, outerslot, spill);
 
-		/* Advance the aggregates */
-		advance_aggregates(aggstate, entry->pergroup);
+		/* Advance the aggregates, unless the tuple was spilled */
+		if (entry != NULL)
+			advance_aggregates(aggstate, entry->pergroup);
 
 		/* Reset per-input-tuple context after each tuple */
 		ResetExprContext(tmpcontext);
 	}
 
+	/* Queue up whatever we spilled for later passes */
+	if (TupleHashSpillStarted(spill))
+		aggstate->hash_spilled = true;
+	aggstate->hash_batches = TupleHashSpillFinish(spill,
+												  aggstate->hash_batches);
+	if (batch)
+		TupleHashBatchEnd(batch);
+
 	aggstate->table_filled = true;
 	/* Initialize to walk the hash table */
 	ResetTupleHashIterator(aggstate->hashtable, &aggstate->hashiter);
 }
 
+/*
+ * ExecAgg for hashed case: start over with the next spilled batch, if any
+ *
+ * Returns false if there are no more batches.
+ */
+static bool
+agg_refill_hash_table(AggState *aggstate)
+{
+	TupleHashBatch batch;
+
+	if (aggstate->hash_batches == NIL)
+		return false;
+
+	batch = (TupleHashBatch) linitial(aggstate->hash_batches);
+	aggstate->hash_batches = list_delete_first(aggstate->hash_batches);
+
+	/*
+	 * The groups in the hash table have all been returned, so throw them
+	 * away, as in ExecReScanAgg.  Any agg shutdown callbacks must be called
+	 * first, since their state lives in the aggcontext too.
+	 */
+	ExecClearTuple(aggstate->ss.ss_ScanTupleSlot);
+	ReScanExprContext(aggstate->ss.ps.ps_ExprContext);
+	MemoryContextResetAndDeleteChildren(aggstate->aggcontext);
+	build_hash_table(aggstate);
+
+	agg_fill_hash_table(aggstate, batch);
+
+	return true;
+}
+
+/*
+ * Release any spilled batches not processed yet
+ */
+static void
+agg_discard_hash_batches(AggState *aggstate)
+{
+	ListCell   *lc;
+
+	foreach(lc, aggstate->hash_batches)
+		TupleHashBatchEnd((TupleHashBatch) lfirst(lc));
+	list_free(aggstate->hash_batches);
+	aggstate->hash_batches = NIL;
+	aggstate->hash_spilled = false;
+}
+
 /*
  * ExecAgg for hashed case: phase 2, retrieving groups from hash table
  */
@@ -1408,7 +1500,11 @@ agg_retrieve_hash_table(AggState *aggstate)
 		entry = (AggHashEntry) ScanTupleHashTable(&aggstate->hashiter);
 		if (entry == NULL)
 		{
-			/* No more entries in hashtable, so done */
+			/* No more entries in hashtable; go on to next batch, if any */
+			if (agg_refill_hash_table(aggstate))
+				continue;
+
+			/* No more batches either, so done */
 			aggstate->agg_done = TRUE;
 			return NULL;
 		}
@@ -1520,6 +1616,9 @@ ExecInitAgg(Agg *node, EState *estate, int eflags)
 	aggstate->pergroup = NULL;
 	aggstate->grp_firstTuple = NULL;
 	aggstate->hashtable = NULL;
+	aggstate->hash_batches = NIL;
+	aggstate->hash_spilled = false;
+	aggstate->hash_batchslot = NULL;
 
 	/*
 	 * Create expression contexts.  We need two, one for per-input-tuple
@@ -1644,6 +1743,10 @@ ExecInitAgg(Agg *node, EState *estate, int eflags)
 		aggstate->table_filled = false;
 		/* Compute the columns we actually need to hash on */
 		aggstate->hash_needed = find_hash_columns(aggstate);
+		/* Spilled input tuples are read back into a slot of their own */
+		aggstate->hash_batchslot = ExecInitExtraTupleSlot(estate);
+		ExecSetSlotDescriptor(aggstate->hash_batchslot,
+							  ExecGetResultType(outerPlanState(aggstate)));
 	}
 	else
 	{
@@ -2033,6 +2136,9 @@ ExecEndAgg(AggState *node)
 	/* And ensure any agg shutdown callbacks have been called */
 	ReScanExprContext(node->ss.ps.ps_ExprContext);
 
+	/* Release any temporary files holding spilled groups */
+	agg_discard_hash_batches(node);
+
 	/*
 	 * Free both the expr contexts.
 	 */
@@ -2073,13 +2179,17 @@ ExecReScanAgg(AggState *node)
 		/*
 		 * If we do have the hash table and the subplan does not have any
 		 * parameter changes, then we can just rescan the existing hash table;
-		 * no need to build it again.
+		 * no need to build it again.  That doesn't work if some groups were
+		 * spilled, since the table then holds only the last batch of groups.
 		 */
-		if (node->ss.ps.lefttree->chgParam == NULL)
+		if (node->ss.ps.lefttree->chgParam == NULL && !node->hash_spilled)
 		{
 			ResetTupleHashIterator(node->hashtable, &node->hashiter);
 			return;
 		}
+
+		/* Release any temporary files holding spilled groups */
+		agg_discard_hash_batches(node);
 	}
 
 	/* Make sure we have closed any open tuplesorts */
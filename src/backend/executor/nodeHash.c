@@ -321,6 +321,7 @@ ExecHashTableCreate(Hash *node, List *hashOperators, bool keepNulls)
 	hashtable->spaceAllowedSkew =
 		hashtable->spaceAllowed * SKEW_WORK_MEM_PERCENT / 100;
 	hashtable->chunks = NULL;
+	hashtable->budgetCxt = MemoryContextGetBudgetContext(CurrentMemoryContext);
 
 	/*
 	 * Get info about the hash functions to be used for each hash key. Also
@@ -884,6 +885,22 @@ ExecHashTableInsert(HashJoinTable hashtable,
 		hashtable->spaceUsed += hashTupleSize;
 		if (hashtable->spaceUsed > hashtable->spacePeak)
 			hashtable->spacePeak = hashtable->spaceUsed;
+
+		/*
+		 * If the query as a whole has used up its memory budget, don't let
+		 * the hash table grow any further than it is now, or 64kB (the
+		 * minimum work_mem) if that's more.  This only needs doing once; from
+		 * then on we stay within the reduced spaceAllowed by adding batches
+		 * as usual.
+		 */
+		if (MemoryContextOverBudget(hashtable->budgetCxt))
+		{
+			hashtable->spaceAllowed = Min(hashtable->spaceAllowed,
+										  Max(hashtable->spaceUsed,
+											  64 * 1024L));
+			hashtable->budgetCxt = NULL;
+		}
+
 		if (hashtable->spaceUsed +
 			hashtable->nbuckets_optimal * sizeof(HashJoinTuple)
 			> hashtable->spaceAllowed)
@@ -23,6 +23,15 @@
  * We can avoid making hashtable entries for any tuples appearing only in the
  * second input relation, since they cannot result in any output.
  *
+ * If the hash table outgrows work_mem, we stop making new entries.  Tuples
+ * of groups not already in the table are then written out to temporary
+ * files, partitioned by hash value, and each partition is processed in a
+ * later pass once the groups in memory have been emitted (see TupleHashSpill
+ * in execGrouping.c).  Tuples of the second relation must be spilled too,
+ * once spilling has begun, since their group may be in some partition.
+ * Each partition preserves the input order, so its tuples from the first
+ * relation still come before those from the second.
+ *
  * This node type is not used for UNION or UNION ALL, since those can be
  * implemented more cheaply (there's no need for the junk attribute to
  * identify the source relation).
@@ -81,7 +90,10 @@ typedef struct SetOpHashEntryData
 
 
 static TupleTableSlot *setop_retrieve_direct(SetOpState *setopstate);
-static void setop_fill_hash_table(SetOpState *setopstate);
+static void setop_fill_hash_table(SetOpState *setopstate,
+					  TupleHashBatch batch);
+static bool setop_refill_hash_table(SetOpState *setopstate);
+static void setop_discard_hash_batches(SetOpState *setopstate);
 static TupleTableSlot *setop_retrieve_hash_table(SetOpState *setopstate);
 
 
@@ -215,7 +227,7 @@ ExecSetOp(SetOpState *node)
 	if (plannode->strategy == SETOP_HASHED)
 	{
 		if (!node->table_filled)
-			setop_fill_hash_table(node);
+			setop_fill_hash_table(node, NULL);
 		return setop_retrieve_hash_table(node);
 	}
 	else
@@ -338,14 +350,19 @@ setop_retrieve_direct(SetOpState *setopstate)
 
 /*
  * ExecSetOp for hashed case: phase 1, read input and build hash table
+ *
+ * The input is the outer plan, or the given batch of tuples spilled by an
+ * earlier pass.  Either way, tuples of groups that don't fit are spilled
+ * into new batches.
  */
 static void
-setop_fill_hash_table(SetOpState *setopstate)
+setop_fill_hash_table(SetOpState *setopstate, TupleHashBatch batch)
 {
 	SetOp	   *node = (SetOp *) setopstate->ps.plan;
 	PlanState  *outerPlan;
 	int			firstFlag;
 	bool in_first_rel PG_USED_FOR_ASSERTS_ONLY;
+	TupleHashSpill spill;
 
 	/*
 	 * get state info from node
@@ -358,9 +375,11 @@ setop_fill_hash_table(SetOpState *setopstate)
 			(node->cmd == SETOPCMD_INTERSECT ||
 			 node->cmd == SETOPCMD_INTERSECT_ALL)));
 
+	spill = TupleHashSpillCreate(batch);
+
 	/*
-	 * Process each outer-plan tuple, and then fetch the next one, until we
-	 * exhaust the outer plan.
+	 * Process each input tuple, and then fetch the next one, until we
+	 * exhaust the input.
 	 */
 	in_first_rel = true;
 	for (;;)
@@ -370,7 +389,10 @@ setop_fill_hash_table(SetOpState *setopstate)
 		SetOpHashEntry entry;
 		bool		isnew;
 
-		outerslot = ExecProcNode(outerPlan);
+		if (batch)
+			outerslot = TupleHashBatchRead(batch, setopstate->hash_batchslot);
+		else
+			outerslot = ExecProcNode(outerPlan);
 		if (TupIsNull(outerslot))
 			break;
 
@@ -382,16 +404,31 @@ setop_fill_hash_table(SetOpState *setopstate)
 			/* (still) in first input relation */
 			Assert(in_first_rel);
 
-			/* Find or build hashtable entry for this tuple's group */
-			entry = (SetOpHashEntry)
-				LookupTupleHashEntry(setopstate->hashtable, outerslot, &isnew);
-
-			/* If new tuple group, initialize counts */
-			if (isnew)
-				initialize_counts(&entry->pergroup);
+			if (TupleHashSpillNeeded(spill, setopstate->hashtable))
+			{
+				/* No room for new groups, so spill the tuple if it's one */
+				entry = (SetOpHashEntry)
+					LookupTupleHashEntry(setopstate->hashtable, outerslot,
+										 NULL);
+				if (entry == NULL)
+					TupleHashSpillTuple(spill, setopstate->hashtable,
+										outerslot, outerslot);
+			}
+			else
+			{
+				/* Find or build hashtable entry for this tuple's group */
+				entry = (SetOpHashEntry)
+					LookupTupleHashEntry(setopstate->hashtable, outerslot,
+										 &isnew);
+
+				/* If new tuple group, initialize counts */
+				if (isnew)
+					initialize_counts(&entry->pergroup);
+			}
 
 			/* Advance the counts */
-			advance_counts(&entry->pergroup, flag);
+			if (entry)
+				advance_counts(&entry->pergroup, flag);
 		}
 		else
 		{
@@ -405,17 +442,72 @@ setop_fill_hash_table(SetOpState *setopstate)
 			/* Advance the counts if entry is already present */
 			if (entry)
 				advance_counts(&entry->pergroup, flag);
+			else if (TupleHashSpillStarted(spill))
+			{
+				/* Its group might have been spilled, so follow it there */
+				TupleHashSpillTuple(spill, setopstate->hashtable,
+									outerslot, outerslot);
+			}
 		}
 
 		/* Must reset temp context after each hashtable lookup */
 		MemoryContextReset(setopstate->tempContext);
 	}
 
+	/* Queue up whatever we spilled for later passes */
+	if (TupleHashSpillStarted(spill))
+		setopstate->hash_spilled = true;
+	setopstate->hash_batches = TupleHashSpillFinish(spill,
+													setopstate->hash_batches);
+	if (batch)
+		TupleHashBatchEnd(batch);
+
 	setopstate->table_filled = true;
 	/* Initialize to walk the hash table */
 	ResetTupleHashIterator(setopstate->hashtable, &setopstate->hashiter);
 }
 
+/*
+ * ExecSetOp for hashed case: start over with the next spilled batch, if any
+ *
+ * Returns false if there are no more batches.
+ */
+static bool
+setop_refill_hash_table(SetOpState *setopstate)
+{
+	TupleHashBatch batch;
+
+	if (setopstate->hash_batches == NIL)
+		return false;
+
+	batch = (TupleHashBatch) linitial(setopstate->hash_batches);
+	setopstate->hash_batches = list_delete_first(setopstate->hash_batches);
+
+	/* The groups in the hash table have all been emitted; discard them */
+	ExecClearTuple(setopstate->ps.ps_ResultTupleSlot);
+	MemoryContextResetAndDeleteChildren(setopstate->tableContext);
+	build_hash_table(setopstate);
+
+	setop_fill_hash_table(setopstate, batch);
+
+	return true;
+}
+
+/*
+ * Release any spilled batches not processed yet
+ */
+static void
+setop_discard_hash_batches(SetOpState *setopstate)
+{
+	ListCell   *lc;
+
+	foreach(lc, setopstate->hash_batches)
+		TupleHashBatchEnd((TupleHashBatch) lfirst(lc));
+	list_free(setopstate->hash_batches);
+	setopstate->hash_batches = NIL;
+	setopstate->hash_spilled = false;
+}
+
 /*
  * ExecSetOp for hashed case: phase 2, retrieving groups from hash table
  */
@@ -441,7 +533,11 @@ setop_retrieve_hash_table(SetOpState *setopstate)
 		entry = (SetOpHashEntry) ScanTupleHashTable(&setopstate->hashiter);
 		if (entry == NULL)
 		{
-			/* No more entries in hashtable, so done */
+			/* No more entries in hashtable; go on to next batch, if any */
+			if (setop_refill_hash_table(setopstate))
+				continue;
+
+			/* No more batches either, so done */
 			setopstate->setop_done = true;
 			return NULL;
 		}
@@ -496,6 +592,9 @@ ExecInitSetOp(SetOp *node, EState *estate, int eflags)
 	setopstate->grp_firstTuple = NULL;
 	setopstate->hashtable = NULL;
 	setopstate->tableContext = NULL;
+	setopstate->hash_batches = NIL;
+	setopstate->hash_spilled = false;
+	setopstate->hash_batchslot = NULL;
 
 	/*
 	 * Miscellaneous initialization
@@ -565,6 +664,10 @@ ExecInitSetOp(SetOp *node, EState *estate, int eflags)
 	{
 		build_hash_table(setopstate);
 		setopstate->table_filled = false;
+		/* Spilled input tuples are read back into a slot of their own */
+		setopstate->hash_batchslot = ExecInitExtraTupleSlot(estate);
+		ExecSetSlotDescriptor(setopstate->hash_batchslot,
+							  ExecGetResultType(outerPlanState(setopstate)));
 	}
 	else
 	{
@@ -588,6 +691,9 @@ ExecEndSetOp(SetOpState *node)
 	/* clean up tuple table */
 	ExecClearTuple(node->ps.ps_ResultTupleSlot);
 
+	/* Release any temporary files holding spilled groups */
+	setop_discard_hash_batches(node);
+
 	/* free subsidiary stuff including hashtable */
 	MemoryContextDelete(node->tempContext);
 	if (node->tableContext)
@@ -618,13 +724,17 @@ ExecReScanSetOp(SetOpState *node)
 		/*
 		 * If we do have the hash table and the subplan does not have any
 		 * parameter changes, then we can just rescan the existing hash table;
-		 * no need to build it again.
+		 * no need to build it again.  That doesn't work if some groups were
+		 * spilled, since the table then holds only the last batch of groups.
 		 */
-		if (node->ps.lefttree->chgParam == NULL)
+		if (node->ps.lefttree->chgParam == NULL && !node->hash_spilled)
 		{
 			ResetTupleHashIterator(node->hashtable, &node->hashiter);
 			return;
 		}
+
+		/* Release any temporary files holding spilled groups */
+		setop_discard_hash_batches(node);
 	}
 
 	/* Release first tuple of group, if we have made a copy */
@@ -106,6 +106,7 @@ typedef struct WindowStatePerAggData
 	Oid			transfn_oid;
 	Oid			invtransfn_oid; /* may be InvalidOid */
 	Oid			finalfn_oid;	/* may be InvalidOid */
+	Oid			combinefn_oid;	/* may be InvalidOid */
 
 	/*
 	 * fmgr lookup data for transition functions --- only valid when
@@ -115,6 +116,7 @@ typedef struct WindowStatePerAggData
 	FmgrInfo	transfn;
 	FmgrInfo	invtransfn;
 	FmgrInfo	finalfn;
+	FmgrInfo	combinefn;
 
 	int			numFinalArgs;	/* number of arguments to pass to finalfn */
 
@@ -152,6 +154,17 @@ typedef struct WindowStatePerAggData
 
 	int64		transValueCount;	/* number of currently-aggregated rows */
 
+	/*
+	 * Partial states used when the frame head moves and we have a combine
+	 * function instead of an inverse transition function.  suffixValues[i]
+	 * is the state for the rows from suffixbase + i up to, but not including,
+	 * suffixupto; transValue then covers the rows from suffixupto onwards.
+	 */
+	Datum	   *suffixValues;
+	bool	   *suffixNulls;
+	int64		suffixbase;
+	int64		suffixupto;
+
 	/* Data local to eval_windowaggregates() */
 	bool		restart;		/* need to restart this agg in this cycle? */
 } WindowStatePerAggData;
@@ -165,6 +178,16 @@ static void advance_windowaggregate(WindowAggState *winstate,
 static bool advance_windowaggregate_base(WindowAggState *winstate,
 							 WindowStatePerFunc perfuncstate,
 							 WindowStatePerAgg peraggstate);
+static Datum combine_windowaggregate(WindowAggState *winstate,
+						WindowStatePerFunc perfuncstate,
+						WindowStatePerAgg peraggstate,
+						Datum value1, bool isnull1,
+						Datum value2, bool isnull2,
+						bool *isnull);
+static void build_windowaggregate_suffixes(WindowAggState *winstate,
+							   WindowStatePerFunc perfuncstate,
+							   WindowStatePerAgg peraggstate,
+							   int64 aggregatedupto);
 static void finalize_windowaggregate(WindowAggState *winstate,
 						 WindowStatePerFunc perfuncstate,
 						 WindowStatePerAgg peraggstate,
@@ -228,6 +251,10 @@ initialize_windowaggregate(WindowAggState *winstate,
 	peraggstate->transValueCount = 0;
 	peraggstate->resultValue = (Datum) 0;
 	peraggstate->resultValueIsNull = true;
+	peraggstate->suffixValues = NULL;
+	peraggstate->suffixNulls = NULL;
+	peraggstate->suffixbase = winstate->frameheadpos;
+	peraggstate->suffixupto = winstate->frameheadpos;
 }
 
 /*
@@ -540,6 +567,161 @@ advance_windowaggregate_base(WindowAggState *winstate,
 	return true;
 }
 
+/*
+ * combine_windowaggregate
+ * Merge two transition states using the aggregate's combine function
+ *
+ * The result is either one of the inputs or allocated in the caller's memory
+ * context.  A strict combine function is not called if either input is null;
+ * a null state then stands for "no rows", and the other one is returned.
+ */
+static Datum
+combine_windowaggregate(WindowAggState *winstate,
+						WindowStatePerFunc perfuncstate,
+						WindowStatePerAgg peraggstate,
+						Datum value1, bool isnull1,
+						Datum value2, bool isnull2,
+						bool *isnull)
+{
+	FunctionCallInfoData fcinfo;
+	Datum		result;
+
+	if (peraggstate->combinefn.fn_strict && (isnull1 || isnull2))
+	{
+		if (isnull1)
+		{
+			*isnull = isnull2;
+			return value2;
+		}
+		*isnull = false;
+		return value1;
+	}
+
+	InitFunctionCallInfoData(fcinfo, &(peraggstate->combinefn),
+							 2,
+							 perfuncstate->winCollation,
+							 (void *) winstate, NULL);
+	fcinfo.arg[0] = value1;
+	fcinfo.argnull[0] = isnull1;
+	fcinfo.arg[1] = value2;
+	fcinfo.argnull[1] = isnull2;
+	winstate->curaggcontext = peraggstate->aggcontext;
+	result = FunctionCallInvoke(&fcinfo);
+	winstate->curaggcontext = NULL;
+
+	*isnull = fcinfo.isnull;
+	return result;
+}
+
+/*
+ * build_windowaggregate_suffixes
+ * Rebuild the partial states of an aggregate that uses a combine function
+ *
+ * This is called when the frame head has moved past suffixupto, so that
+ * transValue includes rows that are no longer in the frame.  We re-read the
+ * rows from the frame head up to aggregatedupto, compute a state for each
+ * single row, and then merge those from the end, leaving suffixValues[i]
+ * as the state for all rows from frameheadpos + i onwards.  transValue is
+ * reset to cover no rows.
+ *
+ * Since the frame head never moves backwards, a row is only processed here
+ * once per partition, so the cost per row is amortized O(1) no matter how
+ * large the frame is.
+ */
+static void
+build_windowaggregate_suffixes(WindowAggState *winstate,
+							   WindowStatePerFunc perfuncstate,
+							   WindowStatePerAgg peraggstate,
+							   int64 aggregatedupto)
+{
+	WindowObject agg_winobj = winstate->agg_winobj;
+	TupleTableSlot *temp_slot = winstate->temp_slot_1;
+	int64		frameheadpos = winstate->frameheadpos;
+	int64		nrows = aggregatedupto - frameheadpos;
+	Datum	   *values;
+	bool	   *nulls;
+	MemoryContext oldContext;
+	int64		i;
+
+	Assert(nrows > 0);
+	Assert(peraggstate->aggcontext != winstate->aggcontext);
+
+	/* Throw away the old partial states and transValue */
+	initialize_windowaggregate(winstate, perfuncstate, peraggstate);
+
+	values = (Datum *) MemoryContextAllocHuge(peraggstate->aggcontext,
+											  nrows * sizeof(Datum));
+	nulls = (bool *) MemoryContextAllocHuge(peraggstate->aggcontext,
+											nrows * sizeof(bool));
+
+	/* Compute the state of each row on its own */
+	for (i = 0; i < nrows; i++)
+	{
+		if (!window_gettupleslot(agg_winobj, frameheadpos + i, temp_slot))
+			elog(ERROR, "could not re-fetch previously fetched frame row");
+
+		winstate->tmpcontext->ecxt_outertuple = temp_slot;
+		advance_windowaggregate(winstate, perfuncstate, peraggstate);
+		ResetExprContext(winstate->tmpcontext);
+
+		values[i] = peraggstate->transValue;
+		nulls[i] = peraggstate->transValueIsNull;
+
+		/* Start the next row from the initial value, keeping this state */
+		if (peraggstate->initValueIsNull)
+			peraggstate->transValue = peraggstate->initValue;
+		else
+		{
+			oldContext = MemoryContextSwitchTo(peraggstate->aggcontext);
+			peraggstate->transValue = datumCopy(peraggstate->initValue,
+												peraggstate->transtypeByVal,
+												peraggstate->transtypeLen);
+			MemoryContextSwitchTo(oldContext);
+		}
+		peraggstate->transValueIsNull = peraggstate->initValueIsNull;
+		peraggstate->transValueCount = 0;
+	}
+	ExecClearTuple(temp_slot);
+
+	/* Now merge them from the end of the range */
+	for (i = nrows - 2; i >= 0; i--)
+	{
+		Datum		newVal;
+		bool		isnull;
+
+		oldContext = MemoryContextSwitchTo(winstate->tmpcontext->ecxt_per_tuple_memory);
+		newVal = combine_windowaggregate(winstate, perfuncstate, peraggstate,
+										 values[i], nulls[i],
+										 values[i + 1], nulls[i + 1],
+										 &isnull);
+
+		/*
+		 * If pass-by-ref datatype, copy the new value into aggcontext unless
+		 * it is one of the inputs.  The old values needn't be freed; they go
+		 * away with aggcontext at the next rebuild.
+		 */
+		if (!peraggstate->transtypeByVal && !isnull &&
+			DatumGetPointer(newVal) != DatumGetPointer(values[i]) &&
+			DatumGetPointer(newVal) != DatumGetPointer(values[i + 1]))
+		{
+			MemoryContextSwitchTo(peraggstate->aggcontext);
+			newVal = datumCopy(newVal,
+							   peraggstate->transtypeByVal,
+							   peraggstate->transtypeLen);
+		}
+		MemoryContextSwitchTo(oldContext);
+		ResetExprContext(winstate->tmpcontext);
+
+		values[i] = newVal;
+		nulls[i] = isnull;
+	}
+
+	peraggstate->suffixValues = values;
+	peraggstate->suffixNulls = nulls;
+	peraggstate->suffixbase = frameheadpos;
+	peraggstate->suffixupto = aggregatedupto;
+}
+
 /*
  * finalize_windowaggregate
  * parallel to finalize_aggregate in nodeAgg.c
@@ -551,9 +733,28 @@ finalize_windowaggregate(WindowAggState *winstate,
 						 Datum *result, bool *isnull)
 {
 	MemoryContext oldContext;
+	Datum		transValue = peraggstate->transValue;
+	bool		transValueIsNull = peraggstate->transValueIsNull;
 
 	oldContext = MemoryContextSwitchTo(winstate->ss.ps.ps_ExprContext->ecxt_per_tuple_memory);
 
+	/*
+	 * If the aggregate keeps partial states for rows at the start of the
+	 * frame, merge the relevant one with transValue to get the frame's state.
+	 */
+	if (OidIsValid(peraggstate->combinefn_oid) &&
+		winstate->frameheadpos < peraggstate->suffixupto)
+	{
+		int64		i = winstate->frameheadpos - peraggstate->suffixbase;
+
+		transValue = combine_windowaggregate(winstate, perfuncstate,
+											 peraggstate,
+											 peraggstate->suffixValues[i],
+											 peraggstate->suffixNulls[i],
+											 transValue, transValueIsNull,
+											 &transValueIsNull);
+	}
+
 	/*
 	 * Apply the agg's finalfn if one is provided, else return transValue.
 	 */
@@ -568,9 +769,9 @@ finalize_windowaggregate(WindowAggState *winstate,
 								 numFinalArgs,
 								 perfuncstate->winCollation,
 								 (void *) winstate, NULL);
-		fcinfo.arg[0] = peraggstate->transValue;
-		fcinfo.argnull[0] = peraggstate->transValueIsNull;
-		anynull = peraggstate->transValueIsNull;
+		fcinfo.arg[0] = transValue;
+		fcinfo.argnull[0] = transValueIsNull;
+		anynull = transValueIsNull;
 
 		/* Fill any remaining argument positions with nulls */
 		for (i = 1; i < numFinalArgs; i++)
@@ -596,8 +797,8 @@ finalize_windowaggregate(WindowAggState *winstate,
 	}
 	else
 	{
-		*result = peraggstate->transValue;
-		*isnull = peraggstate->transValueIsNull;
+		*result = transValue;
+		*isnull = transValueIsNull;
 	}
 
 	/*
@@ -618,7 +819,9 @@ finalize_windowaggregate(WindowAggState *winstate,
  *
  * This differs from nodeAgg.c in two ways.  First, if the window's frame
  * start position moves, we use the inverse transition function (if it exists)
- * to remove rows from the transition value.  And second, we expect to be
+ * to remove rows from the transition value, or else the combine function (if
+ * that exists) to assemble the frame's value from partial states.  And
+ * second, we expect to be
  * able to call aggregate final functions repeatedly after aggregating more
  * data onto the same transition value.  This is not a behavior required by
  * nodeAgg.c.
@@ -630,6 +833,7 @@ eval_windowaggregates(WindowAggState *winstate)
 	int			wfuncno,
 				numaggs,
 				numaggs_restart,
+				numaggs_combine,
 				i;
 	int64		aggregatedupto_nonrestarted;
 	MemoryContext oldContext;
@@ -676,6 +880,15 @@ eval_windowaggregates(WindowAggState *winstate)
 	 * must perform the aggregation all over again for all tuples within the
 	 * new frame boundaries.
 	 *
+	 * An exception is an aggregate that has a combine function but no
+	 * inverse.  For those we keep, besides the running transition value,
+	 * partial states for each suffix of a range of rows at the start of the
+	 * frame; the frame's state is one of those merged with the transition
+	 * value.  Once the head moves past that range, the partial states are
+	 * rebuilt from the rows then in the frame (see
+	 * build_windowaggregate_suffixes).  This is the "two stacks" technique
+	 * for sliding windows, and costs amortized O(1) combine calls per row.
+	 *
 	 * In many common cases, multiple rows share the same frame and hence the
 	 * same aggregate value. (In particular, if there's no ORDER BY in a RANGE
 	 * window, then all rows are peers and so they all have window frame equal
@@ -730,8 +943,8 @@ eval_windowaggregates(WindowAggState *winstate)
 	 *
 	 * We restart the aggregation:
 	 *	 - if we're processing the first row in the partition, or
-	 *	 - if the frame's head moved and we cannot use an inverse
-	 *	   transition function, or
+	 *	 - if the frame's head moved and we can use neither an inverse
+	 *	   transition function nor a combine function, or
 	 *	 - if the new frame doesn't overlap the old one
 	 *
 	 * Note that we don't strictly need to restart in the last case, but if
@@ -740,29 +953,35 @@ eval_windowaggregates(WindowAggState *winstate)
 	 *----------
 	 */
 	numaggs_restart = 0;
+	numaggs_combine = 0;
 	for (i = 0; i < numaggs; i++)
 	{
 		peraggstate = &winstate->peragg[i];
 		if (winstate->currentpos == 0 ||
 			(winstate->aggregatedbase != winstate->frameheadpos &&
-			 !OidIsValid(peraggstate->invtransfn_oid)) ||
+			 !OidIsValid(peraggstate->invtransfn_oid) &&
+			 !OidIsValid(peraggstate->combinefn_oid)) ||
 			winstate->aggregatedupto <= winstate->frameheadpos)
 		{
 			peraggstate->restart = true;
 			numaggs_restart++;
 		}
 		else
+		{
 			peraggstate->restart = false;
+			if (OidIsValid(peraggstate->combinefn_oid))
+				numaggs_combine++;
+		}
 	}
 
 	/*
-	 * If we have any possibly-moving aggregates, attempt to advance
-	 * aggregatedbase to match the frame's head by removing input rows that
-	 * fell off the top of the frame from the aggregations.  This can fail,
-	 * i.e. advance_windowaggregate_base() can return false, in which case
-	 * we'll restart that aggregate below.
+	 * If we have any possibly-moving aggregates with inverse transition
+	 * functions, attempt to advance aggregatedbase to match the frame's head
+	 * by removing input rows that fell off the top of the frame from the
+	 * aggregations.  This can fail, i.e. advance_windowaggregate_base() can
+	 * return false, in which case we'll restart that aggregate below.
 	 */
-	while (numaggs_restart < numaggs &&
+	while (numaggs_restart + numaggs_combine < numaggs &&
 		   winstate->aggregatedbase < winstate->frameheadpos)
 	{
 		/*
@@ -785,7 +1004,8 @@ eval_windowaggregates(WindowAggState *winstate)
 			bool		ok;
 
 			peraggstate = &winstate->peragg[i];
-			if (peraggstate->restart)
+			if (peraggstate->restart ||
+				OidIsValid(peraggstate->combinefn_oid))
 				continue;
 
 			wfuncno = peraggstate->wfuncno;
@@ -877,6 +1097,27 @@ eval_windowaggregates(WindowAggState *winstate)
 		ExecClearTuple(agg_row_slot);
 	}
 
+	/*
+	 * Aggregates using a combine function whose running transition value
+	 * includes rows before the new frame head need their partial states
+	 * rebuilt.  This leaves them covering the same rows as the other
+	 * non-restarted aggregates.
+	 */
+	for (i = 0; i < numaggs; i++)
+	{
+		peraggstate = &winstate->peragg[i];
+		if (peraggstate->restart ||
+			!OidIsValid(peraggstate->combinefn_oid) ||
+			winstate->frameheadpos <= peraggstate->suffixupto)
+			continue;
+
+		wfuncno = peraggstate->wfuncno;
+		build_windowaggregate_suffixes(winstate,
+									   &winstate->perfunc[wfuncno],
+									   peraggstate,
+									   aggregatedupto_nonrestarted);
+	}
+
 	/*
 	 * Advance until we reach a row not in frame (or end of partition).
 	 *
@@ -1029,6 +1270,7 @@ begin_partition(WindowAggState *winstate)
 {
 	PlanState  *outerPlan = outerPlanState(winstate);
 	int			numfuncs = winstate->numfuncs;
+	bool		reuse_buffer = false;
 	int			i;
 
 	winstate->partition_spooled = false;
@@ -1059,8 +1301,19 @@ begin_partition(WindowAggState *winstate)
 		}
 	}
 
-	/* Create new tuplestore for this partition */
-	winstate->buffer = tuplestore_begin_heap(false, false, work_mem);
+	/*
+	 * If the previous partition left its emptied tuplestore behind, reuse it;
+	 * its read pointers are still allocated and were reset to the start by
+	 * tuplestore_clear.  Otherwise create a new tuplestore.
+	 */
+	if (winstate->spare_buffer != NULL)
+	{
+		reuse_buffer = true;
+		winstate->buffer = winstate->spare_buffer;
+		winstate->spare_buffer = NULL;
+	}
+	else
+		winstate->buffer = tuplestore_begin_heap(false, false, work_mem);
 
 	/*
 	 * Set up read pointers for the tuplestore.  The current pointer doesn't
@@ -1070,7 +1323,8 @@ begin_partition(WindowAggState *winstate)
 	winstate->current_ptr = 0;	/* read pointer 0 is pre-allocated */
 
 	/* reset default REWIND capability bit for current ptr */
-	tuplestore_set_eflags(winstate->buffer, 0);
+	if (!reuse_buffer)
+		tuplestore_set_eflags(winstate->buffer, 0);
 
 	/* create read pointers for aggregates, if needed */
 	if (winstate->numaggs > 0)
@@ -1082,13 +1336,15 @@ begin_partition(WindowAggState *winstate)
 		if (!(winstate->frameOptions & FRAMEOPTION_START_UNBOUNDED_PRECEDING))
 		{
 			/* ... create a mark pointer to track the frame head */
-			agg_winobj->markptr = tuplestore_alloc_read_pointer(winstate->buffer, 0);
+			if (!reuse_buffer)
+				agg_winobj->markptr = tuplestore_alloc_read_pointer(winstate->buffer, 0);
 			/* and the read pointer will need BACKWARD capability */
 			readptr_flags |= EXEC_FLAG_BACKWARD;
 		}
 
-		agg_winobj->readptr = tuplestore_alloc_read_pointer(winstate->buffer,
-															readptr_flags);
+		if (!reuse_buffer)
+			agg_winobj->readptr = tuplestore_alloc_read_pointer(winstate->buffer,
+																readptr_flags);
 		agg_winobj->markpos = -1;
 		agg_winobj->seekpos = -1;
 
@@ -1106,10 +1362,13 @@ begin_partition(WindowAggState *winstate)
 		{
 			WindowObject winobj = perfuncstate->winobj;
 
-			winobj->markptr = tuplestore_alloc_read_pointer(winstate->buffer,
-															0);
-			winobj->readptr = tuplestore_alloc_read_pointer(winstate->buffer,
-														 EXEC_FLAG_BACKWARD);
+			if (!reuse_buffer)
+			{
+				winobj->markptr = tuplestore_alloc_read_pointer(winstate->buffer,
+																0);
+				winobj->readptr = tuplestore_alloc_read_pointer(winstate->buffer,
+															 EXEC_FLAG_BACKWARD);
+			}
 			winobj->markpos = -1;
 			winobj->seekpos = -1;
 		}
@@ -1198,6 +1457,10 @@ spool_tuples(WindowAggState *winstate, int64 pos)
  * release_partition
  * clear information kept within a partition, including
  * tuplestore and aggregate results.
+ *
+ * The emptied tuplestore is kept as spare_buffer for the next partition,
+ * which saves setting up a new one and its read pointers for every
+ * partition; ExecEndWindowAgg releases it for good.
  */
 static void
 release_partition(WindowAggState *winstate)
@@ -1228,7 +1491,11 @@ release_partition(WindowAggState *winstate)
 	}
 
 	if (winstate->buffer)
-		tuplestore_end(winstate->buffer);
+	{
+		Assert(winstate->spare_buffer == NULL);
+		tuplestore_clear(winstate->buffer);
+		winstate->spare_buffer = winstate->buffer;
+	}
 	winstate->buffer = NULL;
 	winstate->partition_spooled = false;
 }
@@ -2021,6 +2288,9 @@ ExecEndWindowAgg(WindowAggState *node)
 	int			i;
 
 	release_partition(node);
+	if (node->spare_buffer)
+		tuplestore_end(node->spare_buffer);
+	node->spare_buffer = NULL;
 
 	ExecClearTuple(node->ss.ss_ScanTupleSlot);
 	ExecClearTuple(node->first_part_slot);
@@ -2104,11 +2374,13 @@ initialize_peragg(WindowAggState *winstate, WindowFunc *wfunc,
 	AclResult	aclresult;
 	Oid			transfn_oid,
 				invtransfn_oid,
-				finalfn_oid;
+				finalfn_oid,
+				combinefn_oid;
 	bool		finalextra;
 	Expr	   *transfnexpr,
 			   *invtransfnexpr,
-			   *finalfnexpr;
+			   *finalfnexpr,
+			   *combinefnexpr;
 	Datum		textInitVal;
 	int			i;
 	ListCell   *lc;
@@ -2158,6 +2430,19 @@ initialize_peragg(WindowAggState *winstate, WindowFunc *wfunc,
 		initvalAttNo = Anum_pg_aggregate_agginitval;
 	}
 
+	/*
+	 * Without a moving-aggregate implementation, a combine function still
+	 * saves us from re-aggregating the whole frame whenever its head moves.
+	 * The same restrictions apply as above.
+	 */
+	if (!OidIsValid(invtransfn_oid) &&
+		OidIsValid(aggform->aggcombinefn) &&
+		!(winstate->frameOptions & FRAMEOPTION_START_UNBOUNDED_PRECEDING) &&
+		!contain_volatile_functions((Node *) wfunc))
+		peraggstate->combinefn_oid = combinefn_oid = aggform->aggcombinefn;
+	else
+		peraggstate->combinefn_oid = combinefn_oid = InvalidOid;
+
 	/*
 	 * ExecInitWindowAgg already checked permission to call aggregate function
 	 * ... but we still need to check the component functions
@@ -2202,6 +2487,16 @@ initialize_peragg(WindowAggState *winstate, WindowFunc *wfunc,
 							   get_func_name(finalfn_oid));
 			InvokeFunctionExecuteHook(finalfn_oid);
 		}
+
+		if (OidIsValid(combinefn_oid))
+		{
+			aclresult = pg_proc_aclcheck(combinefn_oid, aggOwner,
+										 ACL_EXECUTE);
+			if (aclresult != ACLCHECK_OK)
+				aclcheck_error(aclresult, ACL_KIND_PROC,
+							   get_func_name(combinefn_oid));
+			InvokeFunctionExecuteHook(combinefn_oid);
+		}
 	}
 
 	/* Detect how many arguments to pass to the finalfn */
@@ -2248,6 +2543,16 @@ initialize_peragg(WindowAggState *winstate, WindowFunc *wfunc,
 		fmgr_info_set_expr((Node *) finalfnexpr, &peraggstate->finalfn);
 	}
 
+	if (OidIsValid(combinefn_oid))
+	{
+		build_aggregate_combinefn_expr(aggtranstype,
+									   wfunc->inputcollid,
+									   combinefn_oid,
+									   &combinefnexpr);
+		fmgr_info(combinefn_oid, &peraggstate->combinefn);
+		fmgr_info_set_expr((Node *) combinefnexpr, &peraggstate->combinefn);
+	}
+
 	/* get info about relevant datatypes */
 	get_typlenbyval(wfunc->wintype,
 					&peraggstate->resulttypeLen,
@@ -2313,8 +2618,11 @@ initialize_peragg(WindowAggState *winstate, WindowFunc *wfunc,
 	 * make the memory allocation rules for moving aggregates different than
 	 * they have historically been for plain aggregates, but that seems grotty
 	 * and likely to lead to memory leaks.
+	 *
+	 * Aggregates using a combine function don't restart when the others do,
+	 * either, so they need their own aggcontext too.
 	 */
-	if (OidIsValid(invtransfn_oid))
+	if (OidIsValid(invtransfn_oid) || OidIsValid(combinefn_oid))
 		peraggstate->aggcontext =
 			AllocSetContextCreate(CurrentMemoryContext,
 								  "WindowAgg_AggregatePrivate",
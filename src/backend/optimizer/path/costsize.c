@@ -117,6 +117,7 @@ bool		enable_nestloop = true;
 bool		enable_material = true;
 bool		enable_mergejoin = true;
 bool		enable_hashjoin = true;
+bool		enable_union_or = true;
 
 typedef struct
 {
@@ -1546,6 +1547,56 @@ cost_agg(Path *path, PlannerInfo *root,
 	path->total_cost = total_cost;
 }
 
+/*
+ * cost_hashagg_spill
+ *		Adds the cost of spilling to disk to a hashed grouping step whose
+ *		hash table won't fit in work_mem.
+ *
+ * 'path' has already been costed by cost_agg (or an equivalent).
+ * 'hashentrysize' is the estimated space per hash table entry, and
+ * 'input_tuples' and 'input_width' describe the input.
+ *
+ * When the hash table fills up, the input tuples of groups that aren't in
+ * it are written to temporary files, partitioned by hash value, and read
+ * back in a later pass; a partition that still doesn't fit is partitioned
+ * again.  We assume the input tuples are spread evenly over the groups, so
+ * the fraction of the input that gets spilled is the fraction of the groups
+ * that don't fit.  Each spilled page is written and read once per pass, at
+ * seq_page_cost, and each spilled tuple costs an extra hash table probe.
+ */
+void
+cost_hashagg_spill(Path *path, double hashentrysize, double numGroups,
+				   double input_tuples, int input_width)
+{
+	double		work_mem_bytes = work_mem * 1024L;
+	double		table_bytes = hashentrysize * numGroups;
+	double		spill_fraction;
+	double		spill_tuples;
+	double		npages;
+	double		npasses;
+	Cost		spill_cost;
+
+	if (table_bytes <= work_mem_bytes)
+		return;
+
+	spill_fraction = 1.0 - work_mem_bytes / table_bytes;
+	spill_tuples = clamp_row_est(input_tuples * spill_fraction);
+	npages = ceil(relation_byte_size(spill_tuples, input_width) / BLCKSZ);
+
+	/* each pass divides the spilled groups among the partitions */
+	npasses = ceil(log(table_bytes / work_mem_bytes) /
+				   log(TUPLE_HASH_SPILL_PARTITIONS));
+	if (npasses < 1.0)
+		npasses = 1.0;
+
+	spill_cost = npasses * (2.0 * seq_page_cost * npages +
+							cpu_operator_cost * spill_tuples);
+
+	/* the first pass spills before any output is produced */
+	path->startup_cost += spill_cost / npasses;
+	path->total_cost += spill_cost;
+}
+
 /*
  * cost_windowagg
  *		Determines and returns the cost of performing a WindowAgg plan node,
@@ -3031,16 +3082,38 @@ cost_qual_eval_walker(Node *node, cost_qual_eval_context *context)
 	}
 	else if (IsA(node, ScalarArrayOpExpr))
 	{
-		/*
-		 * Estimate that the operator will be applied to about half of the
-		 * array elements before the answer is determined.
-		 */
 		ScalarArrayOpExpr *saop = (ScalarArrayOpExpr *) node;
 		Node	   *arraynode = (Node *) lsecond(saop->args);
+		int			nelems = estimate_array_length(arraynode);
+		Oid			eqop;
+		Oid			lhs_hashfn;
+		Oid			rhs_hashfn;
 
 		set_sa_opfuncid(saop);
-		context->total.per_tuple += get_func_cost(saop->opfuncid) *
-			cpu_operator_cost * estimate_array_length(arraynode) * 0.5;
+		if (IsA(arraynode, Const) &&
+			nelems >= MIN_ARRAY_SIZE_FOR_HASHED_SAOP &&
+			ExecScalarArrayOpCanHash(saop, &eqop, &lhs_hashfn, &rhs_hashfn))
+		{
+			/*
+			 * The executor will load the array into a hash table once, and
+			 * then needs one hash calculation and usually one comparison per
+			 * row.
+			 */
+			context->total.startup += get_func_cost(rhs_hashfn) *
+				cpu_operator_cost * nelems;
+			context->total.per_tuple += (get_func_cost(lhs_hashfn) +
+										 get_func_cost(saop->opfuncid)) *
+				cpu_operator_cost;
+		}
+		else
+		{
+			/*
+			 * Estimate that the operator will be applied to about half of the
+			 * array elements before the answer is determined.
+			 */
+			context->total.per_tuple += get_func_cost(saop->opfuncid) *
+				cpu_operator_cost * nelems * 0.5;
+		}
 	}
 	else if (IsA(node, Aggref) ||
 			 IsA(node, WindowFunc))
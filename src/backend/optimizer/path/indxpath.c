@@ -772,13 +772,16 @@ get_index_paths(PlannerInfo *root, RelOptInfo *rel,
 	 * Also, pick out the ones that are usable as bitmap scans.  For that, we
 	 * must discard indexes that don't support bitmap scans, and we also are
 	 * only interested in paths that have some selectivity; we should discard
-	 * anything that was generated solely for ordering purposes.
+	 * anything that was generated solely for ordering purposes.  An AM whose
+	 * amgettuple is only meant for ordered scans gets plain index paths only
+	 * when they use ORDER BY operators.
 	 */
 	foreach(lc, indexpaths)
 	{
 		IndexPath  *ipath = (IndexPath *) lfirst(lc);
 
-		if (index->amhasgettuple)
+		if (index->amhasgettuple &&
+			(ipath->indexorderbys != NIL || !index->amorderbyonly))
 			add_path(rel, (Path *) ipath);
 
 		if (index->amhasgetbitmap &&
@@ -68,6 +68,12 @@ typedef struct
 } standard_qp_extra;
 
 /* Local functions */
+static Plan *plan_query_level(PlannerGlobal *glob, Query *parse,
+				 PlannerInfo *parent_root,
+				 bool hasRecursion, double tuple_fraction,
+				 PlannerInfo **subroot, Query **unconverted);
+static Cost plan_cost_for_fraction(Plan *plan, double tuple_fraction);
+static void discard_subplans(PlannerGlobal *glob, int first, int last);
 static Node *preprocess_expression(PlannerInfo *root, Node *expr, int kind);
 static void preprocess_qual_conditions(PlannerInfo *root, Node *jtnode);
 static Plan *inheritance_planner(PlannerInfo *root);
@@ -100,6 +106,8 @@ static void locate_grouping_columns(PlannerInfo *root,
 						AttrNumber *groupColIdx);
 static List *postprocess_setop_tlist(List *new_tlist, List *orig_tlist);
 static List *select_active_windows(PlannerInfo *root, WindowFuncLists *wflists);
+static bool sortkeys_are_prefix(List *a, List *b);
+static List *list_insert_at(List *list, int n, void *datum);
 static List *make_windowInputTargetList(PlannerInfo *root,
 						   List *tlist, List *activeWindows);
 static List *make_pathkeys_for_window(PlannerInfo *root, WindowClause *wc,
@@ -178,6 +186,7 @@ standard_planner(Query *parse, int cursorOptions, ParamListInfo boundParams)
 	glob->lastRowMarkId = 0;
 	glob->transientPlan = false;
 	glob->hasRowSecurity = false;
+	glob->choosingAggSublinks = false;
 
 	/* Determine what fraction of the plan is likely to be scanned */
 	if (cursorOptions & CURSOR_OPT_FAST_PLAN)
@@ -233,6 +242,10 @@ standard_planner(Query *parse, int cursorOptions, ParamListInfo boundParams)
 		Plan	   *subplan = (Plan *) lfirst(lp);
 		PlannerInfo *subroot = (PlannerInfo *) lfirst(lr);
 
+		/* skip subplans discarded by subquery_planner */
+		if (subplan == NULL)
+			continue;
+
 		lfirst(lp) = set_plan_references(subroot, subplan);
 	}
 
@@ -293,6 +306,72 @@ subquery_planner(PlannerGlobal *glob, Query *parse,
 				 PlannerInfo *parent_root,
 				 bool hasRecursion, double tuple_fraction,
 				 PlannerInfo **subroot)
+{
+	int			num_old_subplans = list_length(glob->subplans);
+	int			num_converted_subplans;
+	bool		outer_choice = glob->choosingAggSublinks;
+	Query	   *unconverted = NULL;
+	PlannerInfo *root;
+	PlannerInfo *altroot;
+	Plan	   *plan;
+	Plan	   *altplan;
+
+	plan = plan_query_level(glob, parse, parent_root,
+							hasRecursion, tuple_fraction,
+							&root, &unconverted);
+
+	/*
+	 * If pull_up_agg_sublinks converted any sub-SELECTs to joins, plan the
+	 * query again as it was before, with SubPlans, and keep whichever plan
+	 * is cheaper.  The subplans made for the other one are discarded.
+	 *
+	 * Only the outermost query level that converts anything makes this
+	 * choice.  The levels below it are planned once in each of its two
+	 * passes, and just keep their conversions; otherwise nested sub-SELECTs
+	 * would cost two plannings per level, exponential in the nesting depth.
+	 */
+	if (unconverted != NULL && !outer_choice)
+	{
+		num_converted_subplans = list_length(glob->subplans);
+
+		altplan = plan_query_level(glob, unconverted, parent_root,
+								   hasRecursion, tuple_fraction,
+								   &altroot, NULL);
+
+		if (plan_cost_for_fraction(altplan, tuple_fraction) <
+			plan_cost_for_fraction(plan, tuple_fraction))
+		{
+			discard_subplans(glob, num_old_subplans, num_converted_subplans);
+			plan = altplan;
+			root = altroot;
+		}
+		else
+			discard_subplans(glob, num_converted_subplans,
+							 list_length(glob->subplans));
+
+		glob->choosingAggSublinks = false;
+	}
+
+	/* Return internal info if caller wants it */
+	if (subroot)
+		*subroot = root;
+
+	return plan;
+}
+
+/*
+ * plan_query_level
+ *	  Does the work of subquery_planner for one way of planning the query.
+ *
+ * If unconverted isn't NULL, correlated aggregate sub-SELECTs may be
+ * converted to joins, and *unconverted is set to a copy of the query from
+ * before the conversion if that happens (else NULL).
+ */
+static Plan *
+plan_query_level(PlannerGlobal *glob, Query *parse,
+				 PlannerInfo *parent_root,
+				 bool hasRecursion, double tuple_fraction,
+				 PlannerInfo **subroot, Query **unconverted)
 {
 	int			num_old_subplans = list_length(glob->subplans);
 	PlannerInfo *root;
@@ -332,6 +411,17 @@ subquery_planner(PlannerGlobal *glob, Query *parse,
 	if (parse->cteList)
 		SS_process_ctes(root);
 
+	/*
+	 * Look for correlated aggregate sub-SELECTs in the targetlist that can be
+	 * computed by outer joins to grouped subqueries instead.
+	 */
+	if (parse->hasSubLinks && unconverted != NULL)
+	{
+		*unconverted = pull_up_agg_sublinks(root);
+		if (*unconverted != NULL)
+			glob->choosingAggSublinks = true;
+	}
+
 	/*
 	 * Look for ANY and EXISTS SubLinks in WHERE and JOIN/ON clauses, and try
 	 * to transform them into joins.  Note that this step does not descend
@@ -626,13 +716,47 @@ subquery_planner(PlannerGlobal *glob, Query *parse,
 		root->glob->nParamExec > 0)
 		SS_finalize_plan(root, plan, true);
 
-	/* Return internal info if caller wants it */
-	if (subroot)
-		*subroot = root;
+	*subroot = root;
 
 	return plan;
 }
 
+/*
+ * plan_cost_for_fraction
+ *	  Estimate the cost of fetching the given fraction of a plan's output,
+ *	  with tuple_fraction interpreted as for grouping_planner.
+ */
+static Cost
+plan_cost_for_fraction(Plan *plan, double tuple_fraction)
+{
+	if (tuple_fraction >= 1.0 && plan->plan_rows > 0)
+		tuple_fraction /= plan->plan_rows;
+	if (tuple_fraction <= 0.0 || tuple_fraction >= 1.0)
+		return plan->total_cost;
+
+	return plan->startup_cost +
+		(plan->total_cost - plan->startup_cost) * tuple_fraction;
+}
+
+/*
+ * discard_subplans
+ *	  Forget the subplans numbered first to last - 1 (counting from 0),
+ *	  made while planning a query level in a way that wasn't chosen.
+ *
+ * Nothing refers to them, but their plan IDs must stay assigned, so their
+ * entries in glob->subplans are just set to NULL.  standard_planner skips
+ * them when setting plan references, so their range table entries and row
+ * marks don't reach the executor, which accepts the NULL entries.
+ */
+static void
+discard_subplans(PlannerGlobal *glob, int first, int last)
+{
+	int			i;
+
+	for (i = first; i < last; i++)
+		lfirst(list_nth_cell(glob->subplans, i)) = NULL;
+}
+
 /*
  * preprocess_expression
  *		Do subquery_planner's preprocessing work for an expression,
@@ -1277,6 +1401,13 @@ grouping_planner(PlannerInfo *root, double tuple_fraction)
 			preprocess_minmax_aggregates(root, tlist);
 		}
 
+		/*
+		 * Plan the arms of a cross-table OR in WHERE separately, in case a
+		 * union of their results is cheaper than the regular plan.  Like
+		 * the MIN/MAX case, this must happen before query_planner.
+		 */
+		preprocess_union_or(root, sub_tlist);
+
 		/* Make tuple_fraction accessible to lower-level routines */
 		root->tuple_fraction = tuple_fraction;
 
@@ -1530,8 +1661,19 @@ grouping_planner(PlannerInfo *root, double tuple_fraction)
 			 */
 			bool		need_sort_for_grouping = false;
 
-			result_plan = create_plan(root, best_path);
-			current_pathkeys = best_path->pathkeys;
+			/*
+			 * If a union of separately planned OR arms is cheaper, use that
+			 * instead; it produces the same Vars (plus some CTIDs), but in
+			 * no useful order.
+			 */
+			result_plan = optimize_union_or(root, best_path, tuple_fraction);
+			if (result_plan != NULL)
+				current_pathkeys = NIL;
+			else
+			{
+				result_plan = create_plan(root, best_path);
+				current_pathkeys = best_path->pathkeys;
+			}
 
 			/* Detect if we'll need an explicit sort for grouping */
 			if (parse->groupClause && !use_hashed_grouping &&
@@ -2750,8 +2892,8 @@ choose_hashed_grouping(PlannerInfo *root,
 		return false;
 
 	/*
-	 * Don't do it if it doesn't look like the hashtable will fit into
-	 * work_mem.
+	 * Estimate the size of the hashtable, so that we can charge for spilling
+	 * to disk if it doesn't look like it will fit into work_mem.
 	 */
 
 	/* Estimate per-hash-entry space at tuple width... */
@@ -2761,9 +2903,6 @@ choose_hashed_grouping(PlannerInfo *root,
 	/* plus the per-hash-entry overhead */
 	hashentrysize += hash_agg_entry_size(agg_costs->numAggs);
 
-	if (hashentrysize * dNumGroups > work_mem * 1024L)
-		return false;
-
 	/*
 	 * When we have both GROUP BY and DISTINCT, use the more-rigorous of
 	 * DISTINCT and ORDER BY as the assumed required output sort order. This
@@ -2797,6 +2936,8 @@ choose_hashed_grouping(PlannerInfo *root,
 			 numGroupCols, dNumGroups,
 			 cheapest_path->startup_cost, cheapest_path->total_cost,
 			 path_rows);
+	cost_hashagg_spill(&hashed_p, hashentrysize, dNumGroups,
+					   path_rows, path_width);
 	/* Result of hashed agg is always unsorted */
 	if (target_pathkeys)
 		cost_sort(&hashed_p, root, target_pathkeys, hashed_p.total_cost,
@@ -2918,8 +3059,8 @@ choose_hashed_distinct(PlannerInfo *root,
 		return false;
 
 	/*
-	 * Don't do it if it doesn't look like the hashtable will fit into
-	 * work_mem.
+	 * Estimate the size of the hashtable, so that we can charge for spilling
+	 * to disk if it doesn't look like it will fit into work_mem.
 	 */
 
 	/* Estimate per-hash-entry space at tuple width... */
@@ -2927,9 +3068,6 @@ choose_hashed_distinct(PlannerInfo *root,
 	/* plus the per-hash-entry overhead */
 	hashentrysize += hash_agg_entry_size(0);
 
-	if (hashentrysize * dNumDistinctRows > work_mem * 1024L)
-		return false;
-
 	/*
 	 * See if the estimated cost is no more than doing it the other way. While
 	 * avoiding the need for sorted input is usually a win, the fact that the
@@ -2947,6 +3085,8 @@ choose_hashed_distinct(PlannerInfo *root,
 			 numDistinctCols, dNumDistinctRows,
 			 cheapest_startup_cost, cheapest_total_cost,
 			 path_rows);
+	cost_hashagg_spill(&hashed_p, hashentrysize, dNumDistinctRows,
+					   path_rows, path_width);
 
 	/*
 	 * Result of hashed agg is always unsorted, so if ORDER BY is present we
@@ -3295,6 +3435,8 @@ select_active_windows(PlannerInfo *root, WindowFuncLists *wflists)
 {
 	List	   *result;
 	List	   *actives;
+	List	   *groups = NIL;
+	List	   *groupkeys = NIL;
 	ListCell   *lc;
 
 	/* First, make a list of the active windows */
@@ -3315,24 +3457,36 @@ select_active_windows(PlannerInfo *root, WindowFuncLists *wflists)
 	 * says that only one sort is to be used for such windows, even if they
 	 * are otherwise distinct (eg, different names or framing clauses).
 	 *
-	 * There is room to be much smarter here, for example detecting whether
-	 * one window's sort keys are a prefix of another's (so that sorting for
-	 * the latter would do for the former), or putting windows first that
-	 * match a sort order available for the underlying query.  For the moment
-	 * we are content with meeting the spec.
+	 * Beyond that, if one window's sort keys are a prefix of another's, we
+	 * want the window with the longer list to come first, so that sorting
+	 * for it also serves the other one.  (grouping_planner stacks the
+	 * WindowAgg nodes in list order, so the first window in the list is the
+	 * lowest WindowAgg and its input is sorted first.)  So each group of
+	 * identical windows is placed just before the first group already chosen
+	 * whose keys are a prefix of its own, or else just after the last one
+	 * whose keys its own are a prefix of.  Otherwise we keep the windows in
+	 * the order written, since that determines the order of the query's
+	 * output when there's no ORDER BY.  Windows with no sort keys at all need
+	 * no sort and stay put.
+	 *
+	 * There is room to be smarter still, for example putting windows first
+	 * that match a sort order available for the underlying query.
 	 */
-	result = NIL;
 	while (actives != NIL)
 	{
 		WindowClause *wc = (WindowClause *) linitial(actives);
+		List	   *group;
+		List	   *keys;
 		ListCell   *prev;
 		ListCell   *next;
+		int			insertpos;
+		int			pos;
 
-		/* Move wc from actives to result */
+		/* Move wc from actives to a new group */
 		actives = list_delete_first(actives);
-		result = lappend(result, wc);
+		group = list_make1(wc);
 
-		/* Now move any matching windows from actives to result */
+		/* Now move any matching windows from actives to the group */
 		prev = NULL;
 		for (lc = list_head(actives); lc; lc = next)
 		{
@@ -3344,16 +3498,93 @@ select_active_windows(PlannerInfo *root, WindowFuncLists *wflists)
 				equal(wc->orderClause, wc2->orderClause))
 			{
 				actives = list_delete_cell(actives, lc, prev);
-				result = lappend(result, wc2);
+				group = lappend(group, wc2);
 			}
 			else
 				prev = lc;
 		}
+
+		/*
+		 * The sort keys are the partitioning clauses followed by the
+		 * ordering clauses; duplicates between the two are redundant, just
+		 * as in make_pathkeys_for_window.
+		 */
+		keys = list_concat_unique(list_copy(wc->partitionClause),
+								  wc->orderClause);
+
+		/* Decide where the group goes among those already placed */
+		insertpos = list_length(groups);
+		if (keys != NIL)
+		{
+			int			afterpos = -1;
+
+			pos = 0;
+			foreach(lc, groupkeys)
+			{
+				List	   *okeys = (List *) lfirst(lc);
+
+				if (okeys != NIL && sortkeys_are_prefix(okeys, keys))
+				{
+					/* we're stronger than this one, so go before it */
+					afterpos = -1;
+					insertpos = pos;
+					break;
+				}
+				if (sortkeys_are_prefix(keys, okeys))
+					afterpos = pos;
+				pos++;
+			}
+			if (afterpos >= 0)
+				insertpos = afterpos + 1;
+		}
+
+		groups = list_insert_at(groups, insertpos, group);
+		groupkeys = list_insert_at(groupkeys, insertpos, keys);
 	}
 
+	/* Flatten the groups into the result list */
+	result = NIL;
+	foreach(lc, groups)
+		result = list_concat(result, (List *) lfirst(lc));
+
 	return result;
 }
 
+/*
+ * sortkeys_are_prefix
+ *		Is SortGroupClause list a a prefix of (or equal to) list b?
+ */
+static bool
+sortkeys_are_prefix(List *a, List *b)
+{
+	ListCell   *lca;
+	ListCell   *lcb;
+
+	if (list_length(a) > list_length(b))
+		return false;
+	forboth(lca, a, lcb, b)
+	{
+		if (!equal(lfirst(lca), lfirst(lcb)))
+			return false;
+	}
+	return true;
+}
+
+/*
+ * list_insert_at
+ *		Insert datum into list so that it becomes the n'th member (counting
+ *		from 0).
+ */
+static List *
+list_insert_at(List *list, int n, void *datum)
+{
+	List	   *tail = list_copy_tail(list, n);
+
+	list = list_truncate(list, n);
+	list = lappend(list, datum);
+	return list_concat(list, tail);
+}
+
 /*
  * make_windowInputTargetList
  *	  Generate appropriate target list for initial input to WindowAgg nodes.
@@ -0,0 +1,475 @@
+/*-------------------------------------------------------------------------
+ *
+ * planunionor.c
+ *	  Consider converting cross-table OR clauses into UNION ALL of subplans.
+ *
+ * A WHERE clause such as "a.x = 1 OR b.y = 2" references more than one
+ * relation, so it can only be checked once the join has been formed and is
+ * no help in restricting the scans of either input.  Unless other clauses
+ * are selective, we end up computing most of the join and filtering it.
+ * This module instead plans the scan/join part of the query once for each
+ * arm of the OR, with that arm in place of the OR clause, so that each
+ * arm's restrictions can drive index scans; the results are then combined
+ * with an Append.  A join row satisfying more than one arm would be emitted
+ * by each of them, so each arm also returns the CTIDs of all the base
+ * relations, and we remove duplicates by sorting and uniquifying on those.
+ *
+ * As in planagg.c, the alternative paths have to be built before the main
+ * query_planner call, which is when we still have a pristine copy of the
+ * query tree.  Once the regular path is known, we compare costs and build
+ * whichever plan is cheaper.  Planning an arm costs about as much as planning
+ * the whole join again, so we only try this for OR clauses of up to
+ * UNION_OR_MAX_ARMS arms, and not at all if enable_union_or is off.
+ *
+ *
+ * Portions Copyright (c) 1996-2015, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/optimizer/plan/planunionor.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "access/sysattr.h"
+#include "catalog/pg_class.h"
+#include "catalog/pg_operator.h"
+#include "catalog/pg_type.h"
+#include "miscadmin.h"
+#include "nodes/makefuncs.h"
+#include "optimizer/clauses.h"
+#include "optimizer/cost.h"
+#include "optimizer/pathnode.h"
+#include "optimizer/paths.h"
+#include "optimizer/planmain.h"
+#include "optimizer/tlist.h"
+#include "optimizer/var.h"
+#include "parser/parse_clause.h"
+#include "parser/parsetree.h"
+#include "storage/itemptr.h"
+
+
+/* Maximum number of arms of an OR clause we plan separately */
+#define UNION_OR_MAX_ARMS	8
+
+/*
+ * Per-arm planning state, kept in root->union_or_arms between
+ * preprocess_union_or and optimize_union_or.
+ */
+typedef struct UnionOrArm
+{
+	PlannerInfo *subroot;		/* PlannerInfo for planning this arm */
+	Path	   *path;			/* cheapest path for this arm */
+} UnionOrArm;
+
+static bool collect_union_or_rels(PlannerInfo *root, Node *jtnode,
+					  List **rtindexes);
+static List *make_ctid_tlist(List *rtindexes, List *tlist);
+static UnionOrArm *build_union_or_arm(PlannerInfo *root, List *tlist,
+				   int orindex, Node *arm);
+static void union_or_qp_callback(PlannerInfo *root, void *extra);
+
+
+/*
+ * preprocess_union_or - plan the arms of a cross-table OR clause
+ *
+ * Check whether the query's WHERE clause contains an OR clause referencing
+ * more than one relation, and whether the query is simple enough that its
+ * scan/join result can be computed as a duplicate-free union.  If so, plan
+ * the scan/join part once per arm of the OR and save the results in
+ * root->union_or_arms.
+ *
+ * Note: we are passed the tlist that will be given to query_planner, which
+ * is not necessarily equal to root->parse->targetList.
+ */
+void
+preprocess_union_or(PlannerInfo *root, List *tlist)
+{
+	Query	   *parse = root->parse;
+	List	   *quals;
+	List	   *rtindexes = NIL;
+	List	   *ctid_tlist;
+	List	   *arms = NIL;
+	BoolExpr   *orclause = NULL;
+	int			orindex = 0;
+	ListCell   *lc;
+
+	/* union_or_arms list should be empty at this point */
+	Assert(root->union_or_arms == NIL);
+
+	Assert(!parse->setOperations);		/* shouldn't get here if a setop */
+
+	/*
+	 * Reject unoptimizable cases.  We only handle SELECTs without row
+	 * locking, since the scan/join output of each arm has to be usable
+	 * interchangeably with that of the whole query.  LATERAL references and
+	 * PlaceHolderVars would complicate matching up the arms' outputs, so
+	 * don't try in those cases either.
+	 */
+	if (!enable_union_or ||
+		parse->commandType != CMD_SELECT ||
+		parse->rowMarks != NIL ||
+		root->hasLateralRTEs ||
+		root->glob->lastPHId != 0)
+		return;
+
+	/*
+	 * Each row of the join must be identified by the CTIDs of its base rows,
+	 * so all the base relations must be plain tables and all the joins must
+	 * be ones that produce each combination of input rows at most once.
+	 */
+	if (!collect_union_or_rels(root, (Node *) parse->jointree, &rtindexes))
+		return;
+	if (list_length(rtindexes) < 2)
+		return;
+
+	/*
+	 * All the join and WHERE clauses will be evaluated once per arm, and a
+	 * row may be produced by several arms before duplicates are removed, so
+	 * give up if any of them are volatile.
+	 */
+	if (contain_volatile_functions((Node *) parse->jointree))
+		return;
+
+	/*
+	 * Look for an OR clause referencing more than one relation in the
+	 * top-level WHERE list (which is in implicit-AND format by now).  OR
+	 * clauses that reference just one relation are already handled by
+	 * index ORing or extract_restriction_or_clauses.
+	 */
+	quals = (List *) parse->jointree->quals;
+	foreach(lc, quals)
+	{
+		Node	   *qual = (Node *) lfirst(lc);
+
+		if (or_clause(qual) &&
+			list_length(((BoolExpr *) qual)->args) <= UNION_OR_MAX_ARMS &&
+			bms_membership(pull_varnos(qual)) == BMS_MULTIPLE)
+		{
+			orclause = (BoolExpr *) qual;
+			break;
+		}
+		orindex++;
+	}
+	if (orclause == NULL)
+		return;
+
+	/*
+	 * OK, plan each arm, requesting the CTIDs of all base relations in
+	 * addition to the Vars the regular plan would produce.
+	 */
+	ctid_tlist = make_ctid_tlist(rtindexes, tlist);
+
+	foreach(lc, orclause->args)
+	{
+		Node	   *arm = (Node *) lfirst(lc);
+
+		arms = lappend(arms,
+					   build_union_or_arm(root, ctid_tlist, orindex, arm));
+	}
+
+	/* We're done until path generation is complete.  Save info for later. */
+	root->union_or_arms = arms;
+}
+
+/*
+ * optimize_union_or - check for implementing the query as a UNION of OR arms
+ *
+ * Check to see whether the union of the per-arm plans, with duplicates
+ * removed, is cheaper than best_path at the given tuple_fraction.  If so,
+ * generate and return a Plan that does it that way.  Otherwise, return NULL.
+ *
+ * The returned plan's tlist contains the Vars that create_plan would have
+ * produced for best_path, followed by the CTID columns used to remove
+ * duplicates.  It has no useful sort order.
+ */
+Plan *
+optimize_union_or(PlannerInfo *root, Path *best_path, double tuple_fraction)
+{
+	RelOptInfo *final_rel = best_path->parent;
+	List	   *rtindexes = NIL;
+	List	   *tlist;
+	List	   *sortcls = NIL;
+	List	   *subplans = NIL;
+	Path		union_p;
+	Path		regular_p;
+	Cost		input_cost = 0;
+	double		input_rows = 0;
+	int			nctids;
+	int			resno;
+	Plan	   *plan;
+	ListCell   *lc;
+
+	/* Nothing to do if preprocess_union_or rejected the query */
+	if (root->union_or_arms == NIL)
+		return NULL;
+
+	/*
+	 * Build the tlist of the result: the regular scan/join output, plus the
+	 * CTIDs.  We make the CTIDs sort/group columns so that the Sort and
+	 * Unique nodes can find them.
+	 */
+	(void) collect_union_or_rels(root, (Node *) root->parse->jointree,
+								 &rtindexes);
+	nctids = list_length(rtindexes);
+
+	tlist = NIL;
+	resno = 1;
+	foreach(lc, final_rel->reltargetlist)
+	{
+		Node	   *node = (Node *) lfirst(lc);
+
+		tlist = lappend(tlist, makeTargetEntry((Expr *) copyObject(node),
+											   resno++, NULL, false));
+	}
+	foreach(lc, make_ctid_tlist(rtindexes, NIL))
+	{
+		TargetEntry *tle = (TargetEntry *) lfirst(lc);
+		SortGroupClause *sortcl;
+
+		tle->resno = resno++;
+		tlist = lappend(tlist, tle);
+
+		sortcl = makeNode(SortGroupClause);
+		sortcl->tleSortGroupRef = assignSortGroupRef(tle, tlist);
+		sortcl->eqop = TIDEqualOperator;
+		sortcl->sortop = TIDLessOperator;
+		sortcl->nulls_first = false;
+		sortcl->hashable = false;
+		sortcls = lappend(sortcls, sortcl);
+	}
+
+	/*
+	 * Estimate the cost of appending the arms' outputs, sorting them by CTID
+	 * and removing duplicates.  This doesn't account for rows eliminated as
+	 * duplicates, but it should be a small fraction in the cases where the
+	 * transformation is a win at all.
+	 */
+	foreach(lc, root->union_or_arms)
+	{
+		UnionOrArm *arm = (UnionOrArm *) lfirst(lc);
+
+		input_cost += arm->path->total_cost;
+		input_rows += arm->path->parent->rows;
+	}
+
+	cost_sort(&union_p, root, NIL, input_cost, input_rows,
+			  final_rel->width + nctids * sizeof(ItemPointerData),
+			  0.0, work_mem, -1.0);
+	union_p.total_cost += cpu_operator_cost * input_rows * nctids;
+
+	/*
+	 * If best_path delivers the ordering the rest of the query wants, the
+	 * union plan will have to be sorted to match it.
+	 */
+	regular_p.startup_cost = best_path->startup_cost;
+	regular_p.total_cost = best_path->total_cost;
+	if (root->query_pathkeys != NIL &&
+		pathkeys_contained_in(root->query_pathkeys, best_path->pathkeys))
+	{
+		cost_sort(&union_p, root, root->query_pathkeys,
+				  union_p.total_cost, final_rel->rows, final_rel->width,
+				  0.0, work_mem, root->limit_tuples);
+	}
+
+	if (compare_fractional_path_costs(&union_p, &regular_p,
+									  tuple_fraction) >= 0)
+		return NULL;			/* too expensive */
+
+	/*
+	 * OK, we are going to generate the union plan.  Create the plan for each
+	 * arm and make it emit the common tlist.
+	 */
+	foreach(lc, root->union_or_arms)
+	{
+		UnionOrArm *arm = (UnionOrArm *) lfirst(lc);
+		List	   *arm_tlist = (List *) copyObject(tlist);
+
+		plan = create_plan(arm->subroot, arm->path);
+
+		/*
+		 * If the top-level plan node is one that cannot do expression
+		 * evaluation and its existing target list isn't already what we
+		 * need, we must insert a Result node to project the desired tlist.
+		 */
+		if (!is_projection_capable_plan(plan) &&
+			!tlist_same_exprs(arm_tlist, plan->targetlist))
+			plan = (Plan *) make_result(arm->subroot, arm_tlist, NULL, plan);
+		else
+			plan->targetlist = arm_tlist;
+
+		subplans = lappend(subplans, plan);
+
+		/*
+		 * Make sure any initplans generated by the sub-planning run get into
+		 * the outer PlannerInfo, without duplicating the ones that were
+		 * copied into the arm's PlannerInfo to begin with.
+		 */
+		root->init_plans = list_concat_unique_ptr(root->init_plans,
+												  arm->subroot->init_plans);
+	}
+
+	plan = (Plan *) make_append(subplans, tlist);
+	plan = (Plan *) make_sort_from_sortclauses(root, sortcls, plan);
+	plan = (Plan *) make_unique(plan, sortcls);
+
+	return plan;
+}
+
+/*
+ * collect_union_or_rels
+ *		Build a list of the RT indexes of the base relations in the jointree.
+ *
+ * Returns FALSE if the jointree contains anything other than plain tables
+ * (which have CTIDs) joined by inner or outer joins.  Semi and anti joins
+ * are rejected because the CTIDs of their inner relations aren't available
+ * above the join.
+ */
+static bool
+collect_union_or_rels(PlannerInfo *root, Node *jtnode, List **rtindexes)
+{
+	if (jtnode == NULL)
+		return true;
+	if (IsA(jtnode, RangeTblRef))
+	{
+		int			varno = ((RangeTblRef *) jtnode)->rtindex;
+		RangeTblEntry *rte = rt_fetch(varno, root->parse->rtable);
+
+		if (rte->rtekind != RTE_RELATION || rte->inh ||
+			(rte->relkind != RELKIND_RELATION &&
+			 rte->relkind != RELKIND_MATVIEW))
+			return false;
+		*rtindexes = lappend_int(*rtindexes, varno);
+	}
+	else if (IsA(jtnode, FromExpr))
+	{
+		FromExpr   *f = (FromExpr *) jtnode;
+		ListCell   *l;
+
+		foreach(l, f->fromlist)
+		{
+			if (!collect_union_or_rels(root, lfirst(l), rtindexes))
+				return false;
+		}
+	}
+	else if (IsA(jtnode, JoinExpr))
+	{
+		JoinExpr   *j = (JoinExpr *) jtnode;
+
+		switch (j->jointype)
+		{
+			case JOIN_INNER:
+			case JOIN_LEFT:
+			case JOIN_FULL:
+			case JOIN_RIGHT:
+				break;
+			default:
+				return false;
+		}
+		if (!collect_union_or_rels(root, j->larg, rtindexes) ||
+			!collect_union_or_rels(root, j->rarg, rtindexes))
+			return false;
+	}
+	else
+		elog(ERROR, "unrecognized node type: %d",
+			 (int) nodeTag(jtnode));
+	return true;
+}
+
+/*
+ * make_ctid_tlist
+ *		Append resjunk CTID entries for the given relations to a copy of tlist.
+ */
+static List *
+make_ctid_tlist(List *rtindexes, List *tlist)
+{
+	List	   *result = list_copy(tlist);
+	ListCell   *lc;
+
+	foreach(lc, rtindexes)
+	{
+		Var		   *var;
+
+		var = makeVar(lfirst_int(lc),
+					  SelfItemPointerAttributeNumber,
+					  TIDOID,
+					  -1,
+					  InvalidOid,
+					  0);
+		result = lappend(result,
+						 makeTargetEntry((Expr *) var,
+										 list_length(result) + 1,
+										 NULL,
+										 true));
+	}
+	return result;
+}
+
+/*
+ * build_union_or_arm
+ *		Plan the scan/join part of the query with the OR clause at position
+ *		orindex of the WHERE list replaced by one of its arms.
+ */
+static UnionOrArm *
+build_union_or_arm(PlannerInfo *root, List *tlist, int orindex, Node *arm)
+{
+	PlannerInfo *subroot;
+	Query	   *parse;
+	List	   *newquals = NIL;
+	RelOptInfo *final_rel;
+	UnionOrArm *result;
+	ListCell   *lc;
+	int			i;
+
+	subroot = (PlannerInfo *) palloc(sizeof(PlannerInfo));
+	memcpy(subroot, root, sizeof(PlannerInfo));
+	subroot->parse = parse = (Query *) copyObject(root->parse);
+	/* make sure subroot planning won't change root->init_plans contents */
+	subroot->init_plans = list_copy(root->init_plans);
+	subroot->union_or_arms = NIL;
+	/* There shouldn't be any OJ or LATERAL info to translate, as yet */
+	Assert(subroot->join_info_list == NIL);
+	Assert(subroot->lateral_info_list == NIL);
+	/* and we haven't created PlaceHolderInfos, either */
+	Assert(subroot->placeholder_list == NIL);
+
+	/* Substitute the arm, flattened into the WHERE list, for the OR */
+	i = 0;
+	foreach(lc, (List *) parse->jointree->quals)
+	{
+		if (i++ == orindex)
+			newquals = list_concat(newquals,
+								   make_ands_implicit((Expr *) copyObject(arm)));
+		else
+			newquals = lappend(newquals, lfirst(lc));
+	}
+	parse->jointree->quals = (Node *) newquals;
+
+	/* We'll need all the rows of the arm, in no particular order */
+	subroot->tuple_fraction = 0.0;
+	subroot->limit_tuples = -1.0;
+
+	final_rel = query_planner(subroot, tlist, union_or_qp_callback, NULL);
+
+	result = (UnionOrArm *) palloc(sizeof(UnionOrArm));
+	result->subroot = subroot;
+	result->path = final_rel->cheapest_total_path;
+
+	return result;
+}
+
+/*
+ * Compute query_pathkeys and other pathkeys during plan generation
+ */
+static void
+union_or_qp_callback(PlannerInfo *root, void *extra)
+{
+	/* The arms' outputs are merged and re-sorted, so no ordering is useful */
+	root->group_pathkeys = NIL;
+	root->window_pathkeys = NIL;
+	root->distinct_pathkeys = NIL;
+	root->sort_pathkeys = NIL;
+	root->query_pathkeys = NIL;
+}
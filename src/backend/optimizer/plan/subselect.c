@@ -14,6 +14,8 @@
 #include "postgres.h"
 
 #include "access/htup_details.h"
+#include "catalog/pg_aggregate.h"
+#include "catalog/pg_inherits_fn.h"
 #include "catalog/pg_operator.h"
 #include "catalog/pg_type.h"
 #include "executor/executor.h"
@@ -27,9 +29,13 @@
 #include "optimizer/prep.h"
 #include "optimizer/subselect.h"
 #include "optimizer/var.h"
+#include "parser/parse_clause.h"
+#include "parser/parse_oper.h"
 #include "parser/parse_relation.h"
+#include "parser/parsetree.h"
 #include "rewrite/rewriteManip.h"
 #include "utils/builtins.h"
+#include "utils/fmgroids.h"
 #include "utils/lsyscache.h"
 #include "utils/syscache.h"
 
@@ -46,6 +52,28 @@ typedef struct process_sublinks_context
 	bool		isTopQual;
 } process_sublinks_context;
 
+typedef struct inline_cte_walker_context
+{
+	const char *ctename;		/* name and relative level of target CTE */
+	int			levelsup;
+	Query	   *ctequery;		/* query to substitute */
+} inline_cte_walker_context;
+
+typedef struct CteRefInfo
+{
+	Query	   *query;			/* query containing a reference to the CTE */
+	List	   *clauses;		/* its WHERE clauses, in implicit-AND form */
+	List	   *pushable;		/* per clause, a copy to apply to the CTE
+								 * query, or NULL if the clause can't be */
+} CteRefInfo;
+
+typedef struct find_cte_refs_context
+{
+	const char *ctename;		/* name and relative level of target CTE */
+	int			levelsup;
+	List	   *refs;			/* CteRefInfos of the references found */
+} find_cte_refs_context;
+
 typedef struct finalize_primnode_context
 {
 	PlannerInfo *root;
@@ -70,6 +98,26 @@ static Node *convert_testexpr_mutator(Node *node,
 static bool subplan_is_hashable(Plan *plan);
 static bool testexpr_is_hashable(Node *testexpr);
 static bool hash_ok_operator(OpExpr *expr);
+static bool contain_dml(Node *node);
+static bool contain_dml_walker(Node *node, void *context);
+static bool contain_outer_selfref(Node *node);
+static bool contain_outer_selfref_walker(Node *node, Index *depth);
+static void inline_cte(PlannerInfo *root, CommonTableExpr *cte);
+static bool inline_cte_walker(Node *node, inline_cte_walker_context *context);
+static Query *push_down_cte_quals(PlannerInfo *root, CommonTableExpr *cte,
+					Query *subquery);
+static bool find_cte_refs_walker(Node *node, find_cte_refs_context *context);
+static CteRefInfo *make_cte_ref_info(Query *query, Index rtindex);
+static bool cte_qual_unsafe_walker(Node *node, Index *rtindex);
+static Query *make_cte_filter_query(CommonTableExpr *cte, Query *ctequery,
+					  List *quals);
+static bool NOT_IN_is_anti_join(Query *parse, Query *subselect,
+					Node *testexpr);
+static Relids find_nullable_rels(FromExpr *jointree);
+static Relids find_nullable_rels_recurse(Node *jtnode);
+static bool expr_is_nonnullable(Query *query, Relids nullable_rels,
+					List *nonnullable_vars, Node *expr);
+static Node *aggregate_empty_result(Aggref *aggref);
 static bool simplify_EXISTS_query(PlannerInfo *root, Query *query);
 static Query *convert_EXISTS_to_ANY(PlannerInfo *root, Query *subselect,
 					  Node **testexpr, List **paramIds);
@@ -1105,12 +1153,53 @@ SS_process_ctes(PlannerInfo *root)
 			continue;
 		}
 
+		/*
+		 * Consider replacing the references to the CTE by sub-selects, so
+		 * that the CTE query can be planned jointly with the rest of the
+		 * query (restrictions pushed into it, joins reordered, and so on).
+		 *
+		 * That changes the semantics if the CTE query has side-effects: it
+		 * would no longer be executed exactly once.  So we only do it for
+		 * non-recursive plain SELECTs without volatile functions.  Other
+		 * than that, inlining is a good bet if there is a single reference,
+		 * but with several it means computing the CTE query several times.
+		 * We can't tell whether that pays off, so by default we inline only
+		 * singly-referenced CTEs and let the user force the choice either way
+		 * with MATERIALIZED or NOT MATERIALIZED.
+		 *
+		 * A multiply-referenced CTE also must not be inlined if its query
+		 * contains the self-reference of an enclosing recursive CTE, since
+		 * we'd end up with more than one scan of the recursive worktable.
+		 */
+		if ((cte->ctematerialized == CTEMaterializeNever ||
+			 (cte->ctematerialized == CTEMaterializeDefault &&
+			  cte->cterefcount == 1)) &&
+			!cte->cterecursive &&
+			cmdType == CMD_SELECT &&
+			!contain_dml(cte->ctequery) &&
+			(cte->cterefcount <= 1 ||
+			 !contain_outer_selfref(cte->ctequery)) &&
+			!contain_volatile_functions(cte->ctequery))
+		{
+			inline_cte(root, cte);
+			/* Make a dummy entry in cte_plan_ids */
+			root->cte_plan_ids = lappend_int(root->cte_plan_ids, -1);
+			continue;
+		}
+
 		/*
 		 * Copy the source Query node.  Probably not necessary, but let's keep
 		 * this similar to make_subplan.
 		 */
 		subquery = (Query *) copyObject(cte->ctequery);
 
+		/*
+		 * If every reference to a materialized SELECT CTE filters its rows
+		 * the same way, apply that filter within the CTE instead.
+		 */
+		if (cmdType == CMD_SELECT && !cte->cterecursive)
+			subquery = push_down_cte_quals(root, cte, subquery);
+
 		/* plan_params should not be in use in current query level */
 		Assert(root->plan_params == NIL);
 
@@ -1186,6 +1275,428 @@ SS_process_ctes(PlannerInfo *root)
 	}
 }
 
+/*
+ * contain_dml: is any subquery not a plain SELECT?
+ *
+ * We reject SELECT FOR UPDATE/SHARE as well as INSERT etc.
+ */
+static bool
+contain_dml(Node *node)
+{
+	return contain_dml_walker(node, NULL);
+}
+
+static bool
+contain_dml_walker(Node *node, void *context)
+{
+	if (node == NULL)
+		return false;
+	if (IsA(node, Query))
+	{
+		Query	   *query = (Query *) node;
+
+		if (query->commandType != CMD_SELECT ||
+			query->rowMarks != NIL)
+			return true;
+
+		return query_tree_walker(query, contain_dml_walker, context, 0);
+	}
+	return expression_tree_walker(node, contain_dml_walker, context);
+}
+
+/*
+ * contain_outer_selfref: is there an external recursive self-reference?
+ *
+ * That is, does the given query contain a recursive self-reference to a CTE
+ * defined at some level above the query itself?
+ */
+static bool
+contain_outer_selfref(Node *node)
+{
+	Index		depth = 0;
+
+	/*
+	 * We should be starting with a Query, so that depth will be 1 while
+	 * examining its immediate contents.
+	 */
+	Assert(IsA(node, Query));
+
+	return contain_outer_selfref_walker(node, &depth);
+}
+
+static bool
+contain_outer_selfref_walker(Node *node, Index *depth)
+{
+	if (node == NULL)
+		return false;
+	if (IsA(node, RangeTblEntry))
+	{
+		RangeTblEntry *rte = (RangeTblEntry *) node;
+
+		/*
+		 * Check for a self-reference to a CTE that's above the Query that our
+		 * search started at.
+		 */
+		if (rte->rtekind == RTE_CTE &&
+			rte->self_reference &&
+			rte->ctelevelsup >= *depth)
+			return true;
+		return false;			/* allow range_table_walker to continue */
+	}
+	if (IsA(node, Query))
+	{
+		/* Recurse into subquery, tracking nesting depth properly */
+		Query	   *query = (Query *) node;
+		bool		result;
+
+		(*depth)++;
+
+		result = query_tree_walker(query, contain_outer_selfref_walker,
+								   (void *) depth, QTW_EXAMINE_RTES);
+
+		(*depth)--;
+
+		return result;
+	}
+	return expression_tree_walker(node, contain_outer_selfref_walker,
+								  (void *) depth);
+}
+
+/*
+ * inline_cte: convert RTE_CTE references to given CTE into RTE_SUBQUERYs
+ */
+static void
+inline_cte(PlannerInfo *root, CommonTableExpr *cte)
+{
+	inline_cte_walker_context context;
+
+	context.ctename = cte->ctename;
+	/* Start at levelsup = -1 because we'll immediately increment it */
+	context.levelsup = -1;
+	context.ctequery = (Query *) cte->ctequery;
+
+	(void) inline_cte_walker((Node *) root->parse, &context);
+}
+
+static bool
+inline_cte_walker(Node *node, inline_cte_walker_context *context)
+{
+	if (node == NULL)
+		return false;
+	if (IsA(node, Query))
+	{
+		Query	   *query = (Query *) node;
+
+		context->levelsup++;
+
+		/*
+		 * range_table_walker will descend into each newly inlined copy of
+		 * the CTE query right after we convert the RTE.  That's harmless,
+		 * since a non-recursive CTE query can't contain references to the
+		 * CTE itself.
+		 */
+		(void) query_tree_walker(query, inline_cte_walker, context,
+								 QTW_EXAMINE_RTES);
+
+		context->levelsup--;
+
+		return false;
+	}
+	else if (IsA(node, RangeTblEntry))
+	{
+		RangeTblEntry *rte = (RangeTblEntry *) node;
+
+		if (rte->rtekind == RTE_CTE &&
+			strcmp(rte->ctename, context->ctename) == 0 &&
+			rte->ctelevelsup == context->levelsup)
+		{
+			/*
+			 * Found a reference to replace.  Generate a copy of the CTE query
+			 * with appropriate level adjustment for outer references (e.g.,
+			 * to other CTEs).
+			 */
+			Query	   *newquery = copyObject(context->ctequery);
+
+			if (context->levelsup > 0)
+				IncrementVarSublevelsUp((Node *) newquery, context->levelsup, 1);
+
+			/*
+			 * Convert the RTE_CTE RTE into a RTE_SUBQUERY.
+			 *
+			 * Historically, a FOR UPDATE clause has been treated as extending
+			 * into views and subqueries, but not into CTEs.  We preserve this
+			 * distinction by not trying to push rowmarks into the new
+			 * subquery.
+			 */
+			rte->rtekind = RTE_SUBQUERY;
+			rte->subquery = newquery;
+			rte->security_barrier = false;
+
+			/* Zero out CTE-specific fields */
+			rte->ctename = NULL;
+			rte->ctelevelsup = 0;
+			rte->self_reference = false;
+			rte->ctecoltypes = NIL;
+			rte->ctecoltypmods = NIL;
+			rte->ctecolcollations = NIL;
+		}
+
+		return false;
+	}
+
+	return expression_tree_walker(node, inline_cte_walker, context);
+}
+
+/*
+ * push_down_cte_quals: apply restrictions common to all references to a CTE
+ * within the CTE query itself
+ *
+ * A CTE that is not inlined is computed in full, however little of its
+ * output the references need.  But if every reference throws away the rows
+ * failing some restriction, we can just as well not produce those rows in
+ * the first place.  We look for restriction clauses of the WHERE clauses of
+ * the queries containing the references that use only the CTE's columns,
+ * and that appear identically at every reference; those are removed from
+ * the references and applied to the CTE query instead.  This is a
+ * significant win if the restriction can use an index of a table the CTE
+ * query scans, or reduces the volume of materialized rows.
+ *
+ * To keep things simple, we only consider references appearing directly in
+ * a query's top-level FROM list.  A reference on the nullable side of an
+ * outer join would need more care.
+ *
+ * subquery is the (copied) CTE query; the result is either it, or a new
+ * query wrapping it that applies the restrictions.  We build a wrapper
+ * rather than modifying the CTE query's WHERE clause so that the planner's
+ * usual rules for pushing restrictions into subqueries apply to it.
+ */
+static Query *
+push_down_cte_quals(PlannerInfo *root, CommonTableExpr *cte, Query *subquery)
+{
+	find_cte_refs_context context;
+	List	   *common = NIL;
+	CteRefInfo *firstref;
+	ListCell   *lc;
+	ListCell   *lc2;
+	ListCell   *lc3;
+
+	if (subquery->rowMarks != NIL)
+		return subquery;
+
+	context.ctename = cte->ctename;
+	/* Start at levelsup = -1 because we'll immediately increment it */
+	context.levelsup = -1;
+	context.refs = NIL;
+	(void) find_cte_refs_walker((Node *) root->parse, &context);
+
+	/*
+	 * If we didn't find every reference, something is odd; don't risk
+	 * removing restrictions from the references we did find.
+	 */
+	if (list_length(context.refs) != cte->cterefcount)
+		return subquery;
+
+	/* Find the pushable clauses present at every reference */
+	firstref = (CteRefInfo *) linitial(context.refs);
+	foreach(lc, firstref->pushable)
+	{
+		Node	   *clause = (Node *) lfirst(lc);
+		bool		everywhere = true;
+
+		if (clause == NULL || list_member(common, clause))
+			continue;
+		for_each_cell(lc2, lnext(list_head(context.refs)))
+		{
+			CteRefInfo *ref = (CteRefInfo *) lfirst(lc2);
+
+			if (!list_member(ref->pushable, clause))
+			{
+				everywhere = false;
+				break;
+			}
+		}
+		if (everywhere)
+			common = lappend(common, clause);
+	}
+
+	if (common == NIL)
+		return subquery;
+
+	/* Remove those clauses from the references' WHERE clauses */
+	foreach(lc, context.refs)
+	{
+		CteRefInfo *ref = (CteRefInfo *) lfirst(lc);
+		List	   *remaining = NIL;
+
+		forboth(lc2, ref->clauses, lc3, ref->pushable)
+		{
+			Node	   *pushable = (Node *) lfirst(lc3);
+
+			if (pushable == NULL || !list_member(common, pushable))
+				remaining = lappend(remaining, lfirst(lc2));
+		}
+		if (remaining == NIL)
+			ref->query->jointree->quals = NULL;
+		else
+			ref->query->jointree->quals =
+				(Node *) make_ands_explicit(remaining);
+	}
+
+	/* And apply them to the CTE query */
+	return make_cte_filter_query(cte, subquery, common);
+}
+
+/*
+ * Find all the references to a CTE, for push_down_cte_quals
+ *
+ * For each reference, we collect the WHERE clauses of the containing query,
+ * and for those that could be applied to the CTE query, a copy rewritten to
+ * refer to the first RTE of the wrapper built by make_cte_filter_query.
+ */
+static bool
+find_cte_refs_walker(Node *node, find_cte_refs_context *context)
+{
+	if (node == NULL)
+		return false;
+	if (IsA(node, Query))
+	{
+		Query	   *query = (Query *) node;
+		Index		rtindex = 0;
+		ListCell   *lc;
+
+		context->levelsup++;
+
+		foreach(lc, query->rtable)
+		{
+			RangeTblEntry *rte = (RangeTblEntry *) lfirst(lc);
+
+			rtindex++;
+			if (rte->rtekind == RTE_CTE &&
+				!rte->self_reference &&
+				strcmp(rte->ctename, context->ctename) == 0 &&
+				rte->ctelevelsup == context->levelsup)
+				context->refs = lappend(context->refs,
+										make_cte_ref_info(query, rtindex));
+		}
+
+		(void) query_tree_walker(query, find_cte_refs_walker, context, 0);
+
+		context->levelsup--;
+
+		return false;
+	}
+	return expression_tree_walker(node, find_cte_refs_walker, context);
+}
+
+static CteRefInfo *
+make_cte_ref_info(Query *query, Index rtindex)
+{
+	CteRefInfo *ref = (CteRefInfo *) palloc(sizeof(CteRefInfo));
+	bool		in_fromlist = false;
+	ListCell   *lc;
+
+	ref->query = query;
+	ref->clauses = NIL;
+	ref->pushable = NIL;
+
+	foreach(lc, query->jointree->fromlist)
+	{
+		Node	   *jtnode = (Node *) lfirst(lc);
+
+		if (IsA(jtnode, RangeTblRef) &&
+			((RangeTblRef *) jtnode)->rtindex == rtindex)
+			in_fromlist = true;
+	}
+	if (!in_fromlist)
+		return ref;
+
+	ref->clauses = make_ands_implicit((Expr *) query->jointree->quals);
+	foreach(lc, ref->clauses)
+	{
+		Node	   *clause = (Node *) lfirst(lc);
+		Node	   *pushable = NULL;
+
+		if (pull_varnos(clause) != NULL &&
+			!cte_qual_unsafe_walker(clause, &rtindex) &&
+			!contain_volatile_functions(clause))
+		{
+			pushable = copyObject(clause);
+			ChangeVarNodes(pushable, rtindex, 1, 0);
+		}
+		ref->pushable = lappend(ref->pushable, pushable);
+	}
+
+	return ref;
+}
+
+/*
+ * Can't push down a clause that refers to anything but columns of the CTE
+ * reference, or that contains sub-selects or aggregates.
+ */
+static bool
+cte_qual_unsafe_walker(Node *node, Index *rtindex)
+{
+	if (node == NULL)
+		return false;
+	if (IsA(node, Var))
+	{
+		Var		   *var = (Var *) node;
+
+		return (var->varlevelsup != 0 ||
+				var->varno != *rtindex ||
+				var->varattno <= 0);
+	}
+	if (IsA(node, SubLink) ||
+		IsA(node, Aggref) ||
+		IsA(node, WindowFunc) ||
+		IsA(node, PlaceHolderVar))
+		return true;
+	return expression_tree_walker(node, cte_qual_unsafe_walker,
+								  (void *) rtindex);
+}
+
+/*
+ * Build "SELECT * FROM (ctequery) WHERE quals", for push_down_cte_quals
+ */
+static Query *
+make_cte_filter_query(CommonTableExpr *cte, Query *ctequery, List *quals)
+{
+	Query	   *query = makeNode(Query);
+	RangeTblEntry *rte;
+	RangeTblRef *rtr;
+	ListCell   *lc;
+
+	rte = addRangeTableEntryForSubquery(NULL,
+										ctequery,
+										makeAlias(cte->ctename, NIL),
+										false,
+										false);
+	rtr = makeNode(RangeTblRef);
+	rtr->rtindex = 1;
+
+	query->commandType = CMD_SELECT;
+	query->querySource = QSRC_ORIGINAL;
+	query->canSetTag = true;
+	query->rtable = list_make1(rte);
+	query->jointree = makeFromExpr(list_make1(rtr),
+								   (Node *) make_ands_explicit(quals));
+
+	foreach(lc, ctequery->targetList)
+	{
+		TargetEntry *tle = (TargetEntry *) lfirst(lc);
+
+		if (tle->resjunk)
+			continue;
+		query->targetList = lappend(query->targetList,
+									makeTargetEntry((Expr *) makeVarFromTargetEntry(1, tle),
+													tle->resno,
+													tle->resname,
+													false));
+	}
+
+	return query;
+}
+
 /*
  * convert_ANY_sublink_to_join: try to convert an ANY SubLink to a join
  *
@@ -1201,6 +1712,11 @@ SS_process_ctes(PlannerInfo *root)
  * is present in an outer join's ON qual.)  The conversion must fail if
  * the converted qual would reference any but these parent-query relids.
  *
+ * We also support the case where the caller has found NOT IN (that is,
+ * NOT of an ANY SubLink), signaled by under_not.  That is converted to an
+ * anti join, but only if we can prove that it gives the same answer as the
+ * original NOT IN; see NOT_IN_is_anti_join.
+ *
  * On success, the returned JoinExpr has larg = NULL and rarg = the jointree
  * item representing the pulled-up subquery.  The caller must set larg to
  * represent the relation(s) on the lefthand side of the new join, and insert
@@ -1222,7 +1738,7 @@ SS_process_ctes(PlannerInfo *root)
  */
 JoinExpr *
 convert_ANY_sublink_to_join(PlannerInfo *root, SubLink *sublink,
-							Relids available_rels)
+							bool under_not, Relids available_rels)
 {
 	JoinExpr   *result;
 	Query	   *parse = root->parse;
@@ -1264,6 +1780,12 @@ convert_ANY_sublink_to_join(PlannerInfo *root, SubLink *sublink,
 	if (contain_volatile_functions(sublink->testexpr))
 		return NULL;
 
+	/*
+	 * NOT IN can only be done as an anti join if NULLs can't get in the way.
+	 */
+	if (under_not && !NOT_IN_is_anti_join(parse, subselect, sublink->testexpr))
+		return NULL;
+
 	/*
 	 * Okay, pull up the sub-select into upper range table.
 	 *
@@ -1302,7 +1824,7 @@ convert_ANY_sublink_to_join(PlannerInfo *root, SubLink *sublink,
 	 * And finally, build the JoinExpr node.
 	 */
 	result = makeNode(JoinExpr);
-	result->jointype = JOIN_SEMI;
+	result->jointype = under_not ? JOIN_ANTI : JOIN_SEMI;
 	result->isNatural = false;
 	result->larg = NULL;		/* caller must fill this in */
 	result->rarg = (Node *) rtr;
@@ -1314,12 +1836,207 @@ convert_ANY_sublink_to_join(PlannerInfo *root, SubLink *sublink,
 	return result;
 }
 
+/*
+ * NOT_IN_is_anti_join: can NOT IN with this test expression be an anti join?
+ *
+ * NOT IN yields NULL rather than TRUE if the comparison with any subquery
+ * row yields NULL, and so in general it is not equivalent to an anti join,
+ * which only looks for rows that compare TRUE.  The two do agree, though,
+ * when the combining operators are ordinary equality operators and neither
+ * the left-hand expressions nor the subquery's outputs can be NULL.
+ *
+ * We prove the left-hand expressions non-null using NOT NULL constraints of
+ * the columns they reference, and the subquery outputs using NOT NULL
+ * constraints as well as strict conditions in the subquery's WHERE clause.
+ * That's enough to catch the common cases of primary key columns and of
+ * subqueries written with an explicit "WHERE x IS NOT NULL".
+ */
+static bool
+NOT_IN_is_anti_join(Query *parse, Query *subselect, Node *testexpr)
+{
+	List	   *clauses;
+	Relids		outer_nullable_rels = NULL;
+	Relids		inner_nullable_rels = NULL;
+	List	   *inner_nonnullable_vars;
+	bool		computed_outer = false;
+	ListCell   *lc;
+
+	/* The test expression is a single comparison, or an AND of them */
+	if (and_clause(testexpr))
+		clauses = ((BoolExpr *) testexpr)->args;
+	else
+		clauses = list_make1(testexpr);
+
+	inner_nullable_rels = find_nullable_rels(subselect->jointree);
+	inner_nonnullable_vars = find_nonnullable_vars(subselect->jointree->quals);
+
+	foreach(lc, clauses)
+	{
+		OpExpr	   *opexpr = (OpExpr *) lfirst(lc);
+		Node	   *leftop;
+		Node	   *rightop;
+		Param	   *param;
+		TargetEntry *tle;
+
+		if (!IsA(opexpr, OpExpr) ||
+			list_length(opexpr->args) != 2)
+			return false;
+
+		/* The operator must be a plain equality operator */
+		if (!op_mergejoinable(opexpr->opno, exprType(linitial(opexpr->args))) &&
+			!op_hashjoinable(opexpr->opno, exprType(linitial(opexpr->args))))
+			return false;
+
+		leftop = (Node *) linitial(opexpr->args);
+		rightop = (Node *) lsecond(opexpr->args);
+		if (rightop && IsA(rightop, RelabelType))
+			rightop = (Node *) ((RelabelType *) rightop)->arg;
+
+		/* The righthand side must be one of the subquery's outputs */
+		if (!rightop || !IsA(rightop, Param))
+			return false;
+		param = (Param *) rightop;
+		if (param->paramkind != PARAM_SUBLINK)
+			return false;
+		tle = get_tle_by_resno(subselect->targetList, param->paramid);
+		if (tle == NULL || tle->resjunk)
+			return false;
+
+		if (!expr_is_nonnullable(subselect, inner_nullable_rels,
+								 inner_nonnullable_vars, (Node *) tle->expr))
+			return false;
+
+		/* Don't bother with the outer query's jointree until needed */
+		if (!computed_outer)
+		{
+			outer_nullable_rels = find_nullable_rels(parse->jointree);
+			computed_outer = true;
+		}
+		if (!expr_is_nonnullable(parse, outer_nullable_rels, NIL, leftop))
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * find_nullable_rels: find the relids nullable by outer joins in a jointree
+ *
+ * This is a conservative approximation for use by expr_is_nonnullable: a
+ * rel is reported if it is on the nullable side of any outer join in the
+ * tree, regardless of where the expression of interest will be evaluated.
+ */
+static Relids
+find_nullable_rels(FromExpr *jointree)
+{
+	return find_nullable_rels_recurse((Node *) jointree);
+}
+
+static Relids
+find_nullable_rels_recurse(Node *jtnode)
+{
+	Relids		result = NULL;
+
+	if (jtnode == NULL || IsA(jtnode, RangeTblRef))
+		return NULL;
+	if (IsA(jtnode, FromExpr))
+	{
+		FromExpr   *f = (FromExpr *) jtnode;
+		ListCell   *l;
+
+		foreach(l, f->fromlist)
+			result = bms_join(result, find_nullable_rels_recurse(lfirst(l)));
+	}
+	else if (IsA(jtnode, JoinExpr))
+	{
+		JoinExpr   *j = (JoinExpr *) jtnode;
+
+		result = bms_join(find_nullable_rels_recurse(j->larg),
+						  find_nullable_rels_recurse(j->rarg));
+		switch (j->jointype)
+		{
+			case JOIN_INNER:
+			case JOIN_SEMI:
+				break;
+			case JOIN_LEFT:
+			case JOIN_ANTI:
+				result = bms_join(result,
+								  get_relids_in_jointree(j->rarg, false));
+				break;
+			case JOIN_RIGHT:
+				result = bms_join(result,
+								  get_relids_in_jointree(j->larg, false));
+				break;
+			case JOIN_FULL:
+			default:
+				result = bms_join(result,
+								  get_relids_in_jointree(jtnode, false));
+				break;
+		}
+	}
+	else
+		elog(ERROR, "unrecognized node type: %d",
+			 (int) nodeTag(jtnode));
+	return result;
+}
+
+/*
+ * expr_is_nonnullable: can we prove that an expression won't yield NULL?
+ *
+ * We only try to prove this for non-null Consts and for plain Vars of the
+ * given query level.  A Var is known non-null if it appears in
+ * nonnullable_vars (typically the result of find_nonnullable_vars applied
+ * to a WHERE clause) or if it is a column of a table with a NOT NULL
+ * constraint, and the table isn't in nullable_rels.
+ */
+static bool
+expr_is_nonnullable(Query *query, Relids nullable_rels,
+					List *nonnullable_vars, Node *expr)
+{
+	Var		   *var;
+	RangeTblEntry *rte;
+
+	while (expr && IsA(expr, RelabelType))
+		expr = (Node *) ((RelabelType *) expr)->arg;
+
+	if (expr == NULL)
+		return false;
+	if (IsA(expr, Const))
+		return !((Const *) expr)->constisnull;
+	if (!IsA(expr, Var))
+		return false;
+
+	var = (Var *) expr;
+	if (var->varlevelsup != 0)
+		return false;
+	if (list_member(nonnullable_vars, var))
+		return true;
+
+	/* System columns are never null, but whole-row Vars could be */
+	if (var->varattno == InvalidAttrNumber)
+		return false;
+	if (bms_is_member(var->varno, nullable_rels))
+		return false;
+	rte = rt_fetch(var->varno, query->rtable);
+	if (rte->rtekind != RTE_RELATION)
+		return false;
+	if (var->varattno < 0)
+		return true;
+
+	/*
+	 * An inheritance child need not have the parent's NOT NULL constraint,
+	 * so we can only trust the constraint of a table without children.
+	 */
+	if (rte->inh && has_subclass(rte->relid))
+		return false;
+
+	return get_attnotnull(rte->relid, var->varattno);
+}
+
 /*
  * convert_EXISTS_sublink_to_join: try to convert an EXISTS SubLink to a join
  *
- * The API of this function is identical to convert_ANY_sublink_to_join's,
- * except that we also support the case where the caller has found NOT EXISTS,
- * so we need an additional input parameter "under_not".
+ * The API of this function is identical to convert_ANY_sublink_to_join's.
  */
 JoinExpr *
 convert_EXISTS_sublink_to_join(PlannerInfo *root, SubLink *sublink,
@@ -1469,6 +2186,340 @@ convert_EXISTS_sublink_to_join(PlannerInfo *root, SubLink *sublink,
 	return result;
 }
 
+/*
+ * convert_EXPR_sublink_to_join: try to convert a scalar aggregate SubLink
+ * to a join
+ *
+ * The caller has found an EXPR SubLink in the query's targetlist.  If it is
+ * a correlated sub-select of the form
+ *
+ *		(SELECT agg(...) FROM ... WHERE inner_expr = outer_expr AND ...)
+ *
+ * where the equalities are the only references to the parent query, we can
+ * compute the aggregate for all values of outer_expr at once by grouping the
+ * sub-select on inner_expr, and then fetch the right group with an outer
+ * join on inner_expr = outer_expr.  That lets the planner choose a hash or
+ * merge join rather than re-executing the sub-select for each outer row.
+ *
+ * If the SubLink can be converted, we add the grouped sub-select to the
+ * query's rangetable and return a JoinExpr with jointype JOIN_LEFT, larg =
+ * NULL and rarg = the jointree item for the sub-select; *replacement is set
+ * to the expression that should replace the SubLink.  The caller must set
+ * larg to represent the relation(s) on the lefthand side of the new join and
+ * insert the JoinExpr into the query's jointree.  Return NULL if the SubLink
+ * cannot be converted.
+ *
+ * A group that doesn't exist yields NULL from the outer join, while the
+ * sub-select would have aggregated over no rows; so we only accept
+ * aggregates that return NULL for empty input, plus count(), whose result
+ * for empty input we supply with a COALESCE.
+ */
+JoinExpr *
+convert_EXPR_sublink_to_join(PlannerInfo *root, SubLink *sublink,
+							 Node **replacement)
+{
+	JoinExpr   *result;
+	Query	   *parse = root->parse;
+	Query	   *subselect = (Query *) sublink->subselect;
+	TargetEntry *aggtle;
+	Aggref	   *aggref;
+	List	   *whereClauses;
+	List	   *otherClauses = NIL;
+	List	   *joinClauses = NIL;
+	List	   *innerExprs = NIL;
+	List	   *outerExprs = NIL;
+	List	   *eqops = NIL;
+	List	   *inputCollids = NIL;
+	Node	   *emptyResult;
+	int			rtindex;
+	RangeTblEntry *rte;
+	RangeTblRef *rtr;
+	Var		   *aggvar;
+	ListCell   *lc;
+	ListCell   *lc2;
+	ListCell   *lc3;
+	ListCell   *keytle;
+
+	Assert(sublink->subLinkType == EXPR_SUBLINK);
+
+	/*
+	 * The sub-select must be a plain aggregate query with a single output
+	 * column.  We don't try to cope with anything that could behave
+	 * differently once grouped, nor with WITH or nested SubLinks.
+	 */
+	if (subselect->commandType != CMD_SELECT ||
+		subselect->setOperations ||
+		!subselect->hasAggs ||
+		subselect->groupClause ||
+		subselect->havingQual ||
+		subselect->hasWindowFuncs ||
+		subselect->hasSubLinks ||
+		subselect->distinctClause ||
+		subselect->sortClause ||
+		subselect->limitOffset ||
+		subselect->limitCount ||
+		subselect->rowMarks ||
+		subselect->cteList ||
+		subselect->jointree->fromlist == NIL ||
+		list_length(subselect->targetList) != 1)
+		return NULL;
+
+	aggtle = (TargetEntry *) linitial(subselect->targetList);
+	aggref = (Aggref *) aggtle->expr;
+	if (!IsA(aggref, Aggref) ||
+		aggref->agglevelsup != 0 ||
+		aggref->aggkind != AGGKIND_NORMAL)
+		return NULL;
+
+	/* Find out what the aggregate produces for empty input */
+	emptyResult = aggregate_empty_result(aggref);
+	if (emptyResult == NULL)
+		return NULL;
+
+	if (contain_volatile_functions((Node *) subselect))
+		return NULL;
+
+	/*
+	 * Copy the subquery so we can modify it safely (see comments in
+	 * make_subplan).
+	 */
+	subselect = (Query *) copyObject(subselect);
+	aggtle = (TargetEntry *) linitial(subselect->targetList);
+
+	/*
+	 * Split the WHERE clause into the correlation equalities and everything
+	 * else.  The WHERE clause hasn't been through eval_const_expressions yet,
+	 * but make_ands_implicit is enough to flatten a top-level AND.
+	 */
+	whereClauses = make_ands_implicit((Expr *) subselect->jointree->quals);
+	foreach(lc, whereClauses)
+	{
+		Node	   *clause = (Node *) lfirst(lc);
+		OpExpr	   *opexpr = (OpExpr *) clause;
+		Node	   *innerExpr;
+		Node	   *outerExpr;
+		Oid			exprtype;
+		Oid			sortop;
+		Oid			eqop;
+		bool		hashable;
+
+		if (!contain_vars_of_level(clause, 1))
+		{
+			otherClauses = lappend(otherClauses, clause);
+			continue;
+		}
+
+		if (!IsA(opexpr, OpExpr) ||
+			list_length(opexpr->args) != 2)
+			return NULL;
+
+		innerExpr = (Node *) linitial(opexpr->args);
+		outerExpr = (Node *) lsecond(opexpr->args);
+		if (contain_vars_of_level(innerExpr, 1))
+		{
+			Node	   *tmp = innerExpr;
+
+			innerExpr = outerExpr;
+			outerExpr = tmp;
+		}
+
+		/* One side must use only the sub-select's Vars, the other only ours */
+		if (contain_vars_of_level(innerExpr, 1) ||
+			!contain_vars_of_level(innerExpr, 0) ||
+			contain_vars_of_level(outerExpr, 0))
+			return NULL;
+
+		/*
+		 * The operator must be the default equality operator of the datatype,
+		 * so that grouping on innerExpr and joining with the operator agree.
+		 */
+		exprtype = exprType(innerExpr);
+		if (exprType(outerExpr) != exprtype)
+			return NULL;
+		get_sort_group_operators(exprtype,
+								 false, false, false,
+								 &sortop, &eqop, NULL,
+								 &hashable);
+		if (!OidIsValid(eqop) || opexpr->opno != eqop)
+			return NULL;
+		if (!OidIsValid(sortop) && !hashable)
+			return NULL;
+
+		innerExprs = lappend(innerExprs, innerExpr);
+		outerExprs = lappend(outerExprs, outerExpr);
+		eqops = lappend_oid(eqops, eqop);
+		inputCollids = lappend_oid(inputCollids, opexpr->inputcollid);
+	}
+
+	/* There must be some correlation, else it's not gonna be a join */
+	if (innerExprs == NIL)
+		return NULL;
+
+	/*
+	 * With the equalities removed, the sub-select must not refer to any Vars
+	 * of the parent query.  (Vars of higher levels should be okay, though.)
+	 */
+	if (otherClauses == NIL)
+		subselect->jointree->quals = NULL;
+	else
+		subselect->jointree->quals = (Node *) make_ands_explicit(otherClauses);
+	if (contain_vars_of_level((Node *) subselect, 1))
+		return NULL;
+
+	/*
+	 * Okay, add the grouping columns to the sub-select.  Equal expressions
+	 * are just grouped on twice, which is harmless.
+	 */
+	foreach(lc, innerExprs)
+	{
+		Node	   *innerExpr = (Node *) lfirst(lc);
+		TargetEntry *tle;
+		SortGroupClause *grpcl;
+		Oid			sortop;
+		Oid			eqop;
+		bool		hashable;
+
+		tle = makeTargetEntry((Expr *) innerExpr,
+							  list_length(subselect->targetList) + 1,
+							  psprintf("key%d",
+									   list_length(subselect->targetList)),
+							  false);
+		subselect->targetList = lappend(subselect->targetList, tle);
+
+		get_sort_group_operators(exprType(innerExpr),
+								 false, false, false,
+								 &sortop, &eqop, NULL,
+								 &hashable);
+		grpcl = makeNode(SortGroupClause);
+		grpcl->tleSortGroupRef = assignSortGroupRef(tle,
+													subselect->targetList);
+		grpcl->eqop = eqop;
+		grpcl->sortop = sortop;
+		grpcl->nulls_first = false;
+		grpcl->hashable = hashable;
+		subselect->groupClause = lappend(subselect->groupClause, grpcl);
+	}
+
+	/*
+	 * Now pull up the sub-select into upper range table, as in
+	 * convert_ANY_sublink_to_join.
+	 */
+	rte = addRangeTableEntryForSubquery(NULL,
+										subselect,
+										makeAlias("EXPR_subquery", NIL),
+										false,
+										false);
+	parse->rtable = lappend(parse->rtable, rte);
+	rtindex = list_length(parse->rtable);
+
+	rtr = makeNode(RangeTblRef);
+	rtr->rtindex = rtindex;
+
+	/*
+	 * Build the join clauses.  The grouping columns follow the aggregate in
+	 * the sub-select's targetlist, and the Vars of the outer expressions
+	 * move up to our level.
+	 */
+	keytle = lnext(list_head(subselect->targetList));
+	forthree(lc, outerExprs, lc2, eqops, lc3, inputCollids)
+	{
+		Node	   *outerExpr = (Node *) lfirst(lc);
+		Var		   *keyvar;
+
+		IncrementVarSublevelsUp(outerExpr, -1, 1);
+		keyvar = makeVarFromTargetEntry(rtindex,
+										(TargetEntry *) lfirst(keytle));
+		joinClauses = lappend(joinClauses,
+							  make_opclause(lfirst_oid(lc2), BOOLOID, false,
+											(Expr *) outerExpr,
+											(Expr *) keyvar,
+											InvalidOid, lfirst_oid(lc3)));
+		keytle = lnext(keytle);
+	}
+
+	/* Build the expression that replaces the SubLink */
+	aggvar = makeVarFromTargetEntry(rtindex, aggtle);
+	if (IsA(emptyResult, Const) &&
+		((Const *) emptyResult)->constisnull)
+		*replacement = (Node *) aggvar;
+	else
+	{
+		CoalesceExpr *coalesce = makeNode(CoalesceExpr);
+
+		coalesce->coalescetype = aggref->aggtype;
+		coalesce->coalescecollid = aggref->aggcollid;
+		coalesce->args = list_make2(aggvar, emptyResult);
+		coalesce->location = -1;
+		*replacement = (Node *) coalesce;
+	}
+
+	/*
+	 * And finally, build the JoinExpr node.
+	 */
+	result = makeNode(JoinExpr);
+	result->jointype = JOIN_LEFT;
+	result->isNatural = false;
+	result->larg = NULL;		/* caller must fill this in */
+	result->rarg = (Node *) rtr;
+	result->usingClause = NIL;
+	result->quals = (Node *) make_ands_explicit(joinClauses);
+	result->alias = NULL;
+	result->rtindex = 0;		/* we don't need an RTE for it */
+
+	return result;
+}
+
+/*
+ * aggregate_empty_result: what does an aggregate return for empty input?
+ *
+ * Returns a Const if we know, or NULL if we don't.  An aggregate without an
+ * initial condition, whose final function is absent or strict, returns NULL
+ * when there are no rows.  We also know about count(), whose transition
+ * function never lets the state become NULL, and whose initial condition is
+ * zero.  A user-defined aggregate can use the same transition function with
+ * some other initial condition, so we check that as well.  We don't try to
+ * be any smarter than that about aggregates with initial conditions.
+ */
+static Node *
+aggregate_empty_result(Aggref *aggref)
+{
+	HeapTuple	aggTuple;
+	Form_pg_aggregate aggform;
+	Datum		textInitVal;
+	bool		initValueIsNull;
+	Node	   *result = NULL;
+
+	aggTuple = SearchSysCache1(AGGFNOID, ObjectIdGetDatum(aggref->aggfnoid));
+	if (!HeapTupleIsValid(aggTuple))
+		elog(ERROR, "cache lookup failed for aggregate %u",
+			 aggref->aggfnoid);
+	aggform = (Form_pg_aggregate) GETSTRUCT(aggTuple);
+
+	textInitVal = SysCacheGetAttr(AGGFNOID, aggTuple,
+								  Anum_pg_aggregate_agginitval,
+								  &initValueIsNull);
+
+	if (initValueIsNull)
+	{
+		if (!OidIsValid(aggform->aggfinalfn) ||
+			func_strict(aggform->aggfinalfn))
+			result = (Node *) makeNullConst(aggref->aggtype, -1,
+											aggref->aggcollid);
+	}
+	else if ((aggform->aggtransfn == F_INT8INC ||
+			  aggform->aggtransfn == F_INT8INC_ANY) &&
+			 !OidIsValid(aggform->aggfinalfn) &&
+			 aggref->aggtype == INT8OID &&
+			 strcmp(TextDatumGetCString(textInitVal), "0") == 0)
+		result = (Node *) makeConst(INT8OID, -1, InvalidOid, sizeof(int64),
+									Int64GetDatum(0), false,
+									FLOAT8PASSBYVAL);
+
+	ReleaseSysCache(aggTuple);
+
+	return result;
+}
+
 /*
  * simplify_EXISTS_query: remove any useless stuff in an EXISTS's subquery
  *
@@ -4,6 +4,7 @@
  *	  Planner preprocessing for subqueries and join tree manipulation.
  *
  * NOTE: the intended sequence for invoking these operations is
+ *		pull_up_agg_sublinks
  *		pull_up_sublinks
  *		inline_set_returning_functions
  *		pull_up_subqueries
@@ -109,6 +110,89 @@ static void fix_append_rel_relids(List *append_rel_list, int varno,
 static Node *find_jointree_node_for_rel(Node *jtnode, int relid);
 
 
+/*
+ * pull_up_agg_sublinks
+ *		Attempt to convert correlated aggregate sub-SELECTs in the
+ *		targetlist into outer joins to grouped subqueries.
+ *
+ * A targetlist item "(SELECT agg(...) FROM ... WHERE inner = outer)" is
+ * normally executed as a SubPlan that is rescanned for each output row.
+ * Instead we can join the query to the sub-SELECT grouped by "inner", which
+ * computes the aggregate for every outer value in one pass; see
+ * convert_EXPR_sublink_to_join for the details.  The resulting LEFT JOINs
+ * are planned like any other join.
+ *
+ * We only do this when the targetlist is evaluated once per row of the
+ * jointree, so not in aggregated or windowed queries.  We also skip queries
+ * with a LIMIT, since computing every group could then cost far more than
+ * running the sub-SELECT for the few rows that are actually wanted.
+ *
+ * The join isn't always cheaper than the SubPlans, which only run for the
+ * rows that are actually produced, possibly using an index.  So if anything
+ * is converted, we return a copy of the query as it was before, which the
+ * caller plans as well to keep the cheaper of the two plans (see
+ * subquery_planner).  We return NULL if nothing was converted.
+ *
+ * This must be done before pull_up_sublinks, which can then process the
+ * WHERE clause against the rebuilt jointree.
+ */
+Query *
+pull_up_agg_sublinks(PlannerInfo *root)
+{
+	Query	   *parse = root->parse;
+	Query	   *unconverted = NULL;
+	Node	   *jtnode = NULL;
+	ListCell   *lc;
+
+	if (parse->commandType != CMD_SELECT ||
+		parse->setOperations ||
+		parse->hasAggs ||
+		parse->groupClause ||
+		parse->havingQual ||
+		parse->hasWindowFuncs ||
+		parse->limitCount ||
+		parse->rowMarks ||
+		parse->jointree->fromlist == NIL)
+		return NULL;
+
+	foreach(lc, parse->targetList)
+	{
+		TargetEntry *tle = (TargetEntry *) lfirst(lc);
+		SubLink    *sublink = (SubLink *) tle->expr;
+		JoinExpr   *j;
+		Node	   *replacement;
+
+		if (!IsA(sublink, SubLink) ||
+			sublink->subLinkType != EXPR_SUBLINK)
+			continue;
+
+		/* Save the query before converting anything in it */
+		if (unconverted == NULL)
+			unconverted = (Query *) copyObject(parse);
+
+		j = convert_EXPR_sublink_to_join(root, sublink, &replacement);
+		if (j == NULL)
+			continue;
+
+		/* Stack the new join on top of what we have so far */
+		if (jtnode == NULL)
+			jtnode = (Node *) makeFromExpr(parse->jointree->fromlist, NULL);
+		j->larg = jtnode;
+		jtnode = (Node *) j;
+
+		tle->expr = (Expr *) replacement;
+	}
+
+	/* If we converted anything, the WHERE clause goes above the new joins */
+	if (jtnode == NULL)
+		return NULL;
+
+	parse->jointree = makeFromExpr(list_make1(jtnode),
+								   parse->jointree->quals);
+
+	return unconverted;
+}
+
 /*
  * pull_up_sublinks
  *		Attempt to pull up ANY and EXISTS SubLinks to be treated as
@@ -128,6 +212,9 @@ static Node *find_jointree_node_for_rel(Node *jtnode, int relid);
  *
  * Under similar conditions, EXISTS and NOT EXISTS clauses can be handled
  * by pulling up the sub-SELECT and creating a semijoin or anti-semijoin.
+ * NOT IN is also handled as an anti-semijoin, but only where it's possible
+ * to prove that neither side of the comparisons can be NULL, since NOT IN
+ * returns NULL rather than TRUE if there's a NULL comparison result.
  *
  * This routine searches for such clauses and does the necessary parsetree
  * transformations if any are found.
@@ -334,7 +421,7 @@ pull_up_sublinks_qual_recurse(PlannerInfo *root, Node *node,
 		/* Is it a convertible ANY or EXISTS clause? */
 		if (sublink->subLinkType == ANY_SUBLINK)
 		{
-			if ((j = convert_ANY_sublink_to_join(root, sublink,
+			if ((j = convert_ANY_sublink_to_join(root, sublink, false,
 												 available_rels1)) != NULL)
 			{
 				/* Yes; insert the new join node into the join tree */
@@ -360,7 +447,7 @@ pull_up_sublinks_qual_recurse(PlannerInfo *root, Node *node,
 				return NULL;
 			}
 			if (available_rels2 != NULL &&
-				(j = convert_ANY_sublink_to_join(root, sublink,
+				(j = convert_ANY_sublink_to_join(root, sublink, false,
 												 available_rels2)) != NULL)
 			{
 				/* Yes; insert the new join node into the join tree */
@@ -445,7 +532,7 @@ pull_up_sublinks_qual_recurse(PlannerInfo *root, Node *node,
 	}
 	if (not_clause(node))
 	{
-		/* If the immediate argument of NOT is EXISTS, try to convert */
+		/* If the immediate argument of NOT is EXISTS or ANY, try to convert */
 		SubLink    *sublink = (SubLink *) get_notclausearg((Expr *) node);
 		JoinExpr   *j;
 		Relids		child_rels;
@@ -506,6 +593,60 @@ pull_up_sublinks_qual_recurse(PlannerInfo *root, Node *node,
 					return NULL;
 				}
 			}
+			else if (sublink->subLinkType == ANY_SUBLINK)
+			{
+				if ((j = convert_ANY_sublink_to_join(root, sublink, true,
+												available_rels1)) != NULL)
+				{
+					/* Yes; insert the new join node into the join tree */
+					j->larg = *jtlink1;
+					*jtlink1 = (Node *) j;
+					/* Recursively process pulled-up jointree nodes */
+					j->rarg = pull_up_sublinks_jointree_recurse(root,
+																j->rarg,
+																&child_rels);
+
+					/*
+					 * Now recursively process the pulled-up quals.  Because
+					 * we are underneath a NOT, we can't pull up sublinks that
+					 * reference the left-hand stuff, but it's still okay to
+					 * pull up sublinks referencing j->rarg.
+					 */
+					j->quals = pull_up_sublinks_qual_recurse(root,
+															 j->quals,
+															 &j->rarg,
+															 child_rels,
+															 NULL, NULL);
+					/* Return NULL representing constant TRUE */
+					return NULL;
+				}
+				if (available_rels2 != NULL &&
+					(j = convert_ANY_sublink_to_join(root, sublink, true,
+												available_rels2)) != NULL)
+				{
+					/* Yes; insert the new join node into the join tree */
+					j->larg = *jtlink2;
+					*jtlink2 = (Node *) j;
+					/* Recursively process pulled-up jointree nodes */
+					j->rarg = pull_up_sublinks_jointree_recurse(root,
+																j->rarg,
+																&child_rels);
+
+					/*
+					 * Now recursively process the pulled-up quals.  Because
+					 * we are underneath a NOT, we can't pull up sublinks that
+					 * reference the left-hand stuff, but it's still okay to
+					 * pull up sublinks referencing j->rarg.
+					 */
+					j->quals = pull_up_sublinks_qual_recurse(root,
+															 j->quals,
+															 &j->rarg,
+															 child_rels,
+															 NULL, NULL);
+					/* Return NULL representing constant TRUE */
+					return NULL;
+				}
+			}
 		}
 		/* Else return it unmodified */
 		return node;
@@ -829,14 +829,11 @@ choose_hashed_setop(PlannerInfo *root, List *groupClauses,
 		return false;
 
 	/*
-	 * Don't do it if it doesn't look like the hashtable will fit into
-	 * work_mem.
+	 * Estimate the size of the hashtable, so that we can charge for spilling
+	 * to disk if it doesn't look like it will fit into work_mem.
 	 */
 	hashentrysize = MAXALIGN(input_plan->plan_width) + MAXALIGN(sizeof(MinimalTupleData));
 
-	if (hashentrysize * dNumGroups > work_mem * 1024L)
-		return false;
-
 	/*
 	 * See if the estimated cost is no more than doing it the other way.
 	 *
@@ -852,6 +849,8 @@ choose_hashed_setop(PlannerInfo *root, List *groupClauses,
 			 numGroupCols, dNumGroups,
 			 input_plan->startup_cost, input_plan->total_cost,
 			 input_plan->plan_rows);
+	cost_hashagg_spill(&hashed_p, hashentrysize, dNumGroups,
+					   input_plan->plan_rows, input_plan->plan_width);
 
 	/*
 	 * Now for the sorted case.  Note that the input is *always* unsorted,
@@ -1371,15 +1371,14 @@ create_unique_path(PlannerInfo *root, RelOptInfo *rel, Path *subpath,
 		 */
 		int			hashentrysize = rel->width + 64;
 
-		if (hashentrysize * pathnode->path.rows > work_mem * 1024L)
-			all_hash = false;	/* don't try to hash */
-		else
-			cost_agg(&agg_path, root,
-					 AGG_HASHED, NULL,
-					 numCols, pathnode->path.rows,
-					 subpath->startup_cost,
-					 subpath->total_cost,
-					 rel->rows);
+		cost_agg(&agg_path, root,
+				 AGG_HASHED, NULL,
+				 numCols, pathnode->path.rows,
+				 subpath->startup_cost,
+				 subpath->total_cost,
+				 rel->rows);
+		cost_hashagg_spill(&agg_path, hashentrysize, pathnode->path.rows,
+						   rel->rows, rel->width);
 	}
 
 	if (all_btree && all_hash)
@@ -1313,3 +1313,38 @@ build_aggregate_fnexprs(Oid *agg_input_types,
 										 COERCE_EXPLICIT_CALL);
 	/* finalfn is currently never treated as variadic */
 }
+
+/*
+ * Like build_aggregate_fnexprs, but for an aggregate's combine function,
+ * which takes two arguments of the transition type and returns that type.
+ */
+void
+build_aggregate_combinefn_expr(Oid agg_state_type,
+							   Oid agg_input_collation,
+							   Oid combinefn_oid,
+							   Expr **combinefnexpr)
+{
+	Param	   *argp;
+	List	   *args;
+	int			i;
+
+	args = NIL;
+	for (i = 0; i < 2; i++)
+	{
+		argp = makeNode(Param);
+		argp->paramkind = PARAM_EXEC;
+		argp->paramid = -1;
+		argp->paramtype = agg_state_type;
+		argp->paramtypmod = -1;
+		argp->paramcollid = agg_input_collation;
+		argp->location = -1;
+		args = lappend(args, argp);
+	}
+
+	*combinefnexpr = (Expr *) makeFuncExpr(combinefn_oid,
+										   agg_state_type,
+										   args,
+										   InvalidOid,
+										   agg_input_collation,
+										   COERCE_EXPLICIT_CALL);
+}
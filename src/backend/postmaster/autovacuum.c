@@ -1990,6 +1990,13 @@ do_autovacuum(void)
 			classForm->relkind != RELKIND_MATVIEW)
 			continue;
 
+		/*
+		 * Global temporary tables have no contents we could see; every
+		 * session's copy lives in that session's local buffers.
+		 */
+		if (classForm->relpersistence == RELPERSISTENCE_GLOBAL_TEMP)
+			continue;
+
 		relid = HeapTupleGetOid(tuple);
 
 		/* Fetch reloptions and the pgstat entry for this table */
@@ -2101,8 +2108,10 @@ do_autovacuum(void)
 
 		/*
 		 * We cannot safely process other backends' temp tables, so skip 'em.
+		 * Likewise for global temporary tables.
 		 */
-		if (classForm->relpersistence == RELPERSISTENCE_TEMP)
+		if (classForm->relpersistence == RELPERSISTENCE_TEMP ||
+			classForm->relpersistence == RELPERSISTENCE_GLOBAL_TEMP)
 			continue;
 
 		relid = HeapTupleGetOid(tuple);
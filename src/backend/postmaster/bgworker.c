@@ -706,9 +706,6 @@ StartBackgroundWorker(void)
 void
 RegisterBackgroundWorker(BackgroundWorker *worker)
 {
-	RegisteredBgWorker *rw;
-	static int	numworkers = 0;
-
 	if (!IsUnderPostmaster)
 		ereport(LOG,
 		 (errmsg("registering background worker \"%s\"", worker->bgw_name)));
@@ -723,6 +720,22 @@ RegisterBackgroundWorker(BackgroundWorker *worker)
 		return;
 	}
 
+	RegisterInternalBackgroundWorker(worker);
+}
+
+/*
+ * Register a background worker that is part of the server itself.
+ *
+ * This is called by the postmaster during startup, for workers that core
+ * subsystems start on their own (such as the I/O workers); it is also the
+ * workhorse of RegisterBackgroundWorker.
+ */
+void
+RegisterInternalBackgroundWorker(BackgroundWorker *worker)
+{
+	RegisteredBgWorker *rw;
+	static int	numworkers = 0;
+
 	if (!SanityCheckBackgroundWorker(worker, LOG))
 		return;
 
@@ -0,0 +1,891 @@
+/*-------------------------------------------------------------------------
+ *
+ * aio.c
+ *	  Asynchronous buffer I/O carried out by I/O worker processes.
+ *
+ * A backend that knows it is going to need a block soon, or the checkpointer
+ * writing out dirty buffers, can hand the actual read() or write() over to a
+ * pool of I/O workers instead of blocking on it.  The number of workers is
+ * set by io_workers; they are background workers started by the postmaster
+ * and connected to shared memory but not to any database.
+ *
+ * Requests go into a fixed-size ring in shared memory.  A request only names
+ * a block (for reads) or a shared buffer (for writes); the worker then does
+ * the I/O through the buffer manager, exactly as if the submitter had called
+ * ReadBuffer or written the buffer out itself, so all the usual buffer header
+ * and io_in_progress interlocking applies unchanged.  A read request simply
+ * leaves the block in shared buffers for the submitter to find later.
+ *
+ * A read request is made without any lock on the relation; the submitter may
+ * have finished with it, and released its lock, long before a worker gets to
+ * the request.  Whoever drops or truncates a relation therefore must call
+ * AioCancelReads first, as the buffer manager does before dropping the
+ * relation's buffers, so that no block of the relation can be read in again
+ * behind the back of DropRelFileNodeBuffers.  Cancelling doesn't look at the
+ * queue at all.  Instead there is an array of cancel counters, indexed by a
+ * hash of the relation, and another indexed by a hash of the database; a
+ * read request remembers the two counters' values at submit time, and a
+ * worker skips the read if either has moved on since.  A hash collision only
+ * makes a worker skip a read that nobody needed to cancel, which is harmless
+ * for a prefetch.  Each worker holds its own LWLock while it checks the
+ * counters and does the read, so cancelling just bumps the counters and then
+ * cycles through the workers' locks to wait out reads already in progress.
+ *
+ * Submitting never blocks: if no worker is running or the queue is full, the
+ * submit function returns false and the caller does the I/O synchronously,
+ * or skips it, as it would have without this module.  Likewise, a request
+ * that fails in the worker is reported to the server log and then counted
+ * as completed; callers that need the I/O to have happened (the checkpoint)
+ * must check for themselves afterwards.
+ *
+ * Each backend's submitted, completed and in-flight request counts are kept
+ * in an array indexed by pgprocno, which also lets a submitter wait until
+ * all of its requests have been processed.
+ *
+ * This is not a general asynchronous I/O interface.  There is no io_uring
+ * support, and reads can't be issued into a buffer the submitter has pinned
+ * and then waited for individually: a read request is only a prefetch into
+ * shared buffers, and the submitter reads the block through ReadBuffer as
+ * usual, waiting on the buffer's io_in_progress lock if a worker is still
+ * reading it.  The only completion interface is AioWaitForCompletion, which
+ * waits for all of the backend's requests at once.
+ *
+ * Portions Copyright (c) 1996-2015, PostgreSQL Global Development Group
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/storage/aio/aio.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include <signal.h>
+
+#include "access/twophase.h"
+#include "funcapi.h"
+#include "miscadmin.h"
+#include "postmaster/bgworker.h"
+#include "postmaster/bgworker_internals.h"
+#include "postmaster/bgwriter.h"
+#include "storage/aio.h"
+#include "storage/bufmgr.h"
+#include "storage/fd.h"
+#include "storage/ipc.h"
+#include "storage/latch.h"
+#include "storage/lwlock.h"
+#include "storage/proc.h"
+#include "storage/shmem.h"
+#include "storage/smgr.h"
+#include "storage/spin.h"
+#include "utils/hsearch.h"
+#include "utils/memutils.h"
+#include "utils/resowner.h"
+
+
+/* Number of request slots in the shared queue */
+#define AIO_QUEUE_SIZE		1024
+
+/* Number of read cancel counters for relations, and for databases */
+#define AIO_CANCEL_SLOTS	256
+
+/* GUC variable */
+int			io_workers = 0;
+
+typedef enum AioOp
+{
+	AIO_READ_BUFFER,			/* read a block into shared buffers */
+	AIO_WRITE_BUFFER			/* write out a checkpoint buffer */
+} AioOp;
+
+typedef struct AioRequest
+{
+	AioOp		op;
+	int			procno;			/* pgprocno of the submitter */
+	int			pid;			/* and its PID */
+	RelFileNode rnode;			/* block to read (AIO_READ_BUFFER) */
+	ForkNumber	forkNum;
+	BlockNumber blockNum;
+	BufferAccessStrategyType btype;	/* strategy to read it with */
+	uint32		relCancel;		/* cancel counters at submit time */
+	uint32		dbCancel;
+	int			buf_id;			/* buffer to write (AIO_WRITE_BUFFER) */
+} AioRequest;
+
+/*
+ * Per-backend counters.  pid identifies the process the counters belong to;
+ * they are reset when a new process starts using the PGPROC slot.
+ */
+typedef struct AioProcStats
+{
+	int			pid;			/* owning process, or 0 if never used */
+	int			inflight;		/* requests submitted but not completed */
+	uint64		reads_submitted;
+	uint64		writes_submitted;
+	uint64		completed;
+	uint64		queue_full;		/* submissions refused for lack of room */
+	uint64		waits;			/* times we had to sleep for completions */
+} AioProcStats;
+
+typedef struct AioCtlData
+{
+	/* These don't change after initialization, or are atomics */
+	LWLock	   *workerLocks[MAX_IO_WORKERS];	/* held while reading */
+	pg_atomic_uint32 relCancel[AIO_CANCEL_SLOTS];
+	pg_atomic_uint32 dbCancel[AIO_CANCEL_SLOTS];
+
+	slock_t		mutex;			/* protects everything below */
+	int			running;		/* number of live I/O workers */
+	uint32		idleWorkers;	/* bitmap of workers waiting for work */
+	Latch	   *workerLatches[MAX_IO_WORKERS];
+	uint32		head;			/* next request to hand to a worker */
+	uint32		tail;			/* next free slot */
+	AioRequest	queue[AIO_QUEUE_SIZE];
+	int			numProcs;		/* length of procStats array */
+	AioProcStats procStats[FLEXIBLE_ARRAY_MEMBER];
+} AioCtlData;
+
+static AioCtlData *AioCtl = NULL;
+
+/* Flags set by signal handlers in the I/O worker */
+static volatile sig_atomic_t got_SIGTERM = false;
+
+/* Request the I/O worker is working on, for error recovery */
+static AioRequest current_request;
+static bool have_request = false;
+
+/* Number of this I/O worker, or -1 if not an I/O worker */
+static int	MyIoWorkerNo = -1;
+
+/* The I/O worker's access strategies, created on first use */
+static BufferAccessStrategy worker_strategies[BAS_VACUUM + 1];
+
+static bool AioSubmit(AioRequest *req);
+static bool AioDequeue(int workerno, AioRequest *req);
+static void AioComplete(AioRequest *req);
+static void AioCancelReadsInternal(const RelFileNode *rnodes, int nnodes,
+					   Oid dbid);
+static bool AioReadCancelled(AioRequest *req);
+static BufferAccessStrategy AioGetStrategy(BufferAccessStrategyType btype);
+static void AioPerform(AioRequest *req);
+static void AioWorkerShutdown(int code, Datum arg);
+static void ioworker_sigterm(SIGNAL_ARGS);
+
+
+/*
+ * Number of PGPROC slots, as computed by InitProcGlobal.  This is needed
+ * before ProcGlobal exists, to size our shared memory.
+ */
+static int
+AioNumProcs(void)
+{
+	return MaxBackends + NUM_AUXILIARY_PROCS + max_prepared_xacts;
+}
+
+/*
+ * Cancel counter slots of a relation and of a database
+ */
+static inline int
+AioRelCancelSlot(RelFileNode rnode)
+{
+	return tag_hash(&rnode, sizeof(RelFileNode)) % AIO_CANCEL_SLOTS;
+}
+
+static inline int
+AioDbCancelSlot(Oid dbid)
+{
+	return dbid % AIO_CANCEL_SLOTS;
+}
+
+/*
+ * AioShmemSize --- report amount of shared memory space needed
+ */
+Size
+AioShmemSize(void)
+{
+	if (io_workers <= 0)
+		return 0;
+
+	return add_size(offsetof(AioCtlData, procStats),
+					mul_size(AioNumProcs(), sizeof(AioProcStats)));
+}
+
+/*
+ * AioShmemInit --- initialize this module's shared memory
+ */
+void
+AioShmemInit(void)
+{
+	Size		size = AioShmemSize();
+	bool		found;
+
+	if (size == 0)
+		return;
+
+	AioCtl = (AioCtlData *) ShmemInitStruct("Asynchronous I/O", size, &found);
+
+	if (!IsUnderPostmaster)
+	{
+		int			i;
+
+		Assert(!found);
+
+		MemSet(AioCtl, 0, size);
+		for (i = 0; i < io_workers; i++)
+			AioCtl->workerLocks[i] = LWLockAssign();
+		for (i = 0; i < AIO_CANCEL_SLOTS; i++)
+		{
+			pg_atomic_init_u32(&AioCtl->relCancel[i], 0);
+			pg_atomic_init_u32(&AioCtl->dbCancel[i], 0);
+		}
+		SpinLockInit(&AioCtl->mutex);
+		AioCtl->numProcs = AioNumProcs();
+	}
+	else
+		Assert(found);
+}
+
+/*
+ * AioRegisterWorkers --- register the I/O workers with the postmaster
+ *
+ * Called once during postmaster startup.  The workers count against
+ * max_worker_processes like any other background worker.
+ */
+void
+AioRegisterWorkers(void)
+{
+	BackgroundWorker worker;
+	int			i;
+
+	for (i = 0; i < io_workers; i++)
+	{
+		MemSet(&worker, 0, sizeof(worker));
+		snprintf(worker.bgw_name, BGW_MAXLEN, "io worker %d", i);
+		worker.bgw_flags = BGWORKER_SHMEM_ACCESS;
+		worker.bgw_start_time = BgWorkerStart_PostmasterStart;
+		worker.bgw_restart_time = 1;
+		worker.bgw_main = IoWorkerMain;
+		worker.bgw_main_arg = Int32GetDatum(i);
+		worker.bgw_notify_pid = 0;
+
+		RegisterInternalBackgroundWorker(&worker);
+	}
+}
+
+/*
+ * Ask the I/O workers to read a block of a permanent relation into shared
+ * buffers.  btype is the kind of access strategy the submitter reads the
+ * relation with; the worker reads the block with a strategy of that kind.
+ *
+ * Returns false, without doing anything, if the request could not be queued.
+ */
+bool
+AioSubmitReadBuffer(RelFileNode rnode, ForkNumber forkNum,
+					BlockNumber blockNum, BufferAccessStrategyType btype)
+{
+	AioRequest	req;
+
+	if (AioCtl == NULL)
+		return false;
+
+	req.op = AIO_READ_BUFFER;
+	req.rnode = rnode;
+	req.forkNum = forkNum;
+	req.blockNum = blockNum;
+	req.btype = btype;
+	req.relCancel =
+		pg_atomic_read_u32(&AioCtl->relCancel[AioRelCancelSlot(rnode)]);
+	req.dbCancel =
+		pg_atomic_read_u32(&AioCtl->dbCancel[AioDbCancelSlot(rnode.dbNode)]);
+	req.buf_id = -1;
+
+	return AioSubmit(&req);
+}
+
+/*
+ * Ask the I/O workers to write out a shared buffer for the checkpoint that
+ * is in progress.  The buffer is written only if it is still marked
+ * BM_CHECKPOINT_NEEDED by the time a worker gets to it.
+ *
+ * Returns false, without doing anything, if the request could not be queued.
+ */
+bool
+AioSubmitWriteBuffer(int buf_id)
+{
+	AioRequest	req;
+
+	req.op = AIO_WRITE_BUFFER;
+	req.buf_id = buf_id;
+
+	return AioSubmit(&req);
+}
+
+/*
+ * Wait until all requests submitted by this backend have been processed.
+ *
+ * The checkpointer absorbs fsync requests while it waits, since the writes
+ * done on its behalf by the workers generate a lot of them.
+ */
+void
+AioWaitForCompletion(void)
+{
+	volatile AioCtlData *ctl = AioCtl;
+	volatile AioProcStats *stats;
+	bool		slept = false;
+
+	if (ctl == NULL || MyProc == NULL)
+		return;
+
+	stats = &ctl->procStats[MyProc->pgprocno];
+
+	for (;;)
+	{
+		int			inflight;
+		int			rc;
+
+		ResetLatch(MyLatch);
+
+		SpinLockAcquire(&ctl->mutex);
+		inflight = (stats->pid == MyProcPid) ? stats->inflight : 0;
+		if (inflight > 0 && !slept)
+		{
+			stats->waits++;
+			slept = true;
+		}
+		SpinLockRelease(&ctl->mutex);
+
+		if (inflight <= 0)
+			break;
+
+		if (AmCheckpointerProcess())
+			AbsorbFsyncRequests();
+
+		rc = WaitLatch(MyLatch, WL_LATCH_SET | WL_TIMEOUT | WL_POSTMASTER_DEATH,
+					   100L);
+		if (rc & WL_POSTMASTER_DEATH)
+			proc_exit(1);
+	}
+}
+
+/*
+ * Queue a request and wake up an idle worker, if any.
+ */
+static bool
+AioSubmit(AioRequest *req)
+{
+	volatile AioCtlData *ctl = AioCtl;
+	volatile AioProcStats *stats;
+	Latch	   *latch = NULL;
+	bool		queued = false;
+
+	if (ctl == NULL || MyProc == NULL)
+		return false;
+
+	req->procno = MyProc->pgprocno;
+	req->pid = MyProcPid;
+	stats = &ctl->procStats[req->procno];
+
+	SpinLockAcquire(&ctl->mutex);
+
+	if (stats->pid != MyProcPid)
+	{
+		/* first use of this slot by this process; reset counters */
+		stats->pid = MyProcPid;
+		stats->inflight = 0;
+		stats->reads_submitted = 0;
+		stats->writes_submitted = 0;
+		stats->completed = 0;
+		stats->queue_full = 0;
+		stats->waits = 0;
+	}
+
+	if (ctl->running > 0)
+	{
+		if (ctl->tail - ctl->head < AIO_QUEUE_SIZE)
+		{
+			ctl->queue[ctl->tail % AIO_QUEUE_SIZE] = *req;
+			ctl->tail++;
+			stats->inflight++;
+			if (req->op == AIO_READ_BUFFER)
+				stats->reads_submitted++;
+			else
+				stats->writes_submitted++;
+			queued = true;
+
+			if (ctl->idleWorkers != 0)
+			{
+				int			i;
+
+				for (i = 0; i < MAX_IO_WORKERS; i++)
+				{
+					if (ctl->idleWorkers & ((uint32) 1 << i))
+					{
+						ctl->idleWorkers &= ~((uint32) 1 << i);
+						latch = ctl->workerLatches[i];
+						break;
+					}
+				}
+			}
+		}
+		else
+			stats->queue_full++;
+	}
+
+	SpinLockRelease(&ctl->mutex);
+
+	if (latch != NULL)
+		SetLatch(latch);
+
+	return queued;
+}
+
+/*
+ * Take the next request off the queue.  If the queue is empty, mark the
+ * worker idle and return false.
+ */
+static bool
+AioDequeue(int workerno, AioRequest *req)
+{
+	volatile AioCtlData *ctl = AioCtl;
+	bool		found = false;
+
+	SpinLockAcquire(&ctl->mutex);
+	if (ctl->head != ctl->tail)
+	{
+		*req = ctl->queue[ctl->head % AIO_QUEUE_SIZE];
+		ctl->head++;
+		ctl->idleWorkers &= ~((uint32) 1 << workerno);
+		found = true;
+	}
+	else
+		ctl->idleWorkers |= ((uint32) 1 << workerno);
+	SpinLockRelease(&ctl->mutex);
+
+	return found;
+}
+
+/*
+ * Count a request as completed and wake up its submitter.
+ */
+static void
+AioComplete(AioRequest *req)
+{
+	volatile AioCtlData *ctl = AioCtl;
+	volatile AioProcStats *stats = &ctl->procStats[req->procno];
+	bool		wakeup = false;
+
+	SpinLockAcquire(&ctl->mutex);
+	/* ignore it if the submitter has gone away in the meantime */
+	if (stats->pid == req->pid)
+	{
+		stats->inflight--;
+		stats->completed++;
+		wakeup = true;
+	}
+	SpinLockRelease(&ctl->mutex);
+
+	if (wakeup)
+		SetLatch(&ProcGlobal->allProcs[req->procno].procLatch);
+}
+
+/*
+ * Cancel queued reads of the given relations, and wait for any reads of them
+ * that I/O workers are already doing to finish.
+ *
+ * The caller must make sure that no new reads of the relations can be
+ * submitted, normally by holding AccessExclusiveLock on them.
+ */
+void
+AioCancelReads(const RelFileNode *rnodes, int nnodes)
+{
+	if (nnodes > 0)
+		AioCancelReadsInternal(rnodes, nnodes, InvalidOid);
+}
+
+/*
+ * Likewise for all relations of a database that is being dropped.
+ */
+void
+AioCancelDatabaseReads(Oid dbid)
+{
+	AioCancelReadsInternal(NULL, 0, dbid);
+}
+
+static void
+AioCancelReadsInternal(const RelFileNode *rnodes, int nnodes, Oid dbid)
+{
+	AioCtlData *ctl = AioCtl;
+	int			i;
+
+	if (ctl == NULL)
+		return;
+
+	/*
+	 * Bump the cancel counters, so that workers skip the reads that are
+	 * still queued.  The atomic increment is a full memory barrier.
+	 */
+	if (rnodes == NULL)
+		pg_atomic_fetch_add_u32(&ctl->dbCancel[AioDbCancelSlot(dbid)], 1);
+	else
+	{
+		for (i = 0; i < nnodes; i++)
+		{
+			int			slot = AioRelCancelSlot(rnodes[i]);
+
+			pg_atomic_fetch_add_u32(&ctl->relCancel[slot], 1);
+		}
+	}
+
+	/*
+	 * A worker that checked the counters before we bumped them may still be
+	 * reading.  It holds its lock while it does, so taking each lock in turn
+	 * waits for all such reads; a worker that gets its lock after us will see
+	 * the new counter values.
+	 */
+	for (i = 0; i < MAX_IO_WORKERS; i++)
+	{
+		if (ctl->workerLocks[i] == NULL)
+			break;
+		LWLockAcquire(ctl->workerLocks[i], LW_SHARED);
+		LWLockRelease(ctl->workerLocks[i]);
+	}
+}
+
+/*
+ * Has a read request been cancelled since it was submitted?
+ */
+static bool
+AioReadCancelled(AioRequest *req)
+{
+	AioCtlData *ctl = AioCtl;
+
+	return req->relCancel !=
+		pg_atomic_read_u32(&ctl->relCancel[AioRelCancelSlot(req->rnode)]) ||
+		req->dbCancel !=
+		pg_atomic_read_u32(&ctl->dbCancel[AioDbCancelSlot(req->rnode.dbNode)]);
+}
+
+/*
+ * Get the I/O worker's access strategy of the given type.
+ *
+ * A worker has just one ring of each type, shared by all the scans it reads
+ * for.  A block that is recycled before its scan gets to it is just read
+ * again by the scan.
+ */
+static BufferAccessStrategy
+AioGetStrategy(BufferAccessStrategyType btype)
+{
+	if (btype == BAS_NORMAL)
+		return NULL;
+
+	if (worker_strategies[btype] == NULL)
+	{
+		MemoryContext oldcontext = MemoryContextSwitchTo(TopMemoryContext);
+
+		worker_strategies[btype] = GetAccessStrategy(btype);
+		MemoryContextSwitchTo(oldcontext);
+	}
+	return worker_strategies[btype];
+}
+
+/*
+ * Carry out one request.
+ */
+static void
+AioPerform(AioRequest *req)
+{
+	switch (req->op)
+	{
+		case AIO_READ_BUFFER:
+			{
+				LWLock	   *lock = AioCtl->workerLocks[MyIoWorkerNo];
+				SMgrRelation reln;
+
+				/*
+				 * The relation can't be dropped or truncated while we hold
+				 * our lock, since AioCancelReads waits for it.  If that
+				 * happened since the request was made, the cancel counters
+				 * have moved on, and we must not read the block back in.
+				 * Even if they haven't, the relation may have been truncated
+				 * before the request was made; don't complain about that.
+				 * An error releases the lock, in LWLockReleaseAll.
+				 */
+				LWLockAcquire(lock, LW_EXCLUSIVE);
+				if (!AioReadCancelled(req))
+				{
+					reln = smgropen(req->rnode, InvalidBackendId);
+					if (smgrexists(reln, req->forkNum) &&
+						req->blockNum < smgrnblocks(reln, req->forkNum))
+					{
+						BufferAccessStrategy strategy;
+						Buffer		buf;
+
+						strategy = AioGetStrategy(req->btype);
+						buf = ReadBufferWithoutRelcache(req->rnode,
+														req->forkNum,
+														req->blockNum,
+														RBM_NORMAL,
+														strategy);
+						ReleaseBuffer(buf);
+					}
+				}
+				LWLockRelease(lock);
+				break;
+			}
+		case AIO_WRITE_BUFFER:
+			SyncCheckpointBuffer(req->buf_id);
+			break;
+	}
+}
+
+/*
+ * Main entry point for an I/O worker process
+ */
+void
+IoWorkerMain(Datum main_arg)
+{
+	int			workerno = DatumGetInt32(main_arg);
+	volatile AioCtlData *ctl = AioCtl;
+	sigjmp_buf	local_sigjmp_buf;
+	MemoryContext ioworker_context;
+
+	pqsignal(SIGTERM, ioworker_sigterm);
+	BackgroundWorkerUnblockSignals();
+
+	if (ctl == NULL || workerno < 0 || workerno >= MAX_IO_WORKERS)
+		proc_exit(0);
+	MyIoWorkerNo = workerno;
+
+	/*
+	 * Create a resource owner to keep track of our buffer pins, and a memory
+	 * context we can reset after an error.
+	 */
+	CurrentResourceOwner = ResourceOwnerCreate(NULL, "I/O Worker");
+	ioworker_context = AllocSetContextCreate(TopMemoryContext,
+											 "I/O Worker",
+											 ALLOCSET_DEFAULT_MINSIZE,
+											 ALLOCSET_DEFAULT_INITSIZE,
+											 ALLOCSET_DEFAULT_MAXSIZE);
+	MemoryContextSwitchTo(ioworker_context);
+
+	/* Announce ourselves */
+	on_shmem_exit(AioWorkerShutdown, main_arg);
+
+	SpinLockAcquire(&ctl->mutex);
+	ctl->workerLatches[workerno] = &MyProc->procLatch;
+	ctl->running++;
+	SpinLockRelease(&ctl->mutex);
+
+	/*
+	 * If an exception is encountered, processing resumes here.  The failed
+	 * request is reported and counted as completed, and we go on with the
+	 * next one.  This is a minimal subset of AbortTransaction(), as in the
+	 * bgwriter.
+	 */
+	if (sigsetjmp(local_sigjmp_buf, 1) != 0)
+	{
+		/* Since not using PG_TRY, must reset error stack by hand */
+		error_context_stack = NULL;
+
+		/* Prevent interrupts while cleaning up */
+		HOLD_INTERRUPTS();
+
+		/* Report the error to the server log */
+		EmitErrorReport();
+
+		LWLockReleaseAll();
+		AbortBufferIO();
+		UnlockBuffers();
+		/* buffer pins are released here: */
+		ResourceOwnerRelease(CurrentResourceOwner,
+							 RESOURCE_RELEASE_BEFORE_LOCKS,
+							 false, true);
+		AtEOXact_Buffers(false);
+		AtEOXact_SMgr();
+		AtEOXact_Files();
+		AtEOXact_HashTables(false);
+
+		MemoryContextSwitchTo(ioworker_context);
+		FlushErrorState();
+		MemoryContextResetAndDeleteChildren(ioworker_context);
+
+		RESUME_INTERRUPTS();
+
+		if (have_request)
+		{
+			have_request = false;
+			AioComplete(&current_request);
+		}
+
+		smgrcloseall();
+	}
+
+	/* We can now handle ereport(ERROR) */
+	PG_exception_stack = &local_sigjmp_buf;
+
+	for (;;)
+	{
+		int			rc;
+
+		ResetLatch(MyLatch);
+
+		if (got_SIGTERM)
+			proc_exit(0);
+
+		while (!got_SIGTERM && AioDequeue(workerno, &current_request))
+		{
+			have_request = true;
+			AioPerform(&current_request);
+			have_request = false;
+			AioComplete(&current_request);
+		}
+
+		if (got_SIGTERM)
+			continue;
+
+		/*
+		 * Close files before going to sleep, so that we don't keep dropped
+		 * relations' files open indefinitely.
+		 */
+		smgrcloseall();
+
+		rc = WaitLatch(MyLatch, WL_LATCH_SET | WL_POSTMASTER_DEATH, 0L);
+		if (rc & WL_POSTMASTER_DEATH)
+			proc_exit(1);
+	}
+}
+
+/*
+ * on_shmem_exit callback for an I/O worker
+ *
+ * If we are the last worker to go, nobody is left to process the queued
+ * requests, so they are dropped and counted as completed, as is a request we
+ * were in the middle of.  Submitters check that what they needed actually
+ * happened.
+ */
+static void
+AioWorkerShutdown(int code, Datum arg)
+{
+	volatile AioCtlData *ctl = AioCtl;
+	int			workerno = DatumGetInt32(arg);
+	int			wakeup[AIO_QUEUE_SIZE];
+	int			nwakeup = 0;
+	int			i;
+
+	SpinLockAcquire(&ctl->mutex);
+	ctl->workerLatches[workerno] = NULL;
+	ctl->idleWorkers &= ~((uint32) 1 << workerno);
+	ctl->running--;
+	if (ctl->running == 0)
+	{
+		while (ctl->head != ctl->tail)
+		{
+			volatile AioRequest *req = &ctl->queue[ctl->head % AIO_QUEUE_SIZE];
+			volatile AioProcStats *stats = &ctl->procStats[req->procno];
+
+			if (stats->pid == req->pid)
+			{
+				stats->inflight--;
+				stats->completed++;
+				wakeup[nwakeup++] = req->procno;
+			}
+			ctl->head++;
+		}
+	}
+	SpinLockRelease(&ctl->mutex);
+
+	/* Don't leave the submitter of an interrupted request waiting, either */
+	if (have_request)
+	{
+		have_request = false;
+		AioComplete(&current_request);
+	}
+
+	for (i = 0; i < nwakeup; i++)
+		SetLatch(&ProcGlobal->allProcs[wakeup[i]].procLatch);
+}
+
+/* SIGTERM: set flag to exit at the next convenient point */
+static void
+ioworker_sigterm(SIGNAL_ARGS)
+{
+	int			save_errno = errno;
+
+	got_SIGTERM = true;
+	SetLatch(MyLatch);
+
+	errno = save_errno;
+}
+
+/*
+ * Returns I/O request statistics for all backends that have submitted
+ * asynchronous I/O requests.
+ */
+Datum
+pg_stat_get_aio(PG_FUNCTION_ARGS)
+{
+#define PG_STAT_GET_AIO_COLS	7
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	TupleDesc	tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext per_query_ctx;
+	MemoryContext oldcontext;
+	int			i;
+
+	/* check to see if caller supports us returning a tuplestore */
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("set-valued function called in context that cannot accept a set")));
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("materialize mode required, but it is not " \
+						"allowed in this context")));
+
+	/* Build a tuple descriptor for our result type */
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	for (i = 0; AioCtl != NULL && i < AioCtl->numProcs; i++)
+	{
+		volatile AioCtlData *ctl = AioCtl;
+		AioProcStats stats;
+		Datum		values[PG_STAT_GET_AIO_COLS];
+		bool		nulls[PG_STAT_GET_AIO_COLS];
+
+		SpinLockAcquire(&ctl->mutex);
+		stats = ctl->procStats[i];
+		SpinLockRelease(&ctl->mutex);
+
+		/* skip slots not in use by their last submitter any more */
+		if (stats.pid == 0 || stats.pid != ProcGlobal->allProcs[i].pid)
+			continue;
+
+		MemSet(nulls, 0, sizeof(nulls));
+		values[0] = Int32GetDatum(stats.pid);
+		values[1] = Int64GetDatum((int64) stats.reads_submitted);
+		values[2] = Int64GetDatum((int64) stats.writes_submitted);
+		values[3] = Int64GetDatum((int64) stats.completed);
+		values[4] = Int32GetDatum(stats.inflight);
+		values[5] = Int64GetDatum((int64) stats.queue_full);
+		values[6] = Int64GetDatum((int64) stats.waits);
+
+		tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+	}
+
+	/* clean up and return the tuplestore */
+	tuplestore_donestoring(tupstore);
+
+	return (Datum) 0;
+}
@@ -73,9 +73,11 @@ InitBufferPool(void)
 						NBuffers * sizeof(BufferDescPadded) + PG_CACHE_LINE_SIZE,
 						&foundDescs));
 
-	BufferBlocks = (char *)
+	/* Align buffer pool on IO page size boundary, as direct I/O needs it. */
+	BufferBlocks = (char *) TYPEALIGN(PG_IO_ALIGN_SIZE,
 		ShmemInitStruct("Buffer Blocks",
-						NBuffers * (Size) BLCKSZ, &foundBufs);
+						NBuffers * (Size) BLCKSZ + PG_IO_ALIGN_SIZE,
+						&foundBufs));
 
 	if (foundDescs || foundBufs)
 	{
@@ -138,7 +140,8 @@ BufferShmemSize(void)
 	/* to allow aligning buffer descriptors */
 	size = add_size(size, PG_CACHE_LINE_SIZE);
 
-	/* size of data pages */
+	/* size of data pages, plus alignment padding */
+	size = add_size(size, PG_IO_ALIGN_SIZE);
 	size = add_size(size, mul_size(NBuffers, BLCKSZ));
 
 	/* size of stuff controlled by freelist.c */
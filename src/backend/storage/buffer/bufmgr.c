@@ -41,6 +41,7 @@
 #include "pg_trace.h"
 #include "pgstat.h"
 #include "postmaster/bgwriter.h"
+#include "storage/aio.h"
 #include "storage/buf_internals.h"
 #include "storage/bufmgr.h"
 #include "storage/ipc.h"
@@ -66,6 +67,13 @@
 
 #define DROP_RELS_BSEARCH_THRESHOLD		20
 
+/*
+ * When dropping buffers of relations with fewer than this many blocks in
+ * total, look up each block in the buffer mapping table instead of scanning
+ * the whole buffer pool.
+ */
+#define BUF_DROP_FULL_SCAN_THRESHOLD		(uint64) (NBuffers / 32)
+
 typedef struct PrivateRefCountEntry
 {
 	Buffer buffer;
@@ -411,6 +419,12 @@ static void FlushBuffer(volatile BufferDesc *buf, SMgrRelation reln);
 static void AtProcExit_Buffers(int code, Datum arg);
 static void CheckForBufferLeaks(void);
 static int	rnode_comparator(const void *p1, const void *p2);
+static BlockNumber DropBufferFork_nblocks(SMgrRelation smgr_reln,
+					   ForkNumber forkNum);
+static void FindAndDropRelFileNodeBuffers(RelFileNode rnode,
+							  ForkNumber forkNum,
+							  BlockNumber nForkBlock,
+							  BlockNumber firstDelBlock);
 
 
 /*
@@ -423,6 +437,21 @@ static int	rnode_comparator(const void *p1, const void *p2);
  */
 void
 PrefetchBuffer(Relation reln, ForkNumber forkNum, BlockNumber blockNum)
+{
+	PrefetchBufferExtended(reln, forkNum, blockNum, BAS_NORMAL);
+}
+
+/*
+ * PrefetchBufferExtended -- prefetch a block, for a scan that reads with
+ *		an access strategy of type btype
+ *
+ * If an I/O worker reads the block into shared buffers, it uses a strategy
+ * of the same type, so that a large scan's readahead recycles a ring of
+ * buffers just like the scan itself instead of flooding the buffer pool.
+ */
+void
+PrefetchBufferExtended(Relation reln, ForkNumber forkNum, BlockNumber blockNum,
+					   BufferAccessStrategyType btype)
 {
 #ifdef USE_PREFETCH
 	Assert(RelationIsValid(reln));
@@ -462,9 +491,18 @@ PrefetchBuffer(Relation reln, ForkNumber forkNum, BlockNumber blockNum)
 		buf_id = BufTableLookup(&newTag, newHash);
 		LWLockRelease(newPartitionLock);
 
-		/* If not in buffers, initiate prefetch */
+		/*
+		 * If not in buffers, initiate prefetch.  For permanent relations, ask
+		 * an I/O worker to read the block into shared buffers if possible;
+		 * otherwise just tell the kernel we'll need it.
+		 */
 		if (buf_id < 0)
-			smgrprefetch(reln->rd_smgr, forkNum, blockNum);
+		{
+			if (reln->rd_rel->relpersistence != RELPERSISTENCE_PERMANENT ||
+				!AioSubmitReadBuffer(reln->rd_smgr->smgr_rnode.node,
+									 forkNum, blockNum, btype))
+				smgrprefetch(reln->rd_smgr, forkNum, blockNum);
+		}
 
 		/*
 		 * If the block *is* in buffers, we do nothing.  This is not really
@@ -1576,6 +1614,7 @@ BufferSync(int flags)
 	int			num_to_scan;
 	int			num_to_write;
 	int			num_written;
+	int			num_submitted;
 	int			mask = BM_DIRTY;
 
 	/* Make sure we can handle the pin inside SyncOneBuffer */
@@ -1642,6 +1681,7 @@ BufferSync(int flags)
 	buf_id = StrategySyncStart(NULL, NULL);
 	num_to_scan = NBuffers;
 	num_written = 0;
+	num_submitted = 0;
 	while (num_to_scan-- > 0)
 	{
 		volatile BufferDesc *bufHdr = GetBufferDescriptor(buf_id);
@@ -1660,7 +1700,21 @@ BufferSync(int flags)
 		 */
 		if (bufHdr->flags & BM_CHECKPOINT_NEEDED)
 		{
-			if (SyncOneBuffer(buf_id, false) & BUF_WRITTEN)
+			bool		written;
+
+			/*
+			 * Hand the write to the I/O workers if we can; a queued write is
+			 * counted as written for pacing purposes.
+			 */
+			if (AioSubmitWriteBuffer(buf_id))
+			{
+				written = true;
+				num_submitted++;
+			}
+			else
+				written = (SyncOneBuffer(buf_id, false) & BUF_WRITTEN) != 0;
+
+			if (written)
 			{
 				TRACE_POSTGRESQL_BUFFER_SYNC_WRITTEN(buf_id);
 				BgWriterStats.m_buf_written_checkpoints++;
@@ -1691,6 +1745,25 @@ BufferSync(int flags)
 			buf_id = 0;
 	}
 
+	/*
+	 * Wait for the writes handed to the I/O workers.  A buffer that a worker
+	 * failed to write, or whose request was dropped because the workers
+	 * exited, still has BM_CHECKPOINT_NEEDED set; write those ourselves, so
+	 * that an error is reported by the checkpoint itself.
+	 */
+	if (num_submitted > 0)
+	{
+		AioWaitForCompletion();
+
+		for (buf_id = 0; buf_id < NBuffers; buf_id++)
+		{
+			volatile BufferDesc *bufHdr = GetBufferDescriptor(buf_id);
+
+			if (bufHdr->flags & BM_CHECKPOINT_NEEDED)
+				SyncOneBuffer(buf_id, false);
+		}
+	}
+
 	/*
 	 * Update checkpoint statistics. As noted above, this doesn't include
 	 * buffers written by other backends or bgwriter scan.
@@ -2063,6 +2136,31 @@ SyncOneBuffer(int buf_id, bool skip_recently_used)
 	return result | BUF_WRITTEN;
 }
 
+/*
+ * SyncCheckpointBuffer -- write out a buffer for the checkpoint in progress
+ *
+ * This is used by the I/O workers to carry out writes that BufferSync handed
+ * to them.  The buffer is written only if it still needs to be.
+ */
+void
+SyncCheckpointBuffer(int buf_id)
+{
+	volatile BufferDesc *bufHdr = GetBufferDescriptor(buf_id);
+	bool		needed;
+
+	LockBufHdr(bufHdr);
+	needed = (bufHdr->flags & BM_CHECKPOINT_NEEDED) != 0;
+	UnlockBufHdr(bufHdr);
+
+	if (!needed)
+		return;
+
+	/* Make sure we can handle the pin inside SyncOneBuffer */
+	ResourceOwnerEnlargeBuffers(CurrentResourceOwner);
+
+	SyncOneBuffer(buf_id, false);
+}
+
 /*
  *		AtEOXact_Buffers - clean up at end of transaction.
  *
@@ -2527,16 +2625,17 @@ BufferGetLSNAtomic(Buffer buffer)
  *		that no other process could be trying to load more pages of the
  *		relation into buffers.
  *
- *		XXX currently it sequentially searches the buffer pool, should be
- *		changed to more clever ways of searching.  However, this routine
- *		is used only in code paths that aren't very performance-critical,
- *		and we shouldn't slow down the hot paths to make it faster ...
+ *		During recovery, if the fork's size is known and only a few pages
+ *		are to be dropped, we look each of them up in the buffer mapping
+ *		table; otherwise we sequentially search the buffer pool.
  * --------------------------------------------------------------------
  */
 void
-DropRelFileNodeBuffers(RelFileNodeBackend rnode, ForkNumber forkNum,
+DropRelFileNodeBuffers(SMgrRelation smgr_reln, ForkNumber forkNum,
 					   BlockNumber firstDelBlock)
 {
+	RelFileNodeBackend rnode = smgr_reln->smgr_rnode;
+	BlockNumber nForkBlock;
 	int			i;
 
 	/* If it's a local relation, it's localbuf.c's problem. */
@@ -2547,6 +2646,28 @@ DropRelFileNodeBuffers(RelFileNodeBackend rnode, ForkNumber forkNum,
 		return;
 	}
 
+	/* Make sure no I/O worker is about to read pages of it, either */
+	AioCancelReads(&rnode.node, 1);
+
+	/*
+	 * Since no one can be loading pages of the relation, every page of it in
+	 * the buffer pool lies below its current length.  If we know that length
+	 * and only a few pages lie between firstDelBlock and it, look them up one
+	 * by one.
+	 */
+	nForkBlock = DropBufferFork_nblocks(smgr_reln, forkNum);
+	if (nForkBlock != InvalidBlockNumber)
+	{
+		if (nForkBlock <= firstDelBlock)
+			return;
+		if (nForkBlock - firstDelBlock < BUF_DROP_FULL_SCAN_THRESHOLD)
+		{
+			FindAndDropRelFileNodeBuffers(rnode.node, forkNum, nForkBlock,
+										  firstDelBlock);
+			return;
+		}
+	}
+
 	for (i = 0; i < NBuffers; i++)
 	{
 		volatile BufferDesc *bufHdr = GetBufferDescriptor(i);
@@ -2587,32 +2708,68 @@ DropRelFileNodeBuffers(RelFileNodeBackend rnode, ForkNumber forkNum,
  *		forks of the specified relations.  It's equivalent to calling
  *		DropRelFileNodeBuffers once per fork per relation with
  *		firstDelBlock = 0.
+ *
+ *		During recovery, if the relations' sizes are known and they are
+ *		small enough all together, each of their pages is looked up;
+ *		otherwise they are all handled in a single pass over the buffer
+ *		pool.
  * --------------------------------------------------------------------
  */
 void
-DropRelFileNodesAllBuffers(RelFileNodeBackend *rnodes, int nnodes)
+DropRelFileNodesAllBuffers(SMgrRelation *smgr_reln, int nnodes)
 {
 	int			i,
 				n = 0;
 	RelFileNode *nodes;
+	SMgrRelation *rels;
 	bool		use_bsearch;
+	BlockNumber (*forkblocks)[MAX_FORKNUM + 1];
+	uint64		nBlocksToDrop = 0;
+	bool		sizes_known = true;
+	ForkNumber	fork;
 
 	if (nnodes == 0)
 		return;
 
 	nodes = palloc(sizeof(RelFileNode) * nnodes);		/* non-local relations */
+	rels = palloc(sizeof(SMgrRelation) * nnodes);
+	forkblocks = palloc(sizeof(*forkblocks) * nnodes);
 
 	/* If it's a local relation, it's localbuf.c's problem. */
 	for (i = 0; i < nnodes; i++)
 	{
-		if (RelFileNodeBackendIsTemp(rnodes[i]))
+		RelFileNodeBackend rnode = smgr_reln[i]->smgr_rnode;
+
+		if (RelFileNodeBackendIsTemp(rnode))
+		{
+			if (rnode.backend == MyBackendId)
+				DropRelFileNodeAllLocalBuffers(rnode.node);
+			continue;
+		}
+
+		rels[n] = smgr_reln[i];
+		nodes[n++] = rnode.node;
+	}
+
+	/* Make sure no I/O worker is about to read pages of them */
+	AioCancelReads(nodes, n);
+
+	/* Remember the fork sizes of relations while they're few enough */
+	for (i = 0; i < n && sizes_known &&
+		 nBlocksToDrop < BUF_DROP_FULL_SCAN_THRESHOLD; i++)
+	{
+		for (fork = 0; fork <= MAX_FORKNUM; fork++)
 		{
-			if (rnodes[i].backend == MyBackendId)
-				DropRelFileNodeAllLocalBuffers(rnodes[i].node);
+			forkblocks[i][fork] = DropBufferFork_nblocks(rels[i], fork);
+			if (forkblocks[i][fork] == InvalidBlockNumber)
+			{
+				sizes_known = false;
+				break;
+			}
+			nBlocksToDrop += forkblocks[i][fork];
 		}
-		else
-			nodes[n++] = rnodes[i].node;
 	}
+	pfree(rels);
 
 	/*
 	 * If there are no non-local relations, then we're done. Release the
@@ -2621,6 +2778,28 @@ DropRelFileNodesAllBuffers(RelFileNodeBackend *rnodes, int nnodes)
 	if (n == 0)
 	{
 		pfree(nodes);
+		pfree(forkblocks);
+		return;
+	}
+
+	/*
+	 * If the relations are small enough all together, look up each of their
+	 * pages rather than scanning the buffer pool.
+	 */
+	if (sizes_known && nBlocksToDrop < BUF_DROP_FULL_SCAN_THRESHOLD)
+	{
+		for (i = 0; i < n; i++)
+		{
+			for (fork = 0; fork <= MAX_FORKNUM; fork++)
+			{
+				if (forkblocks[i][fork] > 0)
+					FindAndDropRelFileNodeBuffers(nodes[i], fork,
+												  forkblocks[i][fork], 0);
+			}
+		}
+
+		pfree(nodes);
+		pfree(forkblocks);
 		return;
 	}
 
@@ -2678,6 +2857,84 @@ DropRelFileNodesAllBuffers(RelFileNodeBackend *rnodes, int nnodes)
 	}
 
 	pfree(nodes);
+	pfree(forkblocks);
+}
+
+/*
+ * DropBufferFork_nblocks -- number of blocks of a fork that might be in
+ * the buffer pool, or InvalidBlockNumber if we can't be sure
+ *
+ * We only trust this during recovery, where the startup process is the only
+ * one extending or truncating relations, so the size in the shared relation
+ * size cache can't be stale.  Outside recovery, the caller must scan the
+ * buffer pool.  If the fork's size isn't cached, we check whether the fork
+ * exists at all, which usually means finding it doesn't; if it does exist,
+ * its size is unknown.
+ */
+static BlockNumber
+DropBufferFork_nblocks(SMgrRelation smgr_reln, ForkNumber forkNum)
+{
+	BlockNumber nblocks;
+
+	if (!InRecovery)
+		return InvalidBlockNumber;
+
+	nblocks = smgrnblocks_cached(smgr_reln, forkNum);
+	if (nblocks == InvalidBlockNumber && !smgrexists(smgr_reln, forkNum))
+		return 0;
+
+	return nblocks;
+}
+
+/*
+ * FindAndDropRelFileNodeBuffers -- drop the buffers of the given fork with
+ * block numbers from firstDelBlock up to nForkBlock - 1, by looking up each
+ * of them in the buffer mapping table
+ */
+static void
+FindAndDropRelFileNodeBuffers(RelFileNode rnode, ForkNumber forkNum,
+							  BlockNumber nForkBlock,
+							  BlockNumber firstDelBlock)
+{
+	BlockNumber curBlock;
+
+	for (curBlock = firstDelBlock; curBlock < nForkBlock; curBlock++)
+	{
+		BufferTag	bufTag;		/* identity of requested block */
+		uint32		bufHash;	/* hash value for tag */
+		LWLock	   *bufPartitionLock;	/* buffer partition lock for it */
+		int			buf_id;
+		volatile BufferDesc *bufHdr;
+
+		/* create a tag so we can lookup the buffer */
+		INIT_BUFFERTAG(bufTag, rnode, forkNum, curBlock);
+
+		/* determine its hash code and partition lock ID */
+		bufHash = BufTableHashCode(&bufTag);
+		bufPartitionLock = BufMappingPartitionLock(bufHash);
+
+		/* Check that it is in the buffer pool. If not, do nothing. */
+		LWLockAcquire(bufPartitionLock, LW_SHARED);
+		buf_id = BufTableLookup(&bufTag, bufHash);
+		LWLockRelease(bufPartitionLock);
+
+		if (buf_id < 0)
+			continue;
+
+		bufHdr = GetBufferDescriptor(buf_id);
+
+		/*
+		 * We need to lock the buffer header and recheck if the buffer is
+		 * still associated with the same block because the buffer could be
+		 * evicted by some other backend loading blocks for a different
+		 * relation after we release lock on the BufMapping table.
+		 */
+		LockBufHdr(bufHdr);
+		if (BUFFERTAGS_EQUAL(bufHdr->tag, bufTag))
+			InvalidateBuffer(bufHdr);	/* releases spinlock */
+		else
+			UnlockBufHdr(bufHdr);
+	}
 }
 
 /* ---------------------------------------------------------------------
@@ -2701,6 +2958,8 @@ DropDatabaseBuffers(Oid dbid)
 	 * database isn't our own.
 	 */
 
+	AioCancelDatabaseReads(dbid);
+
 	for (i = 0; i < NBuffers; i++)
 	{
 		volatile BufferDesc *bufHdr = GetBufferDescriptor(i);
@@ -473,10 +473,12 @@ GetLocalBufferStorage(void)
 		/* But not more than what we need for all remaining local bufs */
 		num_bufs = Min(num_bufs, NLocBuffer - total_bufs_allocated);
 		/* And don't overflow MaxAllocSize, either */
-		num_bufs = Min(num_bufs, MaxAllocSize / BLCKSZ);
+		num_bufs = Min(num_bufs, MaxAllocSize / BLCKSZ - 1);
 
+		/* Buffers must be aligned for direct I/O; waste a bit for that */
 		cur_block = (char *) MemoryContextAlloc(LocalBufferContext,
-												num_bufs * BLCKSZ);
+											num_bufs * BLCKSZ + PG_IO_ALIGN_SIZE);
+		cur_block = (char *) TYPEALIGN(PG_IO_ALIGN_SIZE, cur_block);
 		next_buf_in_block = 0;
 		num_bufs_in_block = num_bufs;
 	}
@@ -111,6 +111,13 @@
  */
 int			max_files_per_process = 1000;
 
+/*
+ * Which kinds of files to open with O_DIRECT, bypassing the kernel's page
+ * cache; see DirectIOMode.  md.c and xlog.c look at this when opening their
+ * files, fd.c itself doesn't.
+ */
+int			direct_io = DIRECT_IO_OFF;
+
 /*
  * Maximum number of file descriptors to open for either VFD entries or
  * AllocateFile/AllocateDir/OpenTransientFile operations.  This is initialized
@@ -59,8 +59,14 @@ SendSharedInvalidMessages(const SharedInvalidationMessage *msgs, int n)
  * routine was entered.  It is of course possible for more messages to get
  * queued right after our last SIGetDataEntries call.
  *
+ * If this backend fell so far behind that some of its messages had to be
+ * removed from the queue, summaryFunction is called with a summary of them
+ * before the remaining messages are processed; if not even a summary could
+ * be kept, resetFunction is called instead.
+ *
  * NOTE: it is entirely possible for this routine to be invoked recursively
- * as a consequence of processing inside the invalFunction or resetFunction.
+ * as a consequence of processing inside the invalFunction, summaryFunction
+ * or resetFunction.
  * Furthermore, such a recursive call must guarantee that all outstanding
  * inval messages have been processed before it exits.  This is the reason
  * for the strange-looking choice to use a statically allocated buffer array
@@ -70,6 +76,7 @@ SendSharedInvalidMessages(const SharedInvalidationMessage *msgs, int n)
 void
 ReceiveSharedInvalidMessages(
 					  void (*invalFunction) (SharedInvalidationMessage *msg),
+					  void (*summaryFunction) (SharedInvalSummary *summary),
 							 void (*resetFunction) (void))
 {
 #define MAXINVALMSGS 32
@@ -91,16 +98,17 @@ ReceiveSharedInvalidMessages(
 		invalFunction(&msg);
 	}
 
-	do
+	for (;;)
 	{
 		int			getResult;
+		SharedInvalSummary summary;
 
 		nextmsg = nummsgs = 0;
 
 		/* Try to get some more messages */
-		getResult = SIGetDataEntries(messages, MAXINVALMSGS);
+		getResult = SIGetDataEntries(messages, MAXINVALMSGS, &summary);
 
-		if (getResult < 0)
+		if (getResult == -1)
 		{
 			/* got a reset message */
 			elog(DEBUG4, "cache state reset");
@@ -109,6 +117,15 @@ ReceiveSharedInvalidMessages(
 			break;				/* nothing more to do */
 		}
 
+		if (getResult == -2)
+		{
+			/* got a summary of messages we were too slow to read */
+			elog(DEBUG4, "cache state summary");
+			SharedInvalidMessageCounter++;
+			summaryFunction(&summary);
+			continue;			/* more messages may follow it */
+		}
+
 		/* Process them, being wary that a recursive call might eat some */
 		nextmsg = 0;
 		nummsgs = getResult;
@@ -125,7 +142,9 @@ ReceiveSharedInvalidMessages(
 		 * We only need to loop if the last SIGetDataEntries call (which might
 		 * have been within a recursive call) returned a full buffer.
 		 */
-	} while (nummsgs == MAXINVALMSGS);
+		if (nummsgs != MAXINVALMSGS)
+			break;
+	}
 
 	/*
 	 * We are now caught up.  If we received a catchup signal, reset that
@@ -43,16 +43,26 @@
  * smallest nextMsgNum --- it may lag behind.  We only update it when
  * SICleanupQueue is called, and we try not to do that often.)
  *
- * In reality, the messages are stored in a circular buffer of MAXNUMMESSAGES
- * entries.  We translate MsgNum values into circular-buffer indexes by
- * computing MsgNum % MAXNUMMESSAGES (this should be fast as long as
- * MAXNUMMESSAGES is a constant and a power of 2).  As long as maxMsgNum
- * doesn't exceed minMsgNum by more than MAXNUMMESSAGES, we have enough space
- * in the buffer.  If the buffer does overflow, we recover by setting the
- * "reset" flag for each backend that has fallen too far behind.  A backend
- * that is in "reset" state is ignored while determining minMsgNum.  When
- * it does finally attempt to receive inval messages, it must discard all
- * its invalidatable state, since it won't know what it missed.
+ * In reality, the messages are stored in a circular buffer of maxMessages
+ * entries, where maxMessages is invalidation_queue_size rounded up to a
+ * power of 2.  We translate MsgNum values into circular-buffer indexes by
+ * masking off the high-order bits.  As long as maxMsgNum doesn't exceed
+ * minMsgNum by more than maxMessages, we have enough space in the buffer.
+ * If the buffer does overflow, we recover by folding the oldest unread
+ * messages of each backend that has fallen too far behind into a per-backend
+ * summary (see SharedInvalSummary), and advancing its nextMsgNum past them.
+ * Only enough messages to make the needed room, plus SUMMARY_QUANTUM more,
+ * are folded at a time, so that the work done while holding both locks
+ * exclusively stays bounded however large the queue is; the summary keeps
+ * accumulating until the backend reads it.  The
+ * summary only keeps the messages that concern the backend's own database
+ * and shared catalogs, and only records which catcaches had anything
+ * invalidated, so it is usually much cheaper to apply than discarding all
+ * cached state.  If the messages don't fit in the summary, we fall back to
+ * setting the "reset" flag for the backend.  A backend that is in "reset"
+ * state is ignored while determining minMsgNum.  When it does finally
+ * attempt to receive inval messages, it must discard all its invalidatable
+ * state, since it won't know what it missed.
  *
  * To reduce the probability of needing resets, we send a "catchup" interrupt
  * to any backend that seems to be falling unreasonably far behind.  The
@@ -74,7 +84,7 @@
  * whenever minMsgNum exceeds MSGNUMWRAPAROUND, we subtract MSGNUMWRAPAROUND
  * from all the MsgNum variables simultaneously.  MSGNUMWRAPAROUND can be
  * large so that we don't need to do this often.  It must be a multiple of
- * MAXNUMMESSAGES so that the existing circular-buffer entries don't need
+ * maxMessages so that the existing circular-buffer entries don't need
  * to be moved when we do it.
  *
  * Access to the shared sinval array is protected by two locks, SInvalReadLock
@@ -107,11 +117,11 @@
 /*
  * Configurable parameters.
  *
- * MAXNUMMESSAGES: max number of shared-inval messages we can buffer.
- * Must be a power of 2 for speed.
+ * invalidation_queue_size: max number of shared-inval messages we can buffer.
+ * Rounded up to a power of 2 for speed; the result is SISeg.maxMessages.
  *
  * MSGNUMWRAPAROUND: how often to reduce MsgNum variables to avoid overflow.
- * Must be a multiple of MAXNUMMESSAGES.  Should be large.
+ * Must be a multiple of maxMessages.  Should be large.
  *
  * CLEANUP_MIN: the minimum number of messages that must be in the buffer
  * before we bother to call SICleanupQueue.
@@ -122,19 +132,28 @@
  * SIG_THRESHOLD: the minimum number of messages a backend must have fallen
  * behind before we'll send it PROCSIG_CATCHUP_INTERRUPT.
  *
+ * SUMMARY_QUANTUM: the number of messages beyond those that must be removed
+ * that SICleanupQueue folds into a lagging backend's summary at a time.
+ *
  * WRITE_QUANTUM: the max number of messages to push into the buffer per
  * iteration of SIInsertDataEntries.  Noncritical but should be less than
  * CLEANUP_QUANTUM, because we only consider calling SICleanupQueue once
  * per iteration.
  */
 
-#define MAXNUMMESSAGES 4096
-#define MSGNUMWRAPAROUND (MAXNUMMESSAGES * 262144)
-#define CLEANUP_MIN (MAXNUMMESSAGES / 2)
-#define CLEANUP_QUANTUM (MAXNUMMESSAGES / 16)
-#define SIG_THRESHOLD (MAXNUMMESSAGES / 2)
+int			invalidation_queue_size = 4096;
+
+#define MAX_INVALIDATION_QUEUE_SIZE (1 << 20)
+#define MSGNUMWRAPAROUND (MAX_INVALIDATION_QUEUE_SIZE * 1024)
+#define CLEANUP_MIN(segP) ((segP)->maxMessages / 2)
+#define CLEANUP_QUANTUM(segP) ((segP)->maxMessages / 16)
+#define SIG_THRESHOLD(segP) ((segP)->maxMessages / 2)
+#define SUMMARY_QUANTUM 256
 #define WRITE_QUANTUM 64
 
+/* Translate a MsgNum into an index into the circular buffer */
+#define SIMsgSlot(segP, msgnum) ((msgnum) & ((segP)->maxMessages - 1))
+
 /* Per-backend state in shared invalidation structure */
 typedef struct ProcState
 {
@@ -146,6 +165,7 @@ typedef struct ProcState
 	bool		resetState;		/* backend needs to reset its state */
 	bool		signaled;		/* backend has been sent catchup signal */
 	bool		hasMessages;	/* backend has unread messages */
+	bool		hasSummary;		/* summary holds messages not yet read */
 
 	/*
 	 * Backend only sends invalidations, never receives them. This only makes
@@ -162,6 +182,12 @@ typedef struct ProcState
 	 * meaningless in an active ProcState entry.
 	 */
 	LocalTransactionId nextLXID;
+
+	/*
+	 * Messages that were removed from the queue before this backend read
+	 * them.  Meaningful only if hasSummary is true.
+	 */
+	SharedInvalSummary summary;
 } ProcState;
 
 /* Shared cache invalidation memory segment */
@@ -175,13 +201,23 @@ typedef struct SISeg
 	int			nextThreshold;	/* # of messages to call SICleanupQueue */
 	int			lastBackend;	/* index of last active procState entry, +1 */
 	int			maxBackends;	/* size of procState array */
+	int			maxMessages;	/* size of buffer, a power of 2 */
 
 	slock_t		msgnumLock;		/* spinlock protecting maxMsgNum */
 
 	/*
-	 * Circular buffer holding shared-inval messages
+	 * Statistics, protected by holding both SInvalWriteLock and
+	 * SInvalReadLock in exclusive mode, as in SICleanupQueue.
 	 */
-	SharedInvalidationMessage buffer[MAXNUMMESSAGES];
+	uint64		numResets;		/* backends forced into reset state */
+	uint64		numSummaries;	/* backends given a summary instead */
+	uint64		numCatchupSignals;	/* catchup interrupts sent */
+
+	/*
+	 * Circular buffer holding shared-inval messages.  It is located just
+	 * past the procState array.
+	 */
+	SharedInvalidationMessage *buffer;
 
 	/*
 	 * Per-backend state info.
@@ -198,20 +234,64 @@ static SISeg *shmInvalBuffer;	/* pointer to the shared inval buffer */
 static LocalTransactionId nextLocalTransactionId;
 
 static void CleanupInvalidationState(int status, Datum arg);
+static bool SISummarizeMessages(SISeg *segP, ProcState *stateP, int upto);
 
 
 /*
- * SInvalShmemSize --- return shared-memory space needed
+ * Number of messages the circular buffer holds: invalidation_queue_size
+ * rounded up to a power of 2.
  */
-Size
-SInvalShmemSize(void)
+static int
+SIQueueSize(void)
+{
+	int			size = 1;
+
+	while (size < invalidation_queue_size &&
+		   size < MAX_INVALIDATION_QUEUE_SIZE)
+		size <<= 1;
+
+	return size;
+}
+
+/*
+ * Size of the SISeg struct up to the end of the procState array, which is
+ * where the message buffer starts.
+ */
+static Size
+SISegProcStateSize(void)
 {
 	Size		size;
 
 	size = offsetof(SISeg, procState);
 	size = add_size(size, mul_size(sizeof(ProcState), MaxBackends));
 
-	return size;
+	return MAXALIGN(size);
+}
+
+/*
+ * SInvalShmemSize --- return shared-memory space needed
+ */
+Size
+SInvalShmemSize(void)
+{
+	return add_size(SISegProcStateSize(),
+					mul_size(sizeof(SharedInvalidationMessage),
+							 SIQueueSize()));
+}
+
+/*
+ * Forget the contents of a backend's summary.
+ */
+static void
+SIClearSummary(ProcState *stateP)
+{
+	SharedInvalSummary *summary = &stateP->summary;
+
+	memset(summary->catcaches, 0, sizeof(summary->catcaches));
+	summary->smgrAll = false;
+	summary->relcacheAll = false;
+	summary->nmsgs = 0;
+	stateP->hasSummary = false;
 }
 
 /*
@@ -226,8 +306,7 @@ CreateSharedInvalidationState(void)
 	bool		found;
 
 	/* Allocate space in shared memory */
-	size = offsetof(SISeg, procState);
-	size = add_size(size, mul_size(sizeof(ProcState), MaxBackends));
+	size = SInvalShmemSize();
 
 	shmInvalBuffer = (SISeg *)
 		ShmemInitStruct("shmInvalBuffer", size, &found);
@@ -237,12 +316,18 @@ CreateSharedInvalidationState(void)
 	/* Clear message counters, save size of procState array, init spinlock */
 	shmInvalBuffer->minMsgNum = 0;
 	shmInvalBuffer->maxMsgNum = 0;
-	shmInvalBuffer->nextThreshold = CLEANUP_MIN;
 	shmInvalBuffer->lastBackend = 0;
 	shmInvalBuffer->maxBackends = MaxBackends;
+	shmInvalBuffer->maxMessages = SIQueueSize();
+	shmInvalBuffer->nextThreshold = CLEANUP_MIN(shmInvalBuffer);
 	SpinLockInit(&shmInvalBuffer->msgnumLock);
+	shmInvalBuffer->numResets = 0;
+	shmInvalBuffer->numSummaries = 0;
+	shmInvalBuffer->numCatchupSignals = 0;
 
 	/* The buffer[] array is initially all unused, so we need not fill it */
+	shmInvalBuffer->buffer = (SharedInvalidationMessage *)
+		((char *) shmInvalBuffer + SISegProcStateSize());
 
 	/* Mark all backends inactive, and initialize nextLXID */
 	for (i = 0; i < shmInvalBuffer->maxBackends; i++)
@@ -253,6 +338,7 @@ CreateSharedInvalidationState(void)
 		shmInvalBuffer->procState[i].resetState = false;
 		shmInvalBuffer->procState[i].signaled = false;
 		shmInvalBuffer->procState[i].hasMessages = false;
+		SIClearSummary(&shmInvalBuffer->procState[i]);
 		shmInvalBuffer->procState[i].nextLXID = InvalidLocalTransactionId;
 	}
 }
@@ -321,6 +407,7 @@ SharedInvalBackendInit(bool sendOnly)
 	stateP->resetState = false;
 	stateP->signaled = false;
 	stateP->hasMessages = false;
+	SIClearSummary(stateP);
 	stateP->sendOnly = sendOnly;
 
 	LWLockRelease(SInvalWriteLock);
@@ -361,6 +448,7 @@ CleanupInvalidationState(int status, Datum arg)
 	stateP->nextMsgNum = 0;
 	stateP->resetState = false;
 	stateP->signaled = false;
+	SIClearSummary(stateP);
 
 	/* Recompute index of last active backend */
 	for (i = segP->lastBackend; i > 0; i--)
@@ -471,7 +559,7 @@ SIInsertDataEntries(const SharedInvalidationMessage *data, int n)
 		for (;;)
 		{
 			numMsgs = segP->maxMsgNum - segP->minMsgNum;
-			if (numMsgs + nthistime > MAXNUMMESSAGES ||
+			if (numMsgs + nthistime > segP->maxMessages ||
 				numMsgs >= segP->nextThreshold)
 				SICleanupQueue(true, nthistime);
 			else
@@ -484,7 +572,7 @@ SIInsertDataEntries(const SharedInvalidationMessage *data, int n)
 		max = segP->maxMsgNum;
 		while (nthistime-- > 0)
 		{
-			segP->buffer[max % MAXNUMMESSAGES] = *data++;
+			segP->buffer[SIMsgSlot(segP, max)] = *data++;
 			max++;
 		}
 
@@ -524,9 +612,12 @@ SIInsertDataEntries(const SharedInvalidationMessage *data, int n)
  *	0:	 no SI message available
  *	n>0: next n SI messages have been extracted into data[]
  * -1:	 SI reset message extracted
+ * -2:	 summary of messages removed from the queue before we could read
+ *		 them has been extracted into *summary
  *
- * If the return value is less than the array size "datasize", the caller
- * can assume that there are no more SI messages after the one(s) returned.
+ * If the return value is less than the array size "datasize" and not -2,
+ * the caller can assume that there are no more SI messages after the one(s)
+ * returned.
  * Otherwise, another call is needed to collect more messages.
  *
  * NB: this can run in parallel with other instances of SIGetDataEntries
@@ -545,7 +636,8 @@ SIInsertDataEntries(const SharedInvalidationMessage *data, int n)
  * to break our hold on SInvalReadLock into segments.
  */
 int
-SIGetDataEntries(SharedInvalidationMessage *data, int datasize)
+SIGetDataEntries(SharedInvalidationMessage *data, int datasize,
+				 SharedInvalSummary *summary)
 {
 	SISeg	   *segP;
 	ProcState  *stateP;
@@ -602,10 +694,25 @@ SIGetDataEntries(SharedInvalidationMessage *data, int datasize)
 		stateP->nextMsgNum = max;
 		stateP->resetState = false;
 		stateP->signaled = false;
+		SIClearSummary(stateP);
 		LWLockRelease(SInvalReadLock);
 		return -1;
 	}
 
+	if (stateP->hasSummary)
+	{
+		/*
+		 * Hand over the summary of the messages we missed.  It precedes
+		 * anything still in the queue for us, so make sure we come back for
+		 * those on the next call.
+		 */
+		memcpy(summary, &stateP->summary, sizeof(SharedInvalSummary));
+		SIClearSummary(stateP);
+		stateP->hasMessages = true;
+		LWLockRelease(SInvalReadLock);
+		return -2;
+	}
+
 	/*
 	 * Retrieve messages and advance backend's counter, until data array is
 	 * full or there are no more messages.
@@ -617,7 +724,7 @@ SIGetDataEntries(SharedInvalidationMessage *data, int datasize)
 	n = 0;
 	while (n < datasize && stateP->nextMsgNum < max)
 	{
-		data[n++] = segP->buffer[stateP->nextMsgNum % MAXNUMMESSAGES];
+		data[n++] = segP->buffer[SIMsgSlot(segP, stateP->nextMsgNum)];
 		stateP->nextMsgNum++;
 	}
 
@@ -644,8 +751,9 @@ SIGetDataEntries(SharedInvalidationMessage *data, int datasize)
  * callerHasWriteLock is TRUE if caller is holding SInvalWriteLock.
  * minFree is the minimum number of message slots to make free.
  *
- * Possible side effects of this routine include marking one or more
- * backends as "reset" in the array, and sending PROCSIG_CATCHUP_INTERRUPT
+ * Possible side effects of this routine include summarizing the unread
+ * messages of one or more backends, or marking them as "reset" in the array
+ * if that isn't possible, and sending PROCSIG_CATCHUP_INTERRUPT
  * to some backend that seems to be getting too far behind.  We signal at
  * most one backend at a time, for reasons explained at the top of the file.
  *
@@ -677,8 +785,8 @@ SICleanupQueue(bool callerHasWriteLock, int minFree)
 	 * a problem even when they are the only active backend.
 	 */
 	min = segP->maxMsgNum;
-	minsig = min - SIG_THRESHOLD;
-	lowbound = min - MAXNUMMESSAGES + minFree;
+	minsig = min - SIG_THRESHOLD(segP);
+	lowbound = min - segP->maxMessages + minFree;
 
 	for (i = 0; i < segP->lastBackend; i++)
 	{
@@ -690,14 +798,27 @@ SICleanupQueue(bool callerHasWriteLock, int minFree)
 			continue;
 
 		/*
-		 * If we must free some space and this backend is preventing it, force
-		 * him into reset state and then ignore until he catches up.
+		 * If we must free some space and this backend is preventing it, fold
+		 * his oldest unread messages into his summary.  If they don't fit,
+		 * force him into reset state and then ignore until he catches up.
 		 */
 		if (n < lowbound)
 		{
-			stateP->resetState = true;
-			/* no point in signaling him ... */
-			continue;
+			int			upto = Min(lowbound + SUMMARY_QUANTUM, segP->maxMsgNum);
+
+			if (!SISummarizeMessages(segP, stateP, upto))
+			{
+				SIClearSummary(stateP);
+				stateP->resetState = true;
+				segP->numResets++;
+				/* no point in signaling him ... */
+				continue;
+			}
+			if (!stateP->hasSummary)
+				segP->numSummaries++;
+			stateP->nextMsgNum = n = upto;
+			stateP->hasSummary = true;
+			stateP->hasMessages = true;
 		}
 
 		/* Track the global minimum nextMsgNum */
@@ -734,10 +855,11 @@ SICleanupQueue(bool callerHasWriteLock, int minFree)
 	 * threshold at which we should repeat SICleanupQueue().
 	 */
 	numMsgs = segP->maxMsgNum - segP->minMsgNum;
-	if (numMsgs < CLEANUP_MIN)
-		segP->nextThreshold = CLEANUP_MIN;
+	if (numMsgs < CLEANUP_MIN(segP))
+		segP->nextThreshold = CLEANUP_MIN(segP);
 	else
-		segP->nextThreshold = (numMsgs / CLEANUP_QUANTUM + 1) * CLEANUP_QUANTUM;
+		segP->nextThreshold = (numMsgs / CLEANUP_QUANTUM(segP) + 1) *
+			CLEANUP_QUANTUM(segP);
 
 	/*
 	 * Lastly, signal anyone who needs a catchup interrupt.  Since
@@ -750,6 +872,7 @@ SICleanupQueue(bool callerHasWriteLock, int minFree)
 		BackendId	his_backendId = (needSig - &segP->procState[0]) + 1;
 
 		needSig->signaled = true;
+		segP->numCatchupSignals++;
 		LWLockRelease(SInvalReadLock);
 		LWLockRelease(SInvalWriteLock);
 		elog(DEBUG4, "sending sinval catchup signal to PID %d", (int) his_pid);
@@ -765,6 +888,145 @@ SICleanupQueue(bool callerHasWriteLock, int minFree)
 	}
 }
 
+/*
+ * Are two messages of the kinds kept in a summary's msgs[] list the same?
+ */
+static bool
+SIMessagesEqual(const SharedInvalidationMessage *a,
+				const SharedInvalidationMessage *b)
+{
+	if (a->id != b->id)
+		return false;
+
+	switch (a->id)
+	{
+		case SHAREDINVALCATALOG_ID:
+			return a->cat.dbId == b->cat.dbId && a->cat.catId == b->cat.catId;
+		case SHAREDINVALRELCACHE_ID:
+			return a->rc.dbId == b->rc.dbId && a->rc.relId == b->rc.relId;
+		case SHAREDINVALRELMAP_ID:
+			return a->rm.dbId == b->rm.dbId;
+		case SHAREDINVALSNAPSHOT_ID:
+			return a->sn.dbId == b->sn.dbId && a->sn.relId == b->sn.relId;
+	}
+
+	return false;
+}
+
+/*
+ * SISummarizeMessages
+ *		Fold the messages a backend has not read yet, up to but not including
+ *		message number upto, into its summary
+ *
+ * Messages for other databases are dropped if we know which database the
+ * backend is connected to.  Returns false if the messages can't be
+ * summarized, in which case the backend must be reset.
+ *
+ * Caller must hold both SInvalWriteLock and SInvalReadLock in exclusive mode.
+ */
+static bool
+SISummarizeMessages(SISeg *segP, ProcState *stateP, int upto)
+{
+	SharedInvalSummary *summary = &stateP->summary;
+	Oid			myDbId = stateP->proc->databaseId;
+	int			msgnum;
+
+	for (msgnum = stateP->nextMsgNum; msgnum < upto; msgnum++)
+	{
+		SharedInvalidationMessage *msg;
+		Oid			dbId;
+		int			i;
+
+		msg = &segP->buffer[SIMsgSlot(segP, msgnum)];
+
+		if (msg->id >= 0)
+			dbId = msg->cc.dbId;
+		else if (msg->id == SHAREDINVALCATALOG_ID)
+			dbId = msg->cat.dbId;
+		else if (msg->id == SHAREDINVALRELCACHE_ID)
+			dbId = msg->rc.dbId;
+		else if (msg->id == SHAREDINVALSMGR_ID)
+		{
+			/* smgr entries of any database might be open, so just close all */
+			summary->smgrAll = true;
+			continue;
+		}
+		else if (msg->id == SHAREDINVALRELMAP_ID)
+			dbId = msg->rm.dbId;
+		else if (msg->id == SHAREDINVALSNAPSHOT_ID)
+			dbId = msg->sn.dbId;
+		else
+			return false;
+
+		if (OidIsValid(myDbId) && OidIsValid(dbId) && dbId != myDbId)
+			continue;
+
+		if (msg->id >= 0)
+		{
+			if (msg->id >= SINVAL_SUMMARY_CACHE_WORDS * 32)
+				return false;
+			summary->catcaches[msg->id / 32] |= ((uint32) 1) << (msg->id % 32);
+			continue;
+		}
+
+		if (msg->id == SHAREDINVALRELCACHE_ID && summary->relcacheAll)
+			continue;
+
+		for (i = 0; i < summary->nmsgs; i++)
+		{
+			if (SIMessagesEqual(&summary->msgs[i], msg))
+				break;
+		}
+		if (i < summary->nmsgs)
+			continue;
+
+		if (summary->nmsgs >= SINVAL_SUMMARY_MAX_MSGS)
+		{
+			int			nkept = 0;
+
+			/*
+			 * Out of room.  Make some by replacing the relcache messages with
+			 * a flag to invalidate the whole relcache.
+			 */
+			for (i = 0; i < summary->nmsgs; i++)
+			{
+				if (summary->msgs[i].id != SHAREDINVALRELCACHE_ID)
+					summary->msgs[nkept++] = summary->msgs[i];
+			}
+			if (nkept == summary->nmsgs)
+				return false;
+			summary->nmsgs = nkept;
+			summary->relcacheAll = true;
+
+			if (msg->id == SHAREDINVALRELCACHE_ID)
+				continue;
+		}
+
+		summary->msgs[summary->nmsgs++] = *msg;
+	}
+
+	return true;
+}
+
+/*
+ * GetSharedInvalidationStats
+ *		Report the size of the message queue and how often backends fell
+ *		too far behind in reading it.
+ */
+void
+GetSharedInvalidationStats(int *queueSize, uint64 *numResets,
+						   uint64 *numSummaries, uint64 *numCatchupSignals)
+{
+	SISeg	   *segP = shmInvalBuffer;
+
+	LWLockAcquire(SInvalReadLock, LW_SHARED);
+	*queueSize = segP->maxMessages;
+	*numResets = segP->numResets;
+	*numSummaries = segP->numSummaries;
+	*numCatchupSignals = segP->numCatchupSignals;
+	LWLockRelease(SInvalReadLock);
+}
+
 
 /*
  * GetNextLocalTransactionId --- allocate a new LocalTransactionId
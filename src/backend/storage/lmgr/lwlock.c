@@ -83,6 +83,7 @@
 #include "pg_trace.h"
 #include "postmaster/postmaster.h"
 #include "replication/slot.h"
+#include "storage/aio.h"
 #include "storage/ipc.h"
 #include "storage/predicate.h"
 #include "storage/proc.h"
@@ -361,6 +362,9 @@ NumLWLocks(void)
 	/* slot.c needs one for each slot */
 	numLocks += max_replication_slots;
 
+	/* aio.c needs one for each I/O worker */
+	numLocks += io_workers;
+
 	/*
 	 * Add any requested by loadable modules; for backwards-compatibility
 	 * reasons, allocate at least NUM_USER_DEFINED_LWLOCKS of them even if
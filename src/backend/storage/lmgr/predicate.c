@@ -94,7 +94,11 @@
  *			that the locks themselves are also covered by the partition
  *			locks of their respective lock targets; this lock only affects
  *			the linked list connecting the locks related to a transaction.
- *		- All transactions share this single lock (with no partitioning).
+ *		- This lock is partitioned: a process wanting a shared lock takes
+ *			only the one partition chosen by its PGPROC number, while an
+ *			exclusive lock consists of all of the partitions.  Since nearly
+ *			all acquisitions are shared, this keeps backends from contending
+ *			on a single LWLock.
  *		- There is never a need for a process other than the one running
  *			an active transaction to walk the list of locks held by that
  *			transaction.
@@ -191,8 +195,10 @@
 #include "access/twophase_rmgr.h"
 #include "access/xact.h"
 #include "access/xlog.h"
+#include "catalog/pg_am.h"
 #include "miscadmin.h"
 #include "storage/bufmgr.h"
+#include "storage/ipc.h"
 #include "storage/predicate.h"
 #include "storage/predicate_internals.h"
 #include "storage/proc.h"
@@ -247,6 +253,17 @@
 #define PredicateLockHashPartitionLockByIndex(i) \
 	(&MainLWLockArray[PREDICATELOCK_MANAGER_LWLOCK_OFFSET + (i)].lock)
 
+/*
+ * The partitions of SerializablePredicateLockListLock; see the comments at
+ * the top of the file.  Use SerializablePredicateLockListLockAcquire and
+ * SerializablePredicateLockListLockRelease to take and release it.
+ */
+#define PredicateLockListLockByIndex(i) \
+	(&MainLWLockArray[PREDICATELOCK_LIST_LWLOCK_OFFSET + (i)].lock)
+#define MyPredicateLockListLock \
+	PredicateLockListLockByIndex(MyProc->pgprocno % \
+								 NUM_PREDICATELOCK_LIST_PARTITIONS)
+
 #define NPREDICATELOCKTARGETENTS() \
 	mul_size(max_predicate_locks_per_xact, add_size(MaxBackends, max_prepared_xacts))
 
@@ -354,6 +371,10 @@ static SERIALIZABLEXACT *OldCommittedSxact;
 /* This configuration variable is used to set the predicate lock table size */
 int			max_predicate_locks_per_xact;		/* set by guc.c */
 
+/* These configuration variables control promotion to coarser locks */
+int			max_predicate_locks_per_relation;	/* set by guc.c */
+int			max_predicate_locks_per_page;		/* set by guc.c */
+
 /*
  * This provides a list of objects in order to track transactions
  * participating in predicate locking.  Entries in the list are fixed size,
@@ -403,6 +424,13 @@ static HTAB *LocalPredicateLockHash = NULL;
 static SERIALIZABLEXACT *MySerializableXact = InvalidSerializableXact;
 static bool MyXactDidWrite = false;
 
+/*
+ * Are we the process clearing old predicate locks (PredXact->clearActive)?
+ * If we exit while we are, ClearOldPredicateLocksAtExit gives up the job.
+ */
+static bool MyClearActive = false;
+static bool ClearAtExitRegistered = false;
+
 /* local functions */
 
 static SERIALIZABLEXACT *CreatePredXact(void);
@@ -436,8 +464,12 @@ static void RestoreScratchTarget(bool lockheld);
 static void RemoveTargetIfNoLongerUsed(PREDICATELOCKTARGET *target,
 						   uint32 targettaghash);
 static void DeleteChildTargetLocks(const PREDICATELOCKTARGETTAG *newtargettag);
-static int	PredicateLockPromotionThreshold(const PREDICATELOCKTARGETTAG *tag);
-static bool CheckAndPromotePredicateLockRequest(const PREDICATELOCKTARGETTAG *reqtag);
+static void SerializablePredicateLockListLockAcquire(LWLockMode mode);
+static void SerializablePredicateLockListLockRelease(LWLockMode mode);
+static int	MaxPredicateChildLocks(const PREDICATELOCKTARGETTAG *tag,
+					   Relation relation);
+static bool CheckAndPromotePredicateLockRequest(const PREDICATELOCKTARGETTAG *reqtag,
+									Relation relation);
 static void DecrementParentLocks(const PREDICATELOCKTARGETTAG *targettag);
 static void CreatePredicateLock(const PREDICATELOCKTARGETTAG *targettag,
 					uint32 targettaghash,
@@ -446,11 +478,16 @@ static void DeleteLockTarget(PREDICATELOCKTARGET *target, uint32 targettaghash);
 static bool TransferPredicateLocksToNewTarget(PREDICATELOCKTARGETTAG oldtargettag,
 								  PREDICATELOCKTARGETTAG newtargettag,
 								  bool removeOld);
-static void PredicateLockAcquire(const PREDICATELOCKTARGETTAG *targettag);
+static void PredicateLockAcquire(const PREDICATELOCKTARGETTAG *targettag,
+					 Relation relation);
 static void DropAllPredicateLocksFromTable(Relation relation,
 							   bool transfer);
 static void SetNewSxactGlobalXmin(void);
 static void ClearOldPredicateLocks(void);
+static void ClearOldPredicateLocksPass(void);
+static void ClearOldPredicateLocksDone(void);
+static void ClearOldPredicateLocksAtExit(int code, Datum arg);
+static void CountSerializableEvent(SerializableEvent event);
 static void ReleaseOneSerializableXact(SERIALIZABLEXACT *sxact, bool partial,
 						   bool summarize);
 static bool XidIsConcurrent(TransactionId xid);
@@ -1180,6 +1217,11 @@ InitPredicateLocks(void)
 		PredXact->LastSxactCommitSeqNo = FirstNormalSerCommitSeqNo - 1;
 		PredXact->CanPartialClearThrough = 0;
 		PredXact->HavePartialClearedThrough = 0;
+		SpinLockInit(&PredXact->clearMutex);
+		PredXact->clearActive = false;
+		PredXact->clearRequested = false;
+		SpinLockInit(&PredXact->statsMutex);
+		memset(PredXact->eventCounts, 0, sizeof(PredXact->eventCounts));
 		requestSize = mul_size((Size) max_table_size,
 							   PredXactListElementDataSize);
 		PredXact->element = ShmemAlloc(requestSize);
@@ -1988,7 +2030,7 @@ RemoveScratchTarget(bool lockheld)
 {
 	bool		found;
 
-	Assert(LWLockHeldByMe(SerializablePredicateLockListLock));
+	Assert(LWLockHeldByMe(MyPredicateLockListLock));
 
 	if (!lockheld)
 		LWLockAcquire(ScratchPartitionLock, LW_EXCLUSIVE);
@@ -2009,7 +2051,7 @@ RestoreScratchTarget(bool lockheld)
 {
 	bool		found;
 
-	Assert(LWLockHeldByMe(SerializablePredicateLockListLock));
+	Assert(LWLockHeldByMe(MyPredicateLockListLock));
 
 	if (!lockheld)
 		LWLockAcquire(ScratchPartitionLock, LW_EXCLUSIVE);
@@ -2031,7 +2073,7 @@ RemoveTargetIfNoLongerUsed(PREDICATELOCKTARGET *target, uint32 targettaghash)
 {
 	PREDICATELOCKTARGET *rmtarget PG_USED_FOR_ASSERTS_ONLY;
 
-	Assert(LWLockHeldByMe(SerializablePredicateLockListLock));
+	Assert(LWLockHeldByMe(MyPredicateLockListLock));
 
 	/* Can't remove it until no locks at this target. */
 	if (!SHMQueueEmpty(&target->predicateLocks))
@@ -2061,7 +2103,7 @@ DeleteChildTargetLocks(const PREDICATELOCKTARGETTAG *newtargettag)
 	SERIALIZABLEXACT *sxact;
 	PREDICATELOCK *predlock;
 
-	LWLockAcquire(SerializablePredicateLockListLock, LW_SHARED);
+	SerializablePredicateLockListLockAcquire(LW_SHARED);
 	sxact = MySerializableXact;
 	predlock = (PREDICATELOCK *)
 		SHMQueueNext(&(sxact->predicateLocks),
@@ -2116,32 +2158,82 @@ DeleteChildTargetLocks(const PREDICATELOCKTARGETTAG *newtargettag)
 
 		predlock = nextpredlock;
 	}
-	LWLockRelease(SerializablePredicateLockListLock);
+	SerializablePredicateLockListLockRelease(LW_SHARED);
+}
+
+/*
+ * Acquire SerializablePredicateLockListLock in the given mode.
+ */
+static void
+SerializablePredicateLockListLockAcquire(LWLockMode mode)
+{
+	int			i;
+
+	if (mode == LW_SHARED)
+	{
+		LWLockAcquire(MyPredicateLockListLock, LW_SHARED);
+		return;
+	}
+
+	for (i = 0; i < NUM_PREDICATELOCK_LIST_PARTITIONS; i++)
+		LWLockAcquire(PredicateLockListLockByIndex(i), LW_EXCLUSIVE);
 }
 
 /*
- * Returns the promotion threshold for a given predicate lock
- * target. This is the number of descendant locks required to promote
- * to the specified tag. Note that the threshold includes non-direct
- * descendants, e.g. both tuples and pages for a relation lock.
+ * Release SerializablePredicateLockListLock, which was acquired in the given
+ * mode.
+ */
+static void
+SerializablePredicateLockListLockRelease(LWLockMode mode)
+{
+	int			i;
+
+	if (mode == LW_SHARED)
+	{
+		LWLockRelease(MyPredicateLockListLock);
+		return;
+	}
+
+	for (i = NUM_PREDICATELOCK_LIST_PARTITIONS; --i >= 0;)
+		LWLockRelease(PredicateLockListLockByIndex(i));
+}
+
+/*
+ * Returns the maximum number of descendant locks the given predicate lock
+ * target may have before we promote to it.  Note that this includes
+ * non-direct descendants, e.g. both tuples and pages for a relation lock.
  *
- * TODO SSI: We should do something more intelligent about what the
- * thresholds are, either making it proportional to the number of
- * tuples in a page & pages in a relation, or at least making it a
- * GUC. Currently the threshold is 3 for a page lock, and
- * max_pred_locks_per_transaction/2 for a relation lock, chosen
- * entirely arbitrarily (and without benchmarking).
+ * For a relation, the relation's max_pred_locks_per_relation storage
+ * parameter, if set, takes precedence over the configuration variable of the
+ * same name.  A negative setting of the latter means
+ * max_pred_locks_per_transaction divided by its absolute value, minus one, so
+ * that the limit follows the size of the lock table.
  */
 static int
-PredicateLockPromotionThreshold(const PREDICATELOCKTARGETTAG *tag)
+MaxPredicateChildLocks(const PREDICATELOCKTARGETTAG *tag, Relation relation)
 {
+	int			maxlocks;
+
 	switch (GET_PREDICATELOCKTARGETTAG_TYPE(*tag))
 	{
 		case PREDLOCKTAG_RELATION:
-			return max_predicate_locks_per_xact / 2;
+			/* Only heap and btree relations carry StdRdOptions here */
+			if (relation != NULL &&
+				(relation->rd_rel->relkind == RELKIND_RELATION ||
+				 relation->rd_rel->relkind == RELKIND_MATVIEW ||
+				 relation->rd_rel->relam == BTREE_AM_OID))
+			{
+				maxlocks = RelationGetMaxPredicateLocks(relation, -1);
+				if (maxlocks >= 0)
+					return maxlocks;
+			}
+			if (max_predicate_locks_per_relation >= 0)
+				return max_predicate_locks_per_relation;
+			return (max_predicate_locks_per_xact /
+					(-max_predicate_locks_per_relation)) - 1;
 
 		case PREDLOCKTAG_PAGE:
-			return 3;
+			return max_predicate_locks_per_page;
 
 		case PREDLOCKTAG_TUPLE:
 
@@ -2167,7 +2259,8 @@ PredicateLockPromotionThreshold(const PREDICATELOCKTARGETTAG *tag)
  * Returns true if a parent lock was acquired and false otherwise.
  */
 static bool
-CheckAndPromotePredicateLockRequest(const PREDICATELOCKTARGETTAG *reqtag)
+CheckAndPromotePredicateLockRequest(const PREDICATELOCKTARGETTAG *reqtag,
+									Relation relation)
 {
 	PREDICATELOCKTARGETTAG targettag,
 				nexttag,
@@ -2196,8 +2289,8 @@ CheckAndPromotePredicateLockRequest(const PREDICATELOCKTARGETTAG *reqtag)
 		else
 			parentlock->childLocks++;
 
-		if (parentlock->childLocks >=
-			PredicateLockPromotionThreshold(&targettag))
+		if (parentlock->childLocks >
+			MaxPredicateChildLocks(&targettag, relation))
 		{
 			/*
 			 * We should promote to this parent lock. Continue to check its
@@ -2213,7 +2306,10 @@ CheckAndPromotePredicateLockRequest(const PREDICATELOCKTARGETTAG *reqtag)
 	if (promote)
 	{
 		/* acquire coarsest ancestor eligible for promotion */
-		PredicateLockAcquire(&promotiontag);
+		CountSerializableEvent(GET_PREDICATELOCKTARGETTAG_TYPE(promotiontag) ==
+							   PREDLOCKTAG_RELATION ?
+							   SSI_PROMOTION_RELATION : SSI_PROMOTION_PAGE);
+		PredicateLockAcquire(&promotiontag, relation);
 		return true;
 	}
 	else
@@ -2306,7 +2402,7 @@ CreatePredicateLock(const PREDICATELOCKTARGETTAG *targettag,
 
 	partitionLock = PredicateLockHashPartitionLock(targettaghash);
 
-	LWLockAcquire(SerializablePredicateLockListLock, LW_SHARED);
+	SerializablePredicateLockListLockAcquire(LW_SHARED);
 	LWLockAcquire(partitionLock, LW_EXCLUSIVE);
 
 	/* Make sure that the target is represented. */
@@ -2344,7 +2440,7 @@ CreatePredicateLock(const PREDICATELOCKTARGETTAG *targettag,
 	}
 
 	LWLockRelease(partitionLock);
-	LWLockRelease(SerializablePredicateLockListLock);
+	SerializablePredicateLockListLockRelease(LW_SHARED);
 }
 
 /*
@@ -2355,7 +2451,8 @@ CreatePredicateLock(const PREDICATELOCKTARGETTAG *targettag,
  * any finer-grained locks covered by the new one.
  */
 static void
-PredicateLockAcquire(const PREDICATELOCKTARGETTAG *targettag)
+PredicateLockAcquire(const PREDICATELOCKTARGETTAG *targettag,
+					 Relation relation)
 {
 	uint32		targettaghash;
 	bool		found;
@@ -2388,7 +2485,7 @@ PredicateLockAcquire(const PREDICATELOCKTARGETTAG *targettag)
 	 * coarser granularity, or whether there are finer-granularity locks to
 	 * clean up.
 	 */
-	if (CheckAndPromotePredicateLockRequest(targettag))
+	if (CheckAndPromotePredicateLockRequest(targettag, relation))
 	{
 		/*
 		 * Lock request was promoted to a coarser-granularity lock, and that
@@ -2424,7 +2521,7 @@ PredicateLockRelation(Relation relation, Snapshot snapshot)
 	SET_PREDICATELOCKTARGETTAG_RELATION(tag,
 										relation->rd_node.dbNode,
 										relation->rd_id);
-	PredicateLockAcquire(&tag);
+	PredicateLockAcquire(&tag, relation);
 }
 
 /*
@@ -2448,7 +2545,7 @@ PredicateLockPage(Relation relation, BlockNumber blkno, Snapshot snapshot)
 									relation->rd_node.dbNode,
 									relation->rd_id,
 									blkno);
-	PredicateLockAcquire(&tag);
+	PredicateLockAcquire(&tag, relation);
 }
 
 /*
@@ -2511,7 +2608,7 @@ PredicateLockTuple(Relation relation, HeapTuple tuple, Snapshot snapshot)
 									 relation->rd_id,
 									 ItemPointerGetBlockNumber(tid),
 									 ItemPointerGetOffsetNumber(tid));
-	PredicateLockAcquire(&tag);
+	PredicateLockAcquire(&tag, relation);
 }
 
 
@@ -2531,7 +2628,7 @@ DeleteLockTarget(PREDICATELOCKTARGET *target, uint32 targettaghash)
 	PREDICATELOCK *nextpredlock;
 	bool		found;
 
-	Assert(LWLockHeldByMe(SerializablePredicateLockListLock));
+	Assert(LWLockHeldByMe(MyPredicateLockListLock));
 	Assert(LWLockHeldByMe(PredicateLockHashPartitionLock(targettaghash)));
 
 	predlock = (PREDICATELOCK *)
@@ -2606,7 +2703,7 @@ TransferPredicateLocksToNewTarget(PREDICATELOCKTARGETTAG oldtargettag,
 	bool		found;
 	bool		outOfShmem = false;
 
-	Assert(LWLockHeldByMe(SerializablePredicateLockListLock));
+	Assert(LWLockHeldByMe(MyPredicateLockListLock));
 
 	oldtargettaghash = PredicateLockTargetTagHashCode(&oldtargettag);
 	newtargettaghash = PredicateLockTargetTagHashCode(&newtargettag);
@@ -2856,7 +2953,7 @@ DropAllPredicateLocksFromTable(Relation relation, bool transfer)
 	heaptarget = NULL;
 
 	/* Acquire locks on all lock partitions */
-	LWLockAcquire(SerializablePredicateLockListLock, LW_EXCLUSIVE);
+	SerializablePredicateLockListLockAcquire(LW_EXCLUSIVE);
 	for (i = 0; i < NUM_PREDICATELOCK_PARTITIONS; i++)
 		LWLockAcquire(PredicateLockHashPartitionLockByIndex(i), LW_EXCLUSIVE);
 	LWLockAcquire(SerializableXactHashLock, LW_EXCLUSIVE);
@@ -2997,7 +3094,7 @@ DropAllPredicateLocksFromTable(Relation relation, bool transfer)
 	LWLockRelease(SerializableXactHashLock);
 	for (i = NUM_PREDICATELOCK_PARTITIONS - 1; i >= 0; i--)
 		LWLockRelease(PredicateLockHashPartitionLockByIndex(i));
-	LWLockRelease(SerializablePredicateLockListLock);
+	SerializablePredicateLockListLockRelease(LW_EXCLUSIVE);
 }
 
 /*
@@ -3063,7 +3160,7 @@ PredicateLockPageSplit(Relation relation, BlockNumber oldblkno,
 									relation->rd_id,
 									newblkno);
 
-	LWLockAcquire(SerializablePredicateLockListLock, LW_EXCLUSIVE);
+	SerializablePredicateLockListLockAcquire(LW_EXCLUSIVE);
 
 	/*
 	 * Try copying the locks over to the new page's tag, creating it if
@@ -3099,7 +3196,7 @@ PredicateLockPageSplit(Relation relation, BlockNumber oldblkno,
 		Assert(success);
 	}
 
-	LWLockRelease(SerializablePredicateLockListLock);
+	SerializablePredicateLockListLockRelease(LW_EXCLUSIVE);
 }
 
 /*
@@ -3501,9 +3598,94 @@ ReleasePredicateLocks(bool isCommit)
 /*
  * Clear old predicate locks, belonging to committed transactions that are no
  * longer interesting to any in-progress transaction.
+ *
+ * Only one process at a time does this.  Transactions finishing at the same
+ * time would otherwise queue up on SerializableFinishedListLock just to find
+ * that there's nothing left for them to clear.  A process that finds someone
+ * else at work asks it to make one more pass when it's done, since the
+ * global xmin may have advanced after it started, and returns immediately.
  */
 static void
 ClearOldPredicateLocks(void)
+{
+	/*
+	 * An ERROR during a pass is handled below, but FATAL and proc_exit don't
+	 * unwind through here, so make sure we give up the job at exit too.
+	 */
+	if (!ClearAtExitRegistered)
+	{
+		before_shmem_exit(ClearOldPredicateLocksAtExit, 0);
+		ClearAtExitRegistered = true;
+	}
+
+	SpinLockAcquire(&PredXact->clearMutex);
+	if (PredXact->clearActive)
+	{
+		PredXact->clearRequested = true;
+		SpinLockRelease(&PredXact->clearMutex);
+		return;
+	}
+	PredXact->clearActive = true;
+	MyClearActive = true;
+	SpinLockRelease(&PredXact->clearMutex);
+
+	for (;;)
+	{
+		PG_TRY();
+		{
+			ClearOldPredicateLocksPass();
+		}
+		PG_CATCH();
+		{
+			ClearOldPredicateLocksDone();
+			PG_RE_THROW();
+		}
+		PG_END_TRY();
+
+		SpinLockAcquire(&PredXact->clearMutex);
+		if (!PredXact->clearRequested)
+		{
+			PredXact->clearActive = false;
+			MyClearActive = false;
+			SpinLockRelease(&PredXact->clearMutex);
+			break;
+		}
+		PredXact->clearRequested = false;
+		SpinLockRelease(&PredXact->clearMutex);
+	}
+}
+
+/*
+ * Give up the job of clearing old predicate locks, if we have it, without
+ * finishing it.  The next process to finish a transaction takes over.
+ */
+static void
+ClearOldPredicateLocksDone(void)
+{
+	if (!MyClearActive)
+		return;
+
+	SpinLockAcquire(&PredXact->clearMutex);
+	PredXact->clearActive = false;
+	PredXact->clearRequested = false;
+	MyClearActive = false;
+	SpinLockRelease(&PredXact->clearMutex);
+}
+
+/*
+ * before_shmem_exit callback for ClearOldPredicateLocks
+ */
+static void
+ClearOldPredicateLocksAtExit(int code, Datum arg)
+{
+	ClearOldPredicateLocksDone();
+}
+
+/*
+ * Make one pass over the finished transactions for ClearOldPredicateLocks.
+ */
+static void
+ClearOldPredicateLocksPass(void)
 {
 	SERIALIZABLEXACT *finishedSxact;
 	PREDICATELOCK *predlock;
@@ -3580,7 +3762,7 @@ ClearOldPredicateLocks(void)
 	/*
 	 * Loop through predicate locks on dummy transaction for summarized data.
 	 */
-	LWLockAcquire(SerializablePredicateLockListLock, LW_SHARED);
+	SerializablePredicateLockListLockAcquire(LW_SHARED);
 	predlock = (PREDICATELOCK *)
 		SHMQueueNext(&OldCommittedSxact->predicateLocks,
 					 &OldCommittedSxact->predicateLocks,
@@ -3636,7 +3818,7 @@ ClearOldPredicateLocks(void)
 		predlock = nextpredlock;
 	}
 
-	LWLockRelease(SerializablePredicateLockListLock);
+	SerializablePredicateLockListLockRelease(LW_SHARED);
 	LWLockRelease(SerializableFinishedListLock);
 }
 
@@ -3677,7 +3859,7 @@ ReleaseOneSerializableXact(SERIALIZABLEXACT *sxact, bool partial,
 	 * First release all the predicate locks held by this xact (or transfer
 	 * them to OldCommittedSxact if summarize is true)
 	 */
-	LWLockAcquire(SerializablePredicateLockListLock, LW_SHARED);
+	SerializablePredicateLockListLockAcquire(LW_SHARED);
 	predlock = (PREDICATELOCK *)
 		SHMQueueNext(&(sxact->predicateLocks),
 					 &(sxact->predicateLocks),
@@ -3757,7 +3939,7 @@ ReleaseOneSerializableXact(SERIALIZABLEXACT *sxact, bool partial,
 	 */
 	SHMQueueInit(&sxact->predicateLocks);
 
-	LWLockRelease(SerializablePredicateLockListLock);
+	SerializablePredicateLockListLockRelease(LW_SHARED);
 
 	sxidtag.xid = sxact->topXid;
 	LWLockAcquire(SerializableXactHashLock, LW_EXCLUSIVE);
@@ -3878,6 +4060,7 @@ CheckForSerializableConflictOut(bool visible, Relation relation,
 	/* Check if someone else has already decided that we need to die */
 	if (SxactIsDoomed(MySerializableXact))
 	{
+		CountSerializableEvent(SSI_FAILURE_PIVOT_CONFLICT_OUT);
 		ereport(ERROR,
 				(errcode(ERRCODE_T_R_SERIALIZATION_FAILURE),
 				 errmsg("could not serialize access due to read/write dependencies among transactions"),
@@ -3967,19 +4150,25 @@ CheckForSerializableConflictOut(bool visible, Relation relation,
 				&& (!SxactIsReadOnly(MySerializableXact)
 					|| conflictCommitSeqNo
 					<= MySerializableXact->SeqNo.lastCommitBeforeSnapshot))
+			{
+				CountSerializableEvent(SSI_FAILURE_OLD_PIVOT);
 				ereport(ERROR,
 						(errcode(ERRCODE_T_R_SERIALIZATION_FAILURE),
 						 errmsg("could not serialize access due to read/write dependencies among transactions"),
 						 errdetail_internal("Reason code: Canceled on conflict out to old pivot %u.", xid),
 					  errhint("The transaction might succeed if retried.")));
+			}
 
 			if (SxactHasSummaryConflictIn(MySerializableXact)
 				|| !SHMQueueEmpty(&MySerializableXact->inConflicts))
+			{
+				CountSerializableEvent(SSI_FAILURE_PIVOT_OLD_COMMITTED);
 				ereport(ERROR,
 						(errcode(ERRCODE_T_R_SERIALIZATION_FAILURE),
 						 errmsg("could not serialize access due to read/write dependencies among transactions"),
 						 errdetail_internal("Reason code: Canceled on identification as a pivot, with conflict out to old committed transaction %u.", xid),
 					  errhint("The transaction might succeed if retried.")));
+			}
 
 			MySerializableXact->flags |= SXACT_FLAG_SUMMARY_CONFLICT_OUT;
 		}
@@ -4014,6 +4203,7 @@ CheckForSerializableConflictOut(bool visible, Relation relation,
 		else
 		{
 			LWLockRelease(SerializableXactHashLock);
+			CountSerializableEvent(SSI_FAILURE_OLD_PIVOT);
 			ereport(ERROR,
 					(errcode(ERRCODE_T_R_SERIALIZATION_FAILURE),
 					 errmsg("could not serialize access due to read/write dependencies among transactions"),
@@ -4178,7 +4368,7 @@ CheckTargetForConflictsIn(PREDICATELOCKTARGETTAG *targettag)
 		uint32		predlockhashcode;
 		PREDICATELOCK *rmpredlock;
 
-		LWLockAcquire(SerializablePredicateLockListLock, LW_SHARED);
+		SerializablePredicateLockListLockAcquire(LW_SHARED);
 		LWLockAcquire(partitionLock, LW_EXCLUSIVE);
 		LWLockAcquire(SerializableXactHashLock, LW_EXCLUSIVE);
 
@@ -4213,7 +4403,7 @@ CheckTargetForConflictsIn(PREDICATELOCKTARGETTAG *targettag)
 
 		LWLockRelease(SerializableXactHashLock);
 		LWLockRelease(partitionLock);
-		LWLockRelease(SerializablePredicateLockListLock);
+		SerializablePredicateLockListLockRelease(LW_SHARED);
 
 		if (rmpredlock != NULL)
 		{
@@ -4253,11 +4443,14 @@ CheckForSerializableConflictIn(Relation relation, HeapTuple tuple,
 
 	/* Check if someone else has already decided that we need to die */
 	if (SxactIsDoomed(MySerializableXact))
+	{
+		CountSerializableEvent(SSI_FAILURE_PIVOT_CONFLICT_IN);
 		ereport(ERROR,
 				(errcode(ERRCODE_T_R_SERIALIZATION_FAILURE),
 				 errmsg("could not serialize access due to read/write dependencies among transactions"),
 				 errdetail_internal("Reason code: Canceled on identification as a pivot, during conflict in checking."),
 				 errhint("The transaction might succeed if retried.")));
+	}
 
 	/*
 	 * We're doing a write which might cause rw-conflicts now or later.
@@ -4358,7 +4551,7 @@ CheckTableForSerializableConflictIn(Relation relation)
 	dbId = relation->rd_node.dbNode;
 	heapId = relation->rd_id;
 
-	LWLockAcquire(SerializablePredicateLockListLock, LW_EXCLUSIVE);
+	SerializablePredicateLockListLockAcquire(LW_EXCLUSIVE);
 	for (i = 0; i < NUM_PREDICATELOCK_PARTITIONS; i++)
 		LWLockAcquire(PredicateLockHashPartitionLockByIndex(i), LW_SHARED);
 	LWLockAcquire(SerializableXactHashLock, LW_SHARED);
@@ -4408,7 +4601,7 @@ CheckTableForSerializableConflictIn(Relation relation)
 	LWLockRelease(SerializableXactHashLock);
 	for (i = NUM_PREDICATELOCK_PARTITIONS - 1; i >= 0; i--)
 		LWLockRelease(PredicateLockHashPartitionLockByIndex(i));
-	LWLockRelease(SerializablePredicateLockListLock);
+	SerializablePredicateLockListLockRelease(LW_EXCLUSIVE);
 }
 
 
@@ -4590,6 +4783,7 @@ OnConflict_CheckForSerializationFailure(const SERIALIZABLEXACT *reader,
 		if (MySerializableXact == writer)
 		{
 			LWLockRelease(SerializableXactHashLock);
+			CountSerializableEvent(SSI_FAILURE_PIVOT_WRITE);
 			ereport(ERROR,
 					(errcode(ERRCODE_T_R_SERIALIZATION_FAILURE),
 					 errmsg("could not serialize access due to read/write dependencies among transactions"),
@@ -4602,6 +4796,7 @@ OnConflict_CheckForSerializationFailure(const SERIALIZABLEXACT *reader,
 
 			/* if we're not the writer, we have to be the reader */
 			Assert(MySerializableXact == reader);
+			CountSerializableEvent(SSI_FAILURE_PIVOT_READ);
 			ereport(ERROR,
 					(errcode(ERRCODE_T_R_SERIALIZATION_FAILURE),
 					 errmsg("could not serialize access due to read/write dependencies among transactions"),
@@ -4644,6 +4839,7 @@ PreCommit_CheckForSerializationFailure(void)
 	if (SxactIsDoomed(MySerializableXact))
 	{
 		LWLockRelease(SerializableXactHashLock);
+		CountSerializableEvent(SSI_FAILURE_PIVOT_COMMIT);
 		ereport(ERROR,
 				(errcode(ERRCODE_T_R_SERIALIZATION_FAILURE),
 				 errmsg("could not serialize access due to read/write dependencies among transactions"),
@@ -4682,6 +4878,7 @@ PreCommit_CheckForSerializationFailure(void)
 					if (SxactIsPrepared(nearConflict->sxactOut))
 					{
 						LWLockRelease(SerializableXactHashLock);
+						CountSerializableEvent(SSI_FAILURE_PREPARED_PIVOT);
 						ereport(ERROR,
 								(errcode(ERRCODE_T_R_SERIALIZATION_FAILURE),
 								 errmsg("could not serialize access due to read/write dependencies among transactions"),
@@ -4759,7 +4956,7 @@ AtPrepare_PredicateLocks(void)
 	 * than using the local predicate lock table because the latter is not
 	 * guaranteed to be accurate.
 	 */
-	LWLockAcquire(SerializablePredicateLockListLock, LW_SHARED);
+	SerializablePredicateLockListLockAcquire(LW_SHARED);
 
 	predlock = (PREDICATELOCK *)
 		SHMQueueNext(&(sxact->predicateLocks),
@@ -4780,7 +4977,7 @@ AtPrepare_PredicateLocks(void)
 						 offsetof(PREDICATELOCK, xactLink));
 	}
 
-	LWLockRelease(SerializablePredicateLockListLock);
+	SerializablePredicateLockListLockRelease(LW_SHARED);
 }
 
 /*
@@ -4969,3 +5166,33 @@ predicatelock_twophase_recover(TransactionId xid, uint16 info,
 		CreatePredicateLock(&lockRecord->target, targettaghash, sxact);
 	}
 }
+
+/*
+ * Count an event for the serializable transaction statistics.
+ */
+static void
+CountSerializableEvent(SerializableEvent event)
+{
+	Assert(event >= 0 && event < NUM_SERIALIZABLE_EVENTS);
+
+	SpinLockAcquire(&PredXact->statsMutex);
+	PredXact->eventCounts[event]++;
+	SpinLockRelease(&PredXact->statsMutex);
+}
+
+/*
+ * GetSerializableStats
+ *		Copy the serializable transaction event counters into counts, which
+ *		must have room for NUM_SERIALIZABLE_EVENTS entries.
+ *
+ * The counters are kept in shared memory only, so they start from zero
+ * whenever the server is started.
+ */
+void
+GetSerializableStats(uint64 *counts)
+{
+	SpinLockAcquire(&PredXact->statsMutex);
+	memcpy(counts, PredXact->eventCounts,
+		   NUM_SERIALIZABLE_EVENTS * sizeof(uint64));
+	SpinLockRelease(&PredXact->statsMutex);
+}
@@ -15,6 +15,20 @@
 
 #include "storage/checksum.h"
 
+/*
+ * On x86-64, have the compiler build pg_checksum_block for AVX2 and SSE 4.1
+ * besides the baseline instruction set, and let the dynamic linker pick the
+ * best one the CPU supports.  This needs the target_clones attribute, which
+ * relies on ifunc support and so is only used with glibc.
+ */
+#if defined(__x86_64__) && defined(__linux__) && defined(__GLIBC__) && \
+	defined(__has_attribute)
+#if __has_attribute(target_clones)
+#define PG_CHECKSUM_BLOCK_ATTRIBUTE \
+	__attribute__((target_clones("avx2", "sse4.1", "default")))
+#endif
+#endif
+
 /*
  * The actual code is in storage/checksum_impl.h.  This is done so that
  * external programs can incorporate the checksum code by #include'ing
@@ -67,6 +67,19 @@
 #define FILE_POSSIBLY_DELETED(err)	((err) == ENOENT || (err) == EACCES)
 #endif
 
+/*
+ * With direct_io covering data files, segment files are opened with
+ * O_DIRECT, and every read() or write() must use a buffer aligned on
+ * PG_IO_ALIGN_SIZE.  Shared and local buffers are, but some callers pass
+ * pages they have palloc'd themselves; those are copied through
+ * md_bounce_buffer.  Kernel readahead and posix_fadvise() don't apply to
+ * direct I/O, so mdprefetch() does nothing in that case.
+ */
+#define MD_DIRECT_IO		((direct_io & DIRECT_IO_DATA) != 0)
+#define MD_OPEN_FLAGS		(O_RDWR | PG_BINARY | (MD_DIRECT_IO ? PG_O_DIRECT : 0))
+
+static char *md_bounce_buffer = NULL;
+
 /*
  *	The magnetic disk storage manager keeps track of open file
  *	descriptors in its own descriptor pool.  This is done to make it
@@ -179,6 +192,7 @@ static void register_dirty_segment(SMgrRelation reln, ForkNumber forknum,
 					   MdfdVec *seg);
 static void register_unlink(RelFileNodeBackend rnode);
 static MdfdVec *_fdvec_alloc(void);
+static char *_mdfd_iobuffer(char *buffer);
 static char *_mdfd_segpath(SMgrRelation reln, ForkNumber forknum,
 			  BlockNumber segno);
 static MdfdVec *_mdfd_openseg(SMgrRelation reln, ForkNumber forkno,
@@ -297,7 +311,7 @@ mdcreate(SMgrRelation reln, ForkNumber forkNum, bool isRedo)
 
 	path = relpath(reln->smgr_rnode, forkNum);
 
-	fd = PathNameOpenFile(path, O_RDWR | O_CREAT | O_EXCL | PG_BINARY, 0600);
+	fd = PathNameOpenFile(path, MD_OPEN_FLAGS | O_CREAT | O_EXCL, 0600);
 
 	if (fd < 0)
 	{
@@ -310,7 +324,7 @@ mdcreate(SMgrRelation reln, ForkNumber forkNum, bool isRedo)
 		 * already, even if isRedo is not set.  (See also mdopen)
 		 */
 		if (isRedo || IsBootstrapProcessingMode())
-			fd = PathNameOpenFile(path, O_RDWR | PG_BINARY, 0600);
+			fd = PathNameOpenFile(path, MD_OPEN_FLAGS, 0600);
 		if (fd < 0)
 		{
 			/* be sure to report the error reported by create, not open */
@@ -492,6 +506,7 @@ mdextend(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 	off_t		seekpos;
 	int			nbytes;
 	MdfdVec    *v;
+	char	   *iobuf;
 
 	/* This assert is too expensive to have on normally ... */
 #ifdef CHECK_WRITE_VS_EXTEND
@@ -531,7 +546,11 @@ mdextend(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 				 errmsg("could not seek to block %u in file \"%s\": %m",
 						blocknum, FilePathName(v->mdfd_vfd))));
 
-	if ((nbytes = FileWrite(v->mdfd_vfd, buffer, BLCKSZ)) != BLCKSZ)
+	iobuf = _mdfd_iobuffer(buffer);
+	if (iobuf != buffer)
+		memcpy(iobuf, buffer, BLCKSZ);
+
+	if ((nbytes = FileWrite(v->mdfd_vfd, iobuf, BLCKSZ)) != BLCKSZ)
 	{
 		if (nbytes < 0)
 			ereport(ERROR,
@@ -554,6 +573,94 @@ mdextend(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 	Assert(_mdnblocks(reln, forknum, v) <= ((BlockNumber) RELSEG_SIZE));
 }
 
+/*
+ *	mdzeroextend() -- Add nblocks zero-filled blocks to the specified relation.
+ *
+ *		This is equivalent to calling mdextend() with a page of zeroes for
+ *		each block from blocknum to blocknum + nblocks - 1, but issues one
+ *		write per segment (or per chunk of MDZEROEXTEND_CHUNK blocks) rather
+ *		than one per block.
+ */
+#define MDZEROEXTEND_CHUNK	64
+
+void
+mdzeroextend(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
+			 int nblocks, bool skipFsync)
+{
+	char	   *rawbuf;
+	char	   *zerobuf;
+	int			bufblocks;
+
+	Assert(nblocks > 0);
+
+	/* See mdextend() */
+	if (blocknum == InvalidBlockNumber ||
+		(BlockNumber) nblocks > InvalidBlockNumber - blocknum)
+		ereport(ERROR,
+				(errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+				 errmsg("cannot extend file \"%s\" beyond %u blocks",
+						relpath(reln->smgr_rnode, forknum),
+						InvalidBlockNumber)));
+
+	bufblocks = Min(nblocks, MDZEROEXTEND_CHUNK);
+	/* aligned, in case direct I/O is in use */
+	rawbuf = palloc0(bufblocks * BLCKSZ + PG_IO_ALIGN_SIZE);
+	zerobuf = (char *) TYPEALIGN(PG_IO_ALIGN_SIZE, rawbuf);
+
+	while (nblocks > 0)
+	{
+		MdfdVec    *v;
+		off_t		seekpos;
+		int			segblocks;
+		int			nbytes;
+		int			numblocks;
+
+		v = _mdfd_getseg(reln, forknum, blocknum, skipFsync, EXTENSION_CREATE);
+
+		/* don't write across a segment boundary */
+		segblocks = RELSEG_SIZE - (blocknum % ((BlockNumber) RELSEG_SIZE));
+		numblocks = Min(Min(nblocks, bufblocks), segblocks);
+
+		seekpos = (off_t) BLCKSZ *(blocknum % ((BlockNumber) RELSEG_SIZE));
+
+		Assert(seekpos < (off_t) BLCKSZ * RELSEG_SIZE);
+
+		if (FileSeek(v->mdfd_vfd, seekpos, SEEK_SET) != seekpos)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not seek to block %u in file \"%s\": %m",
+							blocknum, FilePathName(v->mdfd_vfd))));
+
+		if ((nbytes = FileWrite(v->mdfd_vfd, zerobuf,
+								numblocks * BLCKSZ)) != numblocks * BLCKSZ)
+		{
+			if (nbytes < 0)
+				ereport(ERROR,
+						(errcode_for_file_access(),
+						 errmsg("could not extend file \"%s\": %m",
+								FilePathName(v->mdfd_vfd)),
+						 errhint("Check free disk space.")));
+			/* short write: complain appropriately */
+			ereport(ERROR,
+					(errcode(ERRCODE_DISK_FULL),
+					 errmsg("could not extend file \"%s\": wrote only %d of %d bytes at block %u",
+							FilePathName(v->mdfd_vfd),
+							nbytes, numblocks * BLCKSZ, blocknum),
+					 errhint("Check free disk space.")));
+		}
+
+		if (!skipFsync && !SmgrIsTemp(reln))
+			register_dirty_segment(reln, forknum, v);
+
+		Assert(_mdnblocks(reln, forknum, v) <= ((BlockNumber) RELSEG_SIZE));
+
+		blocknum += numblocks;
+		nblocks -= numblocks;
+	}
+
+	pfree(rawbuf);
+}
+
 /*
  *	mdopen() -- Open the specified relation.
  *
@@ -577,7 +684,7 @@ mdopen(SMgrRelation reln, ForkNumber forknum, ExtensionBehavior behavior)
 
 	path = relpath(reln->smgr_rnode, forknum);
 
-	fd = PathNameOpenFile(path, O_RDWR | PG_BINARY, 0600);
+	fd = PathNameOpenFile(path, MD_OPEN_FLAGS, 0600);
 
 	if (fd < 0)
 	{
@@ -588,7 +695,7 @@ mdopen(SMgrRelation reln, ForkNumber forknum, ExtensionBehavior behavior)
 		 * substitute for mdcreate() in bootstrap mode only. (See mdcreate)
 		 */
 		if (IsBootstrapProcessingMode())
-			fd = PathNameOpenFile(path, O_RDWR | O_CREAT | O_EXCL | PG_BINARY, 0600);
+			fd = PathNameOpenFile(path, MD_OPEN_FLAGS | O_CREAT | O_EXCL, 0600);
 		if (fd < 0)
 		{
 			if (behavior == EXTENSION_RETURN_NULL &&
@@ -652,6 +759,10 @@ mdprefetch(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum)
 	off_t		seekpos;
 	MdfdVec    *v;
 
+	/* the kernel can't prefetch for us if we bypass its cache */
+	if (MD_DIRECT_IO)
+		return;
+
 	v = _mdfd_getseg(reln, forknum, blocknum, false, EXTENSION_FAIL);
 
 	seekpos = (off_t) BLCKSZ *(blocknum % ((BlockNumber) RELSEG_SIZE));
@@ -673,6 +784,7 @@ mdread(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 	off_t		seekpos;
 	int			nbytes;
 	MdfdVec    *v;
+	char	   *iobuf;
 
 	TRACE_POSTGRESQL_SMGR_MD_READ_START(forknum, blocknum,
 										reln->smgr_rnode.node.spcNode,
@@ -692,7 +804,12 @@ mdread(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 				 errmsg("could not seek to block %u in file \"%s\": %m",
 						blocknum, FilePathName(v->mdfd_vfd))));
 
-	nbytes = FileRead(v->mdfd_vfd, buffer, BLCKSZ);
+	iobuf = _mdfd_iobuffer(buffer);
+
+	nbytes = FileRead(v->mdfd_vfd, iobuf, BLCKSZ);
+
+	if (iobuf != buffer && nbytes > 0)
+		memcpy(buffer, iobuf, nbytes);
 
 	TRACE_POSTGRESQL_SMGR_MD_READ_DONE(forknum, blocknum,
 									   reln->smgr_rnode.node.spcNode,
@@ -743,6 +860,7 @@ mdwrite(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 	off_t		seekpos;
 	int			nbytes;
 	MdfdVec    *v;
+	char	   *iobuf;
 
 	/* This assert is too expensive to have on normally ... */
 #ifdef CHECK_WRITE_VS_EXTEND
@@ -767,7 +885,11 @@ mdwrite(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 				 errmsg("could not seek to block %u in file \"%s\": %m",
 						blocknum, FilePathName(v->mdfd_vfd))));
 
-	nbytes = FileWrite(v->mdfd_vfd, buffer, BLCKSZ);
+	iobuf = _mdfd_iobuffer(buffer);
+	if (iobuf != buffer)
+		memcpy(iobuf, buffer, BLCKSZ);
+
+	nbytes = FileWrite(v->mdfd_vfd, iobuf, BLCKSZ);
 
 	TRACE_POSTGRESQL_SMGR_MD_WRITE_DONE(forknum, blocknum,
 										reln->smgr_rnode.node.spcNode,
@@ -1641,6 +1763,29 @@ ForgetDatabaseFsyncRequests(Oid dbid)
 }
 
 
+/*
+ *	_mdfd_iobuffer() -- Get a buffer suitable for reading or writing a block.
+ *
+ * Returns buffer itself unless direct I/O needs an aligned buffer and it
+ * isn't one, in which case the bounce buffer is returned; the caller must
+ * copy the data in or out.
+ */
+static char *
+_mdfd_iobuffer(char *buffer)
+{
+	if (!MD_DIRECT_IO ||
+		TYPEALIGN(PG_IO_ALIGN_SIZE, buffer) == (uintptr_t) buffer)
+		return buffer;
+
+	if (md_bounce_buffer == NULL)
+		md_bounce_buffer = (char *)
+			TYPEALIGN(PG_IO_ALIGN_SIZE,
+					  MemoryContextAlloc(TopMemoryContext,
+										 BLCKSZ + PG_IO_ALIGN_SIZE));
+
+	return md_bounce_buffer;
+}
+
 /*
  *	_fdvec_alloc() -- Make a MdfdVec object.
  */
@@ -1688,7 +1833,7 @@ _mdfd_openseg(SMgrRelation reln, ForkNumber forknum, BlockNumber segno,
 	fullpath = _mdfd_segpath(reln, forknum, segno);
 
 	/* open the file */
-	fd = PathNameOpenFile(fullpath, O_RDWR | PG_BINARY | oflags, 0600);
+	fd = PathNameOpenFile(fullpath, MD_OPEN_FLAGS | oflags, 0600);
 
 	pfree(fullpath);
 
@@ -18,9 +18,14 @@
 #include "postgres.h"
 
 #include "commands/tablespace.h"
+#include "miscadmin.h"
+#include "port/atomics.h"
 #include "storage/bufmgr.h"
 #include "storage/ipc.h"
+#include "storage/lwlock.h"
+#include "storage/shmem.h"
 #include "storage/smgr.h"
+#include "storage/spin.h"
 #include "utils/hsearch.h"
 #include "utils/inval.h"
 
@@ -47,6 +52,8 @@ typedef struct f_smgr
 											bool isRedo);
 	void		(*smgr_extend) (SMgrRelation reln, ForkNumber forknum,
 						 BlockNumber blocknum, char *buffer, bool skipFsync);
+	void		(*smgr_zeroextend) (SMgrRelation reln, ForkNumber forknum,
+						 BlockNumber blocknum, int nblocks, bool skipFsync);
 	void		(*smgr_prefetch) (SMgrRelation reln, ForkNumber forknum,
 											  BlockNumber blocknum);
 	void		(*smgr_read) (SMgrRelation reln, ForkNumber forknum,
@@ -66,7 +73,7 @@ typedef struct f_smgr
 static const f_smgr smgrsw[] = {
 	/* magnetic disk */
 	{mdinit, NULL, mdclose, mdcreate, mdexists, mdunlink, mdextend,
-		mdprefetch, mdread, mdwrite, mdnblocks, mdtruncate, mdimmedsync,
+		mdzeroextend, mdprefetch, mdread, mdwrite, mdnblocks, mdtruncate, mdimmedsync,
 		mdpreckpt, mdsync, mdpostckpt
 	}
 };
@@ -82,10 +89,89 @@ static HTAB *SMgrRelationHash = NULL;
 
 static SMgrRelation first_unowned_reln = NULL;
 
+/*
+ * Shared relation size cache.
+ *
+ * Finding out the size of a relation takes an lseek(SEEK_END) on each of its
+ * segment files, and relation sizes are looked up very often (by the planner
+ * for every relation in every query, and whenever a relation is extended or
+ * scanned).  To avoid those system calls, we remember the size of each fork
+ * of non-temporary relations in a hash table in shared memory.  An entry is
+ * made the first time a size is looked up, advanced by smgrextend() and
+ * smgrzeroextend(), and set by smgrtruncate(); it is removed when the file is
+ * created or unlinked, or when a whole database's files are dropped or moved.
+ *
+ * A missing entry is filled in while holding its partition lock exclusively,
+ * including the underlying storage manager call, and extensions advance the
+ * entry under the same lock after the file has been extended.  Hence a
+ * concurrent extension either happens before the size is measured, or finds
+ * the new entry and advances it; an entry can't end up smaller than the file.
+ *
+ * Temporary relations are only accessed by their own backend and aren't
+ * worth the shared memory, so they're not cached.
+ *
+ * The sizes are kept in a fixed array of slots, and the hash table maps each
+ * cached fork to its slot.  When all slots are in use, one is reclaimed with
+ * a clock sweep like the one the buffer manager uses: each slot has a usage
+ * count that lookups bump, and the sweep decrements until it finds a slot
+ * whose count is zero.  A slot's tag and size, and the hash entry pointing
+ * to it, are protected by the partition lock of the fork cached in it.  Its
+ * flags and usage count are protected by its spinlock.  A slot that is being
+ * reclaimed or filled in is marked busy, which keeps other sweeps away from
+ * it; since reclaiming a slot needs the partition lock of the fork it held,
+ * a slot is always reserved before taking the lock of the fork to cache.
+ */
+typedef struct SMgrSizeTag
+{
+	RelFileNode rnode;			/* physical relation identifier */
+	ForkNumber	forknum;
+} SMgrSizeTag;
+
+typedef struct SMgrSizeEnt
+{
+	SMgrSizeTag tag;			/* hash key; must be first */
+	int			slot;			/* index of the slot holding the size */
+} SMgrSizeEnt;
+
+typedef struct SMgrSizeSlot
+{
+	SMgrSizeTag tag;			/* fork cached in this slot, if valid */
+	BlockNumber nblocks;		/* current size of the fork */
+	uint8		flags;			/* see bit definitions below */
+	uint8		usage_count;	/* usage counter for clock sweep */
+	slock_t		mutex;			/* protects flags and usage_count */
+} SMgrSizeSlot;
+
+#define SMGRSIZE_VALID		(1 << 0)	/* slot holds a cached size */
+#define SMGRSIZE_BUSY		(1 << 1)	/* slot is being reclaimed or filled */
+
+#define SMGRSIZE_MAX_USAGE_COUNT	5
+
+typedef struct SMgrSizeCtlData
+{
+	pg_atomic_uint32 nextVictimSlot;	/* clock sweep hand */
+	SMgrSizeSlot slots[FLEXIBLE_ARRAY_MEMBER];
+} SMgrSizeCtlData;
+
+#define SMgrSizeCacheEntries()	Max(NBuffers / 4, 1024)
+
+#define SMgrSizePartitionLock(hashcode) \
+	(&MainLWLockArray[SMGR_SIZE_LWLOCK_OFFSET + \
+					  ((hashcode) % NUM_SMGR_SIZE_PARTITIONS)].lock)
+
+static HTAB *SMgrSizeHash = NULL;
+static SMgrSizeCtlData *SMgrSizeCtl = NULL;
+
 /* local function prototypes */
 static void smgrshutdown(int code, Datum arg);
 static void add_to_unowned_list(SMgrRelation reln);
 static void remove_from_unowned_list(SMgrRelation reln);
+static void smgrsize_advance(SMgrRelation reln, ForkNumber forknum,
+				 BlockNumber nblocks, bool exact);
+static void smgrsize_forget(RelFileNodeBackend rnode, ForkNumber forknum);
+static int	smgrsize_getslot(void);
+static void smgrsize_unreserve(int slotno);
+static void smgrsize_freeslot(int slotno);
 
 
 /*
@@ -394,6 +480,9 @@ smgrcreate(SMgrRelation reln, ForkNumber forknum, bool isRedo)
 							isRedo);
 
 	(*(smgrsw[reln->smgr_which].smgr_create)) (reln, forknum, isRedo);
+
+	/* Forget any cached size left over from an earlier incarnation */
+	smgrsize_forget(reln->smgr_rnode, forknum);
 }
 
 /*
@@ -415,15 +504,16 @@ smgrdounlink(SMgrRelation reln, bool isRedo)
 	int			which = reln->smgr_which;
 	ForkNumber	forknum;
 
-	/* Close the forks at smgr level */
-	for (forknum = 0; forknum <= MAX_FORKNUM; forknum++)
-		(*(smgrsw[which].smgr_close)) (reln, forknum);
-
 	/*
 	 * Get rid of any remaining buffers for the relation.  bufmgr will just
-	 * drop them without bothering to write the contents.
+	 * drop them without bothering to write the contents.  This must happen
+	 * while the forks' sizes can still be determined.
 	 */
-	DropRelFileNodesAllBuffers(&rnode, 1);
+	DropRelFileNodesAllBuffers(&reln, 1);
+
+	/* Close the forks at smgr level */
+	for (forknum = 0; forknum <= MAX_FORKNUM; forknum++)
+		(*(smgrsw[which].smgr_close)) (reln, forknum);
 
 	/*
 	 * It'd be nice to tell the stats collector to forget it immediately, too.
@@ -450,6 +540,8 @@ smgrdounlink(SMgrRelation reln, bool isRedo)
 	 * xact.
 	 */
 	(*(smgrsw[which].smgr_unlink)) (rnode, InvalidForkNumber, isRedo);
+
+	smgrsize_forget(rnode, InvalidForkNumber);
 }
 
 /*
@@ -475,6 +567,13 @@ smgrdounlinkall(SMgrRelation *rels, int nrels, bool isRedo)
 	if (nrels == 0)
 		return;
 
+	/*
+	 * Get rid of any remaining buffers for the relations.  bufmgr will just
+	 * drop them without bothering to write the contents.  This must happen
+	 * while the forks' sizes can still be determined.
+	 */
+	DropRelFileNodesAllBuffers(rels, nrels);
+
 	/*
 	 * create an array which contains all relations to be dropped, and close
 	 * each relation's forks at the smgr level while at it
@@ -492,12 +591,6 @@ smgrdounlinkall(SMgrRelation *rels, int nrels, bool isRedo)
 			(*(smgrsw[which].smgr_close)) (rels[i], forknum);
 	}
 
-	/*
-	 * Get rid of any remaining buffers for the relations.  bufmgr will just
-	 * drop them without bothering to write the contents.
-	 */
-	DropRelFileNodesAllBuffers(rnodes, nrels);
-
 	/*
 	 * It'd be nice to tell the stats collector to forget them immediately,
 	 * too. But we can't because we don't know the OIDs.
@@ -528,6 +621,8 @@ smgrdounlinkall(SMgrRelation *rels, int nrels, bool isRedo)
 
 		for (forknum = 0; forknum <= MAX_FORKNUM; forknum++)
 			(*(smgrsw[which].smgr_unlink)) (rnodes[i], forknum, isRedo);
+
+		smgrsize_forget(rnodes[i], InvalidForkNumber);
 	}
 
 	pfree(rnodes);
@@ -549,14 +644,14 @@ smgrdounlinkfork(SMgrRelation reln, ForkNumber forknum, bool isRedo)
 	RelFileNodeBackend rnode = reln->smgr_rnode;
 	int			which = reln->smgr_which;
 
-	/* Close the fork at smgr level */
-	(*(smgrsw[which].smgr_close)) (reln, forknum);
-
 	/*
 	 * Get rid of any remaining buffers for the fork.  bufmgr will just drop
 	 * them without bothering to write the contents.
 	 */
-	DropRelFileNodeBuffers(rnode, forknum, 0);
+	DropRelFileNodeBuffers(reln, forknum, 0);
+
+	/* Close the fork at smgr level */
+	(*(smgrsw[which].smgr_close)) (reln, forknum);
 
 	/*
 	 * It'd be nice to tell the stats collector to forget it immediately, too.
@@ -583,6 +678,8 @@ smgrdounlinkfork(SMgrRelation reln, ForkNumber forknum, bool isRedo)
 	 * xact.
 	 */
 	(*(smgrsw[which].smgr_unlink)) (rnode, forknum, isRedo);
+
+	smgrsize_forget(rnode, forknum);
 }
 
 /*
@@ -600,6 +697,25 @@ smgrextend(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 {
 	(*(smgrsw[reln->smgr_which].smgr_extend)) (reln, forknum, blocknum,
 											   buffer, skipFsync);
+
+	smgrsize_advance(reln, forknum, blocknum + 1, false);
+}
+
+/*
+ *	smgrzeroextend() -- Add several zero-filled blocks to a file.
+ *
+ *		This is like calling smgrextend() with an all-zeroes buffer for each
+ *		of the nblocks blocks starting at blocknum, but lets the storage
+ *		manager do the work in fewer, larger I/O requests.
+ */
+void
+smgrzeroextend(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
+			   int nblocks, bool skipFsync)
+{
+	(*(smgrsw[reln->smgr_which].smgr_zeroextend)) (reln, forknum, blocknum,
+												   nblocks, skipFsync);
+
+	smgrsize_advance(reln, forknum, blocknum + nblocks, false);
 }
 
 /*
@@ -652,11 +768,150 @@ smgrwrite(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 /*
  *	smgrnblocks() -- Calculate the number of blocks in the
  *					 supplied relation.
+ *
+ *		The answer comes from the shared relation size cache if possible,
+ *		and is entered there otherwise.
  */
 BlockNumber
 smgrnblocks(SMgrRelation reln, ForkNumber forknum)
 {
-	return (*(smgrsw[reln->smgr_which].smgr_nblocks)) (reln, forknum);
+	SMgrSizeTag tag;
+	uint32		hashcode;
+	LWLock	   *partitionLock;
+	SMgrSizeEnt *entry;
+	BlockNumber result;
+	int			slotno;
+
+	if (SMgrSizeHash == NULL || SmgrIsTemp(reln))
+		return (*(smgrsw[reln->smgr_which].smgr_nblocks)) (reln, forknum);
+
+	MemSet(&tag, 0, sizeof(tag));
+	tag.rnode = reln->smgr_rnode.node;
+	tag.forknum = forknum;
+	hashcode = get_hash_value(SMgrSizeHash, (void *) &tag);
+	partitionLock = SMgrSizePartitionLock(hashcode);
+
+	LWLockAcquire(partitionLock, LW_SHARED);
+	entry = (SMgrSizeEnt *)
+		hash_search_with_hash_value(SMgrSizeHash, (void *) &tag, hashcode,
+									HASH_FIND, NULL);
+	if (entry)
+	{
+		SMgrSizeSlot *slot = &SMgrSizeCtl->slots[entry->slot];
+
+		result = slot->nblocks;
+		if (slot->usage_count < SMGRSIZE_MAX_USAGE_COUNT)
+		{
+			SpinLockAcquire(&slot->mutex);
+			if (slot->usage_count < SMGRSIZE_MAX_USAGE_COUNT)
+				slot->usage_count++;
+			SpinLockRelease(&slot->mutex);
+		}
+		LWLockRelease(partitionLock);
+		return result;
+	}
+	LWLockRelease(partitionLock);
+
+	/*
+	 * Not cached.  Reserve a slot to cache the size in; we must do that
+	 * before taking our partition lock, since evicting the slot's previous
+	 * contents needs another one.  If no slot can be had, we just don't
+	 * cache the size.
+	 */
+	slotno = smgrsize_getslot();
+
+	/*
+	 * Measure the file and make an entry, holding the lock exclusively
+	 * throughout so that a concurrent extension can't be missed.  Somebody
+	 * else may have made the entry while we weren't holding the lock.
+	 */
+	LWLockAcquire(partitionLock, LW_EXCLUSIVE);
+
+	entry = (SMgrSizeEnt *)
+		hash_search_with_hash_value(SMgrSizeHash, (void *) &tag, hashcode,
+									HASH_FIND, NULL);
+	if (entry)
+		result = SMgrSizeCtl->slots[entry->slot].nblocks;
+	else
+	{
+		/* Don't leave the slot reserved if the file can't be measured */
+		PG_TRY();
+		{
+			result = (*(smgrsw[reln->smgr_which].smgr_nblocks)) (reln,
+																 forknum);
+		}
+		PG_CATCH();
+		{
+			if (slotno >= 0)
+				smgrsize_unreserve(slotno);
+			PG_RE_THROW();
+		}
+		PG_END_TRY();
+
+		if (slotno >= 0)
+		{
+			entry = (SMgrSizeEnt *)
+				hash_search_with_hash_value(SMgrSizeHash, (void *) &tag,
+											hashcode, HASH_ENTER_NULL, NULL);
+			if (entry)
+			{
+				SMgrSizeSlot *slot = &SMgrSizeCtl->slots[slotno];
+
+				entry->slot = slotno;
+				slot->tag = tag;
+				slot->nblocks = result;
+				SpinLockAcquire(&slot->mutex);
+				slot->flags = SMGRSIZE_VALID;
+				slot->usage_count = 1;
+				SpinLockRelease(&slot->mutex);
+				slotno = -1;
+			}
+		}
+	}
+
+	LWLockRelease(partitionLock);
+
+	/* Give back the slot if we didn't need it after all */
+	if (slotno >= 0)
+		smgrsize_unreserve(slotno);
+
+	return result;
+}
+
+/*
+ *	smgrnblocks_cached() -- Get the number of blocks in the supplied
+ *							relation, if it is in the relation size cache.
+ *
+ *		Returns InvalidBlockNumber if it isn't.  Unlike smgrnblocks(), this
+ *		never calls the storage manager, nor does it make a cache entry.
+ */
+BlockNumber
+smgrnblocks_cached(SMgrRelation reln, ForkNumber forknum)
+{
+	SMgrSizeTag tag;
+	uint32		hashcode;
+	LWLock	   *partitionLock;
+	SMgrSizeEnt *entry;
+	BlockNumber result = InvalidBlockNumber;
+
+	if (SMgrSizeHash == NULL || SmgrIsTemp(reln))
+		return InvalidBlockNumber;
+
+	MemSet(&tag, 0, sizeof(tag));
+	tag.rnode = reln->smgr_rnode.node;
+	tag.forknum = forknum;
+	hashcode = get_hash_value(SMgrSizeHash, (void *) &tag);
+	partitionLock = SMgrSizePartitionLock(hashcode);
+
+	LWLockAcquire(partitionLock, LW_SHARED);
+	entry = (SMgrSizeEnt *)
+		hash_search_with_hash_value(SMgrSizeHash, (void *) &tag, hashcode,
+									HASH_FIND, NULL);
+	if (entry)
+		result = SMgrSizeCtl->slots[entry->slot].nblocks;
+	LWLockRelease(partitionLock);
+
+	return result;
 }
 
 /*
@@ -672,7 +927,7 @@ smgrtruncate(SMgrRelation reln, ForkNumber forknum, BlockNumber nblocks)
 	 * Get rid of any buffers for the about-to-be-deleted blocks. bufmgr will
 	 * just drop them without bothering to write the contents.
 	 */
-	DropRelFileNodeBuffers(reln->smgr_rnode, forknum, nblocks);
+	DropRelFileNodeBuffers(reln, forknum, nblocks);
 
 	/*
 	 * Send a shared-inval message to force other backends to close any smgr
@@ -690,6 +945,8 @@ smgrtruncate(SMgrRelation reln, ForkNumber forknum, BlockNumber nblocks)
 	 * Do the truncation.
 	 */
 	(*(smgrsw[reln->smgr_which].smgr_truncate)) (reln, forknum, nblocks);
+
+	smgrsize_advance(reln, forknum, nblocks, true);
 }
 
 /*
@@ -792,3 +1049,285 @@ AtEOXact_SMgr(void)
 		smgrclose(first_unowned_reln);
 	}
 }
+
+/*
+ * SMgrSizeShmemSize --- report amount of shared memory space needed
+ */
+Size
+SMgrSizeShmemSize(void)
+{
+	Size		size;
+
+	size = hash_estimate_size(SMgrSizeCacheEntries(), sizeof(SMgrSizeEnt));
+	size = add_size(size, offsetof(SMgrSizeCtlData, slots));
+	size = add_size(size, mul_size(SMgrSizeCacheEntries(),
+								   sizeof(SMgrSizeSlot)));
+	return size;
+}
+
+/*
+ * SMgrSizeShmemInit --- initialize the shared relation size cache
+ */
+void
+SMgrSizeShmemInit(void)
+{
+	HASHCTL		info;
+	long		size = SMgrSizeCacheEntries();
+	bool		found;
+
+	MemSet(&info, 0, sizeof(info));
+	info.keysize = sizeof(SMgrSizeTag);
+	info.entrysize = sizeof(SMgrSizeEnt);
+	info.num_partitions = NUM_SMGR_SIZE_PARTITIONS;
+
+	SMgrSizeHash = ShmemInitHash("Relation Size Cache",
+								 size, size,
+								 &info,
+								 HASH_ELEM | HASH_BLOBS | HASH_PARTITION);
+
+	SMgrSizeCtl = (SMgrSizeCtlData *)
+		ShmemInitStruct("Relation Size Cache Slots",
+						add_size(offsetof(SMgrSizeCtlData, slots),
+								 mul_size(size, sizeof(SMgrSizeSlot))),
+						&found);
+
+	if (!found)
+	{
+		int			i;
+
+		pg_atomic_init_u32(&SMgrSizeCtl->nextVictimSlot, 0);
+		for (i = 0; i < size; i++)
+		{
+			SMgrSizeSlot *slot = &SMgrSizeCtl->slots[i];
+
+			slot->flags = 0;
+			slot->usage_count = 0;
+			SpinLockInit(&slot->mutex);
+		}
+	}
+}
+
+/*
+ * smgrsize_advance -- update a cached relation size after a change
+ *
+ * If exact is false, the fork is now known to be at least nblocks long;
+ * otherwise it is exactly nblocks long.  Nothing is done if the size isn't
+ * cached.
+ */
+static void
+smgrsize_advance(SMgrRelation reln, ForkNumber forknum, BlockNumber nblocks,
+				 bool exact)
+{
+	SMgrSizeTag tag;
+	uint32		hashcode;
+	LWLock	   *partitionLock;
+	SMgrSizeEnt *entry;
+
+	if (SMgrSizeHash == NULL || SmgrIsTemp(reln))
+		return;
+
+	MemSet(&tag, 0, sizeof(tag));
+	tag.rnode = reln->smgr_rnode.node;
+	tag.forknum = forknum;
+	hashcode = get_hash_value(SMgrSizeHash, (void *) &tag);
+	partitionLock = SMgrSizePartitionLock(hashcode);
+
+	LWLockAcquire(partitionLock, LW_EXCLUSIVE);
+	entry = (SMgrSizeEnt *)
+		hash_search_with_hash_value(SMgrSizeHash, (void *) &tag, hashcode,
+									HASH_FIND, NULL);
+	if (entry)
+	{
+		SMgrSizeSlot *slot = &SMgrSizeCtl->slots[entry->slot];
+
+		if (exact || slot->nblocks < nblocks)
+			slot->nblocks = nblocks;
+	}
+	LWLockRelease(partitionLock);
+}
+
+/*
+ * smgrsize_forget -- remove cached sizes of one fork, or all forks if
+ * forknum is InvalidForkNumber, of a relation
+ */
+static void
+smgrsize_forget(RelFileNodeBackend rnode, ForkNumber forknum)
+{
+	SMgrSizeTag tag;
+	ForkNumber	fork;
+	SMgrSizeEnt *entry;
+
+	if (SMgrSizeHash == NULL || RelFileNodeBackendIsTemp(rnode))
+		return;
+
+	for (fork = 0; fork <= MAX_FORKNUM; fork++)
+	{
+		uint32		hashcode;
+		LWLock	   *partitionLock;
+
+		if (forknum != InvalidForkNumber && fork != forknum)
+			continue;
+
+		MemSet(&tag, 0, sizeof(tag));
+		tag.rnode = rnode.node;
+		tag.forknum = fork;
+		hashcode = get_hash_value(SMgrSizeHash, (void *) &tag);
+		partitionLock = SMgrSizePartitionLock(hashcode);
+
+		LWLockAcquire(partitionLock, LW_EXCLUSIVE);
+		entry = (SMgrSizeEnt *)
+			hash_search_with_hash_value(SMgrSizeHash, (void *) &tag, hashcode,
+										HASH_REMOVE, NULL);
+		if (entry)
+			smgrsize_freeslot(entry->slot);
+		LWLockRelease(partitionLock);
+	}
+}
+
+/*
+ * smgrforgetdatabase -- remove all cached relation sizes of a database
+ *
+ * This must be called when a database's files are removed or moved to
+ * another tablespace without going through the storage manager, since its
+ * relfilenodes could otherwise later find stale entries.
+ */
+void
+smgrforgetdatabase(Oid dbid)
+{
+	HASH_SEQ_STATUS status;
+	SMgrSizeEnt *entry;
+	int			i;
+
+	if (SMgrSizeHash == NULL)
+		return;
+
+	/* Lock all partitions, in order to avoid deadlocks */
+	for (i = 0; i < NUM_SMGR_SIZE_PARTITIONS; i++)
+		LWLockAcquire(&MainLWLockArray[SMGR_SIZE_LWLOCK_OFFSET + i].lock,
+					  LW_EXCLUSIVE);
+
+	hash_seq_init(&status, SMgrSizeHash);
+	while ((entry = (SMgrSizeEnt *) hash_seq_search(&status)) != NULL)
+	{
+		if (entry->tag.rnode.dbNode == dbid)
+		{
+			smgrsize_freeslot(entry->slot);
+			hash_search(SMgrSizeHash, (void *) &entry->tag, HASH_REMOVE, NULL);
+		}
+	}
+
+	for (i = NUM_SMGR_SIZE_PARTITIONS; --i >= 0;)
+		LWLockRelease(&MainLWLockArray[SMGR_SIZE_LWLOCK_OFFSET + i].lock);
+}
+
+/*
+ * smgrsize_getslot -- reserve a slot of the relation size cache
+ *
+ * Runs the clock sweep to find a slot that isn't busy and hasn't been used
+ * recently, evicting the size cached there if any.  The slot is returned
+ * marked busy, and the caller must either fill it in or give it back with
+ * smgrsize_unreserve().  Returns -1 if every slot seems to be busy.
+ *
+ * The caller mustn't hold any of the partition locks.
+ */
+static int
+smgrsize_getslot(void)
+{
+	int			nslots = SMgrSizeCacheEntries();
+	int			trycounter = nslots;
+	int			slotno;
+	SMgrSizeSlot *slot;
+	SMgrSizeTag oldtag;
+	bool		oldvalid;
+
+	for (;;)
+	{
+		/*
+		 * The hand isn't wrapped, so after it overflows the sweep jumps to
+		 * an arbitrary position; that's harmless.
+		 */
+		slotno = pg_atomic_fetch_add_u32(&SMgrSizeCtl->nextVictimSlot, 1) %
+			nslots;
+		slot = &SMgrSizeCtl->slots[slotno];
+
+		SpinLockAcquire(&slot->mutex);
+		if ((slot->flags & SMGRSIZE_BUSY) == 0)
+		{
+			if (slot->usage_count == 0)
+			{
+				slot->flags |= SMGRSIZE_BUSY;
+				oldvalid = (slot->flags & SMGRSIZE_VALID) != 0;
+				oldtag = slot->tag;
+				SpinLockRelease(&slot->mutex);
+				break;
+			}
+			slot->usage_count--;
+			trycounter = nslots;
+		}
+		else if (--trycounter == 0)
+		{
+			SpinLockRelease(&slot->mutex);
+			return -1;
+		}
+		SpinLockRelease(&slot->mutex);
+	}
+
+	/*
+	 * Evict the size cached in the slot.  It may have been forgotten since we
+	 * looked, and then perhaps cached again in another slot, so remove the
+	 * hash entry only if it still points to our slot.
+	 */
+	if (oldvalid)
+	{
+		uint32		hashcode;
+		LWLock	   *partitionLock;
+		SMgrSizeEnt *entry;
+
+		hashcode = get_hash_value(SMgrSizeHash, (void *) &oldtag);
+		partitionLock = SMgrSizePartitionLock(hashcode);
+
+		LWLockAcquire(partitionLock, LW_EXCLUSIVE);
+		entry = (SMgrSizeEnt *)
+			hash_search_with_hash_value(SMgrSizeHash, (void *) &oldtag,
+										hashcode, HASH_FIND, NULL);
+		if (entry && entry->slot == slotno)
+		{
+			hash_search_with_hash_value(SMgrSizeHash, (void *) &oldtag,
+										hashcode, HASH_REMOVE, NULL);
+			smgrsize_freeslot(slotno);
+		}
+		LWLockRelease(partitionLock);
+	}
+
+	return slotno;
+}
+
+/*
+ * smgrsize_unreserve -- give back a slot reserved by smgrsize_getslot()
+ */
+static void
+smgrsize_unreserve(int slotno)
+{
+	SMgrSizeSlot *slot = &SMgrSizeCtl->slots[slotno];
+
+	SpinLockAcquire(&slot->mutex);
+	slot->flags &= ~SMGRSIZE_BUSY;
+	SpinLockRelease(&slot->mutex);
+}
+
+/*
+ * smgrsize_freeslot -- mark the slot of a removed hash entry as unused
+ *
+ * The caller must hold the partition lock of the entry.  A busy slot stays
+ * reserved by whoever is evicting it.
+ */
+static void
+smgrsize_freeslot(int slotno)
+{
+	SMgrSizeSlot *slot = &SMgrSizeCtl->slots[slotno];
+
+	SpinLockAcquire(&slot->mutex);
+	slot->flags &= ~SMGRSIZE_VALID;
+	slot->usage_count = 0;
+	SpinLockRelease(&slot->mutex);
+}
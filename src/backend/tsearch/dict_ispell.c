@@ -16,7 +16,9 @@
 #include "commands/defrem.h"
 #include "tsearch/dicts/spell.h"
 #include "tsearch/ts_locale.h"
+#include "tsearch/ts_shared.h"
 #include "tsearch/ts_utils.h"
+#include "utils/memutils.h"
 
 
 typedef struct
@@ -30,40 +32,34 @@ dispell_init(PG_FUNCTION_ARGS)
 {
 	List	   *dictoptions = (List *) PG_GETARG_POINTER(0);
 	DictISpell *d;
-	bool		affloaded = false,
-				dictloaded = false,
-				stoploaded = false;
+	char	   *dictfile = NULL,
+			   *afffile = NULL;
+	bool		stoploaded = false;
 	ListCell   *l;
 
 	d = (DictISpell *) palloc0(sizeof(DictISpell));
 
-	NIStartBuild(&(d->obj));
-
 	foreach(l, dictoptions)
 	{
 		DefElem    *defel = (DefElem *) lfirst(l);
 
 		if (pg_strcasecmp(defel->defname, "DictFile") == 0)
 		{
-			if (dictloaded)
+			if (dictfile)
 				ereport(ERROR,
 						(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
 						 errmsg("multiple DictFile parameters")));
-			NIImportDictionary(&(d->obj),
-							 get_tsearch_config_filename(defGetString(defel),
-														 "dict"));
-			dictloaded = true;
+			dictfile = get_tsearch_config_filename(defGetString(defel),
+												   "dict");
 		}
 		else if (pg_strcasecmp(defel->defname, "AffFile") == 0)
 		{
-			if (affloaded)
+			if (afffile)
 				ereport(ERROR,
 						(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
 						 errmsg("multiple AffFile parameters")));
-			NIImportAffixes(&(d->obj),
-							get_tsearch_config_filename(defGetString(defel),
-														"affix"));
-			affloaded = true;
+			afffile = get_tsearch_config_filename(defGetString(defel),
+												  "affix");
 		}
 		else if (pg_strcasecmp(defel->defname, "StopWords") == 0)
 		{
@@ -83,25 +79,54 @@ dispell_init(PG_FUNCTION_ARGS)
 		}
 	}
 
-	if (affloaded && dictloaded)
-	{
-		NISortDictionary(&(d->obj));
-		NISortAffixes(&(d->obj));
-	}
-	else if (!affloaded)
+	if (!afffile)
 	{
 		ereport(ERROR,
 				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
 				 errmsg("missing AffFile parameter")));
 	}
-	else
+	else if (!dictfile)
 	{
 		ereport(ERROR,
 				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
 				 errmsg("missing DictFile parameter")));
 	}
 
-	NIFinishBuild(&(d->obj));
+	/*
+	 * If another backend has already put this dictionary into shared memory,
+	 * just use that copy.  Otherwise build it here.
+	 */
+	if (!NIAttachShared(&(d->obj), dictfile, afffile))
+	{
+		MemoryContext oldcxt = CurrentMemoryContext;
+		MemoryContext localcxt = NULL;
+
+		/*
+		 * If the result may be moved to shared memory, build it in a context
+		 * of its own, so that the local copy can be released afterwards.
+		 */
+		if (ts_shared_enabled())
+		{
+			localcxt = AllocSetContextCreate(CurrentMemoryContext,
+											 "Ispell dictionary local copy",
+											 ALLOCSET_DEFAULT_MINSIZE,
+											 ALLOCSET_DEFAULT_INITSIZE,
+											 ALLOCSET_DEFAULT_MAXSIZE);
+			MemoryContextSwitchTo(localcxt);
+		}
+
+		NIStartBuild(&(d->obj));
+		NIImportDictionary(&(d->obj), dictfile);
+		NIImportAffixes(&(d->obj), afffile);
+		NISortDictionary(&(d->obj));
+		NISortAffixes(&(d->obj));
+		NIFinishBuild(&(d->obj));
+
+		MemoryContextSwitchTo(oldcxt);
+
+		if (localcxt && NIShare(&(d->obj), dictfile, afffile))
+			MemoryContextDelete(localcxt);
+	}
 
 	PG_RETURN_POINTER(d);
 }
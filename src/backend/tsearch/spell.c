@@ -14,9 +14,12 @@
 
 #include "postgres.h"
 
+#include <sys/stat.h>
+
 #include "catalog/pg_collation.h"
 #include "tsearch/dicts/spell.h"
 #include "tsearch/ts_locale.h"
+#include "tsearch/ts_shared.h"
 #include "utils/memutils.h"
 
 
@@ -373,6 +376,31 @@ FindWord(IspellDict *Conf, const char *word, int affixflag, int flag)
 	return 0;
 }
 
+/*
+ * Compile the regular expression mask of an affix, in CurrentMemoryContext.
+ */
+static regex_t *
+compileAffixRegex(pg_wchar *mask, int masklen)
+{
+	regex_t    *regex = (regex_t *) palloc(sizeof(regex_t));
+	int			err;
+
+	err = pg_regcomp(regex, mask, masklen,
+					 REG_ADVANCED | REG_NOSUB,
+					 DEFAULT_COLLATION_OID);
+	if (err)
+	{
+		char		errstr[100];
+
+		pg_regerror(err, regex, errstr, sizeof(errstr));
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_REGULAR_EXPRESSION),
+				 errmsg("invalid regular expression: %s", errstr)));
+	}
+
+	return regex;
+}
+
 static void
 NIAddAffix(IspellDict *Conf, int flag, char flagflags, const char *mask, const char *find, const char *repl, int type)
 {
@@ -410,7 +438,6 @@ NIAddAffix(IspellDict *Conf, int flag, char flagflags, const char *mask, const c
 	{
 		int			masklen;
 		int			wmasklen;
-		int			err;
 		pg_wchar   *wmask;
 		char	   *tmask;
 
@@ -423,20 +450,28 @@ NIAddAffix(IspellDict *Conf, int flag, char flagflags, const char *mask, const c
 			sprintf(tmask, "^%s", mask);
 
 		masklen = strlen(tmask);
-		wmask = (pg_wchar *) tmpalloc((masklen + 1) * sizeof(pg_wchar));
+
+		/*
+		 * If the dictionary may be moved to shared memory, the mask must be
+		 * kept so that other backends can compile it.  Otherwise it's only
+		 * needed while building.
+		 */
+		if (ts_shared_enabled())
+			wmask = (pg_wchar *) palloc((masklen + 1) * sizeof(pg_wchar));
+		else
+			wmask = (pg_wchar *) tmpalloc((masklen + 1) * sizeof(pg_wchar));
 		wmasklen = pg_mb2wchar_with_len(tmask, wmask, masklen);
 
-		err = pg_regcomp(&(Affix->reg.regex), wmask, wmasklen,
-						 REG_ADVANCED | REG_NOSUB,
-						 DEFAULT_COLLATION_OID);
-		if (err)
+		Affix->reg.re.regex = compileAffixRegex(wmask, wmasklen);
+		if (ts_shared_enabled())
 		{
-			char		errstr[100];
-
-			pg_regerror(err, &(Affix->reg.regex), errstr, sizeof(errstr));
-			ereport(ERROR,
-					(errcode(ERRCODE_INVALID_REGULAR_EXPRESSION),
-					 errmsg("invalid regular expression: %s", errstr)));
+			Affix->reg.re.mask = wmask;
+			Affix->reg.re.masklen = wmasklen;
+		}
+		else
+		{
+			Affix->reg.re.mask = NULL;
+			Affix->reg.re.masklen = 0;
 		}
 	}
 
@@ -1244,6 +1279,359 @@ NISortAffixes(IspellDict *Conf)
 	mkVoidAffix(Conf, false, firstsuffix);
 }
 
+/*
+ * Sharing a dictionary through shared memory.
+ *
+ * Once built, a dictionary can be deep-copied into the shared dictionary
+ * area (see tsearch/ts_shared.c), so that other backends using the same
+ * files don't have to build it again.  The copy is done in two passes over
+ * the same code: first with a NULL target, just to measure the space
+ * needed, and then into the space reserved in shared memory.
+ */
+typedef struct
+{
+	char	   *base;			/* target area, or NULL to only measure */
+	Size		used;			/* space consumed so far */
+} NICopyState;
+
+static void *
+copy_alloc(NICopyState *cs, Size size)
+{
+	void	   *res = NULL;
+
+	if (cs->base)
+		res = cs->base + cs->used;
+	cs->used += MAXALIGN(size);
+	return res;
+}
+
+static void *
+copy_mem(NICopyState *cs, const void *src, Size size)
+{
+	void	   *res = copy_alloc(cs, size);
+
+	if (res)
+		memcpy(res, src, size);
+	return res;
+}
+
+static char *
+copy_str(NICopyState *cs, const char *str)
+{
+	return (char *) copy_mem(cs, str, strlen(str) + 1);
+}
+
+static RegisNode *
+copyRegisNode(NICopyState *cs, RegisNode *node)
+{
+	RegisNode  *res;
+	RegisNode  *next;
+
+	if (node == NULL)
+		return NULL;
+
+	res = (RegisNode *) copy_mem(cs, node, RNHDRSZ + node->len + 1);
+	next = copyRegisNode(cs, node->next);
+	if (res)
+		res->next = next;
+	return res;
+}
+
+static SPNode *
+copySPNode(NICopyState *cs, SPNode *node)
+{
+	SPNode	   *res;
+	SPNode	   *child;
+	uint32		i;
+
+	if (node == NULL)
+		return NULL;
+
+	res = (SPNode *) copy_mem(cs, node,
+							  SPNHDRSZ + node->length * sizeof(SPNodeData));
+	for (i = 0; i < node->length; i++)
+	{
+		child = copySPNode(cs, node->data[i].node);
+		if (res)
+			res->data[i].node = child;
+	}
+	return res;
+}
+
+/*
+ * Copy an affix tree.  The AFFIX pointers in it are redirected from the
+ * oldAffix array to the copy at newAffix.
+ */
+static AffixNode *
+copyAffixNode(NICopyState *cs, AffixNode *node,
+			  AFFIX *oldAffix, AFFIX *newAffix)
+{
+	AffixNode  *res;
+	AffixNode  *child;
+	AFFIX	  **aff;
+	uint32		i,
+				j;
+
+	if (node == NULL)
+		return NULL;
+
+	res = (AffixNode *) copy_mem(cs, node,
+							  ANHRDSZ + node->length * sizeof(AffixNodeData));
+	for (i = 0; i < node->length; i++)
+	{
+		AffixNodeData *data = &node->data[i];
+
+		aff = NULL;
+		if (data->naff > 0)
+		{
+			aff = (AFFIX **) copy_alloc(cs, sizeof(AFFIX *) * data->naff);
+			if (aff)
+			{
+				for (j = 0; j < data->naff; j++)
+					aff[j] = newAffix + (data->aff[j] - oldAffix);
+			}
+		}
+		child = copyAffixNode(cs, data->node, oldAffix, newAffix);
+		if (res)
+		{
+			res->data[i].aff = aff;
+			res->data[i].node = child;
+		}
+	}
+	return res;
+}
+
+/*
+ * Copy a finished dictionary, returning the address of the copied header
+ * (NULL when only measuring).
+ */
+static IspellDict *
+copyDict(NICopyState *cs, IspellDict *Conf)
+{
+	IspellDict *res;
+	AFFIX	   *affix;
+	char	  **affixData;
+	CMPDAffix  *compoundAffix = NULL;
+	int			ncompound;
+	int			i;
+
+	res = (IspellDict *) copy_mem(cs, Conf, sizeof(IspellDict));
+
+	affix = (AFFIX *) copy_mem(cs, Conf->Affix,
+							   sizeof(AFFIX) * Conf->naffixes);
+	for (i = 0; i < Conf->naffixes; i++)
+	{
+		AFFIX	   *src = &Conf->Affix[i];
+		char	   *find = copy_str(cs, src->find);
+		char	   *repl = copy_str(cs, src->repl);
+		RegisNode  *regisNode = NULL;
+		pg_wchar   *mask = NULL;
+
+		if (src->isregis)
+			regisNode = copyRegisNode(cs, src->reg.regis.node);
+		else if (!src->issimple)
+			mask = (pg_wchar *) copy_mem(cs, src->reg.re.mask,
+							  sizeof(pg_wchar) * (src->reg.re.masklen + 1));
+
+		if (affix)
+		{
+			affix[i].find = find;
+			affix[i].repl = repl;
+			if (src->isregis)
+				affix[i].reg.regis.node = regisNode;
+			else if (!src->issimple)
+			{
+				affix[i].reg.re.regex = NULL;
+				affix[i].reg.re.mask = mask;
+			}
+		}
+	}
+
+	affixData = (char **) copy_alloc(cs,
+								 sizeof(char *) * (Conf->nAffixData + 1));
+	for (i = 0; i < Conf->nAffixData; i++)
+	{
+		char	   *str = copy_str(cs, Conf->AffixData[i]);
+
+		if (affixData)
+			affixData[i] = str;
+	}
+	if (affixData)
+		affixData[Conf->nAffixData] = NULL;
+
+	if (Conf->CompoundAffix)
+	{
+		for (ncompound = 0; Conf->CompoundAffix[ncompound].affix; ncompound++)
+			;
+		compoundAffix = (CMPDAffix *) copy_mem(cs, Conf->CompoundAffix,
+									sizeof(CMPDAffix) * (ncompound + 1));
+		for (i = 0; i < ncompound; i++)
+		{
+			char	   *str = copy_str(cs, Conf->CompoundAffix[i].affix);
+
+			if (compoundAffix)
+				compoundAffix[i].affix = str;
+		}
+	}
+
+	if (res)
+	{
+		res->maffixes = Conf->naffixes;
+		res->Affix = affix;
+		res->Prefix = copyAffixNode(cs, Conf->Prefix, Conf->Affix, affix);
+		res->Suffix = copyAffixNode(cs, Conf->Suffix, Conf->Affix, affix);
+		res->Dictionary = copySPNode(cs, Conf->Dictionary);
+		res->AffixData = affixData;
+		res->lenAffixData = Conf->nAffixData;
+		res->CompoundAffix = compoundAffix;
+
+		res->isShared = true;
+		res->sharedRegex = NULL;
+		res->dictCxt = NULL;
+		res->buildCxt = NULL;
+		res->Spell = NULL;
+		res->nspell = res->mspell = 0;
+		res->firstfree = NULL;
+		res->avail = 0;
+	}
+	else
+	{
+		copyAffixNode(cs, Conf->Prefix, Conf->Affix, NULL);
+		copyAffixNode(cs, Conf->Suffix, Conf->Affix, NULL);
+		copySPNode(cs, Conf->Dictionary);
+	}
+
+	return res;
+}
+
+static void
+fillSharedDict(void *dest, void *arg)
+{
+	NICopyState cs;
+
+	cs.base = (char *) dest;
+	cs.used = 0;
+	copyDict(&cs, (IspellDict *) arg);
+}
+
+/*
+ * Build the key identifying a dictionary in the shared area.
+ *
+ * Besides the file names, the key includes the files' modification times
+ * and sizes, so that a dictionary whose files have been replaced isn't
+ * confused with the old one.  Returns NULL if the files can't be examined.
+ */
+static char *
+sharedDictKey(const char *dictfile, const char *afffile)
+{
+	struct stat dst;
+	struct stat ast;
+
+	if (stat(dictfile, &dst) != 0 || stat(afffile, &ast) != 0)
+		return NULL;
+
+	return psprintf("ispell\n%s\n%ld %ld\n%s\n%ld %ld",
+					dictfile, (long) dst.st_mtime, (long) dst.st_size,
+					afffile, (long) ast.st_mtime, (long) ast.st_size);
+}
+
+/*
+ * Set up Conf to use a dictionary held in shared memory.
+ */
+static void
+attachSharedDict(IspellDict *Conf, IspellDict *shared)
+{
+	*Conf = *shared;
+	Conf->dictCxt = CurrentMemoryContext;
+	Conf->sharedRegex = (regex_t **)
+		palloc0(sizeof(regex_t *) * Max(Conf->naffixes, 1));
+}
+
+/*
+ * Look for a shared copy of the dictionary built from the given files.
+ *
+ * If one exists, Conf is set up to use it and true is returned; the caller
+ * needn't build the dictionary.  Conf is assumed to be zeroed.  The shared
+ * copy stays referenced on behalf of CurrentMemoryContext, which must be
+ * the dictionary's own, until the dictionary cache releases it.
+ */
+bool
+NIAttachShared(IspellDict *Conf, const char *dictfile, const char *afffile)
+{
+	char	   *key;
+	IspellDict *shared;
+
+	if (!ts_shared_enabled())
+		return false;
+
+	key = sharedDictKey(dictfile, afffile);
+	if (key == NULL)
+		return false;
+
+	shared = (IspellDict *) ts_shared_attach(key);
+	pfree(key);
+
+	if (shared == NULL)
+		return false;
+
+	attachSharedDict(Conf, shared);
+	return true;
+}
+
+/*
+ * Try to move a dictionary that has just been built into shared memory.
+ *
+ * On success, Conf is switched to the shared copy and true is returned; the
+ * caller may then release the memory holding the local copy.  As with
+ * NIAttachShared, the shared copy is referenced on behalf of
+ * CurrentMemoryContext.  If the shared area is disabled or full, Conf is
+ * left alone and false is returned.
+ */
+bool
+NIShare(IspellDict *Conf, const char *dictfile, const char *afffile)
+{
+	char	   *key;
+	NICopyState cs;
+	IspellDict *shared;
+	int			i;
+
+	if (!ts_shared_enabled())
+		return false;
+
+	key = sharedDictKey(dictfile, afffile);
+	if (key == NULL)
+		return false;
+
+	cs.base = NULL;
+	cs.used = 0;
+	copyDict(&cs, Conf);
+
+	shared = (IspellDict *) ts_shared_store(key, cs.used,
+											fillSharedDict, Conf);
+	if (shared == NULL)
+	{
+		ereport(LOG,
+				(errmsg("not enough shared memory to share Ispell dictionary built from \"%s\" and \"%s\"",
+						dictfile, afffile),
+				 errhint("Consider increasing the configuration parameter \"max_shared_dictionaries_size\".")));
+		pfree(key);
+		return false;
+	}
+	pfree(key);
+
+	/* Release the regexes compiled for the local copy */
+	for (i = 0; i < Conf->naffixes; i++)
+	{
+		AFFIX	   *Affix = &Conf->Affix[i];
+
+		if (!Affix->issimple && !Affix->isregis)
+			pg_regfree(Affix->reg.re.regex);
+	}
+
+	attachSharedDict(Conf, shared);
+	return true;
+}
+
 static AffixNodeData *
 FindAffixes(AffixNode *node, const char *word, int wrdlen, int *level, int type)
 {
@@ -1287,8 +1675,38 @@ FindAffixes(AffixNode *node, const char *word, int wrdlen, int *level, int type)
 	return NULL;
 }
 
+/*
+ * Get the compiled regex of a regular expression affix.
+ *
+ * In a dictionary attached from shared memory, it's compiled on first use
+ * and cached in backend-local memory.
+ */
+static regex_t *
+getAffixRegex(IspellDict *Conf, AFFIX *Affix)
+{
+	int			i;
+	MemoryContext oldcxt;
+
+	if (!Conf->isShared)
+		return Affix->reg.re.regex;
+
+	i = Affix - Conf->Affix;
+	Assert(i >= 0 && i < Conf->naffixes);
+
+	if (Conf->sharedRegex[i] == NULL)
+	{
+		oldcxt = MemoryContextSwitchTo(Conf->dictCxt);
+		Conf->sharedRegex[i] = compileAffixRegex(Affix->reg.re.mask,
+												 Affix->reg.re.masklen);
+		MemoryContextSwitchTo(oldcxt);
+	}
+
+	return Conf->sharedRegex[i];
+}
+
 static char *
-CheckAffix(const char *word, size_t len, AFFIX *Affix, int flagflags, char *newword, int *baselen)
+CheckAffix(IspellDict *Conf, const char *word, size_t len, AFFIX *Affix,
+		   int flagflags, char *newword, int *baselen)
 {
 	/*
 	 * Check compound allow flags
@@ -1366,7 +1784,7 @@ CheckAffix(const char *word, size_t len, AFFIX *Affix, int flagflags, char *neww
 		data = (pg_wchar *) palloc((newword_len + 1) * sizeof(pg_wchar));
 		data_len = pg_mb2wchar_with_len(newword, data, newword_len);
 
-		if (!(err = pg_regexec(&(Affix->reg.regex), data, data_len, 0, NULL, 0, NULL, 0)))
+		if (!(err = pg_regexec(getAffixRegex(Conf, Affix), data, data_len, 0, NULL, 0, NULL, 0)))
 		{
 			pfree(data);
 			return newword;
@@ -1434,7 +1852,7 @@ NormalizeSubWord(IspellDict *Conf, char *word, int flag)
 			break;
 		for (j = 0; j < prefix->naff; j++)
 		{
-			if (CheckAffix(word, wrdlen, prefix->aff[j], flag, newword, NULL))
+			if (CheckAffix(Conf, word, wrdlen, prefix->aff[j], flag, newword, NULL))
 			{
 				/* prefix success */
 				if (FindWord(Conf, newword, prefix->aff[j]->flag, flag))
@@ -1459,7 +1877,7 @@ NormalizeSubWord(IspellDict *Conf, char *word, int flag)
 		/* foreach suffix check affix */
 		for (i = 0; i < suffix->naff; i++)
 		{
-			if (CheckAffix(word, wrdlen, suffix->aff[i], flag, newword, &baselen))
+			if (CheckAffix(Conf, word, wrdlen, suffix->aff[i], flag, newword, &baselen))
 			{
 				/* suffix success */
 				if (FindWord(Conf, newword, suffix->aff[i]->flag, flag))
@@ -1476,7 +1894,7 @@ NormalizeSubWord(IspellDict *Conf, char *word, int flag)
 						break;
 					for (j = 0; j < prefix->naff; j++)
 					{
-						if (CheckAffix(newword, swrdlen, prefix->aff[j], flag, pnewword, &baselen))
+						if (CheckAffix(Conf, newword, swrdlen, prefix->aff[j], flag, pnewword, &baselen))
 						{
 							/* prefix success */
 							int			ff = (prefix->aff[j]->flagflags & suffix->aff[i]->flagflags & FF_CROSSPRODUCT) ?
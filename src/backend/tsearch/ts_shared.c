@@ -0,0 +1,559 @@
+/*-------------------------------------------------------------------------
+ *
+ * ts_shared.c
+ *	  Shared memory area for text search dictionaries.
+ *
+ * Loading a large dictionary (Ispell, Hunspell) takes a noticeable amount
+ * of time and memory, and without this every backend that uses it pays
+ * both.  This module provides a fixed-size area in the main shared memory
+ * segment, sized by max_shared_dictionaries_size, into which a dictionary
+ * can be copied once after it has been built and then used by all backends.
+ * Since the main shared memory segment is mapped at the same address in
+ * every backend, data stored here can contain ordinary pointers into itself.
+ *
+ * The area holds a list of entries identified by a string key, each in a
+ * chunk allocated from a first-fit free list.  A backend that uses an entry
+ * holds a reference to it, which is owned by a memory context: the one in
+ * which the dictionary using the entry lives.  The dictionary cache releases
+ * the references of a dictionary when it discards the dictionary, and all of
+ * a backend's references are released when it exits.
+ *
+ * An entry is marked dead when the dictionary using it is altered or dropped
+ * (see ts_shared_invalidate), after which it can no longer be found, and its
+ * chunk is freed as soon as the last reference to it is released.  Entries
+ * that are still alive but not referenced by anyone, for example those of a
+ * dictionary whose files have been replaced, are evicted when space is
+ * needed for a new entry.
+ *
+ * Portions Copyright (c) 1996-2015, PostgreSQL Global Development Group
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/tsearch/ts_shared.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "miscadmin.h"
+#include "storage/ipc.h"
+#include "storage/lwlock.h"
+#include "storage/shmem.h"
+#include "tsearch/ts_shared.h"
+#include "utils/memutils.h"
+
+
+/* GUC variable: size of the shared area, in kilobytes */
+int			max_shared_dictionaries_size = 0;
+
+typedef struct TsSharedEntry
+{
+	struct TsSharedEntry *next; /* next entry in the list, or NULL */
+	Size		size;			/* size of the chunk holding the entry */
+	int			refcount;		/* number of references held by backends */
+	bool		dead;			/* entry can no longer be looked up */
+	char	   *key;			/* NUL-terminated lookup key */
+	void	   *data;			/* the stored object */
+} TsSharedEntry;
+
+typedef struct TsSharedFreeChunk
+{
+	Size		size;			/* size of the chunk, including this header */
+	struct TsSharedFreeChunk *next;		/* next free chunk by address */
+} TsSharedFreeChunk;
+
+typedef struct TsSharedControl
+{
+	Size		size;			/* size of the data area */
+	TsSharedFreeChunk *freelist;	/* free chunks, in address order */
+	TsSharedEntry *entries;		/* stored objects, newest first */
+	char		area[FLEXIBLE_ARRAY_MEMBER];	/* maxaligned data area */
+} TsSharedControl;
+
+#define TsSharedControlHdrSize	MAXALIGN(offsetof(TsSharedControl, area))
+
+/* every chunk must be able to hold a free chunk header once it's freed */
+#define TsSharedMinChunk	MAXALIGN(sizeof(TsSharedEntry))
+
+/*
+ * A reference held by this backend, in a list in TopMemoryContext.  A
+ * backend may hold several references to the same entry.
+ */
+typedef struct TsSharedRef
+{
+	TsSharedEntry *entry;
+	MemoryContext owner;		/* context of the dictionary using it */
+	struct TsSharedRef *next;
+} TsSharedRef;
+
+static TsSharedControl *TsShared = NULL;
+
+static TsSharedRef *MyRefs = NULL;
+static bool RefsExitRegistered = false;
+
+static TsSharedEntry *find_entry(const char *key);
+static void add_ref(TsSharedEntry *entry);
+static void *alloc_chunk(Size *size);
+static void free_chunk(void *ptr, Size size);
+static void remove_entry(TsSharedEntry *entry);
+static void release_refs(MemoryContext owner, bool all);
+static void ts_shared_atexit(int code, Datum arg);
+
+
+/*
+ * TsSharedShmemSize --- report amount of shared memory space needed
+ */
+Size
+TsSharedShmemSize(void)
+{
+	if (max_shared_dictionaries_size <= 0)
+		return 0;
+
+	return add_size(TsSharedControlHdrSize,
+					mul_size(max_shared_dictionaries_size, 1024));
+}
+
+/*
+ * TsSharedShmemInit --- initialize this module's shared memory
+ */
+void
+TsSharedShmemInit(void)
+{
+	Size		size = TsSharedShmemSize();
+	bool		found;
+
+	if (size == 0)
+		return;
+
+	TsShared = (TsSharedControl *)
+		ShmemInitStruct("Text Search Shared Dictionaries", size, &found);
+
+	if (!IsUnderPostmaster)
+	{
+		Assert(!found);
+
+		TsShared->size = size - TsSharedControlHdrSize;
+		TsShared->freelist = (TsSharedFreeChunk *) TsShared->area;
+		TsShared->freelist->size = TsShared->size;
+		TsShared->freelist->next = NULL;
+		TsShared->entries = NULL;
+	}
+	else
+		Assert(found);
+}
+
+/*
+ * Is the shared dictionary area available?
+ */
+bool
+ts_shared_enabled(void)
+{
+	return TsShared != NULL;
+}
+
+/*
+ * Find the object stored under the given key, or return NULL.
+ *
+ * If found, a reference to the object is taken on behalf of the current
+ * memory context, which must be the one the dictionary using the object
+ * lives in.
+ */
+void *
+ts_shared_attach(const char *key)
+{
+	TsSharedEntry *entry;
+	void	   *result = NULL;
+
+	if (TsShared == NULL)
+		return NULL;
+
+	LWLockAcquire(TsSharedDictLock, LW_EXCLUSIVE);
+
+	entry = find_entry(key);
+	if (entry != NULL)
+	{
+		add_ref(entry);
+		result = entry->data;
+	}
+
+	LWLockRelease(TsSharedDictLock);
+
+	return result;
+}
+
+/*
+ * Store an object of the given size under the given key.
+ *
+ * The space is allocated and then filled in by calling fill(dest, arg)
+ * while the area is locked; if fill throws an error, the space is freed
+ * again.  If there isn't enough free space, entries that
+ * no one references are evicted to make room.  Returns the address of the
+ * stored object, or NULL if there still isn't enough space.  If another
+ * backend has stored an object under the same key in the meantime, that
+ * object is returned and fill is not called.
+ *
+ * Like ts_shared_attach, this takes a reference to the returned object on
+ * behalf of the current memory context.
+ */
+void *
+ts_shared_store(const char *key, Size size,
+				ts_shared_fill_callback fill, void *arg)
+{
+	TsSharedEntry *entry;
+	Size		keylen = strlen(key) + 1;
+	Size		needed;
+	Size		chunksize;
+	char	   *ptr;
+	void	   *result = NULL;
+
+	if (TsShared == NULL)
+		return NULL;
+
+	needed = MAXALIGN(sizeof(TsSharedEntry)) + MAXALIGN(keylen) +
+		MAXALIGN(size);
+
+	LWLockAcquire(TsSharedDictLock, LW_EXCLUSIVE);
+
+	entry = find_entry(key);
+	if (entry != NULL)
+	{
+		add_ref(entry);
+		result = entry->data;
+	}
+	else
+	{
+		chunksize = needed;
+		ptr = alloc_chunk(&chunksize);
+
+		/* Evict unreferenced entries, oldest first, until the entry fits */
+		while (ptr == NULL)
+		{
+			TsSharedEntry *victim = NULL;
+
+			for (entry = TsShared->entries; entry != NULL; entry = entry->next)
+			{
+				if (entry->refcount == 0)
+					victim = entry;
+			}
+			if (victim == NULL)
+				break;
+			remove_entry(victim);
+			ptr = alloc_chunk(&chunksize);
+		}
+
+		if (ptr != NULL)
+		{
+			entry = (TsSharedEntry *) ptr;
+			entry->size = chunksize;
+			entry->refcount = 0;
+			entry->dead = false;
+			ptr += MAXALIGN(sizeof(TsSharedEntry));
+			entry->key = ptr;
+			memcpy(entry->key, key, keylen);
+			ptr += MAXALIGN(keylen);
+			entry->data = ptr;
+
+			/* Don't leak the chunk if fill fails */
+			PG_TRY();
+			{
+				fill(entry->data, arg);
+			}
+			PG_CATCH();
+			{
+				free_chunk(entry, chunksize);
+				PG_RE_THROW();
+			}
+			PG_END_TRY();
+
+			/* Make the entry visible only once it is complete */
+			entry->next = TsShared->entries;
+			TsShared->entries = entry;
+
+			add_ref(entry);
+			result = entry->data;
+		}
+	}
+
+	LWLockRelease(TsSharedDictLock);
+
+	return result;
+}
+
+/*
+ * Release the references held on behalf of the given memory context.
+ *
+ * This must be called before the dictionaries living in the context are
+ * discarded, as the objects they use may be freed.
+ */
+void
+ts_shared_release(MemoryContext owner)
+{
+	if (TsShared == NULL || MyRefs == NULL)
+		return;
+
+	release_refs(owner, false);
+}
+
+/*
+ * Mark the objects stored under the keys of those referenced on behalf of
+ * the given memory context dead.
+ *
+ * This is called when the dictionary living in the context has been altered
+ * or dropped.  Entries are marked by key rather than just the ones we
+ * reference, since the entry we got may itself have been invalidated and
+ * replaced by another backend in the meantime.  Other backends go on using
+ * their references until they discard their copies of the dictionary, but
+ * no new references are given out, and the space is freed once the last
+ * reference is released; entries that no one references are freed at once.
+ */
+void
+ts_shared_invalidate(MemoryContext owner)
+{
+	TsSharedRef *ref;
+
+	if (TsShared == NULL || MyRefs == NULL)
+		return;
+
+	LWLockAcquire(TsSharedDictLock, LW_EXCLUSIVE);
+	for (ref = MyRefs; ref != NULL; ref = ref->next)
+	{
+		TsSharedEntry **prev;
+		TsSharedEntry *entry;
+
+		if (ref->owner != owner)
+			continue;
+
+		prev = &TsShared->entries;
+		while ((entry = *prev) != NULL)
+		{
+			if (entry->dead || strcmp(entry->key, ref->entry->key) != 0)
+			{
+				prev = &entry->next;
+				continue;
+			}
+
+			entry->dead = true;
+			if (entry->refcount == 0)
+			{
+				*prev = entry->next;
+				free_chunk(entry, entry->size);
+			}
+			else
+				prev = &entry->next;
+		}
+	}
+	LWLockRelease(TsSharedDictLock);
+}
+
+/*
+ * Report the number of entries in the area, the number of them that are
+ * dead, the number of references held to them, and the number of bytes
+ * allocated.  This is meant for testing.
+ */
+void
+ts_shared_usage(int *nentries, int *ndead, int *nrefs, Size *allocated)
+{
+	TsSharedEntry *entry;
+	TsSharedFreeChunk *chunk;
+
+	*nentries = *ndead = *nrefs = 0;
+	*allocated = 0;
+
+	if (TsShared == NULL)
+		return;
+
+	LWLockAcquire(TsSharedDictLock, LW_SHARED);
+	for (entry = TsShared->entries; entry != NULL; entry = entry->next)
+	{
+		(*nentries)++;
+		if (entry->dead)
+			(*ndead)++;
+		*nrefs += entry->refcount;
+	}
+	*allocated = TsShared->size;
+	for (chunk = TsShared->freelist; chunk != NULL; chunk = chunk->next)
+		*allocated -= chunk->size;
+	LWLockRelease(TsSharedDictLock);
+}
+
+/*
+ * Find the live entry with the given key.  Caller must hold the lock.
+ */
+static TsSharedEntry *
+find_entry(const char *key)
+{
+	TsSharedEntry *entry;
+
+	for (entry = TsShared->entries; entry != NULL; entry = entry->next)
+	{
+		if (!entry->dead && strcmp(entry->key, key) == 0)
+			return entry;
+	}
+	return NULL;
+}
+
+/*
+ * Take a reference to an entry on behalf of CurrentMemoryContext.  Caller
+ * must hold the lock exclusively.
+ *
+ * The local bookkeeping is allocated first, so that running out of memory
+ * can't leave a reference counted that isn't recorded.
+ */
+static void
+add_ref(TsSharedEntry *entry)
+{
+	TsSharedRef *ref;
+
+	if (!RefsExitRegistered)
+	{
+		before_shmem_exit(ts_shared_atexit, 0);
+		RefsExitRegistered = true;
+	}
+
+	ref = (TsSharedRef *) MemoryContextAlloc(TopMemoryContext,
+											 sizeof(TsSharedRef));
+	ref->entry = entry;
+	ref->owner = CurrentMemoryContext;
+	ref->next = MyRefs;
+	MyRefs = ref;
+
+	entry->refcount++;
+}
+
+/*
+ * Release this backend's references owned by the given context, or all of
+ * them.  Entries that are dead and no longer referenced are removed.
+ */
+static void
+release_refs(MemoryContext owner, bool all)
+{
+	TsSharedRef **prev;
+	TsSharedRef *ref;
+
+	LWLockAcquire(TsSharedDictLock, LW_EXCLUSIVE);
+
+	prev = &MyRefs;
+	while ((ref = *prev) != NULL)
+	{
+		if (all || ref->owner == owner)
+		{
+			TsSharedEntry *entry = ref->entry;
+
+			Assert(entry->refcount > 0);
+			entry->refcount--;
+			if (entry->refcount == 0 && entry->dead)
+				remove_entry(entry);
+
+			*prev = ref->next;
+			pfree(ref);
+		}
+		else
+			prev = &ref->next;
+	}
+
+	LWLockRelease(TsSharedDictLock);
+}
+
+/*
+ * Release all references at backend exit.
+ */
+static void
+ts_shared_atexit(int code, Datum arg)
+{
+	if (MyRefs != NULL)
+		release_refs(NULL, true);
+}
+
+/*
+ * Unlink an unreferenced entry from the list and free its chunk.  Caller
+ * must hold the lock exclusively.
+ */
+static void
+remove_entry(TsSharedEntry *entry)
+{
+	TsSharedEntry **prev;
+
+	Assert(entry->refcount == 0);
+
+	for (prev = &TsShared->entries; *prev != entry; prev = &(*prev)->next)
+		Assert(*prev != NULL);
+	*prev = entry->next;
+
+	free_chunk(entry, entry->size);
+}
+
+/*
+ * Allocate a chunk of at least *size bytes, which must be maxaligned, from
+ * the free list.  *size is set to the actual size of the chunk, which the
+ * caller must pass to free_chunk.  Returns NULL if there's no free chunk
+ * large enough.  Caller must hold the lock exclusively.
+ */
+static void *
+alloc_chunk(Size *size)
+{
+	TsSharedFreeChunk **prev;
+	TsSharedFreeChunk *chunk;
+
+	Assert(*size == MAXALIGN(*size) && *size >= TsSharedMinChunk);
+
+	for (prev = &TsShared->freelist; (chunk = *prev) != NULL;
+		 prev = &chunk->next)
+	{
+		if (chunk->size < *size)
+			continue;
+
+		if (chunk->size - *size >= TsSharedMinChunk)
+		{
+			/* Split the chunk, leaving its tail on the free list */
+			TsSharedFreeChunk *rest;
+
+			rest = (TsSharedFreeChunk *) ((char *) chunk + *size);
+			rest->size = chunk->size - *size;
+			rest->next = chunk->next;
+			*prev = rest;
+		}
+		else
+		{
+			/* The remainder would be too small to use; hand out all of it */
+			*prev = chunk->next;
+			*size = chunk->size;
+		}
+		return chunk;
+	}
+
+	return NULL;
+}
+
+/*
+ * Return a chunk to the free list, merging it with adjacent free chunks.
+ * Caller must hold the lock exclusively.
+ */
+static void
+free_chunk(void *ptr, Size size)
+{
+	TsSharedFreeChunk *chunk = (TsSharedFreeChunk *) ptr;
+	TsSharedFreeChunk **prev;
+	TsSharedFreeChunk *before = NULL;
+
+	for (prev = &TsShared->freelist; *prev != NULL && *prev < chunk;
+		 prev = &(*prev)->next)
+		before = *prev;
+
+	chunk->size = size;
+	chunk->next = *prev;
+	*prev = chunk;
+
+	/* Merge with the following chunk, then with the preceding one */
+	if (chunk->next != NULL &&
+		(char *) chunk + chunk->size == (char *) chunk->next)
+	{
+		chunk->size += chunk->next->size;
+		chunk->next = chunk->next->next;
+	}
+	if (before != NULL &&
+		(char *) before + before->size == (char *) chunk)
+	{
+		before->size += chunk->size;
+		before->next = chunk->next;
+	}
+}
@@ -835,6 +835,10 @@ pg_relation_filepath(PG_FUNCTION_ARGS)
 		case RELPERSISTENCE_PERMANENT:
 			backend = InvalidBackendId;
 			break;
+		case RELPERSISTENCE_GLOBAL_TEMP:
+			/* report the file holding this session's contents */
+			backend = MyBackendId;
+			break;
 		case RELPERSISTENCE_TEMP:
 			if (isTempOrTempToastNamespace(relform->relnamespace))
 				backend = MyBackendId;
@@ -0,0 +1,122 @@
+/*-------------------------------------------------------------------------
+ *
+ * mcxtfuncs.c
+ *		Functions to show the memory contexts of the current backend.
+ *
+ * Copyright (c) 2002-2015, PostgreSQL Global Development Group
+ *
+ * IDENTIFICATION
+ *		src/backend/utils/adt/mcxtfuncs.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "funcapi.h"
+#include "miscadmin.h"
+#include "utils/builtins.h"
+#include "utils/memutils.h"
+
+
+#define PG_GET_BACKEND_MEMORY_CONTEXTS_COLS	10
+
+static void PutMemoryContextsStatsTupleStore(Tuplestorestate *tupstore,
+								 TupleDesc tupdesc, MemoryContext context,
+								 int level);
+
+
+/*
+ * PutMemoryContextsStatsTupleStore
+ *		Add one row for the given context, and recurse into its children.
+ */
+static void
+PutMemoryContextsStatsTupleStore(Tuplestorestate *tupstore,
+								 TupleDesc tupdesc, MemoryContext context,
+								 int level)
+{
+	Datum		values[PG_GET_BACKEND_MEMORY_CONTEXTS_COLS];
+	bool		nulls[PG_GET_BACKEND_MEMORY_CONTEXTS_COLS];
+	MemoryContextCounters stat;
+	MemoryContext child;
+
+	AssertArg(MemoryContextIsValid(context));
+
+	/* Examine the context itself */
+	memset(&stat, 0, sizeof(stat));
+	(*context->methods->stats) (context, level, false, &stat);
+
+	memset(values, 0, sizeof(values));
+	memset(nulls, 0, sizeof(nulls));
+
+	values[0] = CStringGetTextDatum(context->name);
+	if (context->parent)
+		values[1] = CStringGetTextDatum(context->parent->name);
+	else
+		nulls[1] = true;
+	values[2] = Int32GetDatum(level);
+	values[3] = Int64GetDatum((int64) stat.totalspace);
+	values[4] = Int64GetDatum((int64) stat.nblocks);
+	values[5] = Int64GetDatum((int64) stat.freespace);
+	values[6] = Int64GetDatum((int64) stat.freechunks);
+	values[7] = Int64GetDatum((int64) (stat.totalspace - stat.freespace));
+	values[8] = Int64GetDatum((int64) context->mem_total);
+	if (context->mem_budget > 0)
+		values[9] = Int64GetDatum((int64) context->mem_budget);
+	else
+		nulls[9] = true;
+
+	tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+
+	for (child = context->firstchild; child != NULL; child = child->nextchild)
+		PutMemoryContextsStatsTupleStore(tupstore, tupdesc, child, level + 1);
+}
+
+/*
+ * pg_get_backend_memory_contexts
+ *		SQL SRF showing the memory contexts of the current backend.
+ *
+ * The rows come out in depth-first order, each context followed by its
+ * descendants.  The tuplestore holding the result lives in a context of the
+ * tree being reported on, so its own memory shows up in the output.
+ */
+Datum
+pg_get_backend_memory_contexts(PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	TupleDesc	tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext per_query_ctx;
+	MemoryContext oldcontext;
+
+	/* check to see if caller supports us returning a tuplestore */
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("set-valued function called in context that cannot accept a set")));
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("materialize mode required, but it is not " \
+						"allowed in this context")));
+
+	/* Build a tuple descriptor for our result type */
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	PutMemoryContextsStatsTupleStore(tupstore, tupdesc, TopMemoryContext, 0);
+
+	/* clean up and return the tuplestore */
+	tuplestore_donestoring(tupstore);
+
+	return (Datum) 0;
+}
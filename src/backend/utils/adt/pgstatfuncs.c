@@ -20,6 +20,8 @@
 #include "libpq/ip.h"
 #include "miscadmin.h"
 #include "pgstat.h"
+#include "storage/predicate.h"
+#include "storage/sinvaladt.h"
 #include "utils/builtins.h"
 #include "utils/inet.h"
 #include "utils/timestamp.h"
@@ -89,6 +91,10 @@ extern Datum pg_stat_get_db_blk_write_time(PG_FUNCTION_ARGS);
 
 extern Datum pg_stat_get_archiver(PG_FUNCTION_ARGS);
 
+extern Datum pg_stat_get_serializable(PG_FUNCTION_ARGS);
+
+extern Datum pg_stat_get_sinval(PG_FUNCTION_ARGS);
+
 extern Datum pg_stat_get_bgwriter_timed_checkpoints(PG_FUNCTION_ARGS);
 extern Datum pg_stat_get_bgwriter_requested_checkpoints(PG_FUNCTION_ARGS);
 extern Datum pg_stat_get_checkpoint_write_time(PG_FUNCTION_ARGS);
@@ -1807,3 +1813,93 @@ pg_stat_get_archiver(PG_FUNCTION_ARGS)
 	PG_RETURN_DATUM(HeapTupleGetDatum(
 								   heap_form_tuple(tupdesc, values, nulls)));
 }
+
+/*
+ * Get the counts of serializable transaction events since server start.
+ *
+ * These are kept in the predicate lock manager's shared memory rather than
+ * by the statistics collector, so they are always current.
+ */
+Datum
+pg_stat_get_serializable(PG_FUNCTION_ARGS)
+{
+	TupleDesc	tupdesc;
+	Datum		values[NUM_SERIALIZABLE_EVENTS];
+	bool		nulls[NUM_SERIALIZABLE_EVENTS];
+	uint64		counts[NUM_SERIALIZABLE_EVENTS];
+	int			i;
+
+	tupdesc = CreateTemplateTupleDesc(NUM_SERIALIZABLE_EVENTS, false);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 1, "pivot_conflict_out",
+					   INT8OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 2, "pivot_conflict_in",
+					   INT8OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 3, "pivot_write",
+					   INT8OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 4, "pivot_commit",
+					   INT8OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 5, "pivot_old_committed",
+					   INT8OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 6, "old_pivot",
+					   INT8OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 7, "pivot_read",
+					   INT8OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 8, "prepared_pivot",
+					   INT8OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 9, "page_promotions",
+					   INT8OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 10, "relation_promotions",
+					   INT8OID, -1, 0);
+
+	BlessTupleDesc(tupdesc);
+
+	GetSerializableStats(counts);
+
+	/* The columns are in the order of the SerializableEvent values */
+	for (i = 0; i < NUM_SERIALIZABLE_EVENTS; i++)
+	{
+		values[i] = Int64GetDatum((int64) counts[i]);
+		nulls[i] = false;
+	}
+
+	PG_RETURN_DATUM(HeapTupleGetDatum(heap_form_tuple(tupdesc, values, nulls)));
+}
+
+/*
+ * Get the size of the shared invalidation queue and the counts of backends
+ * falling behind in reading it since server start.
+ */
+Datum
+pg_stat_get_sinval(PG_FUNCTION_ARGS)
+{
+	TupleDesc	tupdesc;
+	Datum		values[4];
+	bool		nulls[4];
+	int			queueSize;
+	uint64		numResets;
+	uint64		numSummaries;
+	uint64		numCatchupSignals;
+
+	tupdesc = CreateTemplateTupleDesc(4, false);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 1, "queue_size",
+					   INT4OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 2, "resets",
+					   INT8OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 3, "summaries",
+					   INT8OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 4, "catchup_signals",
+					   INT8OID, -1, 0);
+
+	BlessTupleDesc(tupdesc);
+
+	GetSharedInvalidationStats(&queueSize, &numResets, &numSummaries,
+							   &numCatchupSignals);
+
+	values[0] = Int32GetDatum(queueSize);
+	values[1] = Int64GetDatum((int64) numResets);
+	values[2] = Int64GetDatum((int64) numSummaries);
+	values[3] = Int64GetDatum((int64) numCatchupSignals);
+	memset(nulls, 0, sizeof(nulls));
+
+	PG_RETURN_DATUM(HeapTupleGetDatum(heap_form_tuple(tupdesc, values, nulls)));
+}
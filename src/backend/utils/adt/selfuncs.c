@@ -7330,6 +7330,41 @@ gincostestimate(PG_FUNCTION_ARGS)
 	*indexTotalCost = *indexStartupCost +
 		dataPagesFetched * spc_random_page_cost;
 
+	/*
+	 * An ordered scan also reads the posting lists of the entries extracted
+	 * from its ORDER BY operators' arguments, in full, and it collects and
+	 * sorts all the matching items before returning the first one, so
+	 * everything it does is startup cost.
+	 */
+	if (indexOrderBys != NIL)
+	{
+		GinQualCounts orderCounts;
+		double		nItems = numTuples * *indexSelectivity;
+
+		memset(&orderCounts, 0, sizeof(orderCounts));
+		foreach(l, indexOrderBys)
+		{
+			Expr	   *clause = (Expr *) lfirst(l);
+
+			/* the result doesn't matter; ORDER BY entries never restrict */
+			if (IsA(clause, OpExpr))
+				(void) gincost_opexpr(root, index, (OpExpr *) clause,
+									  &orderCounts);
+		}
+
+		entryPagesFetched = ceil(orderCounts.searchEntries *
+								 rint(pow(numEntryPages, 0.15)));
+		dataPagesFetched = ceil(numDataPages * orderCounts.exactEntries /
+								numEntries);
+		*indexTotalCost += (entryPagesFetched + dataPagesFetched) *
+			spc_random_page_cost;
+
+		/* comparisons made by the sort, costed as in cost_sort */
+		if (nItems > 1)
+			*indexTotalCost += 2.0 * cpu_operator_cost *
+				nItems * (log(nItems) / log(2.0));
+	}
+
 	/*
 	 * Add on index qual eval costs, much as in genericcostestimate
 	 */
@@ -7346,6 +7381,8 @@ gincostestimate(PG_FUNCTION_ARGS)
 	*indexStartupCost += qual_arg_cost;
 	*indexTotalCost += qual_arg_cost;
 	*indexTotalCost += (numTuples * *indexSelectivity) * (cpu_index_tuple_cost + qual_op_cost);
+	if (indexOrderBys != NIL)
+		*indexStartupCost = *indexTotalCost;
 
 	PG_RETURN_VOID();
 }
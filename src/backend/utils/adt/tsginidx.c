@@ -1,7 +1,7 @@
 /*-------------------------------------------------------------------------
  *
  * tsginidx.c
- *	 GIN support functions for tsvector_ops
+ *	 GIN support functions for tsvector_ops and tsvector_rank_ops
  *
  * Portions Copyright (c) 1996-2015, PostgreSQL Global Development Group
  *
@@ -377,3 +377,322 @@ gin_tsquery_consistent_6args(PG_FUNCTION_ARGS)
 		elog(ERROR, "gin_tsquery_consistent requires eight arguments");
 	return gin_tsquery_consistent(fcinfo);
 }
+
+
+/*
+ * tsvector_rank_ops
+ *
+ * This opclass supports the same operators as tsvector_ops, and also
+ * tsvector <=> tsquery as an ordering operator, so that an index scan can
+ * return the best-ranked documents first.  The key of each lexeme is the
+ * lexeme followed by a zero byte and a code summarizing its positions (see
+ * ts_lexeme_rank_summary), which is all the ordering function gets to see.
+ * A query lexeme is looked up as a single partial-match entry, the lexeme
+ * followed by the zero byte, which matches the keys of all its codes; in an
+ * ordered scan, GIN tells the ordering function which key matched, and so
+ * the lexeme's summary.  A prefix operand is a partial-match entry without
+ * the zero byte, matching the keys of all the lexemes it's a prefix of;
+ * prefix operands don't affect the rank.
+ */
+
+/*
+ * Make the key of a lexeme with the given summary code, or with code -1, the
+ * query key that matches the keys of all the lexeme's codes
+ */
+static text *
+make_rank_key(char *lexeme, int len, int code)
+{
+	int			keylen = (code >= 0) ? len + 2 : len + 1;
+	text	   *txt = (text *) palloc(VARHDRSZ + keylen);
+
+	SET_VARSIZE(txt, VARHDRSZ + keylen);
+	memcpy(VARDATA(txt), lexeme, len);
+	VARDATA(txt)[len] = '\0';
+	if (code >= 0)
+		VARDATA(txt)[len + 1] = 'A' + code;
+
+	return txt;
+}
+
+/*
+ * Shared by all the entries extracted from a tsquery
+ */
+typedef struct
+{
+	int		   *operand_entry;	/* entry of each VAL item's operand, or -1 */
+	int			nterms;			/* number of lexemes that count for rank */
+} GinRankQueryInfo;
+
+Datum
+gin_extract_tsvector_rank(PG_FUNCTION_ARGS)
+{
+	TSVector	vector = PG_GETARG_TSVECTOR(0);
+	int32	   *nentries = (int32 *) PG_GETARG_POINTER(1);
+	Datum	   *entries = NULL;
+
+	*nentries = vector->size;
+	if (vector->size > 0)
+	{
+		int			i;
+		WordEntry  *we = ARRPTR(vector);
+
+		entries = (Datum *) palloc(sizeof(Datum) * vector->size);
+
+		for (i = 0; i < vector->size; i++)
+		{
+			entries[i] = PointerGetDatum(make_rank_key(STRPTR(vector) + we->pos,
+													   we->len,
+									   ts_lexeme_rank_summary(vector, we)));
+			we++;
+		}
+	}
+
+	PG_FREE_IF_COPY(vector, 0);
+	PG_RETURN_POINTER(entries);
+}
+
+Datum
+gin_extract_tsquery_rank(PG_FUNCTION_ARGS)
+{
+	TSQuery		query = PG_GETARG_TSQUERY(0);
+	int32	   *nentries = (int32 *) PG_GETARG_POINTER(1);
+	StrategyNumber strategy = PG_GETARG_UINT16(2);
+	bool	  **ptr_partialmatch = (bool **) PG_GETARG_POINTER(3);
+	Pointer   **extra_data = (Pointer **) PG_GETARG_POINTER(4);
+
+	/* bool   **nullFlags = (bool **) PG_GETARG_POINTER(5); */
+	int32	   *searchMode = (int32 *) PG_GETARG_POINTER(6);
+	Datum	   *entries = NULL;
+
+	*nentries = 0;
+
+	if (query->size > 0)
+	{
+		QueryItem  *item = GETQUERY(query);
+		GinRankQueryInfo *info;
+		bool	   *partialmatch;
+		int32		i,
+					j,
+					k;
+
+		/* See gin_extract_tsquery */
+		if (tsquery_requires_match(item))
+			*searchMode = GIN_SEARCH_MODE_DEFAULT;
+		else
+			*searchMode = GIN_SEARCH_MODE_ALL;
+
+		/* count number of VAL items, to size the arrays */
+		j = 0;
+		for (i = 0; i < query->size; i++)
+		{
+			if (item[i].type == QI_VAL)
+				j++;
+		}
+
+		entries = (Datum *) palloc(sizeof(Datum) * j);
+		partialmatch = *ptr_partialmatch = (bool *) palloc(sizeof(bool) * j);
+		*extra_data = (Pointer *) palloc(sizeof(Pointer) * j);
+
+		info = (GinRankQueryInfo *) palloc(sizeof(GinRankQueryInfo));
+		info->operand_entry = (int *) palloc(sizeof(int) * query->size);
+		info->nterms = 0;
+
+		/* Now rescan the VAL items and fill in the arrays */
+		j = 0;
+		for (i = 0; i < query->size; i++)
+		{
+			QueryOperand *val = &item[i].qoperand;
+			char	   *lexeme = GETOPERAND(query) + val->distance;
+
+			info->operand_entry[i] = -1;
+			if (item[i].type != QI_VAL)
+				continue;
+
+			/* reuse the entry of an earlier occurrence of the operand */
+			for (k = 0; k < i; k++)
+			{
+				if (item[k].type == QI_VAL &&
+					item[k].qoperand.prefix == val->prefix &&
+					tsCompareString(GETOPERAND(query) + item[k].qoperand.distance,
+									item[k].qoperand.length,
+									lexeme, val->length, false) == 0)
+					break;
+			}
+			if (k < i)
+			{
+				info->operand_entry[i] = info->operand_entry[k];
+				continue;
+			}
+
+			if (val->prefix)
+			{
+				/* prefix operands don't affect the rank */
+				if (strategy == TSearchRankStrategyNumber)
+					continue;
+
+				entries[j] = PointerGetDatum(cstring_to_text_with_len(lexeme,
+															val->length));
+			}
+			else
+			{
+				entries[j] = PointerGetDatum(make_rank_key(lexeme,
+														   val->length,
+														   -1));
+				info->nterms++;
+			}
+
+			/* both kinds of entries match a range of keys */
+			partialmatch[j] = true;
+			(*extra_data)[j] = (Pointer) info;
+			info->operand_entry[i] = j;
+			j++;
+		}
+
+		*nentries = j;
+	}
+
+	PG_FREE_IF_COPY(query, 0);
+
+	PG_RETURN_POINTER(entries);
+}
+
+typedef struct
+{
+	QueryItem  *first_item;
+	GinTernaryValue *check;
+	GinRankQueryInfo *info;
+	bool	   *need_recheck;
+} GinRankChkVal;
+
+static GinTernaryValue
+checkcondition_gin_rank(void *checkval, QueryOperand *val)
+{
+	GinRankChkVal *gcv = (GinRankChkVal *) checkval;
+	int			j;
+
+	/* if any val requiring a weight is used, set recheck flag */
+	if (val->weight != 0)
+		*(gcv->need_recheck) = true;
+
+	/* convert item's number to corresponding entry's number */
+	j = gcv->info->operand_entry[((QueryItem *) val) - gcv->first_item];
+	if (j < 0)
+		return GIN_FALSE;
+
+	/* return presence of current entry in indexed value */
+	return gcv->check[j];
+}
+
+Datum
+gin_tsquery_rank_consistent(PG_FUNCTION_ARGS)
+{
+	bool	   *check = (bool *) PG_GETARG_POINTER(0);
+
+	/* StrategyNumber strategy = PG_GETARG_UINT16(1); */
+	TSQuery		query = PG_GETARG_TSQUERY(2);
+	int32		nkeys = PG_GETARG_INT32(3);
+	Pointer    *extra_data = (Pointer *) PG_GETARG_POINTER(4);
+	bool	   *recheck = (bool *) PG_GETARG_POINTER(5);
+	bool		res = FALSE;
+
+	/* The query requires recheck only if it involves weights */
+	*recheck = false;
+
+	if (query->size > 0 && nkeys > 0)
+	{
+		GinRankChkVal gcv;
+
+		gcv.first_item = GETQUERY(query);
+		gcv.check = check;
+		gcv.info = (GinRankQueryInfo *) extra_data[0];
+		gcv.need_recheck = recheck;
+
+		res = TS_execute(GETQUERY(query),
+						 &gcv,
+						 true,
+						 checkcondition_gin_rank);
+	}
+
+	PG_RETURN_BOOL(res);
+}
+
+Datum
+gin_tsquery_rank_triconsistent(PG_FUNCTION_ARGS)
+{
+	GinTernaryValue *check = (GinTernaryValue *) PG_GETARG_POINTER(0);
+
+	/* StrategyNumber strategy = PG_GETARG_UINT16(1); */
+	TSQuery		query = PG_GETARG_TSQUERY(2);
+	int32		nkeys = PG_GETARG_INT32(3);
+	Pointer    *extra_data = (Pointer *) PG_GETARG_POINTER(4);
+	GinTernaryValue res = GIN_FALSE;
+	bool		recheck;
+
+	/* The query requires recheck only if it involves weights */
+	recheck = false;
+
+	if (query->size > 0 && nkeys > 0)
+	{
+		GinRankChkVal gcv;
+
+		gcv.first_item = GETQUERY(query);
+		gcv.check = check;
+		gcv.info = (GinRankQueryInfo *) extra_data[0];
+		gcv.need_recheck = &recheck;
+
+		res = TS_execute_ternary(GETQUERY(query),
+								 &gcv,
+								 checkcondition_gin_rank);
+
+		if (res == GIN_TRUE && recheck)
+			res = GIN_MAYBE;
+	}
+
+	PG_RETURN_GIN_TERNARY_VALUE(res);
+}
+
+/*
+ * Distance of an item for tsvector <=> tsquery, from the entries found in it
+ *
+ * Each entry is a query lexeme, and GIN passes the key it matched in
+ * queryKeys[], which ends with the lexeme's summary code.
+ */
+Datum
+gin_tsquery_rank_ordering(PG_FUNCTION_ARGS)
+{
+	bool	   *check = (bool *) PG_GETARG_POINTER(0);
+
+	/* StrategyNumber strategy = PG_GETARG_UINT16(1); */
+	/* TSQuery		query = PG_GETARG_TSQUERY(2); */
+	int32		nkeys = PG_GETARG_INT32(3);
+	Pointer    *extra_data = (Pointer *) PG_GETARG_POINTER(4);
+	Datum	   *queryKeys = (Datum *) PG_GETARG_POINTER(5);
+	int			counts[TS_RANK_SUMMARY_CODES];
+	int			nterms = 0;
+	int			j;
+
+	memset(counts, 0, sizeof(counts));
+
+	if (nkeys > 0)
+	{
+		GinRankQueryInfo *info = (GinRankQueryInfo *) extra_data[0];
+
+		for (j = 0; j < nkeys; j++)
+		{
+			text	   *key;
+			int			code;
+
+			if (!check[j])
+				continue;
+
+			key = DatumGetTextPP(queryKeys[j]);
+			code = VARDATA_ANY(key)[VARSIZE_ANY_EXHDR(key) - 1] - 'A';
+			if (code < 0 || code >= TS_RANK_SUMMARY_CODES)
+				elog(ERROR, "invalid tsvector_rank_ops key");
+			counts[code]++;
+		}
+		nterms = info->nterms;
+	}
+
+	PG_RETURN_FLOAT8((float8) (1.0f - ts_rank_from_summaries(counts, nterms)));
+}
@@ -487,6 +487,132 @@ ts_rank_tt(PG_FUNCTION_ARGS)
 	PG_RETURN_FLOAT4(res);
 }
 
+/*
+ * Rank estimate used by the tsvector_rank_ops GIN opclass.
+ *
+ * An index key can't hold the positions of a lexeme, only a summary of
+ * them: the highest weight among the positions, and a bucket for their
+ * number (1, 2, 3-4, 5-8, 9 or more).  The rank is computed from those
+ * summaries alone, like calc_rank_or with the default weights, assuming
+ * that every occurrence has the highest weight and that the number of
+ * occurrences is the lower bound of its bucket.  Prefix operands don't
+ * contribute.  ts_rank_distance computes the same value from a tsvector, so
+ * that an index scan returns rows in the order of the <=> operator.
+ */
+static const int rank_bucket_lower[] = {1, 2, 3, 5, 9};
+
+#define RANK_NBUCKETS	lengthof(rank_bucket_lower)
+
+/*
+ * Summary code, between 0 and TS_RANK_SUMMARY_CODES - 1, of the positions of
+ * a tsvector entry
+ */
+int
+ts_lexeme_rank_summary(TSVector t, WordEntry *entry)
+{
+	int			npos = 1;
+	int			weight = 0;
+	int			bucket;
+
+	if (entry->haspos)
+	{
+		WordEntryPos *post = POSDATAPTR(t, entry);
+		int			j;
+
+		npos = POSDATALEN(t, entry);
+		for (j = 0; j < npos; j++)
+			weight = Max(weight, WEP_GETWEIGHT(post[j]));
+	}
+
+	for (bucket = RANK_NBUCKETS - 1; bucket > 0; bucket--)
+	{
+		if (npos >= rank_bucket_lower[bucket])
+			break;
+	}
+
+	return weight * RANK_NBUCKETS + bucket;
+}
+
+/*
+ * Rank of a document given the number of matched query lexemes having each
+ * summary code (counts[]), and the number of lexemes in the query
+ */
+float4
+ts_rank_from_summaries(const int *counts, int nterms)
+{
+	float		res = 0.0;
+	int			code;
+
+	if (nterms <= 0)
+		return 0.0;
+
+	for (code = 0; code < TS_RANK_SUMMARY_CODES; code++)
+	{
+		float		resj = 0.0;
+		int			j;
+
+		if (counts[code] == 0)
+			continue;
+
+		for (j = 1; j <= rank_bucket_lower[code % RANK_NBUCKETS]; j++)
+			resj += weights[code / RANK_NBUCKETS] / (j * j);
+
+		res += counts[code] * resj / 1.64493406685;
+	}
+
+	return res / nterms;
+}
+
+/*
+ * tsvector <=> tsquery: one minus the rank estimate described above
+ */
+Datum
+ts_rank_distance(PG_FUNCTION_ARGS)
+{
+	TSVector	txt = PG_GETARG_TSVECTOR(0);
+	TSQuery		query = PG_GETARG_TSQUERY(1);
+	QueryItem  *item = GETQUERY(query);
+	int			counts[TS_RANK_SUMMARY_CODES];
+	int			nterms = 0;
+	int			i,
+				k;
+
+	memset(counts, 0, sizeof(counts));
+
+	for (i = 0; i < query->size; i++)
+	{
+		QueryOperand *val = &item[i].qoperand;
+		WordEntry  *entry;
+		int32		nitem;
+
+		if (item[i].type != QI_VAL || val->prefix)
+			continue;
+
+		/* count each lexeme only once */
+		for (k = 0; k < i; k++)
+		{
+			if (item[k].type == QI_VAL && !item[k].qoperand.prefix &&
+				tsCompareString(GETOPERAND(query) + item[k].qoperand.distance,
+								item[k].qoperand.length,
+								GETOPERAND(query) + val->distance,
+								val->length, false) == 0)
+				break;
+		}
+		if (k < i)
+			continue;
+
+		nterms++;
+
+		entry = find_wordentry(txt, query, val, &nitem);
+		if (entry)
+			counts[ts_lexeme_rank_summary(txt, entry)]++;
+	}
+
+	PG_FREE_IF_COPY(txt, 0);
+	PG_FREE_IF_COPY(query, 1);
+	PG_RETURN_FLOAT4(1.0f - ts_rank_from_summaries(counts, nterms));
+}
+
 typedef struct
 {
 	QueryItem **item;
@@ -701,6 +701,36 @@ CatalogCacheFlushCatalog(Oid catId)
 	CACHE1_elog(DEBUG2, "end of CatalogCacheFlushCatalog call");
 }
 
+/*
+ *		CatalogCacheFlushCacheId
+ *
+ *	Flush all catcache entries of the cache with the given ID.
+ *
+ *	This is used when applying a summary of shared invalidation messages,
+ *	which only records which caches had entries invalidated.
+ */
+void
+CatalogCacheFlushCacheId(int cacheId)
+{
+	slist_iter	iter;
+
+	CACHE2_elog(DEBUG2, "CatalogCacheFlushCacheId called for %d", cacheId);
+
+	slist_foreach(iter, &CacheHdr->ch_caches)
+	{
+		CatCache   *cache = slist_container(CatCache, cc_next, iter.cur);
+
+		if (cache->id == cacheId)
+		{
+			ResetCatalogCache(cache);
+
+			/* Tell inval.c to call syscache callbacks for this cache */
+			CallSyscacheCallbacks(cache->id, 0);
+			break;
+		}
+	}
+}
+
 /*
  *		InitCatCache
  *
@@ -606,6 +606,59 @@ LocalExecuteInvalidationMessage(SharedInvalidationMessage *msg)
 		elog(FATAL, "unrecognized SI message ID: %d", msg->id);
 }
 
+/*
+ * LocalExecuteInvalidationSummary
+ *		Process a summary of shared invalidation messages that this backend
+ *		was too slow to read one at a time.
+ *
+ * The catcaches are flushed first, so that any relcache entries rebuilt
+ * afterwards don't pick up stale catalog data.
+ */
+static void
+LocalExecuteInvalidationSummary(SharedInvalSummary *summary)
+{
+	int			cacheId;
+	int			i;
+
+	InvalidateCatalogSnapshot();
+
+	for (cacheId = 0; cacheId < SINVAL_SUMMARY_CACHE_WORDS * 32; cacheId++)
+	{
+		if (summary->catcaches[cacheId / 32] & (((uint32) 1) << (cacheId % 32)))
+			CatalogCacheFlushCacheId(cacheId);
+	}
+
+	/* Catalog flush, relmap and snapshot messages */
+	for (i = 0; i < summary->nmsgs; i++)
+	{
+		if (summary->msgs[i].id != SHAREDINVALRELCACHE_ID)
+			LocalExecuteInvalidationMessage(&summary->msgs[i]);
+	}
+
+	if (summary->smgrAll)
+		smgrcloseall();
+
+	if (summary->relcacheAll)
+	{
+		RelationCacheInvalidate();
+
+		for (i = 0; i < relcache_callback_count; i++)
+		{
+			struct RELCACHECALLBACK *ccitem = relcache_callback_list + i;
+
+			(*ccitem->function) (ccitem->arg, InvalidOid);
+		}
+	}
+	else
+	{
+		for (i = 0; i < summary->nmsgs; i++)
+		{
+			if (summary->msgs[i].id == SHAREDINVALRELCACHE_ID)
+				LocalExecuteInvalidationMessage(&summary->msgs[i]);
+		}
+	}
+}
+
 /*
  *		InvalidateSystemCaches
  *
@@ -659,6 +712,7 @@ void
 AcceptInvalidationMessages(void)
 {
 	ReceiveSharedInvalidMessages(LocalExecuteInvalidationMessage,
+								 LocalExecuteInvalidationSummary,
 								 InvalidateSystemCaches);
 
 	/*
@@ -996,6 +996,11 @@ RelationBuildDesc(Oid targetRelId, bool insertIt)
 			relation->rd_backend = InvalidBackendId;
 			relation->rd_islocaltemp = false;
 			break;
+		case RELPERSISTENCE_GLOBAL_TEMP:
+			/* every session accesses its own private storage */
+			relation->rd_backend = MyBackendId;
+			relation->rd_islocaltemp = false;
+			break;
 		case RELPERSISTENCE_TEMP:
 			if (isTempOrTempToastNamespace(relation->rd_rel->relnamespace))
 			{
@@ -2920,6 +2925,10 @@ RelationBuildLocalRelation(const char *relname,
 			rel->rd_backend = InvalidBackendId;
 			rel->rd_islocaltemp = false;
 			break;
+		case RELPERSISTENCE_GLOBAL_TEMP:
+			rel->rd_backend = MyBackendId;
+			rel->rd_islocaltemp = false;
+			break;
 		case RELPERSISTENCE_TEMP:
 			Assert(isTempOrTempToastNamespace(relnamespace));
 			rel->rd_backend = MyBackendId;
@@ -3042,6 +3051,14 @@ RelationSetNewRelfilenode(Relation relation, char persistence,
 		   TransactionIdIsNormal(freezeXid));
 	Assert(TransactionIdIsNormal(freezeXid) == MultiXactIdIsValid(minmulti));
 
+	/*
+	 * The relfilenode of a global temporary relation is shared by the
+	 * private storage of every session, so it can never be changed.
+	 */
+	if (RELATION_IS_GLOBAL_TEMP(relation))
+		elog(ERROR, "cannot assign a new relfilenode to global temporary relation \"%s\"",
+			 RelationGetRelationName(relation));
+
 	/* Allocate a new relfilenode */
 	newrelfilenode = GetNewRelFileNode(relation->rd_rel->reltablespace, NULL,
 									   persistence);
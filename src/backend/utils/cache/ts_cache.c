@@ -39,6 +39,7 @@
 #include "catalog/pg_ts_template.h"
 #include "commands/defrem.h"
 #include "tsearch/ts_cache.h"
+#include "tsearch/ts_shared.h"
 #include "utils/builtins.h"
 #include "utils/catcache.h"
 #include "utils/fmgroids.h"
@@ -104,6 +105,34 @@ InvalidateTSCacheCallBack(Datum arg, int cacheid, uint32 hashvalue)
 		TSCurrentConfigCache = InvalidOid;
 }
 
+/*
+ * Syscache callback for the dictionary cache.
+ *
+ * Besides flushing all entries like InvalidateTSCacheCallBack, this tells
+ * ts_shared.c that a dictionary has been altered or dropped, so that the
+ * shared copies of its data it uses are discarded once no one uses them
+ * anymore.  We can't release our own references to them here, since the
+ * dictionary might be in use; that happens when the entry is rebuilt or, if
+ * the dictionary is gone, when some other entry is.
+ */
+static void
+InvalidateTSDictionaryCacheCallBack(Datum arg, int cacheid, uint32 hashvalue)
+{
+	HASH_SEQ_STATUS status;
+	TSDictionaryCacheEntry *entry;
+
+	hash_seq_init(&status, TSDictionaryCacheHash);
+	while ((entry = (TSDictionaryCacheEntry *) hash_seq_search(&status)) != NULL)
+	{
+		entry->isvalid = false;
+
+		if (cacheid == TSDICTOID && hashvalue != 0 &&
+			GetSysCacheHashValue1(TSDICTOID,
+								  ObjectIdGetDatum(entry->dictId)) == hashvalue)
+			ts_shared_invalidate(entry->dictCtx);
+	}
+}
+
 /*
  * Fetch parser cache entry
  */
@@ -221,10 +250,12 @@ lookup_ts_dictionary_cache(Oid dictId)
 		TSDictionaryCacheHash = hash_create("Tsearch dictionary cache", 8,
 											&ctl, HASH_ELEM | HASH_BLOBS);
 		/* Flush cache on pg_ts_dict and pg_ts_template changes */
-		CacheRegisterSyscacheCallback(TSDICTOID, InvalidateTSCacheCallBack,
-									  PointerGetDatum(TSDictionaryCacheHash));
-		CacheRegisterSyscacheCallback(TSTEMPLATEOID, InvalidateTSCacheCallBack,
-									  PointerGetDatum(TSDictionaryCacheHash));
+		CacheRegisterSyscacheCallback(TSDICTOID,
+									  InvalidateTSDictionaryCacheCallBack,
+									  (Datum) 0);
+		CacheRegisterSyscacheCallback(TSTEMPLATEOID,
+									  InvalidateTSDictionaryCacheCallBack,
+									  (Datum) 0);
 
 		/* Also make sure CacheMemoryContext exists */
 		if (!CacheMemoryContext)
@@ -251,6 +282,20 @@ lookup_ts_dictionary_cache(Oid dictId)
 		Form_pg_ts_dict dict;
 		Form_pg_ts_template template;
 		MemoryContext saveCtx;
+		HASH_SEQ_STATUS status;
+		TSDictionaryCacheEntry *other;
+
+		/*
+		 * Release the shared dictionary data used by all invalid entries,
+		 * including this one: those of dropped dictionaries would otherwise
+		 * never be rebuilt, and so never release theirs.
+		 */
+		hash_seq_init(&status, TSDictionaryCacheHash);
+		while ((other = (TSDictionaryCacheEntry *) hash_seq_search(&status)) != NULL)
+		{
+			if (!other->isvalid)
+				ts_shared_release(other->dictCtx);
+		}
 
 		tpdict = SearchSysCache1(TSDICTOID, ObjectIdGetDatum(dictId));
 		if (!HeapTupleIsValid(tpdict))
@@ -15,7 +15,8 @@
  * to hash_create.  This prevents any attempt to split buckets on-the-fly.
  * Therefore, each hash bucket chain operates independently, and no fields
  * of the hash header change after init except nentries and freeList.
- * A partitioned table uses a spinlock to guard changes of those two fields.
+ * (A partitioned table uses multiple copies of those fields, guarded by
+ * spinlocks, for additional concurrency.)
  * This lets any subset of the hash buckets be treated as a separately
  * lockable partition.  We expect callers to use the low-order bits of a
  * lookup key's hash value as a partition number --- this will work because
@@ -112,12 +113,39 @@
 #define DEF_FFACTOR			   1	/* default fill factor */
 
 
+/* Number of freelists to be used for a partitioned hash table. */
+#define NUM_FREELISTS			32
+
 /* A hash bucket is a linked list of HASHELEMENTs */
 typedef HASHELEMENT *HASHBUCKET;
 
 /* A hash segment is an array of bucket headers */
 typedef HASHBUCKET *HASHSEGMENT;
 
+/*
+ * Per-freelist data.
+ *
+ * In a partitioned hash table, each freelist is associated with a specific
+ * set of hashcodes, as determined by the FREELIST_IDX() macro below.
+ * nentries tracks the number of live hashtable entries having those hashcodes
+ * (NOT the number of entries in the freelist, as you might expect).
+ *
+ * The coverage of a freelist might be more or less than one partition, so it
+ * needs its own lock rather than relying on caller locking.  Relying on that
+ * wouldn't work even if the coverage was the same, because of the occasional
+ * need to "borrow" entries from another freelist; see get_hash_entry().
+ *
+ * Using an array of FreeListData instead of separate arrays of mutexes,
+ * nentries and freeLists helps to reduce sharing of cache lines between
+ * different mutexes.
+ */
+typedef struct
+{
+	slock_t		mutex;			/* spinlock for this freelist */
+	long		nentries;		/* number of entries in associated buckets */
+	HASHELEMENT *freeList;		/* chain of free elements */
+} FreeListData;
+
 /*
  * Header structure for a hash table --- contains all changeable info
  *
@@ -128,12 +156,17 @@ typedef HASHBUCKET *HASHSEGMENT;
  */
 struct HASHHDR
 {
-	/* In a partitioned table, take this lock to touch nentries or freeList */
-	slock_t		mutex;			/* unused if not partitioned table */
-
-	/* These fields change during entry addition/deletion */
-	long		nentries;		/* number of entries in hash table */
-	HASHELEMENT *freeList;		/* linked list of free elements */
+	/*
+	 * The freelist can become a point of contention in high-concurrency hash
+	 * tables, so we use an array of freelists, each with its own mutex and
+	 * nentries count, instead of just a single one.  Although the freelists
+	 * normally operate independently, we will scavenge entries from freelists
+	 * other than a hashcode's default freelist when necessary.
+	 *
+	 * If the hash table is not partitioned, only freeList[0] is used and its
+	 * spinlock is not used at all; callers' locking is assumed sufficient.
+	 */
+	FreeListData freeList[NUM_FREELISTS];
 
 	/* These fields can change, but not in a partitioned table */
 	/* Also, dsize can't change in a shared table, even if unpartitioned */
@@ -166,6 +199,9 @@ struct HASHHDR
 
 #define IS_PARTITIONED(hctl)  ((hctl)->num_partitions != 0)
 
+#define FREELIST_IDX(hctl, hashcode) \
+	(IS_PARTITIONED(hctl) ? (hashcode) % NUM_FREELISTS : 0)
+
 /*
  * Top control structure for a hashtable --- in a shared table, each backend
  * has its own copy (OK since no fields change at runtime)
@@ -219,10 +255,10 @@ static long hash_accesses,
  */
 static void *DynaHashAlloc(Size size);
 static HASHSEGMENT seg_alloc(HTAB *hashp);
-static bool element_alloc(HTAB *hashp, int nelem);
+static bool element_alloc(HTAB *hashp, int nelem, int freelist_idx);
 static bool dir_realloc(HTAB *hashp);
 static bool expand_table(HTAB *hashp);
-static HASHBUCKET get_hash_entry(HTAB *hashp);
+static HASHBUCKET get_hash_entry(HTAB *hashp, int freelist_idx);
 static void hdefault(HTAB *hashp);
 static int	choose_nelem_alloc(Size entrysize);
 static bool init_htab(HTAB *hashp, long nelem);
@@ -390,6 +426,10 @@ hash_create(const char *tabname, long nelem, HASHCTL *info, int flags)
 			hashp->ssize = hctl->ssize;
 			hashp->sshift = hctl->sshift;
 
+			/* the size limit isn't kept in the shared header */
+			if (flags & HASH_FIXED_SIZE)
+				hashp->isfixed = true;
+
 			return hashp;
 		}
 	}
@@ -482,10 +522,43 @@ hash_create(const char *tabname, long nelem, HASHCTL *info, int flags)
 	if ((flags & HASH_SHARED_MEM) ||
 		nelem < hctl->nelem_alloc)
 	{
-		if (!element_alloc(hashp, (int) nelem))
-			ereport(ERROR,
-					(errcode(ERRCODE_OUT_OF_MEMORY),
-					 errmsg("out of memory")));
+		int			i,
+					freelist_partitions,
+					nelem_alloc,
+					nelem_alloc_first;
+
+		/*
+		 * If hash table is partitioned, give each freelist an equal share of
+		 * the initial allocation.  Otherwise only freeList[0] is used.
+		 */
+		if (IS_PARTITIONED(hashp->hctl))
+			freelist_partitions = NUM_FREELISTS;
+		else
+			freelist_partitions = 1;
+
+		nelem_alloc = nelem / freelist_partitions;
+		if (nelem_alloc <= 0)
+			nelem_alloc = 1;
+
+		/*
+		 * Make sure we'll allocate all the requested elements; freeList[0]
+		 * gets the excess if the request isn't divisible by NUM_FREELISTS.
+		 */
+		if (nelem_alloc * freelist_partitions < nelem)
+			nelem_alloc_first =
+				nelem - nelem_alloc * (freelist_partitions - 1);
+		else
+			nelem_alloc_first = nelem_alloc;
+
+		for (i = 0; i < freelist_partitions; i++)
+		{
+			int			temp = (i == 0) ? nelem_alloc_first : nelem_alloc;
+
+			if (!element_alloc(hashp, temp, i))
+				ereport(ERROR,
+						(errcode(ERRCODE_OUT_OF_MEMORY),
+						 errmsg("out of memory")));
+		}
 	}
 
 	if (flags & HASH_FIXED_SIZE)
@@ -503,9 +576,6 @@ hdefault(HTAB *hashp)
 
 	MemSet(hctl, 0, sizeof(HASHHDR));
 
-	hctl->nentries = 0;
-	hctl->freeList = NULL;
-
 	hctl->dsize = DEF_DIRSIZE;
 	hctl->nsegs = 0;
 
@@ -572,12 +642,14 @@ init_htab(HTAB *hashp, long nelem)
 	HASHSEGMENT *segp;
 	int			nbuckets;
 	int			nsegs;
+	int			i;
 
 	/*
-	 * initialize mutex if it's a partitioned table
+	 * initialize mutexes if it's a partitioned table
 	 */
 	if (IS_PARTITIONED(hctl))
-		SpinLockInit(&hctl->mutex);
+		for (i = 0; i < NUM_FREELISTS; i++)
+			SpinLockInit(&(hctl->freeList[i].mutex));
 
 	/*
 	 * Divide number of elements by the fill factor to determine a desired
@@ -648,7 +720,7 @@ init_htab(HTAB *hashp, long nelem)
 			"HIGH MASK       ", hctl->high_mask,
 			"LOW  MASK       ", hctl->low_mask,
 			"NSEGS           ", hctl->nsegs,
-			"NENTRIES        ", hctl->nentries);
+			"NENTRIES        ", hash_get_num_entries(hashp));
 #endif
 	return true;
 }
@@ -769,7 +841,7 @@ hash_stats(const char *where, HTAB *hashp)
 			where, hashp->hctl->accesses, hashp->hctl->collisions);
 
 	fprintf(stderr, "hash_stats: entries %ld keysize %ld maxp %u segmentcount %ld\n",
-			hashp->hctl->nentries, (long) hashp->hctl->keysize,
+			hash_get_num_entries(hashp), (long) hashp->hctl->keysize,
 			hashp->hctl->max_bucket, hashp->hctl->nsegs);
 	fprintf(stderr, "%s: total accesses %ld total collisions %ld\n",
 			where, hash_accesses, hash_collisions);
@@ -855,6 +927,7 @@ hash_search_with_hash_value(HTAB *hashp,
 							bool *foundPtr)
 {
 	HASHHDR    *hctl = hashp->hctl;
+	int			freelist_idx = FREELIST_IDX(hctl, hashvalue);
 	Size		keysize;
 	uint32		bucket;
 	long		segment_num;
@@ -885,7 +958,7 @@ hash_search_with_hash_value(HTAB *hashp,
 		 * order of these tests is to try to check cheaper conditions first.
 		 */
 		if (!IS_PARTITIONED(hctl) && !hashp->frozen &&
-			hctl->nentries / (long) (hctl->max_bucket + 1) >= hctl->ffactor &&
+			hctl->freeList[0].nentries / (long) (hctl->max_bucket + 1) >= hctl->ffactor &&
 			!has_seq_scans(hashp))
 			(void) expand_table(hashp);
 	}
@@ -946,20 +1019,24 @@ hash_search_with_hash_value(HTAB *hashp,
 
 				/* if partitioned, must lock to touch nentries and freeList */
 				if (IS_PARTITIONED(hctlv))
-					SpinLockAcquire(&hctlv->mutex);
+					SpinLockAcquire(&(hctlv->freeList[freelist_idx].mutex));
 
-				Assert(hctlv->nentries > 0);
-				hctlv->nentries--;
+				/*
+				 * nentries of a single freelist can go negative if
+				 * hash_update_hash_key moved an entry to another freelist's
+				 * hashcodes, so only the total is sure to be positive.
+				 */
+				hctlv->freeList[freelist_idx].nentries--;
 
 				/* remove record from hash bucket's chain. */
 				*prevBucketPtr = currBucket->link;
 
-				/* add the record to the freelist for this table.  */
-				currBucket->link = hctlv->freeList;
-				hctlv->freeList = currBucket;
+				/* add the record to the appropriate freelist. */
+				currBucket->link = hctlv->freeList[freelist_idx].freeList;
+				hctlv->freeList[freelist_idx].freeList = currBucket;
 
 				if (IS_PARTITIONED(hctlv))
-					SpinLockRelease(&hctlv->mutex);
+					SpinLockRelease(&(hctlv->freeList[freelist_idx].mutex));
 
 				/*
 				 * better hope the caller is synchronizing access to this
@@ -985,7 +1062,7 @@ hash_search_with_hash_value(HTAB *hashp,
 				elog(ERROR, "cannot insert into frozen hashtable \"%s\"",
 					 hashp->tabname);
 
-			currBucket = get_hash_entry(hashp);
+			currBucket = get_hash_entry(hashp, freelist_idx);
 			if (currBucket == NULL)
 			{
 				/* out of memory */
@@ -1175,10 +1252,12 @@ hash_update_hash_key(HTAB *hashp,
 }
 
 /*
- * create a new entry if possible
+ * Allocate a new hashtable entry if possible; return NULL if out of memory.
+ * (Or, if the underlying space allocator throws error for out-of-memory,
+ * we won't return at all.)
  */
 static HASHBUCKET
-get_hash_entry(HTAB *hashp)
+get_hash_entry(HTAB *hashp, int freelist_idx)
 {
 	/* use volatile pointer to prevent code rearrangement */
 	volatile HASHHDR *hctlv = hashp->hctl;
@@ -1188,30 +1267,73 @@ get_hash_entry(HTAB *hashp)
 	{
 		/* if partitioned, must lock to touch nentries and freeList */
 		if (IS_PARTITIONED(hctlv))
-			SpinLockAcquire(&hctlv->mutex);
+			SpinLockAcquire(&(hctlv->freeList[freelist_idx].mutex));
 
 		/* try to get an entry from the freelist */
-		newElement = hctlv->freeList;
+		newElement = hctlv->freeList[freelist_idx].freeList;
 		if (newElement != NULL)
 			break;
 
-		/* no free elements.  allocate another chunk of buckets */
 		if (IS_PARTITIONED(hctlv))
-			SpinLockRelease(&hctlv->mutex);
+			SpinLockRelease(&(hctlv->freeList[freelist_idx].mutex));
 
-		if (!element_alloc(hashp, hctlv->nelem_alloc))
+		/*
+		 * No free elements in this freelist.  In a partitioned table, there
+		 * might be entries in other freelists, but to reduce contention we
+		 * prefer to first try to get another chunk of buckets from the main
+		 * shmem allocator.  If that fails, though, we *MUST* root through all
+		 * the other freelists before giving up.  There are multiple callers
+		 * that assume that they can allocate every element in the initially
+		 * requested table size, or that deleting an element guarantees they
+		 * can insert a new element, even if shared memory is entirely full.
+		 * Failing because the needed element is in a different freelist is
+		 * not acceptable.
+		 */
+		if (!element_alloc(hashp, hctlv->nelem_alloc, freelist_idx))
 		{
-			/* out of memory */
+			int			borrow_from_idx;
+
+			if (!IS_PARTITIONED(hctlv))
+				return NULL;	/* out of memory */
+
+			/* try to borrow element from another freelist */
+			borrow_from_idx = freelist_idx;
+			for (;;)
+			{
+				borrow_from_idx = (borrow_from_idx + 1) % NUM_FREELISTS;
+				if (borrow_from_idx == freelist_idx)
+					break;		/* examined all freelists, fail */
+
+				SpinLockAcquire(&(hctlv->freeList[borrow_from_idx].mutex));
+				newElement = hctlv->freeList[borrow_from_idx].freeList;
+
+				if (newElement != NULL)
+				{
+					hctlv->freeList[borrow_from_idx].freeList = newElement->link;
+					SpinLockRelease(&(hctlv->freeList[borrow_from_idx].mutex));
+
+					/* careful: count the new element in its proper freelist */
+					SpinLockAcquire(&(hctlv->freeList[freelist_idx].mutex));
+					hctlv->freeList[freelist_idx].nentries++;
+					SpinLockRelease(&(hctlv->freeList[freelist_idx].mutex));
+
+					return newElement;
+				}
+
+				SpinLockRelease(&(hctlv->freeList[borrow_from_idx].mutex));
+			}
+
+			/* no elements available to borrow either, so out of memory */
 			return NULL;
 		}
 	}
 
 	/* remove entry from freelist, bump nentries */
-	hctlv->freeList = newElement->link;
-	hctlv->nentries++;
+	hctlv->freeList[freelist_idx].freeList = newElement->link;
+	hctlv->freeList[freelist_idx].nentries++;
 
 	if (IS_PARTITIONED(hctlv))
-		SpinLockRelease(&hctlv->mutex);
+		SpinLockRelease(&(hctlv->freeList[freelist_idx].mutex));
 
 	return newElement;
 }
@@ -1222,11 +1344,21 @@ get_hash_entry(HTAB *hashp)
 long
 hash_get_num_entries(HTAB *hashp)
 {
+	int			i;
+	long		sum = hashp->hctl->freeList[0].nentries;
+
 	/*
-	 * We currently don't bother with the mutex; it's only sensible to call
-	 * this function if you've got lock on all partitions of the table.
+	 * We currently don't bother with acquiring the mutexes; it's only
+	 * sensible to call this function if you've got lock on all partitions of
+	 * the table.
 	 */
-	return hashp->hctl->nentries;
+	if (IS_PARTITIONED(hashp->hctl))
+	{
+		for (i = 1; i < NUM_FREELISTS; i++)
+			sum += hashp->hctl->freeList[i].nentries;
+	}
+
+	return sum;
 }
 
 /*
@@ -1531,10 +1663,10 @@ seg_alloc(HTAB *hashp)
 }
 
 /*
- * allocate some new elements and link them into the free list
+ * allocate some new elements and link them into the indicated free list
  */
 static bool
-element_alloc(HTAB *hashp, int nelem)
+element_alloc(HTAB *hashp, int nelem, int freelist_idx)
 {
 	/* use volatile pointer to prevent code rearrangement */
 	volatile HASHHDR *hctlv = hashp->hctl;
@@ -1568,14 +1700,14 @@ element_alloc(HTAB *hashp, int nelem)
 
 	/* if partitioned, must lock to touch freeList */
 	if (IS_PARTITIONED(hctlv))
-		SpinLockAcquire(&hctlv->mutex);
+		SpinLockAcquire(&(hctlv->freeList[freelist_idx].mutex));
 
 	/* freelist could be nonempty if two backends did this concurrently */
-	firstElement->link = hctlv->freeList;
-	hctlv->freeList = prevElement;
+	firstElement->link = hctlv->freeList[freelist_idx].freeList;
+	hctlv->freeList[freelist_idx].freeList = prevElement;
 
 	if (IS_PARTITIONED(hctlv))
-		SpinLockRelease(&hctlv->mutex);
+		SpinLockRelease(&(hctlv->freeList[freelist_idx].mutex));
 
 	return true;
 }
@@ -108,6 +108,8 @@ bool		enableFsync = true;
 bool		allowSystemTableMods = false;
 int			work_mem = 1024;
 int			maintenance_work_mem = 16384;
+int			query_work_mem = -1;
+int			session_memory_limit = -1;
 
 /*
  * Primary determinants of sizes of shared-memory structures.
@@ -62,6 +62,7 @@
 #include "replication/syncrep.h"
 #include "replication/walreceiver.h"
 #include "replication/walsender.h"
+#include "storage/aio.h"
 #include "storage/bufmgr.h"
 #include "storage/dsm_impl.h"
 #include "storage/standby.h"
@@ -69,8 +70,10 @@
 #include "storage/pg_shmem.h"
 #include "storage/proc.h"
 #include "storage/predicate.h"
+#include "storage/sinvaladt.h"
 #include "tcop/tcopprot.h"
 #include "tsearch/ts_cache.h"
+#include "tsearch/ts_shared.h"
 #include "utils/builtins.h"
 #include "utils/bytea.h"
 #include "utils/guc_tables.h"
@@ -194,6 +197,7 @@ static bool check_max_worker_processes(int *newval, void **extra, GucSource sour
 static bool check_autovacuum_max_workers(int *newval, void **extra, GucSource source);
 static bool check_autovacuum_work_mem(int *newval, void **extra, GucSource source);
 static bool check_effective_io_concurrency(int *newval, void **extra, GucSource source);
+static bool check_direct_io(int *newval, void **extra, GucSource source);
 static void assign_effective_io_concurrency(int newval, void *extra);
 static void assign_pgstat_temp_directory(const char *newval, void *extra);
 static bool check_application_name(char **newval, void **extra, GucSource source);
@@ -395,6 +399,25 @@ static const struct config_enum_entry huge_pages_options[] = {
 	{NULL, 0, false}
 };
 
+/*
+ * Although only "off", "data", "wal" and "all" are documented, we accept
+ * the likely variants of "on" and "off", too.
+ */
+static const struct config_enum_entry direct_io_options[] = {
+	{"off", DIRECT_IO_OFF, false},
+	{"data", DIRECT_IO_DATA, false},
+	{"wal", DIRECT_IO_WAL, false},
+	{"all", DIRECT_IO_ALL, false},
+	{"on", DIRECT_IO_ALL, true},
+	{"true", DIRECT_IO_ALL, true},
+	{"false", DIRECT_IO_OFF, true},
+	{"yes", DIRECT_IO_ALL, true},
+	{"no", DIRECT_IO_OFF, true},
+	{"1", DIRECT_IO_ALL, true},
+	{"0", DIRECT_IO_OFF, true},
+	{NULL, 0, false}
+};
+
 /*
  * Although only "on", "off", and "force" are documented, we
  * accept all the likely variants of "on" and "off".
@@ -798,6 +821,15 @@ static struct config_bool ConfigureNamesBool[] =
 		true,
 		NULL, NULL, NULL
 	},
+	{
+		{"enable_union_or", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enables the planner's use of unions of separately planned OR arms."),
+			NULL
+		},
+		&enable_union_or,
+		true,
+		NULL, NULL, NULL
+	},
 	{
 		{"geqo", PGC_USERSET, QUERY_TUNING_GEQO,
 			gettext_noop("Enables genetic query optimization."),
@@ -1800,6 +1832,30 @@ static struct config_int ConfigureNamesInt[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"query_work_mem", PGC_USERSET, RESOURCES_MEM,
+			gettext_noop("Sets the maximum memory to be shared by the sorts and hash tables of a query."),
+			gettext_noop("Operations that can spill to disk do so early once the query "
+						 "as a whole is using this much memory. -1 means no limit."),
+			GUC_UNIT_KB
+		},
+		&query_work_mem,
+		-1, -1, MAX_KILOBYTES,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"session_memory_limit", PGC_SUSET, RESOURCES_MEM,
+			gettext_noop("Sets the maximum memory a session may allocate."),
+			gettext_noop("Allocations beyond this fail with an out-of-memory error. "
+						 "-1 means no limit."),
+			GUC_UNIT_KB
+		},
+		&session_memory_limit,
+		-1, -1, MAX_KILOBYTES,
+		NULL, NULL, NULL
+	},
+
 	/*
 	 * We use the hopefully-safely-small value of 100kB as the compiled-in
 	 * default for max_stack_depth.  InitializeGUCOptions will increase it if
@@ -1816,6 +1872,28 @@ static struct config_int ConfigureNamesInt[] =
 		check_max_stack_depth, assign_max_stack_depth, NULL
 	},
 
+	{
+		{"max_shared_dictionaries_size", PGC_POSTMASTER, RESOURCES_MEM,
+			gettext_noop("Sets the amount of shared memory used to hold text search dictionaries."),
+			gettext_noop("Ispell dictionaries loaded into this area are shared "
+						 "by all sessions. Zero disables the area."),
+			GUC_UNIT_KB
+		},
+		&max_shared_dictionaries_size,
+		0, 0, MAX_KILOBYTES,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"invalidation_queue_size", PGC_POSTMASTER, RESOURCES_MEM,
+			gettext_noop("Sets the number of cache invalidation messages kept in shared memory."),
+			gettext_noop("The value is rounded up to a power of 2.")
+		},
+		&invalidation_queue_size,
+		4096, 4096, 1048576,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"temp_file_limit", PGC_SUSET, RESOURCES_DISK,
 			gettext_noop("Limits the total size of all temporary files used by each session."),
@@ -2044,6 +2122,30 @@ static struct config_int ConfigureNamesInt[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"max_pred_locks_per_relation", PGC_SUSET, LOCK_MANAGEMENT,
+			gettext_noop("Sets the maximum number of predicate-locked pages and tuples per relation."),
+			gettext_noop("If more than this total of pages and tuples in the same relation are locked "
+						 "by a connection, those locks are replaced by a relation-level lock. "
+						 "A negative value means max_pred_locks_per_transaction divided by "
+						 "its absolute value, minus one.")
+		},
+		&max_predicate_locks_per_relation,
+		-2, INT_MIN, INT_MAX,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"max_pred_locks_per_page", PGC_SUSET, LOCK_MANAGEMENT,
+			gettext_noop("Sets the maximum number of predicate-locked tuples per page."),
+			gettext_noop("If more than this number of tuples on the same page are locked "
+						 "by a connection, those locks are replaced by a page-level lock.")
+		},
+		&max_predicate_locks_per_page,
+		2, 0, INT_MAX,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"authentication_timeout", PGC_SIGHUP, CONN_AUTH_SECURITY,
 			gettext_noop("Sets the maximum allowed time to complete client authentication."),
@@ -2275,6 +2377,18 @@ static struct config_int ConfigureNamesInt[] =
 		check_max_worker_processes, NULL, NULL
 	},
 
+	{
+		{"io_workers",
+			PGC_POSTMASTER,
+			RESOURCES_ASYNCHRONOUS,
+			gettext_noop("Number of worker processes for asynchronous buffer I/O."),
+			gettext_noop("Zero disables asynchronous I/O.")
+		},
+		&io_workers,
+		0, 0, MAX_IO_WORKERS,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"log_rotation_age", PGC_SIGHUP, LOGGING_WHERE,
 			gettext_noop("Automatic log file rotation will occur after N minutes."),
@@ -3524,6 +3638,16 @@ static struct config_enum ConfigureNamesEnum[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"direct_io", PGC_POSTMASTER, RESOURCES_DISK,
+			gettext_noop("Selects the kinds of files to read and write bypassing the kernel's cache."),
+			NULL
+		},
+		&direct_io,
+		DIRECT_IO_OFF, direct_io_options,
+		check_direct_io, NULL, NULL
+	},
+
 	{
 		{"row_security", PGC_USERSET, CONN_AUTH_SECURITY,
 			gettext_noop("Enable row security."),
@@ -9862,6 +9986,17 @@ assign_effective_io_concurrency(int newval, void *extra)
 #endif   /* USE_PREFETCH */
 }
 
+static bool
+check_direct_io(int *newval, void **extra, GucSource source)
+{
+	if (*newval != DIRECT_IO_OFF && PG_O_DIRECT == 0)
+	{
+		GUC_check_errdetail("direct_io is not supported on this platform.");
+		return false;
+	}
+	return true;
+}
+
 static void
 assign_pgstat_temp_directory(const char *newval, void *extra)
 {
@@ -253,7 +253,8 @@ static void AllocSetReset(MemoryContext context);
 static void AllocSetDelete(MemoryContext context);
 static Size AllocSetGetChunkSpace(MemoryContext context, void *pointer);
 static bool AllocSetIsEmpty(MemoryContext context);
-static void AllocSetStats(MemoryContext context, int level);
+static void AllocSetStats(MemoryContext context, int level, bool print,
+			  MemoryContextCounters *totals);
 
 #ifdef MEMORY_CONTEXT_CHECKING
 static void AllocSetCheck(MemoryContext context);
@@ -490,7 +491,10 @@ AllocSetContextCreate(MemoryContext parent,
 		Size		blksize = MAXALIGN(minContextSize);
 		AllocBlock	block;
 
-		block = (AllocBlock) malloc(blksize);
+		if (MemoryContextCheckLimit((MemoryContext) context, blksize))
+			block = (AllocBlock) malloc(blksize);
+		else
+			block = NULL;
 		if (block == NULL)
 		{
 			MemoryContextStats(TopMemoryContext);
@@ -500,6 +504,7 @@ AllocSetContextCreate(MemoryContext parent,
 					 errdetail("Failed while creating memory context \"%s\".",
 							   name)));
 		}
+		MemoryContextNoteAlloc((MemoryContext) context, blksize);
 		block->aset = context;
 		block->freeptr = ((char *) block) + ALLOC_BLOCKHDRSZ;
 		block->endptr = ((char *) block) + blksize;
@@ -553,6 +558,7 @@ AllocSetReset(MemoryContext context)
 {
 	AllocSet	set = (AllocSet) context;
 	AllocBlock	block;
+	Size		freed = 0;
 
 	AssertArg(AllocSetIsValid(set));
 
@@ -590,6 +596,7 @@ AllocSetReset(MemoryContext context)
 		else
 		{
 			/* Normal case, release the block */
+			freed += block->endptr - ((char *) block);
 #ifdef CLOBBER_FREED_MEMORY
 			wipe_mem(block, block->freeptr - ((char *) block));
 #endif
@@ -597,6 +604,7 @@ AllocSetReset(MemoryContext context)
 		}
 		block = next;
 	}
+	MemoryContextNoteFree(context, freed);
 
 	/* Reset block size allocation sequence, too */
 	set->nextBlockSize = set->initBlockSize;
@@ -615,6 +623,7 @@ AllocSetDelete(MemoryContext context)
 {
 	AllocSet	set = (AllocSet) context;
 	AllocBlock	block = set->blocks;
+	Size		freed = 0;
 
 	AssertArg(AllocSetIsValid(set));
 
@@ -632,12 +641,14 @@ AllocSetDelete(MemoryContext context)
 	{
 		AllocBlock	next = block->next;
 
+		freed += block->endptr - ((char *) block);
 #ifdef CLOBBER_FREED_MEMORY
 		wipe_mem(block, block->freeptr - ((char *) block));
 #endif
 		free(block);
 		block = next;
 	}
+	MemoryContextNoteFree(context, freed);
 }
 
 /*
@@ -669,9 +680,12 @@ AllocSetAlloc(MemoryContext context, Size size)
 	{
 		chunk_size = MAXALIGN(size);
 		blksize = chunk_size + ALLOC_BLOCKHDRSZ + ALLOC_CHUNKHDRSZ;
+		if (!MemoryContextCheckLimit(context, blksize))
+			return NULL;
 		block = (AllocBlock) malloc(blksize);
 		if (block == NULL)
 			return NULL;
+		MemoryContextNoteAlloc(context, blksize);
 		block->aset = set;
 		block->freeptr = block->endptr = ((char *) block) + blksize;
 
@@ -844,6 +858,8 @@ AllocSetAlloc(MemoryContext context, Size size)
 			blksize <<= 1;
 
 		/* Try to allocate it */
+		if (!MemoryContextCheckLimit(context, blksize))
+			return NULL;
 		block = (AllocBlock) malloc(blksize);
 
 		/*
@@ -860,6 +876,7 @@ AllocSetAlloc(MemoryContext context, Size size)
 
 		if (block == NULL)
 			return NULL;
+		MemoryContextNoteAlloc(context, blksize);
 
 		block->aset = set;
 		block->freeptr = ((char *) block) + ALLOC_BLOCKHDRSZ;
@@ -964,6 +981,7 @@ AllocSetFree(MemoryContext context, void *pointer)
 			set->blocks = block->next;
 		else
 			prevblock->next = block->next;
+		MemoryContextNoteFree(context, block->endptr - ((char *) block));
 #ifdef CLOBBER_FREED_MEMORY
 		wipe_mem(block, block->freeptr - ((char *) block));
 #endif
@@ -1077,6 +1095,7 @@ AllocSetRealloc(MemoryContext context, void *pointer, Size size)
 		AllocBlock	prevblock = NULL;
 		Size		chksize;
 		Size		blksize;
+		Size		oldblksize;
 
 		while (block != NULL)
 		{
@@ -1092,11 +1111,17 @@ AllocSetRealloc(MemoryContext context, void *pointer, Size size)
 			   (chunk->size + ALLOC_BLOCKHDRSZ + ALLOC_CHUNKHDRSZ));
 
 		/* Do the realloc */
+		oldblksize = block->endptr - ((char *) block);
 		chksize = MAXALIGN(size);
 		blksize = chksize + ALLOC_BLOCKHDRSZ + ALLOC_CHUNKHDRSZ;
+		if (blksize > oldblksize &&
+			!MemoryContextCheckLimit(context, blksize - oldblksize))
+			return NULL;
 		block = (AllocBlock) realloc(block, blksize);
 		if (block == NULL)
 			return NULL;
+		MemoryContextNoteFree(context, oldblksize);
+		MemoryContextNoteAlloc(context, blksize);
 		block->freeptr = block->endptr = ((char *) block) + blksize;
 
 		/* Update pointers since block has likely been moved */
@@ -1223,10 +1248,15 @@ AllocSetIsEmpty(MemoryContext context)
 
 /*
  * AllocSetStats
- *		Displays stats about memory consumption of an allocset.
+ *		Compute stats about memory consumption of an allocset.
+ *
+ * level: recursion level (0 at top level); used for print indentation.
+ * print: true to print stats to stderr.
+ * totals: if not NULL, add stats about this allocset into *totals.
  */
 static void
-AllocSetStats(MemoryContext context, int level)
+AllocSetStats(MemoryContext context, int level, bool print,
+			  MemoryContextCounters *totals)
 {
 	AllocSet	set = (AllocSet) context;
 	Size		nblocks = 0;
@@ -1254,13 +1284,24 @@ AllocSetStats(MemoryContext context, int level)
 		}
 	}
 
-	for (i = 0; i < level; i++)
-		fprintf(stderr, "  ");
+	if (print)
+	{
+		for (i = 0; i < level; i++)
+			fprintf(stderr, "  ");
 
-	fprintf(stderr,
+		fprintf(stderr,
 			"%s: %zu total in %zd blocks; %zu free (%zd chunks); %zu used\n",
-			set->header.name, totalspace, nblocks, freespace, nchunks,
-			totalspace - freespace);
+				set->header.name, totalspace, nblocks, freespace, nchunks,
+				totalspace - freespace);
+	}
+
+	if (totals)
+	{
+		totals->nblocks += nblocks;
+		totals->freechunks += nchunks;
+		totals->totalspace += totalspace;
+		totals->freespace += freespace;
+	}
 }
 
 
@@ -54,7 +54,15 @@ MemoryContext CurTransactionContext = NULL;
 /* This is a transient link to the active portal's memory context: */
 MemoryContext PortalContext = NULL;
 
+/*
+ * Set when MemoryContextCheckLimit refuses a request, and cleared on its next
+ * call; lets us tell a refusal from a genuine malloc() failure.
+ */
+static MemoryContext limitExceededContext = NULL;
+static Size limitExceededSize = 0;
+
 static void MemoryContextStatsInternal(MemoryContext context, int level);
+static int	errdetail_alloc_failure(Size size);
 
 /*
  * You should not do memory allocations within a critical section, because
@@ -263,6 +271,8 @@ MemoryContextResetAndDeleteChildren(MemoryContext context)
 void
 MemoryContextSetParent(MemoryContext context, MemoryContext new_parent)
 {
+	MemoryContext ancestor;
+
 	AssertArg(MemoryContextIsValid(context));
 	AssertArg(context != new_parent);
 
@@ -271,6 +281,10 @@ MemoryContextSetParent(MemoryContext context, MemoryContext new_parent)
 	{
 		MemoryContext parent = context->parent;
 
+		/* The old ancestors no longer hold the subtree's memory */
+		for (ancestor = parent; ancestor != NULL; ancestor = ancestor->parent)
+			ancestor->mem_total -= context->mem_total;
+
 		if (context == parent->firstchild)
 			parent->firstchild = context->nextchild;
 		else
@@ -295,6 +309,10 @@ MemoryContextSetParent(MemoryContext context, MemoryContext new_parent)
 		context->parent = new_parent;
 		context->nextchild = new_parent->firstchild;
 		new_parent->firstchild = context;
+
+		for (ancestor = new_parent; ancestor != NULL;
+			 ancestor = ancestor->parent)
+			ancestor->mem_total += context->mem_total;
 	}
 	else
 	{
@@ -323,6 +341,131 @@ MemoryContextAllowInCriticalSection(MemoryContext context, bool allow)
 #endif
 }
 
+/*
+ * MemoryContextSetBudget
+ *		Set the amount of memory that the context and its descendants should
+ *		try to stay within, or 0 for none.
+ *
+ * Unlike session_memory_limit, a budget is not enforced here.  Code that
+ * has a choice between using more memory and spilling to disk, such as
+ * tuplesort.c, looks up the nearest budget with
+ * MemoryContextGetBudgetContext and spills early when MemoryContextOverBudget
+ * says that the budget has been used up.  The executor sets a budget of
+ * query_work_mem on each query's per-query context, so that the nodes of a
+ * plan share it instead of each assuming it has work_mem to itself.
+ */
+void
+MemoryContextSetBudget(MemoryContext context, Size budget)
+{
+	AssertArg(MemoryContextIsValid(context));
+
+	context->mem_budget = budget;
+}
+
+/*
+ * MemoryContextGetBudgetContext
+ *		Find the nearest context at or above the given one that has a budget.
+ *
+ * Returns NULL if there is none.  Callers typically do this once when they
+ * set up, and then test the result with MemoryContextOverBudget.
+ */
+MemoryContext
+MemoryContextGetBudgetContext(MemoryContext context)
+{
+	AssertArg(MemoryContextIsValid(context));
+
+	for (; context != NULL; context = context->parent)
+	{
+		if (context->mem_budget > 0)
+			return context;
+	}
+	return NULL;
+}
+
+/*
+ * MemoryContextCheckLimit
+ *		Check whether obtaining another "size" bytes for a context would take
+ *		the session over session_memory_limit.
+ *
+ * Returns false if so, in which case the caller must fail the request just
+ * as if malloc() had failed.  The error, if any, is raised by our callers
+ * above (which know whether MCXT_ALLOC_NO_OOM was given), and its message
+ * mentions the limit.
+ *
+ * The limit is applied to everything under TopMemoryContext.  It is not
+ * applied to ErrorContext, which error recovery relies on, nor in a critical
+ * section, where failing would be a PANIC.
+ */
+bool
+MemoryContextCheckLimit(MemoryContext context, Size size)
+{
+	limitExceededContext = NULL;
+
+	if (session_memory_limit <= 0 || TopMemoryContext == NULL)
+		return true;
+	if (context == ErrorContext || CritSectionCount > 0)
+		return true;
+
+	if (TopMemoryContext->mem_total + size >
+		(Size) session_memory_limit * 1024)
+	{
+		limitExceededContext = context;
+		limitExceededSize = size;
+		return false;
+	}
+	return true;
+}
+
+/*
+ * errdetail_alloc_failure
+ *		Add errdetail explaining why an allocation request of "size" failed.
+ */
+static int
+errdetail_alloc_failure(Size size)
+{
+	if (limitExceededContext != NULL)
+	{
+		MemoryContext context = limitExceededContext;
+
+		limitExceededContext = NULL;
+		return errdetail("Allocating %zu more bytes in memory context \"%s\" would exceed session_memory_limit (%dkB).",
+						 limitExceededSize, context->name,
+						 session_memory_limit);
+	}
+	return errdetail("Failed on request of size %zu.", size);
+}
+
+/*
+ * MemoryContextNoteAlloc
+ *		Account for a block of "size" bytes obtained by a context.
+ *
+ * Besides the context's own count, the cumulative count of the context and
+ * all of its ancestors is updated, so that the memory held by any subtree can
+ * be read off its root without walking it.  Blocks are large and relatively
+ * rare compared to chunks, so walking up the tree here is cheap.
+ */
+void
+MemoryContextNoteAlloc(MemoryContext context, Size size)
+{
+	context->mem_allocated += size;
+	for (; context != NULL; context = context->parent)
+		context->mem_total += size;
+}
+
+/*
+ * MemoryContextNoteFree
+ *		Account for a block of "size" bytes returned by a context.
+ */
+void
+MemoryContextNoteFree(MemoryContext context, Size size)
+{
+	Assert(context->mem_allocated >= size);
+
+	context->mem_allocated -= size;
+	for (; context != NULL; context = context->parent)
+		context->mem_total -= size;
+}
+
 /*
  * GetMemoryChunkSpace
  *		Given a currently-allocated chunk, determine the total space
@@ -436,7 +579,7 @@ MemoryContextStatsInternal(MemoryContext context, int level)
 
 	AssertArg(MemoryContextIsValid(context));
 
-	(*context->methods->stats) (context, level);
+	(*context->methods->stats) (context, level, true, NULL);
 	for (child = context->firstchild; child != NULL; child = child->nextchild)
 		MemoryContextStatsInternal(child, level + 1);
 }
@@ -629,7 +772,7 @@ MemoryContextAlloc(MemoryContext context, Size size)
 		ereport(ERROR,
 				(errcode(ERRCODE_OUT_OF_MEMORY),
 				 errmsg("out of memory"),
-				 errdetail("Failed on request of size %zu.", size)));
+				 errdetail_alloc_failure(size)));
 	}
 
 	VALGRIND_MEMPOOL_ALLOC(context, ret, size);
@@ -664,7 +807,7 @@ MemoryContextAllocZero(MemoryContext context, Size size)
 		ereport(ERROR,
 				(errcode(ERRCODE_OUT_OF_MEMORY),
 				 errmsg("out of memory"),
-				 errdetail("Failed on request of size %zu.", size)));
+				 errdetail_alloc_failure(size)));
 	}
 
 	VALGRIND_MEMPOOL_ALLOC(context, ret, size);
@@ -701,7 +844,7 @@ MemoryContextAllocZeroAligned(MemoryContext context, Size size)
 		ereport(ERROR,
 				(errcode(ERRCODE_OUT_OF_MEMORY),
 				 errmsg("out of memory"),
-				 errdetail("Failed on request of size %zu.", size)));
+				 errdetail_alloc_failure(size)));
 	}
 
 	VALGRIND_MEMPOOL_ALLOC(context, ret, size);
@@ -738,7 +881,7 @@ MemoryContextAllocExtended(MemoryContext context, Size size, int flags)
 			ereport(ERROR,
 					(errcode(ERRCODE_OUT_OF_MEMORY),
 					 errmsg("out of memory"),
-					 errdetail("Failed on request of size %zu.", size)));
+					 errdetail_alloc_failure(size)));
 		}
 		return NULL;
 	}
@@ -772,7 +915,7 @@ palloc(Size size)
 		ereport(ERROR,
 				(errcode(ERRCODE_OUT_OF_MEMORY),
 				 errmsg("out of memory"),
-				 errdetail("Failed on request of size %zu.", size)));
+				 errdetail_alloc_failure(size)));
 	}
 
 	VALGRIND_MEMPOOL_ALLOC(CurrentMemoryContext, ret, size);
@@ -801,7 +944,7 @@ palloc0(Size size)
 		ereport(ERROR,
 				(errcode(ERRCODE_OUT_OF_MEMORY),
 				 errmsg("out of memory"),
-				 errdetail("Failed on request of size %zu.", size)));
+				 errdetail_alloc_failure(size)));
 	}
 
 	VALGRIND_MEMPOOL_ALLOC(CurrentMemoryContext, ret, size);
@@ -878,7 +1021,7 @@ repalloc(void *pointer, Size size)
 		ereport(ERROR,
 				(errcode(ERRCODE_OUT_OF_MEMORY),
 				 errmsg("out of memory"),
-				 errdetail("Failed on request of size %zu.", size)));
+				 errdetail_alloc_failure(size)));
 
 	VALGRIND_MEMPOOL_CHANGE(context, pointer, ret, size);
 
@@ -911,7 +1054,7 @@ MemoryContextAllocHuge(MemoryContext context, Size size)
 		ereport(ERROR,
 				(errcode(ERRCODE_OUT_OF_MEMORY),
 				 errmsg("out of memory"),
-				 errdetail("Failed on request of size %zu.", size)));
+				 errdetail_alloc_failure(size)));
 	}
 
 	VALGRIND_MEMPOOL_ALLOC(context, ret, size);
@@ -958,7 +1101,7 @@ repalloc_huge(void *pointer, Size size)
 		ereport(ERROR,
 				(errcode(ERRCODE_OUT_OF_MEMORY),
 				 errmsg("out of memory"),
-				 errdetail("Failed on request of size %zu.", size)));
+				 errdetail_alloc_failure(size)));
 
 	VALGRIND_MEMPOOL_CHANGE(context, pointer, ret, size);
 
@@ -100,6 +100,7 @@
 
 #include <limits.h>
 
+#include "access/gist.h"
 #include "access/htup_details.h"
 #include "access/nbtree.h"
 #include "catalog/index.h"
@@ -219,6 +220,8 @@ struct Tuplesortstate
 	int			maxTapes;		/* number of tapes (Knuth's T) */
 	int			tapeRange;		/* maxTapes-1 (Knuth's P) */
 	MemoryContext sortcontext;	/* memory context holding all sort data */
+	MemoryContext budgetcxt;	/* context holding query's memory budget, or
+								 * NULL if none */
 	LogicalTapeSet *tapeset;	/* logtape.c object for tapes in a temp file */
 
 	/*
@@ -453,6 +456,7 @@ struct Tuplesortstate
 
 static Tuplesortstate *tuplesort_begin_common(int workMem, bool randomAccess);
 static void puttuple_common(Tuplesortstate *state, SortTuple *tuple);
+static bool budget_exhausted(Tuplesortstate *state);
 static bool consider_abort_common(Tuplesortstate *state);
 static void inittapes(Tuplesortstate *state);
 static void selectnewtape(Tuplesortstate *state);
@@ -568,6 +572,7 @@ tuplesort_begin_common(int workMem, bool randomAccess)
 	state->allowedMem = workMem * (int64) 1024;
 	state->availMem = state->allowedMem;
 	state->sortcontext = sortcontext;
+	state->budgetcxt = MemoryContextGetBudgetContext(sortcontext);
 	state->tapeset = NULL;
 
 	state->memtupcount = 0;
@@ -834,6 +839,82 @@ tuplesort_begin_index_btree(Relation heapRel,
 	return state;
 }
 
+/*
+ * GiST indexes have no natural ordering, but the sorted GiST build wants the
+ * tuples clustered by some space-filling curve.  The opclasses supply that
+ * ordering through their SortSupport support function, which compares the
+ * stored (compressed) keys.  Apart from how the SortSupport data is set up,
+ * this works exactly like a non-unique btree index sort.
+ */
+Tuplesortstate *
+tuplesort_begin_index_gist(Relation heapRel,
+						   Relation indexRel,
+						   int workMem, bool randomAccess)
+{
+	Tuplesortstate *state = tuplesort_begin_common(workMem, randomAccess);
+	MemoryContext oldcontext;
+	int			i;
+
+	oldcontext = MemoryContextSwitchTo(state->sortcontext);
+
+#ifdef TRACE_SORT
+	if (trace_sort)
+		elog(LOG,
+			 "begin index sort: workMem = %d, randomAccess = %c",
+			 workMem, randomAccess ? 't' : 'f');
+#endif
+
+	state->nKeys = RelationGetNumberOfAttributes(indexRel);
+
+	TRACE_POSTGRESQL_SORT_START(INDEX_SORT,
+								false,	/* no unique check */
+								state->nKeys,
+								workMem,
+								randomAccess);
+
+	state->comparetup = comparetup_index_btree;
+	state->copytup = copytup_index;
+	state->writetup = writetup_index;
+	state->readtup = readtup_index;
+	state->abbrevNext = 10;
+
+	state->heapRel = heapRel;
+	state->indexRel = indexRel;
+
+	/* Prepare SortSupport data for each column */
+	state->sortKeys = (SortSupport) palloc0(state->nKeys *
+											sizeof(SortSupportData));
+
+	for (i = 0; i < state->nKeys; i++)
+	{
+		SortSupport sortKey = state->sortKeys + i;
+		Oid			sortSupportProc;
+
+		sortKey->ssup_cxt = CurrentMemoryContext;
+		sortKey->ssup_collation = indexRel->rd_indcollation[i];
+		sortKey->ssup_nulls_first = false;
+		sortKey->ssup_attno = i + 1;
+		/* Convey if abbreviation optimization is applicable in principle */
+		sortKey->abbreviate = (i == 0);
+
+		AssertState(sortKey->ssup_attno != 0);
+
+		/* Look for a sort support function */
+		sortSupportProc = index_getprocid(indexRel, i + 1,
+										  GIST_SORTSUPPORT_PROC);
+		if (!OidIsValid(sortSupportProc))
+			elog(ERROR, "missing support function %d for attribute %d of index \"%s\"",
+				 GIST_SORTSUPPORT_PROC, i + 1,
+				 RelationGetRelationName(indexRel));
+		OidFunctionCall1(sortSupportProc, PointerGetDatum(sortKey));
+		Assert(sortKey->comparator != NULL);
+	}
+
+	MemoryContextSwitchTo(oldcontext);
+
+	return state;
+}
+
 Tuplesortstate *
 tuplesort_begin_index_hash(Relation heapRel,
 						   Relation indexRel,
@@ -1075,6 +1156,10 @@ grow_memtuples(Tuplesortstate *state)
 	if (!state->growmemtuples)
 		return false;
 
+	/* Likewise if the query has no memory left to give us */
+	if (budget_exhausted(state))
+		return false;
+
 	/* Select new value of memtupsize */
 	if (memNowUsed <= state->availMem)
 	{
@@ -1329,6 +1414,45 @@ tuplesort_putdatum(Tuplesortstate *state, Datum val, bool isNull)
 	MemoryContextSwitchTo(oldcontext);
 }
 
+/*
+ * budget_exhausted - has the query used up its shared memory budget?
+ *
+ * If so, stop asking for more memory: shrink allowedMem to what we are using
+ * now, as though workMem had been that small to begin with, so that we
+ * switch to (and size the merge for) tape-based operation accordingly.  We
+ * don't go below 64kB, the minimum work_mem, since the merge needs some
+ * room to work with.
+ */
+static bool
+budget_exhausted(Tuplesortstate *state)
+{
+	if (!MemoryContextOverBudget(state->budgetcxt))
+		return false;
+
+	if (state->availMem > 0)
+	{
+		int64		newAllowedMem;
+
+		newAllowedMem = Max(state->allowedMem - state->availMem,
+							64 * (int64) 1024);
+		if (newAllowedMem < state->allowedMem)
+		{
+			state->availMem -= state->allowedMem - newAllowedMem;
+			state->allowedMem = newAllowedMem;
+		}
+
+#ifdef TRACE_SORT
+		if (trace_sort)
+			elog(LOG, "query memory budget exhausted, limiting sort to %ld kB: %s",
+				 (long) (state->allowedMem / 1024),
+				 pg_rusage_show(&state->ru_start));
+#endif
+	}
+	state->growmemtuples = false;
+
+	return true;
+}
+
 /*
  * Shared code for tuple and datum cases.
  */
@@ -1380,9 +1504,11 @@ puttuple_common(Tuplesortstate *state, SortTuple *tuple)
 			}
 
 			/*
-			 * Done if we still fit in available memory and have array slots.
+			 * Done if we still fit in available memory and have array slots,
+			 * and the query as a whole hasn't used up its memory budget.
 			 */
-			if (state->memtupcount < state->memtupsize && !LACKMEM(state))
+			if (state->memtupcount < state->memtupsize && !LACKMEM(state) &&
+				!budget_exhausted(state))
 				return;
 
 			/*
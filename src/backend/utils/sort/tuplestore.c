@@ -111,6 +111,8 @@ struct Tuplestorestate
 	int64		allowedMem;		/* total memory allowed, in bytes */
 	BufFile    *myfile;			/* underlying file, or NULL if none */
 	MemoryContext context;		/* memory context for holding tuples */
+	MemoryContext budgetcxt;	/* context holding query's memory budget, or
+								 * NULL if none */
 	ResourceOwner resowner;		/* resowner for holding temp files */
 
 	/*
@@ -263,6 +265,7 @@ tuplestore_begin_common(int eflags, bool interXact, int maxKBytes)
 	state->availMem = state->allowedMem;
 	state->myfile = NULL;
 	state->context = CurrentMemoryContext;
+	state->budgetcxt = MemoryContextGetBudgetContext(CurrentMemoryContext);
 	state->resowner = CurrentResourceOwner;
 
 	state->memtupdeleted = 0;
@@ -563,6 +566,10 @@ grow_memtuples(Tuplestorestate *state)
 	if (!state->growmemtuples)
 		return false;
 
+	/* Likewise if the query has used up its memory budget */
+	if (MemoryContextOverBudget(state->budgetcxt))
+		return false;
+
 	/* Select new value of memtupsize */
 	if (memNowUsed <= state->availMem)
 	{
@@ -779,9 +786,11 @@ tuplestore_puttuple_common(Tuplestorestate *state, void *tuple)
 			state->memtuples[state->memtupcount++] = tuple;
 
 			/*
-			 * Done if we still fit in available memory and have array slots.
+			 * Done if we still fit in available memory and have array slots,
+			 * and the query as a whole hasn't used up its memory budget.
 			 */
-			if (state->memtupcount < state->memtupsize && !LACKMEM(state))
+			if (state->memtupcount < state->memtupsize && !LACKMEM(state) &&
+				!MemoryContextOverBudget(state->budgetcxt))
 				return;
 
 			/*
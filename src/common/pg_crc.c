@@ -21,6 +21,36 @@
 
 #include "common/pg_crc.h"
 
+/*
+ * Decide which hardware CRC-32C implementations can be compiled here.  The
+ * instructions are used through inline assembly or intrinsics that need no
+ * special compiler flags, and whether the CPU actually has them is checked
+ * at runtime.  The hardware instructions compute the bit-reflected CRC that
+ * the little-endian lookup tables implement, so they can't be used on
+ * big-endian systems.
+ */
+#if !defined(WORDS_BIGENDIAN)
+#if defined(__x86_64__) && defined(__GNUC__)
+#define USE_SSE42_CRC32C
+#include <cpuid.h>
+#elif defined(_M_X64) && defined(_MSC_VER)
+#define USE_SSE42_CRC32C
+#include <intrin.h>
+#include <nmmintrin.h>
+#elif defined(__aarch64__) && defined(__GNUC__) && defined(__linux__)
+#include <sys/auxv.h>
+#ifdef HWCAP_CRC32
+#define USE_ARMV8_CRC32C
+#endif
+#endif
+#endif   /* !WORDS_BIGENDIAN */
+
+static pg_crc32 pg_comp_crc32c_choose(pg_crc32 crc, const void *data,
+					  size_t len);
+
+pg_crc32	(*pg_comp_crc32c) (pg_crc32 crc, const void *data, size_t len) =
+pg_comp_crc32c_choose;
+
 /* Accumulate one input byte */
 #ifdef WORDS_BIGENDIAN
 #define CRC8(x) pg_crc32c_table[0][((crc >> 24) ^ (x)) & 0xFF] ^ (crc << 8)
@@ -39,7 +69,7 @@
  * pp. 1550-1560, November 2008, doi:10.1109/TC.2008.85
  */
 pg_crc32
-pg_comp_crc32c(pg_crc32 crc, const void *data, size_t len)
+pg_comp_crc32c_sb8(pg_crc32 crc, const void *data, size_t len)
 {
 	const unsigned char *p = data;
 	const uint32 *p4;
@@ -105,6 +135,158 @@ pg_comp_crc32c(pg_crc32 crc, const void *data, size_t len)
 	return crc;
 }
 
+#ifdef USE_SSE42_CRC32C
+
+#ifdef _MSC_VER
+#define CRC32C_U8(crc, x)	((crc) = _mm_crc32_u8((crc), (x)))
+#define CRC32C_U64(crc, x)	((crc) = _mm_crc32_u64((crc), (x)))
+#else
+#define CRC32C_U8(crc, x) \
+	__asm__ ("crc32b %1, %0" : "+r" (crc) : "rm" ((uint8) (x)))
+#define CRC32C_U64(crc, x) \
+	__asm__ ("crc32q %1, %0" : "+r" (crc) : "rm" ((uint64) (x)))
+#endif
+
+/*
+ * Compute CRC-32C using the crc32 instruction of Intel SSE 4.2, eight bytes
+ * at a time.  Unaligned loads are fine on x86.
+ */
+static pg_crc32
+pg_comp_crc32c_sse42(pg_crc32 crc, const void *data, size_t len)
+{
+	const unsigned char *p = data;
+	const unsigned char *pend = p + len;
+	uint64		crc64 = crc;
+
+	while (p + 8 <= pend)
+	{
+		CRC32C_U64(crc64, *((const uint64 *) p));
+		p += 8;
+	}
+
+	crc = (pg_crc32) crc64;
+
+	while (p < pend)
+	{
+		CRC32C_U8(crc, *p);
+		p++;
+	}
+
+	return crc;
+}
+
+/*
+ * Does the CPU support the SSE 4.2 crc32 instruction?  That's reported in
+ * bit 20 of ECX by CPUID leaf 1.
+ */
+static bool
+pg_crc32c_sse42_available(void)
+{
+	unsigned int exx[4] = {0, 0, 0, 0};
+
+#ifdef _MSC_VER
+	__cpuid((int *) exx, 1);
+#else
+	if (!__get_cpuid(1, &exx[0], &exx[1], &exx[2], &exx[3]))
+		return false;
+#endif
+
+	return (exx[2] & (1 << 20)) != 0;
+}
+
+#endif   /* USE_SSE42_CRC32C */
+
+#ifdef USE_ARMV8_CRC32C
+
+/*
+ * The ".arch" directive lets the assembler accept the CRC instructions even
+ * if the compiler was not told to target them; callers must check that the
+ * CPU has them.
+ */
+#define CRC32C_U8(crc, x) \
+	__asm__ (".arch armv8-a+crc\n\tcrc32cb %w0, %w0, %w1" \
+			 : "+r" (crc) : "r" ((uint32) (x)))
+#define CRC32C_U64(crc, x) \
+	__asm__ (".arch armv8-a+crc\n\tcrc32cx %w0, %w0, %x1" \
+			 : "+r" (crc) : "r" ((uint64) (x)))
+
+/*
+ * Compute CRC-32C using the ARMv8 CRC extension, eight bytes at a time.
+ * Align the pointer first, since unaligned loads may be slow.
+ */
+static pg_crc32
+pg_comp_crc32c_armv8(pg_crc32 crc, const void *data, size_t len)
+{
+	const unsigned char *p = data;
+	const unsigned char *pend = p + len;
+
+	while (p < pend && ((uintptr_t) p & 7))
+	{
+		CRC32C_U8(crc, *p);
+		p++;
+	}
+
+	while (p + 8 <= pend)
+	{
+		CRC32C_U64(crc, *((const uint64 *) p));
+		p += 8;
+	}
+
+	while (p < pend)
+	{
+		CRC32C_U8(crc, *p);
+		p++;
+	}
+
+	return crc;
+}
+
+#endif   /* USE_ARMV8_CRC32C */
+
+/*
+ * Returns the hardware CRC-32C implementation that the CPU we're running on
+ * supports, and sets *name to a short name for it; or returns NULL if there
+ * is none.  This is exported for the benefit of test code that compares the
+ * implementations.
+ */
+pg_crc32c_impl
+pg_crc32c_hardware_impl(const char **name)
+{
+#ifdef USE_SSE42_CRC32C
+	if (pg_crc32c_sse42_available())
+	{
+		*name = "sse4.2";
+		return pg_comp_crc32c_sse42;
+	}
+#endif
+#ifdef USE_ARMV8_CRC32C
+	if (getauxval(AT_HWCAP) & HWCAP_CRC32)
+	{
+		*name = "armv8";
+		return pg_comp_crc32c_armv8;
+	}
+#endif
+
+	*name = NULL;
+	return NULL;
+}
+
+/*
+ * Called on the first use of pg_comp_crc32c; picks the best implementation,
+ * remembers it for future calls, and uses it for this one.
+ */
+static pg_crc32
+pg_comp_crc32c_choose(pg_crc32 crc, const void *data, size_t len)
+{
+	const char *name;
+
+	pg_comp_crc32c = pg_crc32c_hardware_impl(&name);
+	if (pg_comp_crc32c == NULL)
+		pg_comp_crc32c = pg_comp_crc32c_sb8;
+
+	return pg_comp_crc32c(crc, data, len);
+}
+
 /*
  * Lookup tables for the slicing-by-8 algorithm, for the so-called Castagnoli
  * polynomial (the same that is used e.g. in iSCSI), 0x1EDC6F41. Using
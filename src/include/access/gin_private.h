@@ -375,6 +375,9 @@ typedef struct GinState
 	FmgrInfo	comparePartialFn[INDEX_MAX_KEYS];		/* optional method */
 	/* canPartialMatch[i] is true if comparePartialFn[i] is valid */
 	bool		canPartialMatch[INDEX_MAX_KEYS];
+	FmgrInfo	orderingFn[INDEX_MAX_KEYS];		/* optional method */
+	/* canOrdering[i] is true if orderingFn[i] is valid */
+	bool		canOrdering[INDEX_MAX_KEYS];
 	/* Collations to pass to the support functions */
 	Oid			supportCollation[INDEX_MAX_KEYS];
 } GinState;
@@ -755,7 +758,9 @@ extern void ginVacuumPostingTreeLeaf(Relation rel, Buffer buf, GinVacuumState *g
  *
  * In each GinScanKeyData, nentries is the true number of entries, while
  * nuserentries is the number that extractQueryFn returned (which is what
- * we report to consistentFn).  The "user" entries must come first.
+ * we report to consistentFn).  The "user" entries must come first.  The key
+ * of an ORDER BY operator always has one hidden entry, which finds the NULL
+ * items, so that they can be sorted last.
  */
 typedef struct GinScanKeyData *GinScanKey;
 
@@ -846,8 +851,35 @@ typedef struct GinScanEntryData
 	bool		reduceResult;
 	uint32		predictNumberResult;
 	GinBtreeData btree;
+
+	/* true if the entry belongs to the key of an ORDER BY operator */
+	bool		isOrderBy;
+
+	/*
+	 * A partial-match entry of an ORDER BY key reads the posting lists of the
+	 * index keys it matches through one sub-entry per key, rather than a
+	 * bitmap, so that matchKey can tell which key the current item was found
+	 * under.
+	 */
+	GinScanEntry *subEntries;
+	int			nsubEntries;
+	Datum		matchKey;
 }	GinScanEntryData;
 
+/*
+ * A matching item collected by an ordered scan, with its distance for each
+ * ORDER BY operator.
+ */
+typedef struct GinOrderedItem
+{
+	ItemPointerData iptr;
+	bool		recheck;
+	double		distances[FLEXIBLE_ARRAY_MEMBER];
+} GinOrderedItem;
+
+#define SizeOfGinOrderedItem(norderbys) \
+	MAXALIGN(offsetof(GinOrderedItem, distances) + sizeof(double) * (norderbys))
+
 typedef struct GinScanOpaqueData
 {
 	MemoryContext tempCtx;
@@ -863,6 +895,28 @@ typedef struct GinScanOpaqueData
 	MemoryContext keyCtx;		/* used to hold key and entry data */
 
 	bool		isVoidRes;		/* true if query is unsatisfiable */
+
+	/*
+	 * In an ordered scan, orderKeys has a key for each ORDER BY operator
+	 * (NULL if its argument is null).  Their entries don't restrict the scan,
+	 * they only feed the opclass's ordering function.  gingettuple collects
+	 * the matching items in orderedItems, sorted by distance, in batches of
+	 * at most orderedItemsLimit items, and they are returned from there.
+	 * lastOrderedItem is the last item of the previous batch, which the
+	 * next one starts after; unlike the rest, it survives ginFreeScanKeys.
+	 */
+	GinScanKey *orderKeys;
+	int			norderkeys;
+	char	   *orderedItems;	/* array of GinOrderedItem */
+	int64		nOrderedItems;
+	int64		maxOrderedItems;	/* allocated length of orderedItems */
+	int64		orderedItemsLimit;	/* maximum number of items in a batch */
+	int64		curOrderedItem;
+	bool		orderedItemsReady;
+	bool		orderedItemsTruncated;	/* are there items after the batch? */
+	GinOrderedItem *newOrderedItem;		/* workspace for a new item */
+	GinOrderedItem *lastOrderedItem;
+	bool		haveLastOrderedItem;
 } GinScanOpaqueData;
 
 typedef GinScanOpaqueData *GinScanOpaque;
@@ -877,6 +931,7 @@ extern void ginFreeScanKeys(GinScanOpaque so);
 
 /* ginget.c */
 extern Datum gingetbitmap(PG_FUNCTION_ARGS);
+extern Datum gingettuple(PG_FUNCTION_ARGS);
 
 /* ginlogic.c */
 extern void ginInitConsistentFunction(GinState *ginstate, GinScanKey key);
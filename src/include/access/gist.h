@@ -33,7 +33,9 @@
 #define GIST_PICKSPLIT_PROC				6
 #define GIST_EQUAL_PROC					7
 #define GIST_DISTANCE_PROC				8
-#define GISTNProcs						8
+#define GIST_FETCH_PROC					9
+#define GIST_SORTSUPPORT_PROC			10
+#define GISTNProcs						10
 
 /*
  * strategy numbers for GiST opclasses that want to implement the old
@@ -16,6 +16,7 @@
 
 #include "access/itup.h"
 #include "access/spgist.h"
+#include "lib/pairingheap.h"
 #include "nodes/tidbitmap.h"
 #include "storage/buf.h"
 #include "utils/relcache.h"
@@ -143,9 +144,17 @@ typedef struct SpGistScanOpaqueData
 	int			numberOfKeys;	/* number of index qualifier conditions */
 	ScanKey		keyData;		/* array of index qualifier descriptors */
 
+	/* Ordering operators, for ordered (k-NN) scans */
+	int			numberOfOrderBys;		/* number of ordering operators */
+	ScanKey		orderByData;	/* array of ordering op descriptors */
+	double	   *distances;		/* workspace for leaf_consistent distances */
+
 	/* Stack of yet-to-be-visited pages */
 	List	   *scanStack;		/* List of ScanStackEntrys */
 
+	/* Queue of yet-to-be-visited pages and items, used in ordered scans */
+	pairingheap *scanQueue;		/* pairing heap of ScanStackEntrys */
+
 	/* These fields are only used in amgetbitmap scans: */
 	TIDBitmap  *tbm;			/* bitmap being filled */
 	int64		ntids;			/* number of TIDs passed to bitmap */
@@ -646,4 +655,8 @@ extern void spgPageIndexMultiDelete(SpGistState *state, Page page,
 extern bool spgdoinsert(Relation index, SpGistState *state,
 			ItemPointer heapPtr, Datum datum, bool isnull);
 
+/* spgproc.c */
+extern double *spg_key_orderbys_distances(Datum key, bool isLeaf,
+						   ScanKey orderbys, int norderbys);
+
 #endif   /* SPGIST_PRIVATE_H */
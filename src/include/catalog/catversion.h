@@ -53,6 +53,6 @@
  */
 
 /*							yyyymmddN */
-#define CATALOG_VERSION_NO	201502191
+#define CATALOG_VERSION_NO	201502210
 
 #endif
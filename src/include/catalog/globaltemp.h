@@ -0,0 +1,31 @@
+/*-------------------------------------------------------------------------
+ *
+ * globaltemp.h
+ *	  Per-session storage of global temporary relations
+ *
+ *
+ * Portions Copyright (c) 1996-2015, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/catalog/globaltemp.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef GLOBALTEMP_H
+#define GLOBALTEMP_H
+
+#include "storage/lock.h"
+#include "storage/relfilenode.h"
+#include "utils/relcache.h"
+
+extern void GlobalTempRelationInitStorage(Relation rel);
+extern void GlobalTempRelationInitIndexes(Relation rel, LOCKMODE lockmode);
+extern bool GlobalTempRelationHasStorage(Relation rel);
+extern void GlobalTempStorageCreated(Relation rel);
+extern void GlobalTempStorageDropped(RelFileNode rnode);
+extern void GlobalTempIndexSetValid(Relation index, bool valid);
+extern void GlobalTempSetFrozenXid(Relation rel, TransactionId frozenXid,
+					   MultiXactId minMulti);
+extern void PreCommit_GlobalTemp(void);
+
+#endif   /* GLOBALTEMP_H */
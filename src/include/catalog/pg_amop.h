@@ -713,6 +713,13 @@ DATA(insert (	3655   3614 3615 1 s	3636 783 0 ));
 DATA(insert (	3659   3614 3615 1 s	3636 2742 0 ));
 DATA(insert (	3659   3614 3615 2 s	3660 2742 0 ));
 
+/*
+ * GIN tsvector_rank_ops
+ */
+DATA(insert (	3283   3614 3615 1 s	3636 2742 0 ));
+DATA(insert (	3283   3614 3615 2 s	3660 2742 0 ));
+DATA(insert (	3283   3614 3615 3 o	3290 2742 1970 ));
+
 /*
  * btree tsquery_ops
  */
@@ -765,6 +772,7 @@ DATA(insert (	4015   600 600 5 s	508 4000 0 ));
 DATA(insert (	4015   600 600 10 s 509 4000 0 ));
 DATA(insert (	4015   600 600 6 s	510 4000 0 ));
 DATA(insert (	4015   600 603 8 s	511 4000 0 ));
+DATA(insert (	4015   600 600 15 o 517 4000 1970 ));
 
 /*
  * SP-GiST kd_point_ops
@@ -775,6 +783,7 @@ DATA(insert (	4016   600 600 5 s	508 4000 0 ));
 DATA(insert (	4016   600 600 10 s 509 4000 0 ));
 DATA(insert (	4016   600 600 6 s	510 4000 0 ));
 DATA(insert (	4016   600 603 8 s	511 4000 0 ));
+DATA(insert (	4016   600 600 15 o 517 4000 1970 ));
 
 /*
  * SP-GiST text_ops
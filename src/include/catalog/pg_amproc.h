@@ -191,6 +191,8 @@ DATA(insert (	1029   600 600 5 2581 ));
 DATA(insert (	1029   600 600 6 2582 ));
 DATA(insert (	1029   600 600 7 2584 ));
 DATA(insert (	1029   600 600 8 3064 ));
+DATA(insert (	1029   600 600 9 3281 ));
+DATA(insert (	1029   600 600 10 3282 ));
 DATA(insert (	2593   603 603 1 2578 ));
 DATA(insert (	2593   603 603 2 2583 ));
 DATA(insert (	2593   603 603 3 2579 ));
@@ -198,6 +200,7 @@ DATA(insert (	2593   603 603 4 2580 ));
 DATA(insert (	2593   603 603 5 2581 ));
 DATA(insert (	2593   603 603 6 2582 ));
 DATA(insert (	2593   603 603 7 2584 ));
+DATA(insert (	2593   603 603 9 2580 ));
 DATA(insert (	2594   604 604 1 2585 ));
 DATA(insert (	2594   604 604 2 2583 ));
 DATA(insert (	2594   604 604 3 2586 ));
@@ -233,6 +236,7 @@ DATA(insert (	3919   3831 3831 4 3878 ));
 DATA(insert (	3919   3831 3831 5 3879 ));
 DATA(insert (	3919   3831 3831 6 3880 ));
 DATA(insert (	3919   3831 3831 7 3881 ));
+DATA(insert (	3919   3831 3831 9 3878 ));
 
 
 /* gin */
@@ -392,6 +396,13 @@ DATA(insert (	3659   3614 3614 3 3657 ));
 DATA(insert (	3659   3614 3614 4 3658 ));
 DATA(insert (	3659   3614 3614 5 2700 ));
 DATA(insert (	3659   3614 3614 6 3921 ));
+DATA(insert (	3283   3614 3614 1 3724 ));
+DATA(insert (	3283   3614 3614 2 3284 ));
+DATA(insert (	3283   3614 3614 3 3285 ));
+DATA(insert (	3283   3614 3614 4 3286 ));
+DATA(insert (	3283   3614 3614 5 2700 ));
+DATA(insert (	3283   3614 3614 6 3287 ));
+DATA(insert (	3283   3614 3614 7 3288 ));
 DATA(insert (	4036   3802 3802 1 3480 ));
 DATA(insert (	4036   3802 3802 2 3482 ));
 DATA(insert (	4036   3802 3802 3 3483 ));
@@ -1652,6 +1652,8 @@ DATA(insert OID = 3660 (  "@@@"    PGNSP PGUID b f f 3614	 3615	 16 3661	0	 ts_m
 DESCR("deprecated, use @@ instead");
 DATA(insert OID = 3661 (  "@@@"    PGNSP PGUID b f f 3615	 3614	 16 3660	0	 ts_match_qv   tsmatchsel tsmatchjoinsel ));
 DESCR("deprecated, use @@ instead");
+DATA(insert OID = 3290 (  "<=>"    PGNSP PGUID b f f 3614	 3615	 700	0	0	 ts_rank_distance   -	-	  ));
+DESCR("distance by estimated rank");
 DATA(insert OID = 3674 (  "<"	   PGNSP PGUID b f f 3615	 3615	 16 3679 3678	 tsquery_lt scalarltsel scalarltjoinsel ));
 DESCR("less than");
 DATA(insert OID = 3675 (  "<="	   PGNSP PGUID b f f 3615	 3615	 16 3678 3679	 tsquery_le scalarltsel scalarltjoinsel ));
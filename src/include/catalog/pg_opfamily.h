@@ -141,6 +141,7 @@ DATA(insert OID = 3523 (	405		enum_ops		PGNSP PGUID ));
 DATA(insert OID = 3626 (	403		tsvector_ops	PGNSP PGUID ));
 DATA(insert OID = 3655 (	783		tsvector_ops	PGNSP PGUID ));
 DATA(insert OID = 3659 (	2742	tsvector_ops	PGNSP PGUID ));
+DATA(insert OID = 3283 (	2742	tsvector_rank_ops	PGNSP PGUID ));
 DATA(insert OID = 3683 (	403		tsquery_ops		PGNSP PGUID ));
 DATA(insert OID = 3702 (	783		tsquery_ops		PGNSP PGUID ));
 DATA(insert OID = 3901 (	403		range_ops		PGNSP PGUID ));
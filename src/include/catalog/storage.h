@@ -14,6 +14,7 @@
 #ifndef STORAGE_H
 #define STORAGE_H
 
+#include "storage/backendid.h"
 #include "storage/block.h"
 #include "storage/relfilenode.h"
 #include "utils/relcache.h"
@@ -29,6 +30,7 @@ extern void RelationTruncate(Relation rel, BlockNumber nblocks);
  */
 extern void smgrDoPendingDeletes(bool isCommit);
 extern int	smgrGetPendingDeletes(bool forCommit, RelFileNode **ptr);
+extern bool smgrIsPendingDelete(RelFileNode rnode, BackendId backend);
 extern void AtSubCommit_smgr(void);
 extern void AtSubAbort_smgr(void);
 extern void PostPrepare_smgr(void);
@@ -49,7 +49,7 @@ extern void AlterRelationNamespaceInternal(Relation classRel, Oid relOid,
 
 extern void CheckTableNotInUse(Relation rel, const char *stmt);
 
-extern void ExecuteTruncate(TruncateStmt *stmt);
+extern void ExecuteTruncate(TruncateStmt *stmt, bool isTopLevel);
 
 extern void SetRelationHasSubclass(Oid relationId, bool relhassubclass);
 
@@ -71,7 +71,18 @@ typedef uint32 pg_crc32;
 	((crc) = pg_comp_crc32c((crc), (data), (len)))
 #define EQ_CRC32C(c1, c2) ((c1) == (c2))
 
-extern pg_crc32 pg_comp_crc32c(pg_crc32 crc, const void *data, size_t len);
+/*
+ * pg_comp_crc32c is a function pointer, which is set on first use to the
+ * fastest implementation that the CPU we're running on supports: the SSE 4.2
+ * CRC32 instruction on x86-64, the ARMv8 CRC32C instructions, or failing
+ * those, a slicing-by-8 lookup table implementation.
+ */
+extern CRCDLLIMPORT pg_crc32 (*pg_comp_crc32c) (pg_crc32 crc, const void *data, size_t len);
+
+typedef pg_crc32 (*pg_crc32c_impl) (pg_crc32 crc, const void *data, size_t len);
+
+extern pg_crc32 pg_comp_crc32c_sb8(pg_crc32 crc, const void *data, size_t len);
+extern pg_crc32c_impl pg_crc32c_hardware_impl(const char **name);
 
 /*
  * CRC-32, the same used e.g. in Ethernet.
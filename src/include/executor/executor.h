@@ -117,6 +117,13 @@ extern bool execCurrentOf(CurrentOfExpr *cexpr,
 			  Oid table_oid,
 			  ItemPointer current_tid);
 
+/*
+ * Each pass of a TupleHashSpill partitions its tuples using this many more
+ * bits of their hash value (see execGrouping.c).
+ */
+#define TUPLE_HASH_SPILL_BITS		5
+#define TUPLE_HASH_SPILL_PARTITIONS	(1 << TUPLE_HASH_SPILL_BITS)
+
 /*
  * prototypes from functions in execGrouping.c
  */
@@ -151,6 +158,16 @@ extern TupleHashEntry FindTupleHashEntry(TupleHashTable hashtable,
 				   TupleTableSlot *slot,
 				   FmgrInfo *eqfunctions,
 				   FmgrInfo *hashfunctions);
+extern TupleHashSpill TupleHashSpillCreate(TupleHashBatch batch);
+extern bool TupleHashSpillNeeded(TupleHashSpill spill,
+					 TupleHashTable hashtable);
+extern bool TupleHashSpillStarted(TupleHashSpill spill);
+extern void TupleHashSpillTuple(TupleHashSpill spill, TupleHashTable hashtable,
+					TupleTableSlot *hashslot, TupleTableSlot *slot);
+extern List *TupleHashSpillFinish(TupleHashSpill spill, List *batches);
+extern TupleTableSlot *TupleHashBatchRead(TupleHashBatch batch,
+				   TupleTableSlot *slot);
+extern void TupleHashBatchEnd(TupleHashBatch batch);
 
 /*
  * prototypes from functions in execJunk.c
@@ -247,6 +264,14 @@ extern int	ExecTargetListLength(List *targetlist);
 extern int	ExecCleanTargetListLength(List *targetlist);
 extern TupleTableSlot *ExecProject(ProjectionInfo *projInfo,
 			ExprDoneCond *isDone);
+extern bool ExecScalarArrayOpCanHash(ScalarArrayOpExpr *opexpr,
+						 Oid *eqop, Oid *lhs_hashfn, Oid *rhs_hashfn);
+
+/*
+ * ScalarArrayOpExprs over constant arrays with at least this many elements
+ * are evaluated using a hash table, when the operator allows it.
+ */
+#define MIN_ARRAY_SIZE_FOR_HASHED_SAOP	9
 
 /*
  * prototypes from functions in execScan.c
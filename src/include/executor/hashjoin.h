@@ -181,6 +181,8 @@ typedef struct HashJoinTableData
 
 	MemoryContext hashCxt;		/* context for whole-hash-join storage */
 	MemoryContext batchCxt;		/* context for this-batch-only storage */
+	MemoryContext budgetCxt;	/* context holding query's memory budget, or
+								 * NULL if none (or already exhausted) */
 
 	/* used for dense allocation of tuples (into linked chunks) */
 	HashMemoryChunk chunks;		/*  one list for the whole batch */
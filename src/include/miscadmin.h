@@ -238,6 +238,8 @@ extern bool enableFsync;
 extern bool allowSystemTableMods;
 extern PGDLLIMPORT int work_mem;
 extern PGDLLIMPORT int maintenance_work_mem;
+extern PGDLLIMPORT int query_work_mem;
+extern PGDLLIMPORT int session_memory_limit;
 
 extern int	VacuumCostPageHit;
 extern int	VacuumCostPageMiss;
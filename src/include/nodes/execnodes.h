@@ -473,6 +473,15 @@ typedef struct ExecAuxRowMark
 typedef struct TupleHashEntryData *TupleHashEntry;
 typedef struct TupleHashTableData *TupleHashTable;
 
+/*
+ * Tuples of groups that don't fit in a TupleHashTable can be set aside in a
+ * TupleHashSpill, which partitions them into temporary files by hash value.
+ * Each partition then becomes a TupleHashBatch, to be processed in a later
+ * pass with a fresh hash table.  Both are private to execGrouping.c.
+ */
+typedef struct TupleHashSpillData *TupleHashSpill;
+typedef struct TupleHashBatchData *TupleHashBatch;
+
 typedef struct TupleHashEntryData
 {
 	/* firstTuple must be the first field in this struct! */
@@ -489,6 +498,8 @@ typedef struct TupleHashTableData
 	FmgrInfo   *tab_eq_funcs;	/* equality functions for table datatype(s) */
 	MemoryContext tablecxt;		/* memory context containing table */
 	MemoryContext tempcxt;		/* context for function evaluations */
+	MemoryContext budgetcxt;	/* context holding query's memory budget, or
+								 * NULL if none */
 	Size		entrysize;		/* actual size to make each hash entry */
 	TupleTableSlot *tableslot;	/* slot for referencing table entries */
 	/* The following fields are set transiently for each table search: */
@@ -699,8 +710,26 @@ typedef struct FuncExprState
  *		ScalarArrayOpExprState node
  *
  * This is a FuncExprState plus some additional data.
+ *
+ * A large array that doesn't change during execution may be loaded into a
+ * ScalarArrayOpHashTable, so that each scalar can be checked by a hash
+ * probe instead of comparing it to every element.
  * ----------------
  */
+typedef struct ScalarArrayOpHashTable
+{
+	Datum		array;			/* the array datum the table was built from */
+	FmgrInfo	hash_finfo;		/* hash function for the scalar's type */
+	FmgrInfo	eq_finfo;		/* equality function */
+	bool		has_nulls;		/* does the array contain NULLs? */
+	int			nvalues;		/* number of non-null elements */
+	Datum	   *values;			/* the non-null elements */
+	uint32	   *hashes;			/* their hash values */
+	int		   *next;			/* next element in same bucket, or -1 */
+	int		   *buckets;		/* first element in each bucket, or -1 */
+	uint32		mask;			/* number of buckets - 1 */
+} ScalarArrayOpHashTable;
+
 typedef struct ScalarArrayOpExprState
 {
 	FuncExprState fxprstate;
@@ -709,6 +738,9 @@ typedef struct ScalarArrayOpExprState
 	int16		typlen;
 	bool		typbyval;
 	char		typalign;
+	/* Hash table of the array elements, if we're using one */
+	bool		hash_checked;	/* have we tried to build it yet? */
+	ScalarArrayOpHashTable *hashtable;	/* NULL if not hashing */
 } ScalarArrayOpExprState;
 
 /* ----------------
@@ -1764,6 +1796,9 @@ typedef struct AggState
 	List	   *hash_needed;	/* list of columns needed in hash table */
 	bool		table_filled;	/* hash table filled yet? */
 	TupleHashIterator hashiter; /* for iterating through hash table */
+	List	   *hash_batches;	/* spilled TupleHashBatches still to do */
+	bool		hash_spilled;	/* has the current scan spilled any groups? */
+	TupleTableSlot *hash_batchslot;		/* slot for reading spilled tuples */
 } AggState;
 
 /* ----------------
@@ -1788,6 +1823,7 @@ typedef struct WindowAggState
 	FmgrInfo   *partEqfunctions;	/* equality funcs for partition columns */
 	FmgrInfo   *ordEqfunctions; /* equality funcs for ordering columns */
 	Tuplestorestate *buffer;	/* stores rows of current partition */
+	Tuplestorestate *spare_buffer;	/* emptied buffer kept for reuse */
 	int			current_ptr;	/* read pointer # for current */
 	int64		spooled_rows;	/* total # of rows in buffer */
 	int64		currentpos;		/* position of current row in partition */
@@ -1889,6 +1925,9 @@ typedef struct SetOpState
 	MemoryContext tableContext; /* memory context containing hash table */
 	bool		table_filled;	/* hash table filled yet? */
 	TupleHashIterator hashiter; /* for iterating through hash table */
+	List	   *hash_batches;	/* spilled TupleHashBatches still to do */
+	bool		hash_spilled;	/* has the current scan spilled any groups? */
+	TupleTableSlot *hash_batchslot;		/* slot for reading spilled tuples */
 } SetOpState;
 
 /* ----------------
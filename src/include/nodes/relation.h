@@ -103,6 +103,10 @@ typedef struct PlannerGlobal
 
 	bool		hasRowSecurity;	/* row security applied? */
 
+	bool		choosingAggSublinks;	/* planning a query level both with
+										 * and without converted aggregate
+										 * sub-SELECTs? */
+
 } PlannerGlobal;
 
 /* macro for fetching the Plan associated with a SubPlan node */
@@ -232,6 +236,8 @@ typedef struct PlannerInfo
 
 	List	   *minmax_aggs;	/* List of MinMaxAggInfos */
 
+	List	   *union_or_arms;	/* OR-clause arms planned by planunionor.c */
+
 	List	   *initial_rels;	/* RelOptInfos we are now trying to join */
 
 	MemoryContext planner_cxt;	/* context holding PlannerInfo */
@@ -535,6 +541,7 @@ typedef struct IndexOptInfo
 	bool		hypothetical;	/* true if index doesn't really exist */
 	bool		canreturn;		/* can index return IndexTuples? */
 	bool		amcanorderbyop; /* does AM support order by operator result? */
+	bool		amorderbyonly;	/* is amgettuple only for ordered scans? */
 	bool		amoptionalkey;	/* can query omit key for the first column? */
 	bool		amsearcharray;	/* can AM handle ScalarArrayOpExpr quals? */
 	bool		amsearchnulls;	/* can AM search for NULL/NOT NULL entries? */
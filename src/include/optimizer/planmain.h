@@ -37,6 +37,13 @@ extern void preprocess_minmax_aggregates(PlannerInfo *root, List *tlist);
 extern Plan *optimize_minmax_aggregates(PlannerInfo *root, List *tlist,
 						   const AggClauseCosts *aggcosts, Path *best_path);
 
+/*
+ * prototypes for plan/planunionor.c
+ */
+extern void preprocess_union_or(PlannerInfo *root, List *tlist);
+extern Plan *optimize_union_or(PlannerInfo *root, Path *best_path,
+				  double tuple_fraction);
+
 /*
  * prototypes for plan/createplan.c
  */
@@ -21,6 +21,7 @@
 /*
  * prototypes for prepjointree.c
  */
+extern Query *pull_up_agg_sublinks(PlannerInfo *root);
 extern void pull_up_sublinks(PlannerInfo *root);
 extern void inline_set_returning_functions(PlannerInfo *root);
 extern Node *pull_up_subqueries(PlannerInfo *root, Node *jtnode);
@@ -45,4 +45,9 @@ extern void build_aggregate_fnexprs(Oid *agg_input_types,
 						Expr **invtransfnexpr,
 						Expr **finalfnexpr);
 
+extern void build_aggregate_combinefn_expr(Oid agg_state_type,
+							   Oid agg_input_collation,
+							   Oid combinefn_oid,
+							   Expr **combinefnexpr);
+
 #endif   /* PARSE_AGG_H */
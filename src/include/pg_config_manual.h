@@ -119,6 +119,14 @@
  */
 #define ALIGNOF_BUFFER	32
 
+/*
+ * Alignment of buffers that may be read or written with direct I/O (see the
+ * direct_io parameter).  Direct I/O requires the memory address, as well as
+ * the file offset and length, to be a multiple of the device's logical block
+ * size; 4kB covers all common devices.
+ */
+#define PG_IO_ALIGN_SIZE	4096
+
 /*
  * Disable UNIX sockets for certain operating systems.
  */
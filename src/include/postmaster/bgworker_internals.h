@@ -44,6 +44,7 @@ extern void ForgetBackgroundWorker(slist_mutable_iter *cur);
 extern void ReportBackgroundWorkerPID(RegisteredBgWorker *);
 extern void BackgroundWorkerStopNotifications(pid_t pid);
 extern void ResetBackgroundWorkerCrashTimes(void);
+extern void RegisterInternalBackgroundWorker(BackgroundWorker *worker);
 
 /* Function to start a background worker, called from postmaster.c */
 extern void StartBackgroundWorker(void) __attribute__((noreturn));
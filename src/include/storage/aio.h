@@ -0,0 +1,41 @@
+/*-------------------------------------------------------------------------
+ *
+ * aio.h
+ *	  Asynchronous buffer I/O carried out by I/O worker processes.
+ *
+ * Portions Copyright (c) 1996-2015, PostgreSQL Global Development Group
+ *
+ * src/include/storage/aio.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef AIO_H
+#define AIO_H
+
+#include "fmgr.h"
+#include "storage/block.h"
+#include "storage/bufmgr.h"
+#include "storage/relfilenode.h"
+
+/* Upper limit for the io_workers GUC */
+#define MAX_IO_WORKERS		32
+
+/* GUC variable */
+extern int	io_workers;
+
+extern Size AioShmemSize(void);
+extern void AioShmemInit(void);
+extern void AioRegisterWorkers(void);
+
+extern bool AioSubmitReadBuffer(RelFileNode rnode, ForkNumber forkNum,
+					BlockNumber blockNum, BufferAccessStrategyType btype);
+extern bool AioSubmitWriteBuffer(int buf_id);
+extern void AioWaitForCompletion(void);
+extern void AioCancelReads(const RelFileNode *rnodes, int nnodes);
+extern void AioCancelDatabaseReads(Oid dbid);
+
+extern void IoWorkerMain(Datum main_arg) __attribute__((noreturn));
+
+extern Datum pg_stat_get_aio(PG_FUNCTION_ARGS);
+
+#endif   /* AIO_H */
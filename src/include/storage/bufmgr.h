@@ -22,6 +22,9 @@
 
 typedef void *Block;
 
+/* forward declared, to avoid having to include smgr.h here */
+struct SMgrRelationData;
+
 /* Possible arguments for GetAccessStrategy() */
 typedef enum BufferAccessStrategyType
 {
@@ -146,6 +149,8 @@ extern PGDLLIMPORT int32 *LocalRefCount;
  */
 extern void PrefetchBuffer(Relation reln, ForkNumber forkNum,
 			   BlockNumber blockNum);
+extern void PrefetchBufferExtended(Relation reln, ForkNumber forkNum,
+					   BlockNumber blockNum, BufferAccessStrategyType btype);
 extern Buffer ReadBuffer(Relation reln, BlockNumber blockNum);
 extern Buffer ReadBufferExtended(Relation reln, ForkNumber forkNum,
 				   BlockNumber blockNum, ReadBufferMode mode,
@@ -171,9 +176,10 @@ extern BlockNumber RelationGetNumberOfBlocksInFork(Relation relation,
 								ForkNumber forkNum);
 extern void FlushRelationBuffers(Relation rel);
 extern void FlushDatabaseBuffers(Oid dbid);
-extern void DropRelFileNodeBuffers(RelFileNodeBackend rnode,
+extern void DropRelFileNodeBuffers(struct SMgrRelationData *smgr_reln,
 					   ForkNumber forkNum, BlockNumber firstDelBlock);
-extern void DropRelFileNodesAllBuffers(RelFileNodeBackend *rnodes, int nnodes);
+extern void DropRelFileNodesAllBuffers(struct SMgrRelationData **smgr_reln,
+						   int nnodes);
 extern void DropDatabaseBuffers(Oid dbid);
 
 #define RelationGetNumberOfBlocks(reln) \
@@ -202,6 +208,7 @@ extern void AbortBufferIO(void);
 
 extern void BufmgrCommit(void);
 extern bool BgBufferSync(void);
+extern void SyncCheckpointBuffer(int buf_id);
 
 extern void AtProcExit_LocalBuffers(void);
 
@@ -77,7 +77,11 @@
  * available on x86 SSE4.1 extensions (pmulld) and ARM NEON (vmul.i32).
  * Vectorization requires a compiler to do the vectorization for us. For recent
  * GCC versions the flags -msse4.1 -funroll-loops -ftree-vectorize are enough
- * to achieve vectorization.
+ * to achieve vectorization; with -mavx2 the loop is done in 256-bit registers
+ * (vpmulld), which is about twice as fast again.  Since the baseline x86-64
+ * instruction set lacks pmulld, checksum.c asks the compiler to build
+ * versions for those instruction sets and select one at runtime, where the
+ * toolchain supports that.
  *
  * The optimal amount of parallelism to use depends on CPU specific instruction
  * latency, SIMD instruction width, throughput and the amount of registers
@@ -131,10 +135,20 @@ do { \
 	(checksum) = __tmp * FNV_PRIME ^ (__tmp >> 17); \
 } while (0)
 
+/*
+ * The includer may define PG_CHECKSUM_BLOCK_ATTRIBUTE to attach a function
+ * attribute to pg_checksum_block, for instance to have the compiler build it
+ * for several instruction sets and choose among them at runtime.
+ */
+#ifndef PG_CHECKSUM_BLOCK_ATTRIBUTE
+#define PG_CHECKSUM_BLOCK_ATTRIBUTE
+#endif
+
 /*
  * Block checksum algorithm.  The data argument must be aligned on a 4-byte
  * boundary.
  */
+PG_CHECKSUM_BLOCK_ATTRIBUTE
 static uint32
 pg_checksum_block(char *data, uint32 size)
 {
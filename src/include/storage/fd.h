@@ -51,8 +51,18 @@ typedef char *FileName;
 typedef int File;
 
 
-/* GUC parameter */
+/* Possible values for direct_io; a bitmask of the kinds of files affected */
+typedef enum DirectIOMode
+{
+	DIRECT_IO_OFF = 0,
+	DIRECT_IO_DATA = 1,			/* relation data files */
+	DIRECT_IO_WAL = 2,			/* WAL segment files */
+	DIRECT_IO_ALL = 3
+} DirectIOMode;
+
+/* GUC parameters */
 extern int	max_files_per_process;
+extern int	direct_io;
 
 /*
  * This is private to fd.c, but exported for save/restore_backend_variables()
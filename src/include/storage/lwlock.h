@@ -124,7 +124,7 @@ extern PGDLLIMPORT LWLockPadded *MainLWLockArray;
 #define AsyncQueueLock				(&MainLWLockArray[27].lock)
 #define SerializableXactHashLock	(&MainLWLockArray[28].lock)
 #define SerializableFinishedListLock		(&MainLWLockArray[29].lock)
-#define SerializablePredicateLockListLock	(&MainLWLockArray[30].lock)
+/* 30 is available; was formerly SerializablePredicateLockListLock */
 #define OldSerXidLock				(&MainLWLockArray[31].lock)
 #define SyncRepLock					(&MainLWLockArray[32].lock)
 #define BackgroundWorkerLock		(&MainLWLockArray[33].lock)
@@ -134,8 +134,9 @@ extern PGDLLIMPORT LWLockPadded *MainLWLockArray;
 #define ReplicationSlotControlLock		(&MainLWLockArray[37].lock)
 #define CommitTsControlLock			(&MainLWLockArray[38].lock)
 #define CommitTsLock				(&MainLWLockArray[39].lock)
+#define TsSharedDictLock			(&MainLWLockArray[40].lock)
 
-#define NUM_INDIVIDUAL_LWLOCKS		40
+#define NUM_INDIVIDUAL_LWLOCKS		41
 
 /*
  * It's a bit odd to declare NUM_BUFFER_PARTITIONS and NUM_LOCK_PARTITIONS
@@ -154,14 +155,29 @@ extern PGDLLIMPORT LWLockPadded *MainLWLockArray;
 #define LOG2_NUM_PREDICATELOCK_PARTITIONS  4
 #define NUM_PREDICATELOCK_PARTITIONS  (1 << LOG2_NUM_PREDICATELOCK_PARTITIONS)
 
+/*
+ * Number of partitions of the lock protecting predicate lock lists; see
+ * predicate.c
+ */
+#define LOG2_NUM_PREDICATELOCK_LIST_PARTITIONS  4
+#define NUM_PREDICATELOCK_LIST_PARTITIONS  (1 << LOG2_NUM_PREDICATELOCK_LIST_PARTITIONS)
+
+/* Number of partitions of the shared relation size cache */
+#define LOG2_NUM_SMGR_SIZE_PARTITIONS  4
+#define NUM_SMGR_SIZE_PARTITIONS  (1 << LOG2_NUM_SMGR_SIZE_PARTITIONS)
+
 /* Offsets for various chunks of preallocated lwlocks. */
 #define BUFFER_MAPPING_LWLOCK_OFFSET	NUM_INDIVIDUAL_LWLOCKS
 #define LOCK_MANAGER_LWLOCK_OFFSET		\
 	(BUFFER_MAPPING_LWLOCK_OFFSET + NUM_BUFFER_PARTITIONS)
 #define PREDICATELOCK_MANAGER_LWLOCK_OFFSET \
 	(LOCK_MANAGER_LWLOCK_OFFSET + NUM_LOCK_PARTITIONS)
-#define NUM_FIXED_LWLOCKS \
+#define SMGR_SIZE_LWLOCK_OFFSET		\
 	(PREDICATELOCK_MANAGER_LWLOCK_OFFSET + NUM_PREDICATELOCK_PARTITIONS)
+#define PREDICATELOCK_LIST_LWLOCK_OFFSET	\
+	(SMGR_SIZE_LWLOCK_OFFSET + NUM_SMGR_SIZE_PARTITIONS)
+#define NUM_FIXED_LWLOCKS \
+	(PREDICATELOCK_LIST_LWLOCK_OFFSET + NUM_PREDICATELOCK_LIST_PARTITIONS)
 
 typedef enum LWLockMode
 {
@@ -22,11 +22,36 @@
  * GUC variables
  */
 extern int	max_predicate_locks_per_xact;
+extern int	max_predicate_locks_per_relation;
+extern int	max_predicate_locks_per_page;
 
 
 /* Number of SLRU buffers to use for predicate locking */
 #define NUM_OLDSERXID_BUFFERS	16
 
+/*
+ * Events counted for the serializable transaction statistics: the reasons
+ * for serialization failures, and promotions of predicate locks to coarser
+ * granularity (which can cause false-positive failures).
+ */
+typedef enum SerializableEvent
+{
+	SSI_FAILURE_PIVOT_CONFLICT_OUT,		/* pivot, during conflict out check */
+	SSI_FAILURE_PIVOT_CONFLICT_IN,		/* pivot, during conflict in check */
+	SSI_FAILURE_PIVOT_WRITE,	/* pivot, during write */
+	SSI_FAILURE_PIVOT_COMMIT,	/* pivot, during commit attempt */
+	SSI_FAILURE_PIVOT_OLD_COMMITTED,	/* pivot, with conflict out to old
+										 * committed transaction */
+	SSI_FAILURE_OLD_PIVOT,		/* conflict out to old pivot */
+	SSI_FAILURE_PIVOT_READ,		/* conflict out to prepared pivot, during
+								 * read */
+	SSI_FAILURE_PREPARED_PIVOT, /* conflict in from prepared pivot, during
+								 * commit */
+	SSI_PROMOTION_PAGE,			/* tuple locks promoted to a page lock */
+	SSI_PROMOTION_RELATION,		/* locks promoted to a relation lock */
+	NUM_SERIALIZABLE_EVENTS
+} SerializableEvent;
+
 
 /*
  * function prototypes
@@ -40,6 +65,7 @@ extern void CheckPointPredicate(void);
 
 /* predicate lock reporting */
 extern bool PageIsPredicateLocked(Relation relation, BlockNumber blkno);
+extern void GetSerializableStats(uint64 *counts);
 
 /* predicate lock maintenance */
 extern Snapshot GetSerializableTransactionSnapshot(Snapshot snapshot);
@@ -15,6 +15,8 @@
 #define PREDICATE_INTERNALS_H
 
 #include "storage/lock.h"
+#include "storage/predicate.h"
+#include "storage/spin.h"
 
 /*
  * Commit number.
@@ -173,6 +175,15 @@ typedef struct PredXactListData
 												 * seq no */
 	SERIALIZABLEXACT *OldCommittedSxact;		/* shared copy of dummy sxact */
 
+	/* Coordination of ClearOldPredicateLocks; protected by clearMutex. */
+	slock_t		clearMutex;
+	bool		clearActive;	/* is some process clearing old locks? */
+	bool		clearRequested; /* should it make another pass? */
+
+	/* Event counters for statistics; protected by statsMutex. */
+	slock_t		statsMutex;
+	uint64		eventCounts[NUM_SERIALIZABLE_EVENTS];
+
 	PredXactListElement element;
 }	PredXactListData;
 
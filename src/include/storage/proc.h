@@ -14,6 +14,7 @@
 #ifndef _PROC_H_
 #define _PROC_H_
 
+#include "access/clog.h"
 #include "access/xlogdefs.h"
 #include "lib/ilist.h"
 #include "storage/latch.h"
@@ -95,6 +96,14 @@ struct PGPROC
 	Oid			databaseId;		/* OID of database this backend is using */
 	Oid			roleId;			/* OID of role using this backend */
 
+	/*
+	 * Oldest XID and multixact that this backend's storage of global
+	 * temporary relations may contain, or invalid if it has none.  See
+	 * globaltemp.c.  Protected by ProcArrayLock.
+	 */
+	TransactionId gttFrozenXid;
+	MultiXactId gttMinMulti;
+
 	/*
 	 * While in hot standby mode, shows that a conflict signal has been sent
 	 * for the current transaction. Set/cleared while holding ProcArrayLock,
@@ -134,6 +143,25 @@ struct PGPROC
 
 	struct XidCache subxids;	/* cache for subtransaction XIDs */
 
+	/* Support for group XID clearing. */
+	bool		procArrayGroupMember;	/* true, if member of ProcArray group
+										 * waiting for XID clear */
+	pg_atomic_uint32 procArrayGroupNext;	/* next ProcArray group member */
+	TransactionId procArrayGroupMemberXid;	/* latest transaction id among
+											 * the transaction's main XID and
+											 * subtransactions */
+
+	/* Support for group transaction status update. */
+	bool		clogGroupMember;	/* true, if member of clog group */
+	pg_atomic_uint32 clogGroupNext;		/* next clog group member */
+	TransactionId clogGroupMemberXid;	/* transaction id of clog group member */
+	XidStatus	clogGroupMemberXidStatus;	/* transaction status of clog
+											 * group member */
+	int			clogGroupMemberPage;	/* clog page corresponding to
+										 * transaction id of clog group member */
+	XLogRecPtr	clogGroupMemberLsn;		/* WAL location of commit record for
+										 * clog group member */
+
 	/* Per-backend LWLock.  Protects fields below. */
 	LWLock	   *backendLock;	/* protects the fields below */
 
@@ -195,6 +223,10 @@ typedef struct PROC_HDR
 	PGPROC	   *autovacFreeProcs;
 	/* Head of list of bgworker free PGPROC structures */
 	PGPROC	   *bgworkerFreeProcs;
+	/* First pgproc waiting for group XID clear */
+	pg_atomic_uint32 procArrayGroupFirst;
+	/* First pgproc waiting for group transaction status update */
+	pg_atomic_uint32 clogGroupFirst;
 	/* WALWriter process's latch */
 	Latch	   *walwriterLatch;
 	/* Checkpointer process's latch */
@@ -222,6 +254,12 @@ extern PGPROC *PreparedXactProcs;
  */
 #define NUM_AUXILIARY_PROCS		4
 
+/*
+ * Value of a pgprocno that denotes no PGPROC, used to terminate the lists
+ * of processes taking part in a group XID clear or status update.
+ */
+#define INVALID_PGPROCNO		0x7FFFFFFF
+
 
 /* configurable options */
 extern int	DeadlockTimeout;
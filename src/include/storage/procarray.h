@@ -69,6 +69,8 @@ extern VirtualTransactionId *GetConflictingVirtualXIDs(TransactionId limitXmin,
 extern pid_t CancelVirtualTransaction(VirtualTransactionId vxid, ProcSignalReason sigmode);
 
 extern bool MinimumActiveBackends(int min);
+extern void GetOldestGlobalTempXids(Oid databaseid, TransactionId *xid,
+						MultiXactId *mxid);
 extern int	CountDBBackends(Oid databaseid);
 extern void CancelDBBackends(Oid databaseid, ProcSignalReason sigmode, bool conflictPending);
 extern int	CountUserBackends(Oid roleid);
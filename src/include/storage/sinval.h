@@ -120,6 +120,28 @@ typedef union
 	SharedInvalSnapshotMsg sn;
 } SharedInvalidationMessage;
 
+/*
+ * When a backend falls so far behind that the messages it hasn't read yet
+ * must be removed from the queue, they are folded into a per-backend summary
+ * instead of throwing away all of its cache state.  The summary remembers
+ * which catcaches had any tuple invalidated, whether any smgr entry must be
+ * closed, and a deduplicated list of the remaining messages that concern the
+ * backend's own database or shared catalogs.  If too many relcache messages
+ * are folded, the whole relcache is invalidated instead.
+ */
+#define SINVAL_SUMMARY_CACHE_WORDS	4	/* room for 128 catcache IDs */
+#define SINVAL_SUMMARY_MAX_MSGS		64
+
+typedef struct SharedInvalSummary
+{
+	uint32		catcaches[SINVAL_SUMMARY_CACHE_WORDS];	/* catcache IDs to
+														 * flush */
+	bool		smgrAll;		/* close all smgr entries */
+	bool		relcacheAll;	/* invalidate all relcache entries */
+	int			nmsgs;			/* number of valid entries in msgs[] */
+	SharedInvalidationMessage msgs[SINVAL_SUMMARY_MAX_MSGS];
+} SharedInvalSummary;
+
 
 /* Counter of messages processed; don't worry about overflow. */
 extern uint64 SharedInvalidMessageCounter;
@@ -130,6 +152,7 @@ extern void SendSharedInvalidMessages(const SharedInvalidationMessage *msgs,
 						  int n);
 extern void ReceiveSharedInvalidMessages(
 					  void (*invalFunction) (SharedInvalidationMessage *msg),
+					  void (*summaryFunction) (SharedInvalSummary *summary),
 							 void (*resetFunction) (void));
 
 /* signal handler for catchup events (PROCSIG_CATCHUP_INTERRUPT) */
@@ -25,6 +25,9 @@
 #include "storage/lock.h"
 #include "storage/sinval.h"
 
+/* GUC variable */
+extern int	invalidation_queue_size;
+
 /*
  * prototypes for functions in sinvaladt.c
  */
@@ -35,8 +38,11 @@ extern PGPROC *BackendIdGetProc(int backendID);
 extern void BackendIdGetTransactionIds(int backendID, TransactionId *xid, TransactionId *xmin);
 
 extern void SIInsertDataEntries(const SharedInvalidationMessage *data, int n);
-extern int	SIGetDataEntries(SharedInvalidationMessage *data, int datasize);
+extern int	SIGetDataEntries(SharedInvalidationMessage *data, int datasize,
+				 SharedInvalSummary *summary);
 extern void SICleanupQueue(bool callerHasWriteLock, int minFree);
+extern void GetSharedInvalidationStats(int *queueSize, uint64 *numResets,
+						   uint64 *numSummaries, uint64 *numCatchupSignals);
 
 extern LocalTransactionId GetNextLocalTransactionId(void);
 
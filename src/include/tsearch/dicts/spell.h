@@ -87,7 +87,19 @@ typedef struct aff_struct
 	char	   *repl;
 	union
 	{
-		regex_t		regex;
+		/*
+		 * If shared dictionaries are enabled, a regular expression mask
+		 * keeps its source next to the compiled form; otherwise mask is
+		 * NULL.  A compiled regex can't live in shared memory, so in a
+		 * shared dictionary regex is NULL and each backend compiles the
+		 * mask on first use (see NIAttachShared).
+		 */
+		struct
+		{
+			regex_t    *regex;
+			pg_wchar   *mask;
+			int			masklen;
+		}			re;
 		Regis		regis;
 	}			reg;
 } AFFIX;
@@ -151,6 +163,15 @@ typedef struct
 	unsigned char flagval[256];
 	bool		usecompound;
 
+	/*
+	 * If the dictionary data lives in shared memory, isShared is set and
+	 * sharedRegex caches this backend's compiled regex for each affix,
+	 * allocated in dictCxt on first use.
+	 */
+	bool		isShared;
+	regex_t   **sharedRegex;
+	MemoryContext dictCxt;
+
 	/*
 	 * Remaining fields are only used during dictionary construction; they are
 	 * set up by NIStartBuild and cleared by NIFinishBuild.
@@ -175,5 +196,9 @@ extern void NIImportDictionary(IspellDict *Conf, const char *filename);
 extern void NISortDictionary(IspellDict *Conf);
 extern void NISortAffixes(IspellDict *Conf);
 extern void NIFinishBuild(IspellDict *Conf);
+extern bool NIAttachShared(IspellDict *Conf, const char *dictfile,
+			   const char *afffile);
+extern bool NIShare(IspellDict *Conf, const char *dictfile,
+		const char *afffile);
 
 #endif
@@ -0,0 +1,36 @@
+/*-------------------------------------------------------------------------
+ *
+ * ts_shared.h
+ *	  Shared memory area for text search dictionaries.
+ *
+ * Portions Copyright (c) 1996-2015, PostgreSQL Global Development Group
+ *
+ * src/include/tsearch/ts_shared.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef TS_SHARED_H
+#define TS_SHARED_H
+
+/* GUC variable */
+extern int	max_shared_dictionaries_size;
+
+/*
+ * Callback that fills in a freshly allocated shared entry.  If it throws an
+ * error, the entry is discarded.
+ */
+typedef void (*ts_shared_fill_callback) (void *dest, void *arg);
+
+extern Size TsSharedShmemSize(void);
+extern void TsSharedShmemInit(void);
+
+extern bool ts_shared_enabled(void);
+extern void *ts_shared_attach(const char *key);
+extern void *ts_shared_store(const char *key, Size size,
+				ts_shared_fill_callback fill, void *arg);
+extern void ts_shared_release(MemoryContext owner);
+extern void ts_shared_invalidate(MemoryContext owner);
+extern void ts_shared_usage(int *nentries, int *ndead, int *nrefs,
+				Size *allocated);
+
+#endif   /* TS_SHARED_H */
@@ -153,14 +153,30 @@ extern Datum gin_tsquery_triconsistent(PG_FUNCTION_ARGS);
 extern Datum gin_extract_tsvector_2args(PG_FUNCTION_ARGS);
 extern Datum gin_extract_tsquery_5args(PG_FUNCTION_ARGS);
 extern Datum gin_tsquery_consistent_6args(PG_FUNCTION_ARGS);
+extern Datum gin_extract_tsvector_rank(PG_FUNCTION_ARGS);
+extern Datum gin_extract_tsquery_rank(PG_FUNCTION_ARGS);
+extern Datum gin_tsquery_rank_consistent(PG_FUNCTION_ARGS);
+extern Datum gin_tsquery_rank_triconsistent(PG_FUNCTION_ARGS);
+extern Datum gin_tsquery_rank_ordering(PG_FUNCTION_ARGS);
+
+/*
+ * Rank estimate from per-lexeme summaries, used by tsvector_rank_ops and
+ * tsvector <=> tsquery (see tsrank.c)
+ */
+#define TS_RANK_SUMMARY_CODES	20
+
+extern int	ts_lexeme_rank_summary(TSVector t, WordEntry *entry);
+extern float4 ts_rank_from_summaries(const int *counts, int nterms);
 
 /*
  * Possible strategy numbers for indexes
  *	  TSearchStrategyNumber  - (tsvector|text) @@ tsquery
  *	  TSearchWithClassStrategyNumber  - tsvector @@@ tsquery
+ *	  TSearchRankStrategyNumber  - tsvector <=> tsquery (ordering)
  */
 #define TSearchStrategyNumber			1
 #define TSearchWithClassStrategyNumber	2
+#define TSearchRankStrategyNumber		3
 
 /*
  * TSQuery Utilities
@@ -103,6 +103,17 @@ extern bool MemoryContextIsEmpty(MemoryContext context);
 extern void MemoryContextStats(MemoryContext context);
 extern void MemoryContextAllowInCriticalSection(MemoryContext context,
 									bool allow);
+extern void MemoryContextSetBudget(MemoryContext context, Size budget);
+extern MemoryContext MemoryContextGetBudgetContext(MemoryContext context);
+
+/*
+ * MemoryContextOverBudget
+ *		True if the memory held under a budget context exceeds its budget.
+ *
+ * The argument is a result of MemoryContextGetBudgetContext, and may be NULL.
+ */
+#define MemoryContextOverBudget(budgetcxt) \
+	((budgetcxt) != NULL && (budgetcxt)->mem_total > (budgetcxt)->mem_budget)
 
 #ifdef MEMORY_CONTEXT_CHECKING
 extern void MemoryContextCheck(MemoryContext context);
@@ -119,6 +130,17 @@ extern MemoryContext MemoryContextCreate(NodeTag tag, Size size,
 					MemoryContext parent,
 					const char *name);
 
+/*
+ * Context-type-specific code reports every block it obtains from or returns
+ * to malloc() through these, which keeps the byte counts in the context tree
+ * up to date.  MemoryContextCheckLimit must be called before obtaining a
+ * block; it enforces session_memory_limit, and if it returns false the
+ * request must fail as though malloc() had returned NULL.
+ */
+extern bool MemoryContextCheckLimit(MemoryContext context, Size size);
+extern void MemoryContextNoteAlloc(MemoryContext context, Size size);
+extern void MemoryContextNoteFree(MemoryContext context, Size size);
+
 
 /*
  * Memory-context-type-specific functions
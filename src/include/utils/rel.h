@@ -220,6 +220,8 @@ typedef struct StdRdOptions
 	AutoVacOpts autovacuum;		/* autovacuum-related options */
 	bool		user_catalog_table;		/* use as an additional catalog
 										 * relation */
+	int			max_pred_locks_per_relation;	/* predicate lock promotion
+												 * threshold, or -1 */
 } StdRdOptions;
 
 #define HEAP_MIN_FILLFACTOR			10
@@ -233,6 +235,17 @@ typedef struct StdRdOptions
 	((relation)->rd_options ? \
 	 ((StdRdOptions *) (relation)->rd_options)->fillfactor : (defaultff))
 
+/*
+ * RelationGetMaxPredicateLocks
+ *		Returns the relation's max_pred_locks_per_relation setting, or the
+ *		given default if it is not set.  Note multiple eval of argument!
+ */
+#define RelationGetMaxPredicateLocks(relation, defaultmax) \
+	((relation)->rd_options && \
+	 ((StdRdOptions *) (relation)->rd_options)->max_pred_locks_per_relation >= 0 ? \
+	 ((StdRdOptions *) (relation)->rd_options)->max_pred_locks_per_relation : \
+	 (defaultmax))
+
 /*
  * RelationGetTargetPageUsage
  *		Returns the relation's desired space usage per page in bytes.
@@ -439,7 +452,16 @@ typedef struct ViewOptions
  *		True if relation's pages are stored in local buffers.
  */
 #define RelationUsesLocalBuffers(relation) \
-	((relation)->rd_rel->relpersistence == RELPERSISTENCE_TEMP)
+	((relation)->rd_rel->relpersistence == RELPERSISTENCE_TEMP || \
+	 (relation)->rd_rel->relpersistence == RELPERSISTENCE_GLOBAL_TEMP)
+
+/*
+ * RELATION_IS_GLOBAL_TEMP
+ *		True for a global temporary relation.  Its definition is shared by
+ *		all sessions, but each session sees only its own private storage.
+ */
+#define RELATION_IS_GLOBAL_TEMP(relation) \
+	((relation)->rd_rel->relpersistence == RELPERSISTENCE_GLOBAL_TEMP)
 
 /*
  * RELATION_IS_LOCAL
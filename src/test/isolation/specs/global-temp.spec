@@ -0,0 +1,66 @@
+# Global temporary tables
+#
+# Each session has its own contents of a global temporary table, and its own
+# copy of each index, which is built over those contents when the session
+# first uses an index created by another session.  When the table is dropped,
+# the other sessions remove their copies at the end of their next
+# transaction; gtt_files records the files of s1's copy, and s2 checks
+# whether they're still there.
+
+setup
+{
+  CREATE GLOBAL TEMPORARY TABLE gtt (id int, val text);
+  CREATE TABLE gtt_files (path text);
+  CREATE VIEW gtt_files_left AS
+    SELECT count(*) AS nleft FROM gtt_files
+      WHERE EXISTS (SELECT 1 FROM pg_ls_dir(regexp_replace(path, '/[^/]*$', '')) f
+                      WHERE f = regexp_replace(path, '^.*/', ''));
+}
+
+teardown
+{
+  DROP TABLE IF EXISTS gtt;
+  DROP VIEW gtt_files_left;
+  DROP TABLE gtt_files;
+}
+
+session "s1"
+setup
+{
+  SET enable_seqscan = off;
+  SET enable_bitmapscan = off;
+}
+step "s1ins"	{ INSERT INTO gtt SELECT g, 's1' FROM generate_series(1, 3) g; }
+step "s1sel"	{ SELECT * FROM gtt ORDER BY id; }
+step "s1plan"	{ EXPLAIN (COSTS OFF) SELECT * FROM gtt WHERE id = 2; }
+step "s1selidx"	{ SELECT * FROM gtt WHERE id = 2; }
+step "s1file"	{ INSERT INTO gtt_files VALUES (pg_relation_filepath('gtt')); }
+step "s1begin"	{ BEGIN; }
+step "s1commit"	{ COMMIT; }
+step "s1sync"	{ SELECT 1 AS sync; }
+
+session "s2"
+setup
+{
+  SET enable_seqscan = off;
+  SET enable_bitmapscan = off;
+}
+step "s2ins"	{ INSERT INTO gtt SELECT g, 's2' FROM generate_series(2, 5) g; }
+step "s2sel"	{ SELECT * FROM gtt ORDER BY id; }
+step "s2idx"	{ CREATE INDEX gtt_id ON gtt (id); }
+step "s2selidx"	{ SELECT * FROM gtt WHERE id = 2; }
+step "s2drop"	{ DROP TABLE gtt; }
+step "s2create"	{ CREATE GLOBAL TEMPORARY TABLE gtt (id int, val text); }
+step "s2files"	{ SELECT * FROM gtt_files_left; }
+
+# the sessions see only their own rows
+permutation "s1ins" "s2ins" "s1sel" "s2sel"
+
+# an index created by s2 is built over s1's rows when s1 uses it
+permutation "s1ins" "s2ins" "s2idx" "s1plan" "s1selidx" "s2selidx"
+
+# DROP waits for s1's transaction; s1's copy goes away after its next one
+permutation "s1ins" "s1file" "s1begin" "s1sel" "s2drop" "s1commit" "s2files" "s1sync" "s2files"
+
+# a table created again under the same name starts out empty in s1
+permutation "s1ins" "s1file" "s2drop" "s2create" "s1sel" "s2files" "s1ins" "s2idx" "s1plan" "s1selidx"
@@ -0,0 +1,56 @@
+# Predicate lock promotion thresholds
+#
+# Tuple locks are promoted to a page lock once more than
+# max_pred_locks_per_page of them are held on one page, and the locks on a
+# relation are promoted to a relation lock once more than
+# max_pred_locks_per_relation of its pages and tuples are locked.  The
+# max_pred_locks_per_relation storage parameter takes precedence over the
+# configuration variable.  Only the locks on the tables are shown; the
+# index scans also take page locks on the primary key indexes.
+
+setup
+{
+  CREATE TABLE pl_a (id int PRIMARY KEY, val int);
+  INSERT INTO pl_a SELECT g, g FROM generate_series(1, 10) g;
+  CREATE TABLE pl_b (id int PRIMARY KEY, val int)
+    WITH (max_pred_locks_per_relation = 2);
+  INSERT INTO pl_b SELECT g, g FROM generate_series(1, 10) g;
+  CREATE VIEW pl_locks AS
+    SELECT relation::regclass, locktype, page, tuple FROM pg_locks
+      WHERE mode = 'SIReadLock' AND pid = pg_backend_pid()
+        AND relation IN ('pl_a'::regclass, 'pl_b'::regclass);
+}
+
+teardown
+{
+  DROP VIEW pl_locks;
+  DROP TABLE pl_a, pl_b;
+}
+
+session "s1"
+setup
+{
+  BEGIN ISOLATION LEVEL SERIALIZABLE;
+  SET LOCAL enable_seqscan = off;
+  SET LOCAL enable_bitmapscan = off;
+}
+step "page5"	{ SET LOCAL max_pred_locks_per_page = 5; }
+step "rel2"		{ SET LOCAL max_pred_locks_per_relation = 2; }
+step "rel100"	{ SET LOCAL max_pred_locks_per_relation = 100; }
+step "ra2"		{ SELECT sum(val) FROM pl_a WHERE id <= 2; }
+step "ra3"		{ SELECT sum(val) FROM pl_a WHERE id <= 3; }
+step "rb3"		{ SELECT sum(val) FROM pl_b WHERE id <= 3; }
+step "locks"	{ SELECT * FROM pl_locks ORDER BY 1, 2, 3, 4; }
+teardown		{ ABORT; }
+
+# default max_pred_locks_per_page of 2: the third tuple promotes to the page
+permutation "ra2" "locks" "ra3" "locks"
+
+# a higher max_pred_locks_per_page keeps the tuple locks
+permutation "page5" "ra3" "locks"
+
+# a low max_pred_locks_per_relation promotes to the relation
+permutation "page5" "rel2" "ra3" "locks"
+
+# the storage parameter wins over the configuration variable
+permutation "page5" "rel100" "rb3" "locks"
@@ -0,0 +1,29 @@
+# Shared invalidation summaries
+#
+# s2 waits for a lock while s1 commits enough catalog changes to overflow the
+# invalidation queue, so s2 can't read the messages before they have to be
+# removed from the queue.  They should be folded into a summary for s2, not
+# force it into reset state.
+
+setup
+{
+  CREATE TABLE sinval_lock (a int);
+  CREATE TABLE sinval_before AS SELECT resets, summaries FROM pg_stat_sinval;
+}
+
+teardown
+{
+  DO $$ BEGIN FOR i IN 1..500 LOOP EXECUTE 'DROP TABLE IF EXISTS sinval_t' || i; END LOOP; END $$;
+  DROP TABLE sinval_lock, sinval_before;
+}
+
+session "s1"
+step "s1lock"	{ BEGIN; LOCK TABLE sinval_lock; }
+step "s1ddl"	{ DO $$ BEGIN FOR i IN 1..500 LOOP EXECUTE 'CREATE TABLE sinval_t' || i || ' (a int, b text)'; END LOOP; END $$; }
+step "s1commit"	{ COMMIT; }
+
+session "s2"
+step "s2sel"	{ SELECT count(*) FROM sinval_lock; }
+step "s2check"	{ SELECT s.summaries > b.summaries AS summarized, s.resets = b.resets AS not_reset FROM pg_stat_sinval s, sinval_before b; }
+
+permutation "s1lock" "s2sel" "s1ddl" "s1commit" "s2check"
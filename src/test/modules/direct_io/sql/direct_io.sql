@@ -0,0 +1,43 @@
+--
+-- Direct I/O for data files
+--
+-- This runs with direct_io = data and two I/O workers (see direct_io.conf).
+--
+SHOW direct_io;
+
+CREATE TABLE dio (id int, pad text);
+INSERT INTO dio SELECT g, repeat('x', 200) FROM generate_series(1, 5000) g;
+
+-- The table is larger than a quarter of shared_buffers, so a seqscan reads
+-- it through a ring of buffers, with readahead done by the I/O workers
+SELECT count(*), sum(id) FROM dio;
+
+-- Index builds write pages from local memory, through a bounce buffer
+CREATE INDEX dio_id ON dio (id);
+
+-- Bitmap heap scans prefetch through the I/O workers too
+SET enable_seqscan = off;
+SET enable_indexscan = off;
+SELECT count(*), sum(id) FROM dio WHERE id BETWEEN 1001 AND 4000;
+RESET enable_seqscan;
+RESET enable_indexscan;
+
+SELECT reads_submitted > 0 AS reads_submitted FROM pg_stat_aio
+  WHERE pid = pg_backend_pid();
+
+-- CLUSTER also writes the new heap from local memory
+CLUSTER dio USING dio_id;
+SELECT count(*), sum(id) FROM dio;
+
+-- Truncation by VACUUM, and extension afterwards
+DELETE FROM dio WHERE id > 100;
+VACUUM dio;
+SELECT pg_relation_size('dio') < 10 * 8192 AS truncated;
+INSERT INTO dio SELECT g, repeat('x', 200) FROM generate_series(101, 5000) g;
+SELECT count(*), sum(id) FROM dio;
+
+-- The checkpoint's writes are done by the I/O workers
+CHECKPOINT;
+SELECT count(*), sum(id) FROM dio;
+
+DROP TABLE dio;
@@ -0,0 +1,22 @@
+/*--------------------------------------------------------------------------
+ *
+ * checksum_avx2.c
+ *		The data page checksum, built for AVX2.
+ *
+ * Copyright (C) 2015, PostgreSQL Global Development Group
+ *
+ * IDENTIFICATION
+ *		src/test/modules/test_crc32c/checksum_avx2.c
+ *
+ * -------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "test_crc32c.h"
+
+#ifdef HAVE_CHECKSUM_VARIANTS
+#define PG_CHECKSUM_BLOCK_ATTRIBUTE __attribute__((target("avx2")))
+#define pg_checksum_page test_checksum_page_avx2
+#include "storage/checksum_impl.h"
+#endif
@@ -0,0 +1,19 @@
+/*--------------------------------------------------------------------------
+ *
+ * checksum_default.c
+ *		The data page checksum, built for the baseline instruction set.
+ *
+ * Copyright (C) 2015, PostgreSQL Global Development Group
+ *
+ * IDENTIFICATION
+ *		src/test/modules/test_crc32c/checksum_default.c
+ *
+ * -------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "test_crc32c.h"
+
+#define pg_checksum_page test_checksum_page_default
+#include "storage/checksum_impl.h"
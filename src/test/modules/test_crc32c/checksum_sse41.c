@@ -0,0 +1,22 @@
+/*--------------------------------------------------------------------------
+ *
+ * checksum_sse41.c
+ *		The data page checksum, built for SSE 4.1.
+ *
+ * Copyright (C) 2015, PostgreSQL Global Development Group
+ *
+ * IDENTIFICATION
+ *		src/test/modules/test_crc32c/checksum_sse41.c
+ *
+ * -------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "test_crc32c.h"
+
+#ifdef HAVE_CHECKSUM_VARIANTS
+#define PG_CHECKSUM_BLOCK_ATTRIBUTE __attribute__((target("sse4.1")))
+#define pg_checksum_page test_checksum_page_sse41
+#include "storage/checksum_impl.h"
+#endif
@@ -0,0 +1,8 @@
+CREATE EXTENSION test_crc32c;
+
+SELECT test_crc32c_check();
+
+-- the throughput depends on the machine, so only check what gets measured
+SELECT implementation FROM bench_crc32c(8192, 10)
+  WHERE implementation = 'slicing-by-8';
+SELECT count(*) >= 2 AS ok FROM bench_page_checksum(10);
@@ -0,0 +1,19 @@
+/* src/test/modules/test_crc32c/test_crc32c--1.0.sql */
+
+-- complain if script is sourced in psql, rather than via CREATE EXTENSION
+\echo Use "CREATE EXTENSION test_crc32c" to load this file. \quit
+
+CREATE FUNCTION test_crc32c_check()
+    RETURNS pg_catalog.bool STRICT
+	AS 'MODULE_PATHNAME' LANGUAGE C;
+
+CREATE FUNCTION bench_crc32c(size pg_catalog.int4,
+					   loop_count pg_catalog.int4)
+    RETURNS TABLE (implementation pg_catalog.text,
+				   mb_per_sec pg_catalog.float8) STRICT
+	AS 'MODULE_PATHNAME' LANGUAGE C;
+
+CREATE FUNCTION bench_page_checksum(loop_count pg_catalog.int4)
+    RETURNS TABLE (implementation pg_catalog.text,
+				   mb_per_sec pg_catalog.float8) STRICT
+	AS 'MODULE_PATHNAME' LANGUAGE C;
@@ -0,0 +1,346 @@
+/*--------------------------------------------------------------------------
+ *
+ * test_crc32c.c
+ *		Test code and microbenchmarks for the CRC-32C implementations and
+ *		the data page checksum.
+ *
+ * Copyright (C) 2015, PostgreSQL Global Development Group
+ *
+ * IDENTIFICATION
+ *		src/test/modules/test_crc32c/test_crc32c.c
+ *
+ * -------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "common/pg_crc.h"
+#include "fmgr.h"
+#include "funcapi.h"
+#include "miscadmin.h"
+#include "portability/instr_time.h"
+#include "storage/bufpage.h"
+#include "storage/checksum.h"
+#include "utils/builtins.h"
+#include "utils/tuplestore.h"
+
+#include "test_crc32c.h"
+
+PG_MODULE_MAGIC;
+
+PG_FUNCTION_INFO_V1(test_crc32c_check);
+PG_FUNCTION_INFO_V1(bench_crc32c);
+PG_FUNCTION_INFO_V1(bench_page_checksum);
+
+typedef uint16 (*checksum_page_impl) (char *page, BlockNumber blkno);
+
+typedef struct
+{
+	const char *name;
+	checksum_page_impl fn;
+} ChecksumVariant;
+
+/* CRC-32C of "123456789", the usual check value */
+#define CRC32C_CHECK_VALUE	0xE3069283
+
+#define TEST_MAX_LEN		1024
+
+/* keeps the compiler from optimizing away the benchmarked calls */
+static volatile uint32 bench_sink;
+
+static int	checksum_variants(ChecksumVariant *variants);
+static void fill_random(char *buf, int len);
+static Tuplestorestate *bench_start(FunctionCallInfo fcinfo,
+			TupleDesc *tupdesc);
+static void bench_add_row(Tuplestorestate *tupstore, TupleDesc tupdesc,
+			  const char *name, double bytes, instr_time elapsed);
+
+/*
+ * Returns the page checksum variants the CPU can run, the server's own
+ * pg_checksum_page, which picks one of them at load time, first.
+ */
+static int
+checksum_variants(ChecksumVariant *variants)
+{
+	int			n = 0;
+
+	variants[n].name = "dispatched";
+	variants[n++].fn = pg_checksum_page;
+	variants[n].name = "default";
+	variants[n++].fn = test_checksum_page_default;
+#ifdef HAVE_CHECKSUM_VARIANTS
+	if (__builtin_cpu_supports("sse4.1"))
+	{
+		variants[n].name = "sse4.1";
+		variants[n++].fn = test_checksum_page_sse41;
+	}
+	if (__builtin_cpu_supports("avx2"))
+	{
+		variants[n].name = "avx2";
+		variants[n++].fn = test_checksum_page_avx2;
+	}
+#endif
+
+	return n;
+}
+
+static void
+fill_random(char *buf, int len)
+{
+	int			i;
+
+	for (i = 0; i < len; i++)
+		buf[i] = (char) random();
+}
+
+/*
+ * Check that all the CRC-32C implementations the CPU can run compute the
+ * same values, for all lengths up to TEST_MAX_LEN and all alignments of the
+ * input, and that all the page checksum variants agree too.  Errors out on
+ * the first mismatch.
+ */
+Datum
+test_crc32c_check(PG_FUNCTION_ARGS)
+{
+	const char *hw_name;
+	pg_crc32c_impl hw = pg_crc32c_hardware_impl(&hw_name);
+	char	   *buf = palloc(TEST_MAX_LEN + 8);
+	char	   *page = palloc(BLCKSZ);
+	ChecksumVariant variants[4];
+	int			nvariants = checksum_variants(variants);
+	pg_crc32	crc;
+	int			len;
+	int			off;
+	int			i;
+
+	INIT_CRC32C(crc);
+	crc = pg_comp_crc32c_sb8(crc, "123456789", 9);
+	FIN_CRC32C(crc);
+	if (crc != CRC32C_CHECK_VALUE)
+		elog(ERROR, "slicing-by-8 CRC-32C check value is %08X", crc);
+
+	fill_random(buf, TEST_MAX_LEN + 8);
+	for (len = 0; len <= TEST_MAX_LEN; len++)
+	{
+		for (off = 0; off < 8; off++)
+		{
+			pg_crc32	expected;
+
+			INIT_CRC32C(expected);
+			expected = pg_comp_crc32c_sb8(expected, buf + off, len);
+
+			INIT_CRC32C(crc);
+			COMP_CRC32C(crc, buf + off, len);
+			if (crc != expected)
+				elog(ERROR, "pg_comp_crc32c mismatch for length %d offset %d",
+					 len, off);
+
+			if (hw != NULL)
+			{
+				INIT_CRC32C(crc);
+				crc = hw(crc, buf + off, len);
+				if (crc != expected)
+					elog(ERROR, "%s CRC-32C mismatch for length %d offset %d",
+						 hw_name, len, off);
+			}
+		}
+	}
+
+	for (i = 0; i < 100; i++)
+	{
+		BlockNumber blkno = (BlockNumber) random();
+		uint16		expected;
+		int			v;
+
+		fill_random(page, BLCKSZ);
+		/* pg_checksum_page only accepts initialized pages */
+		((PageHeader) page)->pd_upper = BLCKSZ;
+
+		expected = variants[0].fn(page, blkno);
+		for (v = 1; v < nvariants; v++)
+		{
+			if (variants[v].fn(page, blkno) != expected)
+				elog(ERROR, "%s page checksum mismatch", variants[v].name);
+		}
+	}
+
+	pfree(buf);
+	pfree(page);
+
+	PG_RETURN_BOOL(true);
+}
+
+/*
+ * Set up a tuplestore to return (implementation, mb_per_sec) rows in.
+ */
+static Tuplestorestate *
+bench_start(FunctionCallInfo fcinfo, TupleDesc *tupdesc)
+{
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	Tuplestorestate *tupstore;
+	MemoryContext per_query_ctx;
+	MemoryContext oldcontext;
+
+	/* check to see if caller supports us returning a tuplestore */
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("set-valued function called in context that cannot accept a set")));
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("materialize mode required, but it is not "
+						"allowed in this context")));
+
+	if (get_call_result_type(fcinfo, NULL, tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	*tupdesc = CreateTupleDescCopy(*tupdesc);
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = *tupdesc;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	return tupstore;
+}
+
+/*
+ * Add a row with the throughput of processing the given number of bytes in
+ * the given time.  If the timer was too coarse to measure anything, the
+ * throughput is NULL.
+ */
+static void
+bench_add_row(Tuplestorestate *tupstore, TupleDesc tupdesc,
+			  const char *name, double bytes, instr_time elapsed)
+{
+	Datum		values[2];
+	bool		nulls[2];
+	double		secs = INSTR_TIME_GET_DOUBLE(elapsed);
+
+	values[0] = CStringGetTextDatum(name);
+	nulls[0] = false;
+	values[1] = Float8GetDatum(bytes / (1024.0 * 1024.0) / secs);
+	nulls[1] = (secs <= 0);
+
+	tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+}
+
+/*
+ * Measure the throughput of each CRC-32C implementation the CPU can run,
+ * computing the CRC of a buffer of the given size loop_count times.  Each
+ * computation continues the CRC of the previous one, like the WAL code does
+ * across the pieces of a record.
+ */
+Datum
+bench_crc32c(PG_FUNCTION_ARGS)
+{
+	int32		size = PG_GETARG_INT32(0);
+	int32		loop_count = PG_GETARG_INT32(1);
+	TupleDesc	tupdesc;
+	Tuplestorestate *tupstore;
+	struct
+	{
+		const char *name;
+		pg_crc32c_impl fn;
+	}			impls[2];
+	int			nimpls = 0;
+	char	   *buf;
+	int			i;
+
+	if (size < 0 || loop_count < 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("size and loop count must not be negative")));
+
+	tupstore = bench_start(fcinfo, &tupdesc);
+
+	impls[nimpls].name = "slicing-by-8";
+	impls[nimpls++].fn = pg_comp_crc32c_sb8;
+	impls[nimpls].fn = pg_crc32c_hardware_impl(&impls[nimpls].name);
+	if (impls[nimpls].fn != NULL)
+		nimpls++;
+
+	buf = palloc(size);
+	fill_random(buf, size);
+
+	for (i = 0; i < nimpls; i++)
+	{
+		pg_crc32	crc;
+		instr_time	start;
+		instr_time	elapsed;
+		int32		loop;
+
+		INIT_CRC32C(crc);
+		INSTR_TIME_SET_CURRENT(start);
+		for (loop = 0; loop < loop_count; loop++)
+		{
+			crc = impls[i].fn(crc, buf, size);
+			CHECK_FOR_INTERRUPTS();
+		}
+		INSTR_TIME_SET_CURRENT(elapsed);
+		INSTR_TIME_SUBTRACT(elapsed, start);
+		bench_sink ^= crc;
+
+		bench_add_row(tupstore, tupdesc, impls[i].name,
+					  (double) size * loop_count, elapsed);
+	}
+
+	pfree(buf);
+
+	return (Datum) 0;
+}
+
+/*
+ * Measure the throughput of each page checksum variant the CPU can run,
+ * checksumming a page loop_count times.
+ */
+Datum
+bench_page_checksum(PG_FUNCTION_ARGS)
+{
+	int32		loop_count = PG_GETARG_INT32(0);
+	TupleDesc	tupdesc;
+	Tuplestorestate *tupstore;
+	ChecksumVariant variants[4];
+	int			nvariants = checksum_variants(variants);
+	char	   *page;
+	int			v;
+
+	if (loop_count < 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("loop count must not be negative")));
+
+	tupstore = bench_start(fcinfo, &tupdesc);
+
+	page = palloc(BLCKSZ);
+	fill_random(page, BLCKSZ);
+	((PageHeader) page)->pd_upper = BLCKSZ;
+
+	for (v = 0; v < nvariants; v++)
+	{
+		instr_time	start;
+		instr_time	elapsed;
+		int32		loop;
+
+		INSTR_TIME_SET_CURRENT(start);
+		for (loop = 0; loop < loop_count; loop++)
+		{
+			bench_sink ^= variants[v].fn(page, (BlockNumber) loop);
+			CHECK_FOR_INTERRUPTS();
+		}
+		INSTR_TIME_SET_CURRENT(elapsed);
+		INSTR_TIME_SUBTRACT(elapsed, start);
+
+		bench_add_row(tupstore, tupdesc, variants[v].name,
+					  (double) BLCKSZ * loop_count, elapsed);
+	}
+
+	pfree(page);
+
+	return (Datum) 0;
+}
@@ -0,0 +1,29 @@
+/*--------------------------------------------------------------------------
+ *
+ * test_crc32c.h
+ *		Declarations for the data page checksum variants, each of which is
+ *		the same checksum_impl.h code built by its own file for a different
+ *		instruction set.
+ *
+ * Copyright (C) 2015, PostgreSQL Global Development Group
+ *
+ * IDENTIFICATION
+ *		src/test/modules/test_crc32c/test_crc32c.h
+ *
+ * -------------------------------------------------------------------------
+ */
+#ifndef TEST_CRC32C_H
+#define TEST_CRC32C_H
+
+#include "storage/block.h"
+
+extern uint16 test_checksum_page_default(char *page, BlockNumber blkno);
+
+/* The server's checksum.c builds these variants only on x86-64, too */
+#if defined(__x86_64__) && defined(__GNUC__)
+#define HAVE_CHECKSUM_VARIANTS
+extern uint16 test_checksum_page_sse41(char *page, BlockNumber blkno);
+extern uint16 test_checksum_page_avx2(char *page, BlockNumber blkno);
+#endif
+
+#endif   /* TEST_CRC32C_H */
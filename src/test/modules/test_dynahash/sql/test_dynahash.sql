@@ -0,0 +1,17 @@
+CREATE EXTENSION test_dynahash;
+
+--
+-- Fill the table with keys of a single partition; this only succeeds for
+-- the whole table if entries are borrowed from the other freelists.
+--
+SELECT test_dynahash_fill();
+
+--
+-- Concurrent insertions and deletions.  The timing isn't stable, so just
+-- check that all the operations were done.
+--
+SELECT inserts, deletes, elapsed_ms >= 0 AS timed
+  FROM test_dynahash_churn(4, 1000);
+
+-- The table should be empty again afterwards
+SELECT test_dynahash_fill();
@@ -0,0 +1,16 @@
+/* src/test/modules/test_dynahash/test_dynahash--1.0.sql */
+
+-- complain if script is sourced in psql, rather than via CREATE EXTENSION
+\echo Use "CREATE EXTENSION test_dynahash" to load this file. \quit
+
+CREATE FUNCTION test_dynahash_fill()
+    RETURNS pg_catalog.int4 STRICT
+	AS 'MODULE_PATHNAME' LANGUAGE C;
+
+CREATE FUNCTION test_dynahash_churn(num_workers pg_catalog.int4,
+					   loop_count pg_catalog.int4,
+					   OUT inserts pg_catalog.int8,
+					   OUT deletes pg_catalog.int8,
+					   OUT elapsed_ms pg_catalog.float8)
+    RETURNS record STRICT
+	AS 'MODULE_PATHNAME' LANGUAGE C;
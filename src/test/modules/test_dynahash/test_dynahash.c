@@ -0,0 +1,425 @@
+/*--------------------------------------------------------------------------
+ *
+ * test_dynahash.c
+ *		Test code for the freelists of partitioned shared hash tables.
+ *
+ * Copyright (C) 2015, PostgreSQL Global Development Group
+ *
+ * IDENTIFICATION
+ *		src/test/modules/test_dynahash/test_dynahash.c
+ *
+ * -------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include <signal.h>
+
+#include "access/htup_details.h"
+#include "fmgr.h"
+#include "funcapi.h"
+#include "miscadmin.h"
+#include "postmaster/bgworker.h"
+#include "storage/ipc.h"
+#include "storage/latch.h"
+#include "storage/lwlock.h"
+#include "storage/procsignal.h"
+#include "storage/shmem.h"
+#include "tcop/tcopprot.h"
+#include "utils/builtins.h"
+#include "utils/hsearch.h"
+#include "utils/timestamp.h"
+
+PG_MODULE_MAGIC;
+
+PG_FUNCTION_INFO_V1(test_dynahash_fill);
+PG_FUNCTION_INFO_V1(test_dynahash_churn);
+
+void		test_dynahash_worker(Datum main_arg);
+
+/*
+ * The table is small enough to fit into the spare space the postmaster
+ * leaves in the main shared memory segment.
+ */
+#define TEST_HASH_SIZE			1024
+#define TEST_PARTITIONS			16
+#define TEST_BATCH				8
+#define TEST_MAX_WORKERS		32
+
+typedef struct
+{
+	int			tranche_id;
+	int			loop_count;		/* iterations for each churn worker */
+	pg_atomic_uint64 inserts;
+	pg_atomic_uint64 deletes;
+	LWLock		locks[TEST_PARTITIONS];
+} TestDynahashShared;
+
+typedef struct
+{
+	uint32		key;
+	uint32		worker;
+} TestDynahashEntry;
+
+#define TestPartitionLock(hashcode) \
+	(&shared->locks[(hashcode) % TEST_PARTITIONS])
+
+static TestDynahashShared *shared = NULL;
+static HTAB *test_hash = NULL;
+static LWLockTranche test_tranche;
+
+static void test_dynahash_attach(void);
+static bool test_dynahash_insert(uint32 key, uint32 worker);
+static bool test_dynahash_delete(uint32 key);
+static void wait_for_workers(BackgroundWorkerHandle **handles, int nworkers);
+
+/*
+ * Fill the table with keys that all belong to partition 0, until no more
+ * entries can be had, and then empty it again.
+ *
+ * Returns the number of keys that could be inserted.  Since the table has a
+ * fixed size and its entries are spread over all the freelists, this is only
+ * TEST_HASH_SIZE if entries were borrowed from the freelists of the other
+ * partitions.
+ */
+Datum
+test_dynahash_fill(PG_FUNCTION_ARGS)
+{
+	HASH_SEQ_STATUS status;
+	TestDynahashEntry *entry;
+	uint32		key;
+	int32		ninserted = 0;
+	int			i;
+
+	test_dynahash_attach();
+
+	for (i = 0; i < TEST_PARTITIONS; i++)
+		LWLockAcquire(&shared->locks[i], LW_EXCLUSIVE);
+
+	if (hash_get_num_entries(test_hash) != 0)
+		elog(ERROR, "test_dynahash table is not empty");
+
+	for (key = 0;; key++)
+	{
+		uint32		hashcode = get_hash_value(test_hash, &key);
+		bool		found;
+
+		if (hashcode % TEST_PARTITIONS != 0)
+			continue;
+
+		entry = (TestDynahashEntry *)
+			hash_search_with_hash_value(test_hash, &key, hashcode,
+										HASH_ENTER_NULL, &found);
+		if (entry == NULL)
+			break;
+		if (found)
+			elog(ERROR, "duplicate key %u in test_dynahash table", key);
+		entry->worker = 0;
+		ninserted++;
+	}
+
+	if (hash_get_num_entries(test_hash) != ninserted)
+		elog(ERROR, "test_dynahash table has %ld entries, expected %d",
+			 hash_get_num_entries(test_hash), ninserted);
+
+	hash_seq_init(&status, test_hash);
+	while ((entry = (TestDynahashEntry *) hash_seq_search(&status)) != NULL)
+	{
+		if (hash_search(test_hash, &entry->key, HASH_REMOVE, NULL) == NULL)
+			elog(ERROR, "test_dynahash table corrupted");
+	}
+
+	if (hash_get_num_entries(test_hash) != 0)
+		elog(ERROR, "test_dynahash table is not empty after deleting all keys");
+
+	for (i = 0; i < TEST_PARTITIONS; i++)
+		LWLockRelease(&shared->locks[i]);
+
+	PG_RETURN_INT32(ninserted);
+}
+
+/*
+ * Run background workers that concurrently insert and delete keys.
+ */
+Datum
+test_dynahash_churn(PG_FUNCTION_ARGS)
+{
+	int32		nworkers = PG_GETARG_INT32(0);
+	int32		loop_count = PG_GETARG_INT32(1);
+	BackgroundWorkerHandle *handles[TEST_MAX_WORKERS];
+	BackgroundWorker worker;
+	TimestampTz start_time;
+	long		secs;
+	int			usecs;
+	TupleDesc	tupdesc;
+	Datum		values[3];
+	bool		nulls[3];
+	uint64		inserts;
+	uint64		deletes;
+	long		nentries;
+	int			i;
+
+	if (nworkers < 1 || nworkers > TEST_MAX_WORKERS)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("number of workers must be between 1 and %d",
+						TEST_MAX_WORKERS)));
+	if (loop_count < 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("loop count must be a non-negative integer")));
+
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	test_dynahash_attach();
+
+	shared->loop_count = loop_count;
+	pg_atomic_write_u64(&shared->inserts, 0);
+	pg_atomic_write_u64(&shared->deletes, 0);
+
+	/* Configure a worker. */
+	worker.bgw_flags = BGWORKER_SHMEM_ACCESS;
+	worker.bgw_start_time = BgWorkerStart_ConsistentState;
+	worker.bgw_restart_time = BGW_NEVER_RESTART;
+	worker.bgw_main = NULL;		/* new worker might not have library loaded */
+	sprintf(worker.bgw_library_name, "test_dynahash");
+	sprintf(worker.bgw_function_name, "test_dynahash_worker");
+	snprintf(worker.bgw_name, BGW_MAXLEN, "test_dynahash");
+	/* set bgw_notify_pid, so we can detect when the worker stops */
+	worker.bgw_notify_pid = MyProcPid;
+
+	start_time = GetCurrentTimestamp();
+
+	for (i = 0; i < nworkers; i++)
+	{
+		worker.bgw_main_arg = Int32GetDatum(i);
+		if (!RegisterDynamicBackgroundWorker(&worker, &handles[i]))
+		{
+			/* let the workers we did start finish before complaining */
+			wait_for_workers(handles, i);
+			ereport(ERROR,
+					(errcode(ERRCODE_INSUFFICIENT_RESOURCES),
+					 errmsg("could not register background process"),
+				 errhint("You may need to increase max_worker_processes.")));
+		}
+	}
+
+	wait_for_workers(handles, nworkers);
+
+	TimestampDifference(start_time, GetCurrentTimestamp(), &secs, &usecs);
+
+	/*
+	 * Every key that a worker managed to insert but not to delete must still
+	 * be in the table.
+	 */
+	inserts = pg_atomic_read_u64(&shared->inserts);
+	deletes = pg_atomic_read_u64(&shared->deletes);
+
+	for (i = 0; i < TEST_PARTITIONS; i++)
+		LWLockAcquire(&shared->locks[i], LW_EXCLUSIVE);
+	nentries = hash_get_num_entries(test_hash);
+	for (i = 0; i < TEST_PARTITIONS; i++)
+		LWLockRelease(&shared->locks[i]);
+
+	if (inserts < deletes || nentries != (long) (inserts - deletes))
+		elog(ERROR, "test_dynahash table has %ld entries after " UINT64_FORMAT
+			 " insertions and " UINT64_FORMAT " deletions",
+			 nentries, inserts, deletes);
+
+	values[0] = Int64GetDatum((int64) inserts);
+	values[1] = Int64GetDatum((int64) deletes);
+	values[2] = Float8GetDatum(secs * 1000.0 + usecs / 1000.0);
+	memset(nulls, 0, sizeof(nulls));
+
+	PG_RETURN_DATUM(HeapTupleGetDatum(heap_form_tuple(tupdesc, values, nulls)));
+}
+
+/*
+ * Background worker entrypoint.
+ *
+ * Each worker inserts batches of TEST_BATCH keys and deletes them again.
+ * The keys of different workers never collide, and successive batches spread
+ * over all partitions.  The insertions and deletions that succeeded are
+ * counted, so that test_dynahash_churn can check them against the table.
+ */
+void
+test_dynahash_worker(Datum main_arg)
+{
+	uint32		worker = (uint32) DatumGetInt32(main_arg);
+	int			loop_count;
+	uint64		inserts = 0;
+	uint64		deletes = 0;
+	int			i;
+	int			j;
+
+	pqsignal(SIGTERM, die);
+	BackgroundWorkerUnblockSignals();
+
+	test_dynahash_attach();
+	loop_count = shared->loop_count;
+
+	for (i = 0; i < loop_count; i++)
+	{
+		uint32		base = ((uint32) i << 8) | (worker << 3);
+
+		for (j = 0; j < TEST_BATCH; j++)
+		{
+			if (test_dynahash_insert(base | j, worker))
+				inserts++;
+		}
+		for (j = 0; j < TEST_BATCH; j++)
+		{
+			if (test_dynahash_delete(base | j))
+				deletes++;
+		}
+
+		CHECK_FOR_INTERRUPTS();
+	}
+
+	pg_atomic_fetch_add_u64(&shared->inserts, inserts);
+	pg_atomic_fetch_add_u64(&shared->deletes, deletes);
+
+	proc_exit(0);
+}
+
+/*
+ * Create the shared state and the table, or attach to them if some other
+ * process has done so already.
+ */
+static void
+test_dynahash_attach(void)
+{
+	HASHCTL		info;
+	bool		found;
+	int			i;
+
+	if (test_hash != NULL)
+		return;
+
+	LWLockAcquire(AddinShmemInitLock, LW_EXCLUSIVE);
+
+	shared = ShmemInitStruct("test_dynahash", sizeof(TestDynahashShared),
+							 &found);
+	if (!found)
+	{
+		shared->tranche_id = LWLockNewTrancheId();
+		shared->loop_count = 0;
+		pg_atomic_init_u64(&shared->inserts, 0);
+		pg_atomic_init_u64(&shared->deletes, 0);
+		for (i = 0; i < TEST_PARTITIONS; i++)
+			LWLockInitialize(&shared->locks[i], shared->tranche_id);
+	}
+
+	MemSet(&info, 0, sizeof(info));
+	info.keysize = sizeof(uint32);
+	info.entrysize = sizeof(TestDynahashEntry);
+	info.num_partitions = TEST_PARTITIONS;
+
+	test_hash = ShmemInitHash("test_dynahash table",
+							  TEST_HASH_SIZE, TEST_HASH_SIZE,
+							  &info,
+							  HASH_ELEM | HASH_BLOBS | HASH_PARTITION |
+							  HASH_FIXED_SIZE);
+
+	LWLockRelease(AddinShmemInitLock);
+
+	test_tranche.name = "test_dynahash";
+	test_tranche.array_base = shared->locks;
+	test_tranche.array_stride = sizeof(LWLock);
+	LWLockRegisterTranche(shared->tranche_id, &test_tranche);
+}
+
+/*
+ * Insert a key, returning false if the table is full.
+ */
+static bool
+test_dynahash_insert(uint32 key, uint32 worker)
+{
+	uint32		hashcode = get_hash_value(test_hash, &key);
+	LWLock	   *partitionLock = TestPartitionLock(hashcode);
+	TestDynahashEntry *entry;
+	bool		found;
+
+	LWLockAcquire(partitionLock, LW_EXCLUSIVE);
+	entry = (TestDynahashEntry *)
+		hash_search_with_hash_value(test_hash, &key, hashcode,
+									HASH_ENTER_NULL, &found);
+	if (entry != NULL)
+	{
+		if (found)
+			elog(ERROR, "duplicate key %u in test_dynahash table", key);
+		entry->worker = worker;
+	}
+	LWLockRelease(partitionLock);
+
+	return entry != NULL;
+}
+
+/*
+ * Delete a key, returning false if it wasn't in the table.
+ */
+static bool
+test_dynahash_delete(uint32 key)
+{
+	uint32		hashcode = get_hash_value(test_hash, &key);
+	LWLock	   *partitionLock = TestPartitionLock(hashcode);
+	void	   *entry;
+
+	LWLockAcquire(partitionLock, LW_EXCLUSIVE);
+	entry = hash_search_with_hash_value(test_hash, &key, hashcode,
+										HASH_REMOVE, NULL);
+	LWLockRelease(partitionLock);
+
+	return entry != NULL;
+}
+
+/*
+ * Wait until all the given workers have exited.
+ */
+static void
+wait_for_workers(BackgroundWorkerHandle **handles, int nworkers)
+{
+	bool		save_set_latch_on_sigusr1;
+	int			i;
+
+	save_set_latch_on_sigusr1 = set_latch_on_sigusr1;
+	set_latch_on_sigusr1 = true;
+
+	PG_TRY();
+	{
+		for (i = 0; i < nworkers; i++)
+		{
+			for (;;)
+			{
+				BgwHandleStatus status;
+				pid_t		pid;
+
+				status = GetBackgroundWorkerPid(handles[i], &pid);
+				if (status == BGWH_STOPPED)
+					break;
+				if (status == BGWH_POSTMASTER_DIED)
+					ereport(ERROR,
+							(errcode(ERRCODE_ADMIN_SHUTDOWN),
+							 errmsg("postmaster exited during test_dynahash_churn")));
+
+				/* Wait to be signalled. */
+				WaitLatch(MyLatch, WL_LATCH_SET, 0);
+
+				/* An interrupt may have occurred while we were waiting. */
+				CHECK_FOR_INTERRUPTS();
+
+				/* Reset the latch so we don't spin. */
+				ResetLatch(MyLatch);
+			}
+		}
+	}
+	PG_CATCH();
+	{
+		set_latch_on_sigusr1 = save_set_latch_on_sigusr1;
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+
+	set_latch_on_sigusr1 = save_set_latch_on_sigusr1;
+}
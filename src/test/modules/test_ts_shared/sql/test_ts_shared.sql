@@ -0,0 +1,49 @@
+CREATE EXTENSION test_ts_shared;
+
+-- Nothing is shared yet
+SELECT entries, dead, refs, allocated > 0 AS allocated
+  FROM test_ts_shared_usage();
+
+CREATE TEXT SEARCH DICTIONARY shared_ispell (
+                        Template=ispell,
+                        DictFile=ispell_sample,
+                        AffFile=ispell_sample
+);
+CREATE TEXT SEARCH DICTIONARY shared_ispell2 (
+                        Template=ispell,
+                        DictFile=ispell_sample,
+                        AffFile=ispell_sample
+);
+
+--
+-- Using a dictionary stores it, and another dictionary built from the same
+-- files shares the stored copy.
+--
+SELECT ts_lexize('shared_ispell', 'skies');
+SELECT ts_lexize('shared_ispell2', 'bookings');
+SELECT entries, dead, refs, allocated > 0 AS allocated
+  FROM test_ts_shared_usage();
+
+--
+-- Altering a dictionary makes its copy dead.  It's freed when both
+-- dictionaries have let go of it, and the next use stores a new one.
+--
+ALTER TEXT SEARCH DICTIONARY shared_ispell (StopWords=english);
+SELECT ts_lexize('shared_ispell', 'skies');
+SELECT entries, dead, refs, allocated > 0 AS allocated
+  FROM test_ts_shared_usage();
+SELECT ts_lexize('shared_ispell2', 'bookings');
+SELECT entries, dead, refs, allocated > 0 AS allocated
+  FROM test_ts_shared_usage();
+
+--
+-- Dropping the dictionaries makes the copy dead too.  The references are
+-- released, and the copy freed, when another dictionary is loaded.
+--
+DROP TEXT SEARCH DICTIONARY shared_ispell;
+DROP TEXT SEARCH DICTIONARY shared_ispell2;
+SELECT entries, dead, refs, allocated > 0 AS allocated
+  FROM test_ts_shared_usage();
+SELECT ts_lexize('simple', 'word');
+SELECT entries, dead, refs, allocated > 0 AS allocated
+  FROM test_ts_shared_usage();
@@ -0,0 +1,11 @@
+/* src/test/modules/test_ts_shared/test_ts_shared--1.0.sql */
+
+-- complain if script is sourced in psql, rather than via CREATE EXTENSION
+\echo Use "CREATE EXTENSION test_ts_shared" to load this file. \quit
+
+CREATE FUNCTION test_ts_shared_usage(OUT entries pg_catalog.int4,
+					   OUT dead pg_catalog.int4,
+					   OUT refs pg_catalog.int4,
+					   OUT allocated pg_catalog.int8)
+    RETURNS record STRICT
+	AS 'MODULE_PATHNAME' LANGUAGE C;
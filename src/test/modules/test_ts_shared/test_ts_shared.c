@@ -0,0 +1,51 @@
+/*--------------------------------------------------------------------------
+ *
+ * test_ts_shared.c
+ *		Test code for shared text search dictionaries.
+ *
+ * Copyright (C) 2015, PostgreSQL Global Development Group
+ *
+ * IDENTIFICATION
+ *		src/test/modules/test_ts_shared/test_ts_shared.c
+ *
+ * -------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "access/htup_details.h"
+#include "fmgr.h"
+#include "funcapi.h"
+#include "tsearch/ts_shared.h"
+
+PG_MODULE_MAGIC;
+
+PG_FUNCTION_INFO_V1(test_ts_shared_usage);
+
+/*
+ * Report the usage of the shared dictionary area.
+ */
+Datum
+test_ts_shared_usage(PG_FUNCTION_ARGS)
+{
+	TupleDesc	tupdesc;
+	Datum		values[4];
+	bool		nulls[4];
+	int			nentries;
+	int			ndead;
+	int			nrefs;
+	Size		allocated;
+
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	ts_shared_usage(&nentries, &ndead, &nrefs, &allocated);
+
+	values[0] = Int32GetDatum(nentries);
+	values[1] = Int32GetDatum(ndead);
+	values[2] = Int32GetDatum(nrefs);
+	values[3] = Int64GetDatum((int64) allocated);
+	memset(nulls, 0, sizeof(nulls));
+
+	PG_RETURN_DATUM(HeapTupleGetDatum(heap_form_tuple(tupdesc, values, nulls)));
+}
@@ -10,7 +10,10 @@ our @EXPORT = qw(
   standard_initdb
   start_test_server
   restart_test_server
+  reconfigure_test_server
+  crash_restart_test_server
   psql
+  psql_out
   system_or_bail
 
   command_ok
@@ -110,6 +113,27 @@ sub restart_test_server
 	  $test_server_logfile, 'restart';
 }
 
+# Append the given lines to the test server's postgresql.conf, and restart
+# it so that they take effect.
+sub reconfigure_test_server
+{
+	my @lines = @_;
+
+	open my $conf, '>>', "$test_server_datadir/postgresql.conf"
+	  or BAIL_OUT("could not open postgresql.conf: $!");
+	print $conf "$_\n" foreach @lines;
+	close $conf;
+	restart_test_server();
+}
+
+# Stop the test server in immediate mode, so that it has to go through crash
+# recovery when it starts again.  Returns the exit status of pg_ctl.
+sub crash_restart_test_server
+{
+	return system 'pg_ctl', '-s', '-D', $test_server_datadir, '-w', '-m',
+	  'immediate', '-l', $test_server_logfile, 'restart';
+}
+
 END
 {
 	if ($test_server_datadir)
@@ -125,6 +149,20 @@ sub psql
 	run [ 'psql', '-X', '-q', '-d', $dbname, '-f', '-' ], '<', \$sql or die;
 }
 
+# Run the given SQL in the postgres database, stopping at the first error,
+# and return the output in unaligned, tuples-only format.
+sub psql_out
+{
+	my ($sql) = @_;
+	my ($stdout, $stderr);
+	run [ 'psql', '-X', '-q', '-A', '-t', '-v', 'ON_ERROR_STOP=1',
+		'-d', 'postgres' ],
+	  '<', \$sql, '>', \$stdout, '2>', \$stderr
+	  or die "psql failed: $stderr";
+	chomp $stdout;
+	return $stdout;
+}
+
 sub system_or_bail
 {
 	system(@_) == 0 or BAIL_OUT("system @_ failed: $?");
@@ -255,6 +255,18 @@ select 33 = all (null::int[]);
 select null::int = all ('{1,2,3}');
 select 33 = all ('{1,null,3}');
 select 33 = all ('{33,null,33}');
+-- large constant arrays are searched using a hash table
+select count(*) from generate_series(1, 100) g
+  where g in (1, 2, 3, 5, 8, 13, 21, 34, 55, 89);
+select count(*) from generate_series(1, 100) g
+  where g not in (1, 2, 3, 5, 8, 13, 21, 34, 55, 89);
+select count(*) from generate_series(1, 100) g
+  where g = any ('{1,2,3,5,8,13,21,34,55,89}'::int8[]);
+select count(*) from (values ('b'), ('x'), ('z')) v(x)
+  where x in ('a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j');
+select g, g in (2, 3, 5, 7, 11, 13, 17, 19, 23, null) as "in",
+  g not in (2, 3, 5, 7, 11, 13, 17, 19, 23, null) as "not in"
+from (values (1), (2), (null)) v(g);
 
 -- test indexes on arrays
 create temp table arr_tbl (f1 int[] unique);
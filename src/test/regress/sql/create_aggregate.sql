@@ -144,3 +144,21 @@ CREATE AGGREGATE wrongreturntype (float8)
     msfunc = float8pl,
     minvfunc = float8mi_int
 );
+
+-- combine function
+
+CREATE AGGREGATE maxcombine (int4)
+(
+    stype = int4,
+    sfunc = int4larger,
+    combinefunc = int4larger
+);
+
+-- invalid: combine function returning the wrong type
+
+CREATE AGGREGATE wrongcombinetype (int4)
+(
+    stype = int4,
+    sfunc = int4larger,
+    combinefunc = int4eq
+);
@@ -275,3 +275,51 @@ set default_text_search_config = no_such_config;
 select func_with_bad_set();
 
 reset check_function_bodies;
+
+-- Memory context accounting
+select name, parent, level from pg_backend_memory_contexts where level = 0;
+select count(*) from pg_backend_memory_contexts
+  where cumulative_bytes < total_bytes or used_bytes > total_bytes;
+
+-- query_work_mem is a budget on the executor's per-query context
+set query_work_mem = '1MB';
+select budget_bytes from pg_backend_memory_contexts where name = 'ExecutorState';
+select g from (select g from generate_series(1, 100000) g order by g desc) s
+  offset 99997;
+reset query_work_mem;
+select count(*) from pg_backend_memory_contexts where budget_bytes is not null;
+
+-- once the query is over its query_work_mem budget, sorts and hash joins spill
+create function query_spills(query text) returns bool
+language plpgsql as
+$$
+declare
+  ln text;
+begin
+  for ln in execute 'explain (analyze, costs off, timing off) ' || query loop
+    if ln ~ 'Sort Method: external|Batches: ([2-9]|[0-9]{2,})' then
+      return true;
+    end if;
+  end loop;
+  return false;
+end;
+$$;
+set enable_mergejoin = off;
+set enable_nestloop = off;
+select query_spills('select unique1, string4 from tenk1 order by string4, unique1');
+select query_spills('select count(*) from tenk1 a join tenk1 b on a.unique1 = b.unique2');
+set query_work_mem = '256kB';
+select query_spills('select unique1, string4 from tenk1 order by string4, unique1');
+select query_spills('select count(*) from tenk1 a join tenk1 b on a.unique1 = b.unique2');
+reset query_work_mem;
+reset enable_mergejoin;
+reset enable_nestloop;
+drop function query_spills(text);
+
+-- session_memory_limit makes allocations beyond it fail
+set session_memory_limit = '64MB';
+\set VERBOSITY terse
+select length(repeat('x', 100 * 1024 * 1024));
+\set VERBOSITY default
+reset session_memory_limit;
+select length(repeat('x', 100 * 1024 * 1024));
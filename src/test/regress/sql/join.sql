@@ -779,6 +779,46 @@ select * from tenk1 a join tenk1 b on
   (a.unique1 = 1 and b.unique1 = 2) or
   ((a.unique2 = 3 or a.unique2 = 7) and b.hundred = 4);
 
+--
+-- test planning a cross-table OR in WHERE as a union of its arms
+--
+
+explain (costs off)
+select a.unique1, b.unique2 from tenk1 a join tenk2 b on a.unique1 = b.unique1
+where a.unique2 = 42 or b.unique2 = 4242;
+select a.unique1, b.unique2 from tenk1 a join tenk2 b on a.unique1 = b.unique1
+where a.unique2 = 42 or b.unique2 = 4242
+order by 1;
+-- a join row satisfying both arms must be returned only once
+select a.unique1, b.unique2 from tenk1 a join tenk2 b on a.unique1 = b.unique1
+where a.unique2 = 42 or b.unique2 = 42;
+-- does the plan of a query use the union of its OR arms?
+create function union_or_used(query text) returns bool
+language plpgsql as
+$$
+declare
+  ln text;
+begin
+  for ln in execute 'explain (costs off) ' || query loop
+    if ln like '%Sort Key: %ctid%' then
+      return true;
+    end if;
+  end loop;
+  return false;
+end;
+$$;
+select union_or_used('select a.unique1 from tenk1 a join tenk2 b on a.unique1 = b.unique1 where a.unique2 = 42 or b.unique2 = 4242');
+-- not when disabled
+set enable_union_or = off;
+select union_or_used('select a.unique1 from tenk1 a join tenk2 b on a.unique1 = b.unique1 where a.unique2 = 42 or b.unique2 = 4242');
+reset enable_union_or;
+-- not with a volatile join clause
+select union_or_used('select a.unique1 from tenk1 a join tenk2 b on a.unique1 = b.unique1 and random() >= 0 where a.unique2 = 42 or b.unique2 = 4242');
+-- up to eight arms, but not more
+select union_or_used('select a.unique1 from tenk1 a join tenk2 b on a.unique1 = b.unique1 where a.unique2 = 1 or b.unique2 = 2 or a.unique2 = 3 or b.unique2 = 4 or a.unique2 = 5 or b.unique2 = 6 or a.unique2 = 7 or b.unique2 = 8');
+select union_or_used('select a.unique1 from tenk1 a join tenk2 b on a.unique1 = b.unique1 where a.unique2 = 1 or b.unique2 = 2 or a.unique2 = 3 or b.unique2 = 4 or a.unique2 = 5 or b.unique2 = 6 or a.unique2 = 7 or b.unique2 = 8 or a.unique2 = 9');
+drop function union_or_used(text);
+
 --
 -- test placement of movable quals in a parameterized join tree
 --
@@ -856,6 +856,18 @@ WHERE a.aggfnoid = p.oid AND
     a.aggminvtransfn = iptr.oid AND
     ptr.proisstrict != iptr.proisstrict;
 
+-- Cross-check combinefn (if present) against its entry in pg_proc.
+-- It must take two arguments of the transition type and return that type.
+
+SELECT a.aggfnoid::oid, p.proname, cfn.oid, cfn.proname
+FROM pg_aggregate AS a, pg_proc AS p, pg_proc AS cfn
+WHERE a.aggfnoid = p.oid AND
+    a.aggcombinefn = cfn.oid AND
+    (cfn.proretset OR cfn.pronargs != 2 OR a.aggkind != 'n'
+     OR NOT physically_coercible(cfn.prorettype, a.aggtranstype)
+     OR NOT physically_coercible(a.aggtranstype, cfn.proargtypes[0])
+     OR NOT physically_coercible(a.aggtranstype, cfn.proargtypes[1]));
+
 -- Cross-check aggsortop (if present) against pg_operator.
 -- We expect to find entries for bool_and, bool_or, every, max, and min.
 
@@ -1191,9 +1203,9 @@ SELECT * FROM (
 WHERE NOT (
   -- btree has one mandatory and one optional support function.
   -- hash has one support function, which is mandatory.
-  -- GiST has eight support functions, one of which is optional.
-  -- GIN has six support functions. 1-3 are mandatory, 5 is optional, and
-  --   at least one of 4 and 6 must be given.
+  -- GiST has ten support functions, three of which are optional.
+  -- GIN has seven support functions. 1-3 are mandatory, 5 and 7 are
+  --   optional, and at least one of 4 and 6 must be given.
   -- SP-GiST has five support functions, all mandatory
   -- BRIN has four mandatory support functions, and a bunch of optionals
   amname = 'btree' AND procnums @> '{1}' OR
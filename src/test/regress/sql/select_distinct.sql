@@ -62,3 +62,26 @@ SELECT 1 IS NOT DISTINCT FROM 2 as "no";
 SELECT 2 IS NOT DISTINCT FROM 2 as "yes";
 SELECT 2 IS NOT DISTINCT FROM null as "no";
 SELECT null IS NOT DISTINCT FROM null as "yes";
+
+--
+-- Hashed DISTINCT and GROUP BY spill to disk when the hash table doesn't
+-- fit in work_mem.  Every group must still come out exactly once.
+--
+
+CREATE TEMP TABLE hashspill AS
+  SELECT g % 5000 AS a, g AS b FROM generate_series(1, 20000) g;
+ANALYZE hashspill;
+
+SET work_mem = '64kB';
+SET enable_sort = off;
+
+EXPLAIN (costs off)
+SELECT DISTINCT a FROM hashspill;
+SELECT count(*), sum(a) FROM (SELECT DISTINCT a FROM hashspill) ss;
+
+SELECT count(*), min(n), max(n), sum(n) FROM
+  (SELECT a, count(*) AS n FROM hashspill GROUP BY a) ss;
+
+RESET enable_sort;
+RESET work_mem;
+DROP TABLE hashspill;
@@ -467,3 +467,59 @@ select * from
   order by 1;
 
 select nextval('ts1');
+
+--
+-- Check conversion of NOT IN to an anti join, which is only possible when
+-- neither side of the comparison can be null
+--
+create temp table notin_outer (a int not null, b int);
+create temp table notin_inner (x int not null, y int);
+insert into notin_outer values (1, 1), (2, null), (3, 3), (4, null);
+insert into notin_inner values (1, null), (3, 3);
+explain (costs off)
+select * from notin_outer where a not in (select x from notin_inner);
+select * from notin_outer where a not in (select x from notin_inner);
+-- the subquery's output can be null, so this has to stay a subplan
+explain (costs off)
+select * from notin_outer where a not in (select y from notin_inner);
+select * from notin_outer where a not in (select y from notin_inner);
+-- ... unless the subquery filters out the nulls
+explain (costs off)
+select * from notin_outer where a not in
+  (select y from notin_inner where y is not null);
+select * from notin_outer where a not in
+  (select y from notin_inner where y is not null);
+-- a nullable column on the outer side also prevents the conversion
+explain (costs off)
+select * from notin_outer where b not in (select x from notin_inner);
+select * from notin_outer where b not in (select x from notin_inner);
+
+--
+-- Check conversion of correlated aggregate sub-selects in the targetlist
+-- to outer joins to grouped subqueries
+--
+explain (costs off)
+select a, (select count(*) from notin_inner where x = a) from notin_outer;
+select a, (select count(*) from notin_inner where x = a) from notin_outer;
+select a, (select max(y) from notin_inner where x = a) from notin_outer;
+-- the transition function of count(), but with another initial condition
+create aggregate count_plus_one (*) (sfunc = int8inc, stype = int8, initcond = '1');
+explain (costs off)
+select a, (select count_plus_one(*) from notin_inner where x = a) from notin_outer;
+select a, (select count_plus_one(*) from notin_inner where x = a) from notin_outer;
+drop aggregate count_plus_one (*);
+-- the join isn't used when running the sub-select for each row is cheaper
+create temp table agg_inner as select g as x, g as y from generate_series(1, 10000) g;
+create index on agg_inner (x);
+analyze agg_inner;
+analyze notin_outer;
+explain (costs off)
+select a, (select max(y) from agg_inner where x = a) from notin_outer;
+select a, (select max(y) from agg_inner where x = a) from notin_outer;
+-- nested query levels that each convert a sub-select
+select s2.a, s2.c1, s2.c2, (select count(*) from notin_inner where x = s2.a) as c3
+from (select s1.a, s1.c1, (select count(*) from notin_inner where x = s1.a) as c2
+      from (select a, (select count(*) from notin_inner where x = a) as c1
+            from notin_outer offset 0) s1
+      offset 0) s2
+order by 1;
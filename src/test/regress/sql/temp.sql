@@ -151,3 +151,62 @@ select whoami();
 select pg_temp.whoami();
 
 drop table public.whereami;
+
+-- global temporary tables have a shared definition but per-session contents
+create global temp table gtt1 (a int primary key, b text);
+select relname, relpersistence from pg_class
+  where relname in ('gtt1', 'gtt1_pkey') order by relname;
+insert into gtt1 values (1, 'one'), (2, 'two');
+begin;
+insert into gtt1 values (3, 'three');
+rollback;
+select * from gtt1 order by a;
+insert into gtt1 values (1, 'uno');
+truncate gtt1;
+select count(*) from gtt1;
+insert into gtt1 values (4, 'four');
+
+-- truncation can't be rolled back, so it isn't allowed in a transaction block
+begin;
+truncate gtt1;
+rollback;
+-- an index is rebuilt in place, which a rollback doesn't undo, but it's
+-- derived from the contents anyway
+begin;
+reindex table gtt1;
+rollback;
+set enable_seqscan = off;
+select * from gtt1 where a = 4;
+reset enable_seqscan;
+
+\c
+
+-- a new session starts out empty, with its own copy of the index
+select * from gtt1;
+insert into gtt1 select i, 'x' || i from generate_series(1, 100) i;
+select b from gtt1 where a = 42;
+insert into gtt1 values (42, 'dup');
+
+-- the contents are private, so they can be modified in a read-only transaction
+begin read only;
+insert into gtt1 values (101, 'x101');
+delete from gtt1 where a = 101;
+commit;
+
+-- global temporary tables can reference each other
+create global temp table gtt2 (a int references gtt1, c int);
+insert into gtt2 values (42, 1);
+insert into gtt2 values (142, 1);
+
+-- unsupported cases
+create global temp table gtt3 (a int) on commit delete rows;
+create global temp sequence gtt_seq;
+create global temp view gtt_view as select 1 as a;
+create table gtt_ref (a int references gtt1);
+create global temp table gtt_child () inherits (gtt2);
+create table gtt_child2 () inherits (gtt2);
+alter table gtt2 alter column c type bigint;
+alter table gtt2 add constraint gtt2_c_check check (c > 0);
+cluster gtt1 using gtt1_pkey;
+
+drop table gtt_child, gtt2, gtt1;
@@ -80,6 +80,63 @@ SELECT count(*) FROM test_tsvector WHERE a @@ 'w:*|q:*';
 SELECT count(*) FROM test_tsvector WHERE a @@ any ('{wr,qh}');
 
 RESET enable_seqscan;
+
+-- ordered retrieval by estimated rank, with tsvector_rank_ops
+SELECT 'a:1A,2 b:3'::tsvector <=> 'a & b' AS d1,
+       'a:1A,2 b:3'::tsvector <=> 'a | c:*' AS d2,
+       'a b'::tsvector <=> 'c' AS d3;
+
+DROP INDEX wowidx;
+
+CREATE INDEX wowrankidx ON test_tsvector USING gin (a tsvector_rank_ops);
+
+SET enable_seqscan=OFF;
+
+SELECT count(*) FROM test_tsvector WHERE a @@ 'wr|qh';
+SELECT count(*) FROM test_tsvector WHERE a @@ 'wr&qh';
+SELECT count(*) FROM test_tsvector WHERE a @@ 'eq&yt';
+SELECT count(*) FROM test_tsvector WHERE a @@ 'eq|yt';
+SELECT count(*) FROM test_tsvector WHERE a @@ '(eq&yt)|(wr&qh)';
+SELECT count(*) FROM test_tsvector WHERE a @@ '(eq|yt)&(wr|qh)';
+SELECT count(*) FROM test_tsvector WHERE a @@ 'w:*|q:*';
+SELECT count(*) FROM test_tsvector WHERE a @@ any ('{wr,qh}');
+
+SET enable_bitmapscan=OFF;
+
+EXPLAIN (costs off)
+SELECT a <=> 'wr&qh' AS dist FROM test_tsvector WHERE a @@ 'wr|qh'
+ORDER BY a <=> 'wr&qh' LIMIT 20;
+SELECT a <=> 'wr&qh' AS dist FROM test_tsvector WHERE a @@ 'wr|qh'
+ORDER BY a <=> 'wr&qh' LIMIT 20;
+SELECT a <=> 'wr&qh' AS dist, count(*)
+FROM (SELECT a FROM test_tsvector ORDER BY a <=> 'wr&qh' LIMIT 200) s
+GROUP BY 1 ORDER BY 1;
+
+-- more matching items than fit in work_mem, so that they are collected and
+-- returned in several batches
+CREATE TABLE test_tsvector_big AS
+  SELECT i, to_tsvector('simple', repeat('aa ', i % 4 + 1) ||
+                        CASE WHEN i % 3 = 0 THEN 'bb' ELSE '' END) AS a
+  FROM generate_series(1, 20000) i;
+CREATE INDEX bigrankidx ON test_tsvector_big USING gin (a tsvector_rank_ops);
+-- these go to the pending list
+INSERT INTO test_tsvector_big
+  SELECT i, to_tsvector('simple', repeat('bb ', i % 3 + 1) || 'aa')
+  FROM generate_series(20001, 20100) i;
+SET work_mem = 64;
+EXPLAIN (costs off)
+SELECT i FROM test_tsvector_big WHERE a @@ 'aa' ORDER BY a <=> 'aa|bb';
+SELECT count(*) AS n, count(DISTINCT i) AS ndistinct,
+       sum(CASE WHEN d < prevd THEN 1 ELSE 0 END) AS misordered
+FROM (SELECT i, d, lag(d) OVER () AS prevd
+      FROM (SELECT i, a <=> 'aa|bb' AS d FROM test_tsvector_big
+            WHERE a @@ 'aa' ORDER BY a <=> 'aa|bb') s) t;
+RESET work_mem;
+DROP TABLE test_tsvector_big;
+
+RESET enable_seqscan;
+RESET enable_bitmapscan;
+
 INSERT INTO test_tsvector VALUES ('???', 'DFG:1A,2B,6C,10 FGH');
 SELECT * FROM ts_stat('SELECT a FROM test_tsvector') ORDER BY ndoc DESC, nentry DESC, word LIMIT 10;
 SELECT * FROM ts_stat('SELECT a FROM test_tsvector', 'AB') ORDER BY ndoc DESC, nentry DESC, word;
@@ -317,3 +317,32 @@ select * from
 
 drop table t3;
 drop function expensivefunc(int);
+
+--
+-- Hashed set operations spill to disk when the hash table doesn't fit in
+-- work_mem
+--
+
+create temp table hashspill as
+  select g % 5000 as a, g as b from generate_series(1, 20000) g;
+analyze hashspill;
+
+set work_mem = '64kB';
+set enable_sort = off;
+
+explain (costs off)
+select a from hashspill intersect select b from hashspill;
+select count(*), sum(x) from
+  (select a as x from hashspill intersect select b from hashspill) ss;
+select count(*) from
+  (select a from hashspill intersect all select b from hashspill) ss;
+select count(*), sum(x) from
+  (select b as x from hashspill except select a from hashspill) ss;
+select count(*) from
+  (select a from hashspill except all select b from hashspill) ss;
+select count(*), sum(x) from
+  (select a as x from hashspill union select b from hashspill) ss;
+
+reset enable_sort;
+reset work_mem;
+drop table hashspill;
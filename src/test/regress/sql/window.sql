@@ -292,6 +292,17 @@ SELECT * FROM
    FROM empsalary) emp
 WHERE depname = 'sales';
 
+-- a window whose sort keys are a prefix of another's can share its sort
+EXPLAIN (COSTS OFF)
+SELECT empno,
+       sum(salary) OVER (PARTITION BY depname) depsalary,
+       rank() OVER (PARTITION BY depname ORDER BY salary) deprank
+FROM empsalary;
+SELECT depname, empno, salary,
+       sum(salary) OVER (PARTITION BY depname) depsalary,
+       rank() OVER (PARTITION BY depname ORDER BY salary) deprank
+FROM empsalary ORDER BY depname, salary, empno;
+
 -- cleanup
 DROP TABLE empsalary;
 
@@ -641,3 +652,31 @@ SELECT to_char(SUM(n::float8) OVER (ORDER BY i ROWS BETWEEN CURRENT ROW AND 1 FO
 SELECT i, b, bool_and(b) OVER w, bool_or(b) OVER w
   FROM (VALUES (1,true), (2,true), (3,false), (4,false), (5,true)) v(i,b)
   WINDOW w AS (ORDER BY i ROWS BETWEEN CURRENT ROW AND 1 FOLLOWING);
+
+-- aggregates with a combine function but no inverse transition function
+-- assemble moving frames from partial states
+SELECT i, v, min(v) OVER w, max(v) OVER w
+  FROM (VALUES (1,'d'), (2,'b'), (3,NULL), (4,'e'), (5,'a'), (6,'c')) t(i,v)
+  WINDOW w AS (ORDER BY i ROWS BETWEEN 2 PRECEDING AND CURRENT ROW);
+
+-- compare against evaluating each frame separately
+WITH t AS (
+  SELECT i, CASE WHEN i % 7 = 0 THEN NULL ELSE (i * 37) % 101 END AS v
+  FROM generate_series(1, 300) i
+)
+SELECT count(*) FROM (
+  SELECT i, min(v) OVER w1 AS mn, max(v::text) OVER w1 AS mx,
+         bit_and(v) OVER w1 AS ba, max(v) OVER w2 AS mx2
+  FROM t
+  WINDOW w1 AS (ORDER BY i ROWS BETWEEN 10 PRECEDING AND 3 FOLLOWING),
+         w2 AS (PARTITION BY i / 50 ORDER BY i / 5
+                RANGE BETWEEN CURRENT ROW AND UNBOUNDED FOLLOWING)
+) x
+WHERE mn IS DISTINCT FROM
+        (SELECT min(v) FROM t WHERE t.i BETWEEN x.i - 10 AND x.i + 3)
+   OR mx IS DISTINCT FROM
+        (SELECT max(v::text) FROM t WHERE t.i BETWEEN x.i - 10 AND x.i + 3)
+   OR ba IS DISTINCT FROM
+        (SELECT bit_and(v) FROM t WHERE t.i BETWEEN x.i - 10 AND x.i + 3)
+   OR mx2 IS DISTINCT FROM
+        (SELECT max(v) FROM t WHERE t.i / 50 = x.i / 50 AND t.i / 5 >= x.i / 5);
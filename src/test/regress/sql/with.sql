@@ -364,6 +364,48 @@ WITH RECURSIVE
      (SELECT * FROM y UNION ALL SELECT id+1 FROM z WHERE id < 10)
  SELECT * FROM z;
 
+--
+-- Check inlining of WITH queries and pushdown of restrictions into them
+--
+
+-- a singly-referenced side-effect-free CTE is inlined
+EXPLAIN (COSTS OFF)
+WITH x AS (SELECT * FROM tenk1)
+SELECT * FROM x WHERE unique1 = 5;
+
+-- unless it's marked MATERIALIZED; but the restriction is still pushed down
+EXPLAIN (COSTS OFF)
+WITH x AS MATERIALIZED (SELECT * FROM tenk1)
+SELECT * FROM x WHERE unique1 = 5;
+
+WITH x AS MATERIALIZED (SELECT * FROM tenk1)
+SELECT unique1, unique2 FROM x WHERE unique1 = 5;
+
+-- a restriction applied by every reference is pushed down
+EXPLAIN (COSTS OFF)
+WITH x AS (SELECT * FROM tenk1)
+SELECT unique1 FROM x WHERE ten = 1
+UNION ALL
+SELECT unique2 FROM x WHERE ten = 1;
+
+-- but not one applied by only some of them
+EXPLAIN (COSTS OFF)
+WITH x AS (SELECT * FROM tenk1)
+SELECT unique1 FROM x WHERE ten = 1
+UNION ALL
+SELECT unique2 FROM x WHERE ten = 2;
+
+-- NOT MATERIALIZED inlines even a multiply-referenced CTE
+EXPLAIN (COSTS OFF)
+WITH x AS NOT MATERIALIZED (SELECT * FROM tenk1)
+SELECT * FROM x x1 JOIN x x2 ON x1.unique1 = x2.unique2
+WHERE x2.unique1 = 5;
+
+-- a CTE with volatile functions is never inlined
+EXPLAIN (COSTS OFF)
+WITH x AS NOT MATERIALIZED (SELECT random() AS r FROM int4_tbl)
+SELECT * FROM x;
+
 --
 -- Test WITH attached to a data-modifying statement
 --
@@ -0,0 +1,97 @@
+# Test the shared relation size cache: that relation sizes stay right when
+# there are more relations than the cache can hold, so that sizes are
+# evicted and looked up again, and that truncation updates cached sizes.
+use strict;
+use warnings;
+use TestLib;
+use Test::More tests => 8;
+
+my $tempdir = TestLib::tempdir;
+
+# With shared_buffers this small, the cache has its minimum of 1024 entries.
+start_test_server($tempdir);
+reconfigure_test_server("shared_buffers = 1MB");
+
+psql_out(<<'EOSQL');
+CREATE FUNCTION count_rows(ntables int) RETURNS bigint AS $$
+DECLARE
+	total bigint := 0;
+	n bigint;
+BEGIN
+	FOR i IN 1 .. ntables LOOP
+		EXECUTE 'SELECT count(*) FROM r' || i INTO n;
+		total := total + n;
+	END LOOP;
+	RETURN total;
+END
+$$ LANGUAGE plpgsql;
+EOSQL
+
+# Make more relations than fit in the cache, each spanning a few pages.  As
+# the tables are created and filled one after another, the sizes of earlier
+# ones are evicted.
+my $ntables  = 1500;
+my $expected = 0;
+my $script   = "";
+foreach my $i (1 .. $ntables)
+{
+	my $nrows = 200 + $i % 500;
+	$script .= "CREATE TABLE r$i (v int);\n";
+	$script .= "INSERT INTO r$i SELECT generate_series(1, $nrows);\n";
+	$expected += $nrows;
+}
+psql_out($script);
+is(psql_out("SELECT count_rows($ntables)"),
+	$expected, 'all rows visible with more relations than cache entries');
+
+# Extend all the tables again.  Their sizes are looked up afresh after being
+# evicted; had a size been cached too small, the extension would overwrite
+# existing pages.
+$script = "";
+foreach my $i (1 .. $ntables)
+{
+	$script .= "INSERT INTO r$i SELECT generate_series(1, 300);\n";
+	$expected += 300;
+}
+psql_out($script);
+is(psql_out("SELECT count_rows($ntables)"),
+	$expected, 'all rows visible after extending evicted relations');
+is(psql_out("SELECT count_rows($ntables)"),
+	$expected, 'all rows visible on repeated scan');
+
+# Truncation by VACUUM must set the cached size.  If the old, larger size
+# were kept, scans would try to read past the end of the file, and new rows
+# would go to a page past it.
+psql_out(<<'EOSQL');
+CREATE TABLE trunc (v int);
+INSERT INTO trunc SELECT generate_series(1, 10000);
+SELECT count(*) FROM trunc;
+DELETE FROM trunc;
+VACUUM trunc;
+EOSQL
+is(psql_out("SELECT pg_relation_size('trunc')"),
+	'0', 'VACUUM truncated the table');
+is(psql_out("SELECT count(*) FROM trunc"),
+	'0', 'scan of truncated table');
+is(psql_out("INSERT INTO trunc VALUES (1) RETURNING ctid"),
+	'(0,1)', 'insertion after truncation goes to the first page');
+
+# Truncating a table created in the same transaction truncates its file in
+# place, rather than creating a new one.
+is( psql_out(<<'EOSQL'),
+BEGIN;
+CREATE TABLE trunc2 (v int);
+INSERT INTO trunc2 SELECT generate_series(1, 10000);
+SELECT count(*) FROM trunc2;
+TRUNCATE trunc2;
+INSERT INTO trunc2 VALUES (1) RETURNING ctid;
+COMMIT;
+EOSQL
+	"10000\n(0,1)", 'insertion after in-place TRUNCATE goes to the first page');
+
+# TRUNCATE of an older table gives it a new file, which mustn't find the
+# size of the old one.
+psql_out("INSERT INTO trunc SELECT generate_series(1, 10000)");
+psql_out("TRUNCATE trunc");
+is(psql_out("INSERT INTO trunc VALUES (1) RETURNING ctid"),
+	'(0,1)', 'insertion after TRUNCATE goes to the first page');
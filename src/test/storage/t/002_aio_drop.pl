@@ -0,0 +1,80 @@
+# Test that reads queued for the I/O workers don't outlive truncation or
+# dropping of the relation.  A bitmap heap scan with a LIMIT stops long
+# before the prefetches it has queued have been carried out, and releases its
+# lock on the table; the table is then truncated by VACUUM, or dropped, while
+# workers may still be reading its blocks.  A block read in behind the back
+# of the truncation would make the next extension of the table fail with
+# "unexpected data beyond EOF", and a read of a dropped file would fail in
+# the worker.
+use strict;
+use warnings;
+use TestLib;
+use Test::More tests => 5;
+
+my $tempdir = TestLib::tempdir;
+
+my $nrows  = 20000;
+my $nloops = 20;
+
+# Keep shared_buffers small, so that the blocks of the table are mostly not
+# in buffers when they are prefetched.
+start_test_server($tempdir);
+reconfigure_test_server(
+	"io_workers = 2",
+	"shared_buffers = 1MB",
+	"effective_io_concurrency = 100",
+	"enable_seqscan = off",
+	"enable_indexscan = off");
+
+# About 14 rows fit on a page, so the table has some 1400 pages.
+psql_out(<<"EOSQL");
+CREATE TABLE t (k int, pad text);
+INSERT INTO t SELECT g, repeat('x', 500) FROM generate_series(1, $nrows) g;
+CREATE INDEX t_k ON t (k);
+EOSQL
+
+is( psql_out(<<'EOSQL'),
+SELECT count(*) FROM t WHERE k > 0;
+SELECT reads_submitted > 0 FROM pg_stat_aio WHERE pid = pg_backend_pid();
+EOSQL
+	"$nrows\nt", 'bitmap heap scan submits reads to the I/O workers');
+
+# Each scan reads some 140 pages and leaves several hundred more queued.
+# VACUUM then cuts the table down to its first few pages, and the INSERT
+# extends it again.
+my $script = "";
+foreach my $i (1 .. $nloops)
+{
+	$script .= "SELECT count(*) FROM (SELECT * FROM t WHERE k > 0 LIMIT 2000) s;\n";
+	$script .= "DELETE FROM t WHERE k > 100;\n";
+	$script .= "VACUUM t;\n";
+	$script .= "INSERT INTO t SELECT g, repeat('x', 500) FROM generate_series(101, $nrows) g;\n";
+}
+psql_out($script);
+is(psql_out("SELECT count(*) FROM t WHERE k > 0"),
+	$nrows, 'all rows visible after truncating with reads queued');
+is( psql_out(<<'EOSQL'),
+SELECT count(*) FROM (SELECT * FROM t WHERE k > 0 LIMIT 2000) s;
+DELETE FROM t WHERE k > 100;
+VACUUM t;
+SELECT pg_relation_size('t') <= 8 * 8192;
+EOSQL
+	"2000\nt", 'VACUUM truncated the table with reads queued');
+
+# The same with dropping the table and creating it again.
+$script = "";
+foreach my $i (1 .. $nloops)
+{
+	$script .= "SELECT count(*) FROM (SELECT * FROM t WHERE k > 0 LIMIT 2000) s;\n";
+	$script .= "DROP TABLE t;\n";
+	$script .= "CREATE TABLE t (k int, pad text);\n";
+	$script .= "INSERT INTO t SELECT g, repeat('x', 500) FROM generate_series(1, $nrows) g;\n";
+	$script .= "CREATE INDEX t_k ON t (k);\n";
+}
+psql_out($script);
+is(psql_out("SELECT count(*) FROM t WHERE k > 0"),
+	$nrows, 'all rows visible after dropping with reads queued');
+
+# Neither the sessions nor the I/O workers should have run into errors.
+my $log = `cat '$tempdir/logfile'`;
+unlike($log, qr/ERROR:/, 'no errors in server log');
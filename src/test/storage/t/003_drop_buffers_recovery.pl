@@ -0,0 +1,54 @@
+# Test dropping the buffers of dropped and truncated relations during crash
+# recovery, where the buffers of small relations are looked up one by one
+# using the sizes in the shared relation size cache instead of scanning the
+# whole buffer pool.  Had a buffer of a dropped page been left behind, the
+# replay of a later extension of the relation would find it, and recovery
+# would fail.
+use strict;
+use warnings;
+use TestLib;
+use Test::More tests => 6;
+
+my $tempdir = TestLib::tempdir;
+
+start_test_server($tempdir);
+
+# Everything after the checkpoint is replayed after the crash below.  Each
+# relation is small, so that its buffers are dropped by looking them up.
+psql_out(<<'EOSQL');
+CREATE TABLE dropped (v int);
+CREATE TABLE truncated (v int);
+CREATE TABLE vacuumed (v int);
+CHECKPOINT;
+
+-- a dropped table, and one replaced by TRUNCATE, whose old file is dropped
+INSERT INTO dropped SELECT generate_series(1, 10000);
+DROP TABLE dropped;
+INSERT INTO truncated SELECT generate_series(1, 10000);
+TRUNCATE truncated;
+INSERT INTO truncated SELECT generate_series(1, 100);
+
+-- VACUUM truncates the empty tail of the table, which is then extended again
+INSERT INTO vacuumed SELECT generate_series(1, 10000);
+DELETE FROM vacuumed WHERE v > 100;
+VACUUM vacuumed;
+INSERT INTO vacuumed SELECT generate_series(1, 5000);
+EOSQL
+
+# Crash, so that the server has to replay all of that on restart
+is(crash_restart_test_server(), 0, 'server restarted after crash');
+
+is(psql_out("SELECT count(*) FROM pg_class WHERE relname = 'dropped'"),
+	'0', 'dropped table is gone');
+is(psql_out("SELECT count(*) FROM truncated"),
+	'100', 'rows inserted after TRUNCATE survived');
+is(psql_out("SELECT count(*) FROM vacuumed"),
+	'5100', 'rows before and after VACUUM truncation survived');
+
+# New pages must not find stale buffers either
+psql_out("INSERT INTO truncated SELECT generate_series(1, 10000)");
+psql_out("INSERT INTO vacuumed SELECT generate_series(1, 10000)");
+is(psql_out("SELECT count(*) FROM truncated"),
+	'10100', 'truncated table extended after recovery');
+is(psql_out("SELECT count(*) FROM vacuumed"),
+	'15100', 'vacuumed table extended after recovery');
@@ -0,0 +1,64 @@
+# Insert into one table from many sessions at once, so that they queue up
+# for the relation extension lock and the relation is extended by several
+# pages at a time.  The extra pages are entered into the free space map for
+# the waiters; check that no rows get lost, and that the extra pages are
+# used rather than left empty while the relation keeps growing.
+use strict;
+use warnings;
+use TestLib;
+use Test::More tests => 4;
+use IPC::Run qw(start finish);
+
+my $tempdir = TestLib::tempdir;
+
+my $nclients = 16;
+my $nxacts   = 50;
+my $nrows    = 200;
+
+start_test_server($tempdir);
+reconfigure_test_server("max_connections = 40");
+
+psql_out("CREATE TABLE t (client int, filler text)");
+
+# Each statement inserts a dozen pages or so, in a transaction of its own.
+my @handles;
+foreach my $client (1 .. $nclients)
+{
+	my $script = ("INSERT INTO t SELECT $client, repeat('x', 500) "
+		  . "FROM generate_series(1, $nrows);\n") x $nxacts;
+	my ($stdout, $stderr);
+	push @handles,
+	  start [ 'psql', '-X', '-q', '-v', 'ON_ERROR_STOP=1', '-d', 'postgres' ],
+	  '<', \$script, '>', \$stdout, '2>', \$stderr;
+}
+
+my $failed = 0;
+foreach my $h (@handles)
+{
+	finish $h or $failed++;
+}
+is($failed, 0, 'all clients finished without error');
+
+is(psql_out("SELECT count(*) FROM t"),
+	$nclients * $nxacts * $nrows, 'all rows inserted');
+
+# A waiter only extends the relation if the free space map has nothing for
+# it, so at most the last batch of extra pages, and the page each client
+# was filling, can be left empty.
+my $empty = psql_out(<<'EOSQL');
+SELECT pg_relation_size('t') / current_setting('block_size')::int
+	- count(DISTINCT (ctid::text::point)[0])
+FROM t
+EOSQL
+cmp_ok($empty, '<=', 512 + $nclients, 'extra pages were used');
+
+# Any pages that are left empty are found through the free space map.
+SKIP:
+{
+	skip 'no empty pages left', 1 if $empty == 0;
+
+	my $size = psql_out("SELECT pg_relation_size('t')");
+	psql_out("INSERT INTO t SELECT 0, repeat('x', 500)");
+	is(psql_out("SELECT pg_relation_size('t')"),
+		$size, 'insertion used an existing page');
+}
@@ -0,0 +1,83 @@
+# Test that prepared transactions can be finished whether their state is
+# read back from WAL, from a state file written at checkpoint, or from the
+# transactions recovered at startup.
+use strict;
+use warnings;
+use TestLib;
+use Test::More tests => 14;
+
+my $tempdir = TestLib::tempdir;
+
+sub twophase_files
+{
+	opendir(my $dh, "$tempdir/pgdata/pg_twophase") or die;
+	my @files = grep { !/^\./ } readdir($dh);
+	closedir($dh);
+	return scalar @files;
+}
+
+start_test_server($tempdir);
+reconfigure_test_server("max_prepared_transactions = 10");
+
+psql_out("CREATE TABLE t (id int)");
+
+# The state of a transaction prepared since the last checkpoint is only in
+# WAL, and COMMIT/ROLLBACK PREPARED read it from there.
+psql_out("BEGIN; INSERT INTO t VALUES (1); PREPARE TRANSACTION 'wal_commit'");
+psql_out("BEGIN; INSERT INTO t VALUES (2); PREPARE TRANSACTION 'wal_abort'");
+is(twophase_files(), 0, 'no state files before checkpoint');
+psql_out("COMMIT PREPARED 'wal_commit'");
+psql_out("ROLLBACK PREPARED 'wal_abort'");
+is(psql_out("SELECT string_agg(id::text, ',' ORDER BY id) FROM t"),
+	'1', 'transactions finished with state read from WAL');
+
+# A checkpoint moves the state of the transactions into state files.
+psql_out("BEGIN; INSERT INTO t VALUES (3); PREPARE TRANSACTION 'file_commit'");
+psql_out("BEGIN; INSERT INTO t VALUES (4); PREPARE TRANSACTION 'file_abort'");
+psql_out("CHECKPOINT");
+is(twophase_files(), 2, 'checkpoint writes state files');
+psql_out("CHECKPOINT");
+is(twophase_files(), 2, 'later checkpoint keeps state files');
+psql_out("COMMIT PREPARED 'file_commit'");
+psql_out("ROLLBACK PREPARED 'file_abort'");
+is(twophase_files(), 0, 'state files removed when finished');
+is(psql_out("SELECT string_agg(id::text, ',' ORDER BY id) FROM t"),
+	'1,3', 'transactions finished with state read from files');
+
+# A transaction prepared before a clean shutdown is recovered from its
+# state file, written by the shutdown checkpoint.
+psql_out("BEGIN; INSERT INTO t VALUES (5); PREPARE TRANSACTION 'restart'");
+restart_test_server();
+is(psql_out("SELECT gid FROM pg_prepared_xacts"),
+	'restart', 'prepared transaction survives restart');
+is(twophase_files(), 1, 'state file written at shutdown');
+psql_out("COMMIT PREPARED 'restart'");
+
+# A transaction prepared since the last checkpoint is recovered by replaying
+# the WAL after a crash, and one prepared before the checkpoint from its
+# file.
+psql_out("BEGIN; INSERT INTO t VALUES (6); PREPARE TRANSACTION 'crash_file'");
+psql_out("CHECKPOINT");
+psql_out("BEGIN; INSERT INTO t VALUES (7); PREPARE TRANSACTION 'crash_wal'");
+psql_out("BEGIN; INSERT INTO t VALUES (8); PREPARE TRANSACTION 'crash_abort'");
+crash_restart_test_server() == 0
+  or BAIL_OUT("restart after crash failed");
+is(psql_out("SELECT string_agg(gid, ',' ORDER BY gid) FROM pg_prepared_xacts"),
+	'crash_abort,crash_file,crash_wal',
+	'prepared transactions survive crash');
+psql_out("COMMIT PREPARED 'crash_file'");
+psql_out("COMMIT PREPARED 'crash_wal'");
+psql_out("ROLLBACK PREPARED 'crash_abort'");
+is(psql_out("SELECT count(*) FROM pg_prepared_xacts"),
+	'0', 'recovered transactions finished');
+is(twophase_files(), 0, 'no state files left');
+
+# After all that, another prepared transaction still works from WAL, and the
+# results are as expected.
+psql_out("BEGIN; INSERT INTO t VALUES (9); PREPARE TRANSACTION 'final'");
+is(twophase_files(), 0, 'new transaction has no state file');
+psql_out("COMMIT PREPARED 'final'");
+is(psql_out("SELECT string_agg(id::text, ',' ORDER BY id) FROM t"),
+	'1,3,5,6,7,9', 'committed rows visible, aborted rows not');
+is(psql_out("SELECT count(*) FROM pg_prepared_xacts"),
+	'0', 'nothing left prepared');
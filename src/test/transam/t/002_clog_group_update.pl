@@ -0,0 +1,79 @@
+# Commit and abort transactions from many sessions at once, so that their
+# clog updates contend for CLogControlLock and go through the group update
+# path.  Some transactions have more subtransactions than the group update
+# handles, and enough XIDs are consumed to cross several clog pages, so that
+# backends also take the fallbacks for a differing page and for too many
+# subxids while the group path is busy.
+use strict;
+use warnings;
+use TestLib;
+use Test::More tests => 4;
+use IPC::Run qw(start finish);
+
+my $tempdir = TestLib::tempdir;
+
+my $nclients = 16;
+my $nxacts   = 2000;
+
+start_test_server($tempdir);
+reconfigure_test_server("max_connections = 40");
+
+psql_out("CREATE TABLE t (client int, xact int, sub int)");
+my $startxid = psql_out("SELECT txid_current()");
+
+# Transaction i of a client has i % 8 subtransactions, each inserting a row,
+# besides the row of the top-level transaction.  Every fifth transaction is
+# rolled back, and in the others one subtransaction in four is.  Half of the
+# clients commit asynchronously, so that their clog updates carry an LSN.
+my $expected = 0;
+my @handles;
+foreach my $client (1 .. $nclients)
+{
+	my $script = "";
+	$script .= "SET synchronous_commit = off;\n" if $client % 2 == 0;
+	foreach my $i (1 .. $nxacts)
+	{
+		my $nsub = $i % 8;
+		my $abort = ($i % 5 == 0);
+
+		$script .= "BEGIN;\nINSERT INTO t VALUES ($client, $i, 0);\n";
+		$expected++ unless $abort;
+		foreach my $s (1 .. $nsub)
+		{
+			$script .= "SAVEPOINT s$s;\n";
+			$script .= "INSERT INTO t VALUES ($client, $i, $s);\n";
+			if ($s % 4 == 0)
+			{
+				$script .= "ROLLBACK TO SAVEPOINT s$s;\n";
+			}
+			else
+			{
+				$expected++ unless $abort;
+			}
+		}
+		$script .= $abort ? "ROLLBACK;\n" : "COMMIT;\n";
+	}
+
+	my ($stdout, $stderr);
+	push @handles,
+	  start [ 'psql', '-X', '-q', '-v', 'ON_ERROR_STOP=1', '-d', 'postgres' ],
+	  '<', \$script, '>', \$stdout, '2>', \$stderr;
+}
+
+my $failed = 0;
+foreach my $h (@handles)
+{
+	finish $h or $failed++;
+}
+is($failed, 0, 'all clients finished without error');
+
+my $endxid = psql_out("SELECT txid_current()");
+cmp_ok(int(($endxid - $startxid) / 32768), '>=', 2,
+	'XIDs span several clog pages');
+
+is(psql_out("SELECT count(*) FROM t"), $expected,
+	'rows of committed transactions and subtransactions visible');
+is( psql_out(
+		"SELECT count(*) FROM t WHERE xact % 5 = 0 OR (sub > 0 AND sub % 4 = 0)"),
+	'0',
+	'rows of aborted transactions and subtransactions not visible');
@@ -0,0 +1,86 @@
+# Commit transactions from many sessions at once while other sessions keep
+# taking snapshots, so that ProcArrayLock is contended and committing
+# backends clear their XIDs through the group XID clear path.  Each writer
+# transaction moves one unit between two accounts, so every snapshot must
+# see the same total; a snapshot that saw one side of a transfer but not the
+# other would mean an XID left the running set at the wrong time.
+use strict;
+use warnings;
+use TestLib;
+use Test::More tests => 4;
+use IPC::Run qw(start finish);
+
+my $tempdir = TestLib::tempdir;
+
+my $nwriters  = 16;
+my $nreaders  = 4;
+my $naccounts = 100;
+my $nxacts    = 2000;
+my $total     = $naccounts * 1000;
+
+start_test_server($tempdir);
+reconfigure_test_server("max_connections = 40");
+
+psql_out("CREATE TABLE accounts (id int PRIMARY KEY, balance int)");
+psql_out("INSERT INTO accounts "
+	  . "SELECT g, 1000 FROM generate_series(1, $naccounts) g");
+
+# A transfer updates the account with the lower id first, so that writers
+# always lock rows in the same order and can't deadlock.  Half of the writers
+# commit asynchronously.
+srand(42);
+my @handles;
+my @outputs;
+foreach my $client (1 .. $nwriters)
+{
+	my $script = "";
+	$script .= "SET synchronous_commit = off;\n" if $client % 2 == 0;
+	foreach my $i (1 .. $nxacts)
+	{
+		my $lo = 1 + int(rand($naccounts));
+		my $hi = 1 + int(rand($naccounts));
+		next if $lo == $hi;
+		($lo, $hi) = ($hi, $lo) if $lo > $hi;
+		my $delta = ($i % 2 == 0) ? 1 : -1;
+
+		$script .= "BEGIN;\n";
+		$script .= "UPDATE accounts SET balance = balance + $delta "
+		  . "WHERE id = $lo;\n";
+		$script .= "UPDATE accounts SET balance = balance - $delta "
+		  . "WHERE id = $hi;\n";
+		$script .= "COMMIT;\n";
+	}
+
+	my ($stdout, $stderr);
+	push @handles,
+	  start [ 'psql', '-X', '-q', '-v', 'ON_ERROR_STOP=1', '-d', 'postgres' ],
+	  '<', \$script, '>', \$stdout, '2>', \$stderr;
+}
+
+my $nchecks = 0;
+foreach my $client (1 .. $nreaders)
+{
+	my $script = "SELECT sum(balance) FROM accounts;\n" x $nxacts;
+	my $stdout = "";
+	my $stderr;
+	push @outputs, \$stdout;
+	push @handles,
+	  start [ 'psql', '-X', '-q', '-A', '-t', '-v', 'ON_ERROR_STOP=1',
+		'-d', 'postgres' ],
+	  '<', \$script, '>', \$stdout, '2>', \$stderr;
+	$nchecks += $nxacts;
+}
+
+my $failed = 0;
+foreach my $h (@handles)
+{
+	finish $h or $failed++;
+}
+is($failed, 0, 'all clients finished without error');
+
+my @sums = map { split /\n/, $$_ } @outputs;
+is(scalar @sums, $nchecks, 'readers took all their snapshots');
+is(scalar(grep { $_ != $total } @sums), 0,
+	'every snapshot saw whole transfers only');
+is(psql_out("SELECT sum(balance) FROM accounts"), $total,
+	'total balance unchanged at the end');